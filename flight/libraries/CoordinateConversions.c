@@ -30,6 +30,8 @@
 #include <math.h>
 #include <stdint.h>
 #include <pios_math.h>
+#include <fastmath.h>
+#include <vectors.h>
 #include "CoordinateConversions.h"
 
 #define MIN_ALLOWABLE_MAGNITUDE 1e-30f
@@ -110,10 +112,8 @@ void RneFromLLA(int32_t LLAi[3], float Rne[3][3])
 {
     float sinLat, sinLon, cosLat, cosLon;
 
-    sinLat    = sinf(DEG2RAD((float)LLAi[0] * 1e-7f));
-    sinLon    = sinf(DEG2RAD((float)LLAi[1] * 1e-7f));
-    cosLat    = cosf(DEG2RAD((float)LLAi[0] * 1e-7f));
-    cosLon    = cosf(DEG2RAD((float)LLAi[1] * 1e-7f));
+    fast_sincosf(DEG2RAD((float)LLAi[0] * 1e-7f), &sinLat, &cosLat);
+    fast_sincosf(DEG2RAD((float)LLAi[1] * 1e-7f), &sinLon, &cosLon);
 
     Rne[0][0] = -sinLat * cosLon;
     Rne[0][1] = -sinLat * sinLon;
@@ -141,9 +141,9 @@ void Quaternion2RPY(const float q[4], float rpy[3])
     R23    = 2.0f * (q[2] * q[3] + q[0] * q[1]);
     R33    = q0s - q1s - q2s + q3s;
 
-    rpy[1] = RAD2DEG(asinf(-R13)); // pitch always between -pi/2 to pi/2
-    rpy[2] = RAD2DEG(atan2f(R12, R11));
-    rpy[0] = RAD2DEG(atan2f(R23, R33));
+    rpy[1] = RAD2DEG(fast_asinf(-R13)); // pitch always between -pi/2 to pi/2
+    rpy[2] = RAD2DEG(fast_atan2f(R12, R11));
+    rpy[0] = RAD2DEG(fast_atan2f(R23, R33));
 
     // TODO: consider the cases where |R13| ~= 1, |pitch| ~= pi/2
 }
@@ -157,12 +157,9 @@ void RPY2Quaternion(const float rpy[3], float q[4])
     phi    = DEG2RAD(rpy[0] / 2);
     theta  = DEG2RAD(rpy[1] / 2);
     psi    = DEG2RAD(rpy[2] / 2);
-    cphi   = cosf(phi);
-    sphi   = sinf(phi);
-    ctheta = cosf(theta);
-    stheta = sinf(theta);
-    cpsi   = cosf(psi);
-    spsi   = sinf(psi);
+    fast_sincosf(phi, &sphi, &cphi);
+    fast_sincosf(theta, &stheta, &ctheta);
+    fast_sincosf(psi, &spsi, &cpsi);
 
     q[0]   = cphi * ctheta * cpsi + sphi * stheta * spsi;
     q[1]   = sphi * ctheta * cpsi - cphi * stheta * spsi;
@@ -260,9 +257,7 @@ void LLA2Base(int32_t LLAi[3], double BaseECEF[3], float Rne[3][3], float NED[3]
     diff[1] = (float)(ECEF[1] - BaseECEF[1]);
     diff[2] = (float)(ECEF[2] - BaseECEF[2]);
 
-    NED[0]  = Rne[0][0] * diff[0] + Rne[0][1] * diff[1] + Rne[0][2] * diff[2];
-    NED[1]  = Rne[1][0] * diff[0] + Rne[1][1] * diff[1] + Rne[1][2] * diff[2];
-    NED[2]  = Rne[2][0] * diff[0] + Rne[2][1] * diff[1] + Rne[2][2] * diff[2];
+    vector3_rotatef(Rne, diff, NED);
 }
 
 // ****** Express ECEF in a local NED Base Frame ********
@@ -274,9 +269,7 @@ void ECEF2Base(double ECEF[3], double BaseECEF[3], float Rne[3][3], float NED[3]
     diff[1] = (float)(ECEF[1] - BaseECEF[1]);
     diff[2] = (float)(ECEF[2] - BaseECEF[2]);
 
-    NED[0]  = Rne[0][0] * diff[0] + Rne[0][1] * diff[1] + Rne[0][2] * diff[2];
-    NED[1]  = Rne[1][0] * diff[0] + Rne[1][1] * diff[1] + Rne[1][2] * diff[2];
-    NED[2]  = Rne[2][0] * diff[0] + Rne[2][1] * diff[1] + Rne[2][2] * diff[2];
+    vector3_rotatef(Rne, diff, NED);
 }
 
 // ****** convert Rotation Matrix to Quaternion ********
@@ -421,8 +414,9 @@ void Rv2Rot(float Rv[3], float R[3][3])
         q[3] = 0.5f * Rv[2];
         // This prevents division by zero, while retaining full accuracy
     } else {
-        q[0] = cosf(angle * 0.5f);
-        float scale = sinf(angle * 0.5f) / angle;
+        float scale;
+        fast_sincosf(angle * 0.5f, &scale, &q[0]);
+        scale /= angle;
         q[1] = scale * Rv[0];
         q[2] = scale * Rv[1];
         q[3] = scale * Rv[2];
@@ -491,7 +485,5 @@ void quat_mult(const float q1[4], const float q2[4], float qout[4])
  */
 void rot_mult(float R[3][3], const float vec[3], float vec_out[3])
 {
-    vec_out[0] = R[0][0] * vec[0] + R[0][1] * vec[1] + R[0][2] * vec[2];
-    vec_out[1] = R[1][0] * vec[0] + R[1][1] * vec[1] + R[1][2] * vec[2];
-    vec_out[2] = R[2][0] * vec[0] + R[2][1] * vec[1] + R[2][2] * vec[2];
+    vector3_rotatef(R, vec, vec_out);
 }
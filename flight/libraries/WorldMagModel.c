@@ -20,6 +20,8 @@
  *                - Hard coded coefficients for model
  *                - Elimination of user interface
  *                - Elimination of dynamic memory allocation
+ *                - Time adjusted coefficients and Schmidt normalisation
+ *                  factors computed once per lookup, not per term
  *
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -152,10 +154,13 @@ static const float CoeffFile[91][6] = {
     { 12.0f, 12.0f, 0.0f,      0.9f,     0.1f,   0.0f   }
 };
 
+static WMMtype_Cache *Cache = NULL;
 static WMMtype_Ellipsoid *Ellip = NULL;
 static WMMtype_MagneticModel *MagneticModel = NULL;
 static float decimal_date;
 
+static int WMM_MagneticField(WMMtype_CoordSpherical *CoordSpherical, WMMtype_CoordGeodetic *CoordGeodetic, WMMtype_MagneticResults *MagneticResultsGeo);
+
 /**************************************************************************************
 *   Example use - very simple - only two exposed functions
 *
@@ -165,18 +170,28 @@ static float decimal_date;
 *	e.g. Iceland in may of 2012 = WMM_GetMagVector(65.0, -20.0, 0.0, 5, 5, 2012, B);
 *	Alt is above the WGS-84 Ellipsoid
 *	B is the NED (XYZ) magnetic vector in nTesla
+*
+*	WMM_Release(); // Free the model state once no more lookups are expected
 **************************************************************************************/
 
 int WMM_Initialize()
 // Sets default values for WMM subroutines.
 // UPDATES : Ellip and MagneticModel
 {
-    if (!Ellip) {
-        return -1; // invalid pointer
+    uint16_t n, m, index, index1;
+
+    if (Cache) {
+        return 0; // already done, the constants never change
     }
-    if (!MagneticModel) {
-        return -2; // invalid pointer
+
+    Cache = (WMMtype_Cache *)MALLOC(sizeof(WMMtype_Cache));
+    if (!Cache) {
+        return -1; // memory allocation error
     }
+    memset(Cache, 0, sizeof(WMMtype_Cache));
+    Ellip = &Cache->Ellip;
+    MagneticModel = &Cache->MagneticModel;
+
     // Sets WGS-84 parameters
     Ellip->a     = 6378.137f;   // semi-major axis of the ellipsoid in km
     Ellip->b     = 6356.7523142f;       // semi-minor axis of the ellipsoid in km
@@ -195,16 +210,49 @@ int WMM_Initialize()
     MagneticModel->epoch = 2010.0f;
     sprintf(MagneticModel->ModelName, "WMM-2010");
 
+    /* Compute the ratio between the Gauss-normalized associated Legendre
+       functions and the Schmidt quasi-normalized version once, it only depends
+       on n and m. This is equivalent to sqrt((m==0?1:2)*(n-m)!/(n+m!))*(2n-1)!!/(n-m)!  */
+    Cache->SchmidtQuasiNorm[0] = 1.0f;
+    for (n = 1; n <= WMM_MAX_MODEL_DEGREES; n++) {
+        index  = (n * (n + 1) / 2);
+        index1 = (n - 1) * n / 2;
+        /* for m = 0 */
+        Cache->SchmidtQuasiNorm[index] = Cache->SchmidtQuasiNorm[index1] * (float)(2 * n - 1) / (float)n;
+
+        for (m = 1; m <= n; m++) {
+            index  = (n * (n + 1) / 2 + m);
+            index1 = (n * (n + 1) / 2 + m - 1);
+            Cache->SchmidtQuasiNorm[index] = Cache->SchmidtQuasiNorm[index1] * sqrtf((float)((n - m + 1) * (m == 1 ? 2 : 1)) / (float)(n + m));
+        }
+    }
+
+    // no date set yet
+    Cache->CoeffDecimalYear = NAN;
+
     return 0; // OK
 }
 
+void WMM_Release()
+// Frees the model state, the next lookup initializes again.
+{
+    if (Cache) {
+        FREE(Cache);
+        Cache = NULL;
+        Ellip = NULL;
+        MagneticModel = NULL;
+    }
+}
+
 int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3])
 {
+    WMMtype_CoordSpherical CoordSpherical;
+    WMMtype_CoordGeodetic CoordGeodetic;
+    WMMtype_MagneticResults MagneticResultsGeo;
+
     // return '0' if all appears to be OK
     // return < 0 if error
 
-    int returned = 0; // default to OK
-
     // ***********
     // range check supplied params
 
@@ -221,92 +269,59 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
         return -4; // error
     }
     // ***********
-    // allocated required memory
-
-// Ellip = NULL;
-// MagneticModel = NULL;
-
-// MagneticModel = NULL;
-// CoordGeodetic = NULL;
-// GeoMagneticElements = NULL;
-
-    Ellip = (WMMtype_Ellipsoid *)MALLOC(sizeof(WMMtype_Ellipsoid));
-    MagneticModel = (WMMtype_MagneticModel *)MALLOC(sizeof(WMMtype_MagneticModel));
 
-    WMMtype_CoordSpherical *CoordSpherical = (WMMtype_CoordSpherical *)MALLOC(sizeof(WMMtype_CoordSpherical));
-    WMMtype_CoordGeodetic *CoordGeodetic   = (WMMtype_CoordGeodetic *)MALLOC(sizeof(WMMtype_CoordGeodetic));
-    WMMtype_GeoMagneticElements *GeoMagneticElements = (WMMtype_GeoMagneticElements *)MALLOC(sizeof(WMMtype_GeoMagneticElements));
-
-    if (!Ellip || !MagneticModel || !CoordSpherical || !CoordGeodetic || !GeoMagneticElements) {
-        returned = -5; // error
+    if (WMM_Initialize() < 0) {
+        return -5; // error
     }
-    // ***********
 
-    if (returned >= 0) {
-        if (WMM_Initialize() < 0) {
-            returned = -6; // error
-        }
+    if (WMM_DateToYear(Month, Day, Year) < 0) {
+        return -8; // error
     }
 
-    if (returned >= 0) {
-        CoordGeodetic->lambda = Lon;
-        CoordGeodetic->phi    = Lat;
-        CoordGeodetic->HeightAboveEllipsoid = AltEllipsoid / 1000.0f; // convert to km
+    CoordGeodetic.lambda = Lon;
+    CoordGeodetic.phi    = Lat;
+    CoordGeodetic.HeightAboveEllipsoid = AltEllipsoid / 1000.0f; // convert to km
 
-        // Convert from geodetic to Spherical Equations: 17-18, WMM Technical report
-        if (WMM_GeodeticToSpherical(CoordGeodetic, CoordSpherical) < 0) {
-            returned = -7; // error
-        }
+    // Convert from geodetic to Spherical Equations: 17-18, WMM Technical report
+    if (WMM_GeodeticToSpherical(&CoordGeodetic, &CoordSpherical) < 0) {
+        return -7; // error
     }
 
-
-    if (returned >= 0) {
-        if (WMM_DateToYear(Month, Day, Year) < 0) {
-            returned = -8; // error
-        }
+    // Compute the geoMagnetic field, the secular variation is of no interest here
+    if (WMM_MagneticField(&CoordSpherical, &CoordGeodetic, &MagneticResultsGeo) < 0) {
+        return -9; // error
     }
 
-    if (returned >= 0) {
-        // Compute the geoMagnetic field elements and their time change
-        if (WMM_Geomag(CoordSpherical, CoordGeodetic, GeoMagneticElements) < 0) {
-            returned = -9; // error
-        } else { // set the returned values
-            B[0] = GeoMagneticElements->X;
-            B[1] = GeoMagneticElements->Y;
-            B[2] = GeoMagneticElements->Z;
-        }
-    }
+    B[0] = MagneticResultsGeo.Bx * 1e-2f;
+    B[1] = MagneticResultsGeo.By * 1e-2f;
+    B[2] = MagneticResultsGeo.Bz * 1e-2f;
 
-    // ***********
-    // free allocated memory
+    return 0; // OK
+}
 
-    if (GeoMagneticElements) {
-        FREE(GeoMagneticElements);
-    }
+static int WMM_MagneticField(WMMtype_CoordSpherical *CoordSpherical, WMMtype_CoordGeodetic *CoordGeodetic, WMMtype_MagneticResults *MagneticResultsGeo)
+// Main field in geodetic coordinates, leaves the Legendre functions and
+// spherical harmonic variables of the point in Cache
+{
+    WMMtype_MagneticResults MagneticResultsSph;
 
-    if (CoordGeodetic) {
-        FREE(CoordGeodetic);
+    if (WMM_ComputeSphericalHarmonicVariables(CoordSpherical, MagneticModel->nMax, &Cache->SphVariables) < 0) {
+        return -2; // error
     }
 
-    if (CoordSpherical) {
-        FREE(CoordSpherical);
+    if (WMM_AssociatedLegendreFunction(CoordSpherical, MagneticModel->nMax, &Cache->Legendre) < 0) {
+        return -3; // error
     }
 
-    if (MagneticModel) {
-        FREE(MagneticModel);
-        MagneticModel = NULL;
+    if (WMM_Summation(&Cache->Legendre, &Cache->SphVariables, CoordSpherical, &MagneticResultsSph) < 0) {
+        return -4; // error
     }
 
-    if (Ellip) {
-        FREE(Ellip);
-        Ellip = NULL;
+    if (WMM_RotateMagneticVector(CoordSpherical, CoordGeodetic, &MagneticResultsSph, MagneticResultsGeo) < 0) {
+        return -6; // error
     }
 
-    B[0] = GeoMagneticElements->X * 1e-2f;
-    B[1] = GeoMagneticElements->Y * 1e-2f;
-    B[2] = GeoMagneticElements->Z * 1e-2f;
-
-    return returned;
+    return 0; // OK
 }
 
 int WMM_Geomag(WMMtype_CoordSpherical *CoordSpherical, WMMtype_CoordGeodetic *CoordGeodetic, WMMtype_GeoMagneticElements *GeoMagneticElements)
@@ -332,88 +347,40 @@ int WMM_Geomag(WMMtype_CoordSpherical *CoordSpherical, WMMtype_CoordGeodetic *Co
    WMM_CalculateGeoMagneticElements(&MagneticResultsGeo, GeoMagneticElements);   Calculate the Geomagnetic elements
    WMM_CalculateSecularVariation(MagneticResultsGeoVar, GeoMagneticElements); Calculate the secular variation of each of the Geomagnetic elements
 
+   The spherical harmonic variables and Legendre functions are the ones
+   WMM_MagneticField left in Cache.
  */
 {
-    int returned = 0; // default to OK
-
-    WMMtype_MagneticResults MagneticResultsSph;
     WMMtype_MagneticResults MagneticResultsGeo;
     WMMtype_MagneticResults MagneticResultsSphVar;
     WMMtype_MagneticResults MagneticResultsGeoVar;
 
-    // ********
-    // allocate required memory
-
-    WMMtype_LegendreFunction *LegendreFunction = (WMMtype_LegendreFunction *)MALLOC(sizeof(WMMtype_LegendreFunction));
-    WMMtype_SphericalHarmonicVariables *SphVariables = (WMMtype_SphericalHarmonicVariables *)MALLOC(sizeof(WMMtype_SphericalHarmonicVariables));
-
-    if (!LegendreFunction || !SphVariables) {
-        returned = -1; // memory allocation error
-    }
-    // ********
-
-    if (returned >= 0) { // Compute Spherical Harmonic variables
-        if (WMM_ComputeSphericalHarmonicVariables(CoordSpherical, MagneticModel->nMax, SphVariables) < 0) {
-            returned = -2; // error
-        }
-    }
-
-    if (returned >= 0) { // Compute ALF
-        if (WMM_AssociatedLegendreFunction(CoordSpherical, MagneticModel->nMax, LegendreFunction) < 0) {
-            returned = -3; // error
-        }
-    }
-
-    if (returned >= 0) { // Accumulate the spherical harmonic coefficients
-        if (WMM_Summation(LegendreFunction, SphVariables, CoordSpherical, &MagneticResultsSph) < 0) {
-            returned = -4; // error
-        }
-    }
-
-    if (returned >= 0) { // Sum the Secular Variation Coefficients
-        if (WMM_SecVarSummation(LegendreFunction, SphVariables, CoordSpherical, &MagneticResultsSphVar) < 0) {
-            returned = -5; // error
-        }
+    // Compute Spherical Harmonic variables and ALF, accumulate and rotate the main field
+    if (WMM_MagneticField(CoordSpherical, CoordGeodetic, &MagneticResultsGeo) < 0) {
+        return -4; // error
     }
 
-    if (returned >= 0) { // Map the computed Magnetic fields to Geodeitic coordinates
-        if (WMM_RotateMagneticVector(CoordSpherical, CoordGeodetic, &MagneticResultsSph, &MagneticResultsGeo) < 0) {
-            returned = -6; // error
-        }
+    // Sum the Secular Variation Coefficients
+    if (WMM_SecVarSummation(&Cache->Legendre, &Cache->SphVariables, CoordSpherical, &MagneticResultsSphVar) < 0) {
+        return -5; // error
     }
 
-    if (returned >= 0) { // Map the secular variation field components to Geodetic coordinates
-        if (WMM_RotateMagneticVector(CoordSpherical, CoordGeodetic, &MagneticResultsSphVar, &MagneticResultsGeoVar) < 0) {
-            returned = -7; // error
-        }
+    // Map the secular variation field components to Geodetic coordinates
+    if (WMM_RotateMagneticVector(CoordSpherical, CoordGeodetic, &MagneticResultsSphVar, &MagneticResultsGeoVar) < 0) {
+        return -7; // error
     }
 
-    if (returned >= 0) { // Calculate the Geomagnetic elements, Equation 18 , WMM Technical report
-        if (WMM_CalculateGeoMagneticElements(&MagneticResultsGeo, GeoMagneticElements) < 0) {
-            returned = -8; // error
-        }
+    // Calculate the Geomagnetic elements, Equation 18 , WMM Technical report
+    if (WMM_CalculateGeoMagneticElements(&MagneticResultsGeo, GeoMagneticElements) < 0) {
+        return -8; // error
     }
 
-    if (returned >= 0) { // Calculate the secular variation of each of the Geomagnetic elements
-        if (WMM_CalculateSecularVariation(&MagneticResultsGeoVar, GeoMagneticElements) < 0) {
-            returned = -9; // error
-        }
+    // Calculate the secular variation of each of the Geomagnetic elements
+    if (WMM_CalculateSecularVariation(&MagneticResultsGeoVar, GeoMagneticElements) < 0) {
+        return -9; // error
     }
 
-    // ********
-    // free allocated memory
-
-    if (SphVariables) {
-        FREE(SphVariables);
-    }
-
-    if (LegendreFunction) {
-        FREE(LegendreFunction);
-    }
-
-    // ********
-
-    return returned;
+    return 0; // OK
 }
 
 int WMM_ComputeSphericalHarmonicVariables(WMMtype_CoordSpherical *CoordSpherical, uint16_t nMax, WMMtype_SphericalHarmonicVariables *SphVariables)
@@ -531,6 +498,8 @@ int WMM_Summation(WMMtype_LegendreFunction *LegendreFunction,
 
     uint16_t m, n, index;
     float cos_phi;
+    const float *g = Cache->MainFieldCoeffG;
+    const float *h = Cache->MainFieldCoeffH;
 
     MagneticResults->Bz = 0.0f;
     MagneticResults->By = 0.0f;
@@ -546,8 +515,8 @@ int WMM_Summation(WMMtype_LegendreFunction *LegendreFunction,
 /* Equation 12 in the WMM Technical report.  Derivative with respect to radius.*/
             MagneticResults->Bz -=
                 SphVariables->RelativeRadiusPower[n] *
-                (WMM_get_main_field_coeff_g(index) *
-                 SphVariables->cos_mlambda[m] + WMM_get_main_field_coeff_h(index) * SphVariables->sin_mlambda[m])
+                (g[index] *
+                 SphVariables->cos_mlambda[m] + h[index] * SphVariables->sin_mlambda[m])
                 * (float)(n + 1) * LegendreFunction->Pcup[index];
 
 /*		  1 nMax  (n+2)    n     m            m           m
@@ -556,8 +525,8 @@ int WMM_Summation(WMMtype_LegendreFunction *LegendreFunction,
 /* Equation 11 in the WMM Technical report. Derivative with respect to longitude, divided by radius. */
             MagneticResults->By +=
                 SphVariables->RelativeRadiusPower[n] *
-                (WMM_get_main_field_coeff_g(index) *
-                 SphVariables->sin_mlambda[m] - WMM_get_main_field_coeff_h(index) * SphVariables->cos_mlambda[m])
+                (g[index] *
+                 SphVariables->sin_mlambda[m] - h[index] * SphVariables->cos_mlambda[m])
                 * (float)(m) * LegendreFunction->Pcup[index];
 /*		   nMax  (n+2) n     m            m           m
         Bx = - SUM (a/r)   SUM  [g cosf(m p) + h sinf(m p)] dP (sinf(phi))
@@ -566,8 +535,8 @@ int WMM_Summation(WMMtype_LegendreFunction *LegendreFunction,
 
             MagneticResults->Bx -=
                 SphVariables->RelativeRadiusPower[n] *
-                (WMM_get_main_field_coeff_g(index) *
-                 SphVariables->cos_mlambda[m] + WMM_get_main_field_coeff_h(index) * SphVariables->sin_mlambda[m])
+                (g[index] *
+                 SphVariables->cos_mlambda[m] + h[index] * SphVariables->sin_mlambda[m])
                 * LegendreFunction->dPcup[index];
         }
     }
@@ -967,9 +936,7 @@ int WMM_PcupLow(float *Pcup, float *dPcup, float x, uint16_t nMax)
     uint16_t n, m, index, index1, index2;
     float k, z;
 
-    float *schmidtQuasiNorm = (float *)MALLOC(sizeof(float) * NUMPCUP);
-
-    if (!schmidtQuasiNorm) { // memory allocation error
+    if (!Cache) { // WMM_Initialize() not called
         return -1;
     }
 
@@ -1006,40 +973,20 @@ int WMM_PcupLow(float *Pcup, float *dPcup, float x, uint16_t nMax)
             }
         }
     }
-/*Compute the ration between the Gauss-normalized associated Legendre
-   functions and the Schmidt quasi-normalized version. This is equivalent to
-   sqrt((m==0?1:2)*(n-m)!/(n+m!))*(2n-1)!!/(n-m)!  */
-
-    schmidtQuasiNorm[0] = 1.0f;
-    for (n = 1; n <= nMax; n++) {
-        index  = (n * (n + 1) / 2);
-        index1 = (n - 1) * n / 2;
-        /* for m = 0 */
-        schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * (float)(2 * n - 1) / (float)n;
-
-        for (m = 1; m <= n; m++) {
-            index  = (n * (n + 1) / 2 + m);
-            index1 = (n * (n + 1) / 2 + m - 1);
-            schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * sqrtf((float)((n - m + 1) * (m == 1 ? 2 : 1)) / (float)(n + m));
-        }
-    }
-
 /* Converts the  Gauss-normalized associated Legendre
-          functions to the Schmidt quasi-normalized version using pre-computed
-          relation stored in the variable schmidtQuasiNorm */
+          functions to the Schmidt quasi-normalized version using the relation
+          pre-computed by WMM_Initialize */
 
     for (n = 1; n <= nMax; n++) {
         for (m = 0; m <= n; m++) {
             index = (n * (n + 1) / 2 + m);
-            Pcup[index]  = Pcup[index] * schmidtQuasiNorm[index];
-            dPcup[index] = -dPcup[index] * schmidtQuasiNorm[index];
+            Pcup[index]  = Pcup[index] * Cache->SchmidtQuasiNorm[index];
+            dPcup[index] = -dPcup[index] * Cache->SchmidtQuasiNorm[index];
             /* The sign is changed since the new WMM routines use derivative with respect to latitude
                insted of co-latitude */
         }
     }
 
-    FREE(schmidtQuasiNorm);
-
     return 0; // OK
 }
 
@@ -1062,11 +1009,8 @@ int WMM_SummationSpecial(WMMtype_SphericalHarmonicVariables *
     float schmidtQuasiNorm2;
     float schmidtQuasiNorm3;
 
-    float *PcupS = (float *)MALLOC(sizeof(float) * NUMPCUPS);
+    float PcupS[NUMPCUPS];
 
-    if (!PcupS) {
-        return -1; // memory allocation error
-    }
     PcupS[0] = 1;
     schmidtQuasiNorm1   = 1.0f;
 
@@ -1096,13 +1040,11 @@ int WMM_SummationSpecial(WMMtype_SphericalHarmonicVariables *
 
         MagneticResults->By +=
             SphVariables->RelativeRadiusPower[n] *
-            (WMM_get_main_field_coeff_g(index) *
-             SphVariables->sin_mlambda[1] - WMM_get_main_field_coeff_h(index) * SphVariables->cos_mlambda[1])
+            (Cache->MainFieldCoeffG[index] *
+             SphVariables->sin_mlambda[1] - Cache->MainFieldCoeffH[index] * SphVariables->cos_mlambda[1])
             * PcupS[n] * schmidtQuasiNorm3;
     }
 
-    FREE(PcupS);
-
     return 0; // OK
 }
 
@@ -1124,11 +1066,8 @@ int WMM_SecVarSummationSpecial(WMMtype_SphericalHarmonicVariables *
     float schmidtQuasiNorm2;
     float schmidtQuasiNorm3;
 
-    float *PcupS = (float *)MALLOC(sizeof(float) * NUMPCUPS);
+    float PcupS[NUMPCUPS];
 
-    if (!PcupS) {
-        return -1; // memory allocation error
-    }
     PcupS[0] = 1;
     schmidtQuasiNorm1   = 1.0f;
 
@@ -1159,13 +1098,30 @@ int WMM_SecVarSummationSpecial(WMMtype_SphericalHarmonicVariables *
             * PcupS[n] * schmidtQuasiNorm3;
     }
 
-    FREE(PcupS);
-
     return 0; // OK
 }
 
+void WMM_Set_Coeff_Array()
+// Adjusts the main field coefficients to decimal_date with the secular variation
+// UPDATES : Cache->MainFieldCoeffG and Cache->MainFieldCoeffH
+{
+    uint16_t index, last_sv_index;
+    float dt = decimal_date - MagneticModel->epoch;
+
+    last_sv_index = (MagneticModel->nMaxSecVar * (MagneticModel->nMaxSecVar + 1) / 2 + MagneticModel->nMaxSecVar);
+    for (index = 0; index < NUMTERMS; index++) {
+        Cache->MainFieldCoeffG[index] = CoeffFile[index][2];
+        Cache->MainFieldCoeffH[index] = CoeffFile[index][3];
+        if (index > 0 && index <= last_sv_index) {
+            Cache->MainFieldCoeffG[index] += dt * WMM_get_secular_var_coeff_g(index);
+            Cache->MainFieldCoeffH[index] += dt * WMM_get_secular_var_coeff_h(index);
+        }
+    }
+    Cache->CoeffDecimalYear = decimal_date;
+}
+
 /**
- * @brief Comput the MainFieldCoeffH accounting for the date
+ * @brief Comput the MainFieldCoeffG accounting for the date
  */
 float WMM_get_main_field_coeff_g(uint16_t index)
 {
@@ -1173,28 +1129,7 @@ float WMM_get_main_field_coeff_g(uint16_t index)
         return 0;
     }
 
-    uint16_t n, m, sum_index, a, b;
-
-    float coeff = CoeffFile[index][2];
-
-    a = MagneticModel->nMaxSecVar;
-    b = (a * (a + 1) / 2 + a);
-    for (n = 1; n <= MagneticModel->nMax; n++) {
-        for (m = 0; m <= n; m++) {
-            sum_index = (n * (n + 1) / 2 + m);
-
-            /* Hacky for now, will solve for which conditions need summing analytically */
-            if (sum_index != index) {
-                continue;
-            }
-
-            if (index <= b) {
-                coeff += (decimal_date - MagneticModel->epoch) * WMM_get_secular_var_coeff_g(sum_index);
-            }
-        }
-    }
-
-    return coeff;
+    return Cache->MainFieldCoeffG[index];
 }
 
 float WMM_get_main_field_coeff_h(uint16_t index)
@@ -1203,27 +1138,7 @@ float WMM_get_main_field_coeff_h(uint16_t index)
         return 0;
     }
 
-    uint16_t n, m, sum_index, a, b;
-    float coeff = CoeffFile[index][3];
-
-    a = MagneticModel->nMaxSecVar;
-    b = (a * (a + 1) / 2 + a);
-    for (n = 1; n <= MagneticModel->nMax; n++) {
-        for (m = 0; m <= n; m++) {
-            sum_index = (n * (n + 1) / 2 + m);
-
-            /* Hacky for now, will solve for which conditions need summing analytically */
-            if (sum_index != index) {
-                continue;
-            }
-
-            if (index <= b) {
-                coeff += (decimal_date - MagneticModel->epoch) * WMM_get_secular_var_coeff_h(sum_index);
-            }
-        }
-    }
-
-    return coeff;
+    return Cache->MainFieldCoeffH[index];
 }
 
 float WMM_get_secular_var_coeff_g(uint16_t index)
@@ -1259,6 +1174,10 @@ int WMM_DateToYear(uint16_t month, uint16_t day, uint16_t year)
 
     /******************Validation********************************/
 
+    if (!Cache) {
+        return -3; // WMM_Initialize() not called
+    }
+
     if (month <= 0 || month > 12) {
         return -1; // error
     }
@@ -1273,6 +1192,10 @@ int WMM_DateToYear(uint16_t month, uint16_t day, uint16_t year)
 
     decimal_date = year + (temp - 1) / (365.0f + ExtraDay);
 
+    if (decimal_date != Cache->CoeffDecimalYear) {
+        WMM_Set_Coeff_Array();
+    }
+
     return 0; // OK
 }
 
@@ -115,6 +115,22 @@ typedef struct {
     float GVdot; /*16. Yearly rate of chnage in grid variation */
 } WMMtype_GeoMagneticElements;
 
+
+/*
+ * Model state from WMM_Initialize() to WMM_Release(). The time adjusted
+ * coefficients are only recomputed when the date changes.
+ */
+typedef struct {
+    WMMtype_Ellipsoid     Ellip;
+    WMMtype_MagneticModel MagneticModel;
+    float CoeffDecimalYear; // date the main field coefficients are valid for
+    float MainFieldCoeffG[NUMTERMS]; // time adjusted Gauss coefficients (nT)
+    float MainFieldCoeffH[NUMTERMS];
+    float SchmidtQuasiNorm[NUMPCUP]; // Gauss to Schmidt semi normalisation
+    WMMtype_LegendreFunction Legendre; // of the point being evaluated
+    WMMtype_SphericalHarmonicVariables SphVariables;
+} WMMtype_Cache;
+
 // Internal Function Prototypes
 void WMM_Set_Coeff_Array();
 int WMM_GeodeticToSpherical(WMMtype_CoordGeodetic *CoordGeodetic, WMMtype_CoordSpherical *CoordSpherical);
@@ -0,0 +1,107 @@
+/**
+ ******************************************************************************
+ *
+ * @file       latencystats.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Latency statistics
+ *             Min/mean/max and a linear histogram of microsecond durations
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <stdint.h>
+
+#define LATENCYSTATS_BUCKETS 16
+
+typedef struct {
+    uint32_t count;
+    uint32_t min; // us
+    uint32_t max; // us
+    uint64_t sum; // us
+    uint16_t bucketWidth; // us, the last bucket also holds everything above
+    uint16_t histogram[LATENCYSTATS_BUCKETS];
+} LatencyStats;
+
+/**
+ * Initialize and clear a statistics set
+ * @param stats the set
+ * @param bucketWidth histogram bucket width in us
+ */
+void LatencyStatsInit(LatencyStats *stats, uint16_t bucketWidth);
+
+/**
+ * Clear all samples, keeping the bucket width
+ */
+void LatencyStatsReset(LatencyStats *stats);
+
+/**
+ * Add a sample
+ * @param us the measured duration in microseconds
+ */
+void LatencyStatsAdd(LatencyStats *stats, uint32_t us);
+
+/**
+ * \return the mean of all samples in us, 0 without samples
+ */
+uint32_t LatencyStatsMean(const LatencyStats *stats);
+
+/**
+ * Upper bound in us of the histogram bucket holding the given percentile,
+ * never more than the largest sample
+ * @param percentile 1 to 100
+ * \return the bound, 0 without samples
+ */
+uint32_t LatencyStatsPercentile(const LatencyStats *stats, uint8_t percentile);
+
+/**
+ * Latency from a timestamped sample to the output computed from it, and
+ * its change between consecutive samples (jitter)
+ */
+typedef struct {
+    LatencyStats latency;
+    LatencyStats jitter;
+    uint32_t     lastSampleTime; // raw delay timer, 0 before the first sample
+    uint32_t     lastLatency; // us
+} LatencyTracker;
+
+/**
+ * Initialize a tracker without samples
+ * @param latencyBucketWidth latency histogram bucket width in us
+ * @param jitterBucketWidth jitter histogram bucket width in us
+ */
+void LatencyTrackerInit(LatencyTracker *tracker, uint16_t latencyBucketWidth, uint16_t jitterBucketWidth);
+
+/**
+ * Account an output computed from the sample taken at sampleTime.
+ * Samples without timestamp (0) and repeated outputs of the same sample
+ * are not counted. Both times are PIOS_DELAY_GetRaw() ticks, the latency
+ * is converted with PIOS_DELAY_DiffuS2().
+ * @param sampleTime raw time the sample was read
+ * @param now raw time the output was made
+ * \return 1 if the sample was counted, 0 otherwise
+ */
+uint8_t LatencyTrackerAdd(LatencyTracker *tracker, uint32_t sampleTime, uint32_t now);
+
+/**
+ * Clear the statistics, the last sample is kept so the next jitter is valid
+ */
+void LatencyTrackerReset(LatencyTracker *tracker);
+
+#endif /* LATENCYSTATS_H */
@@ -48,6 +48,13 @@ typedef struct {
 #define COUNT   1
 #define DATA    5
 
+/* Differential upload */
+#define DFU_CAP_SECTOR_CRC     0x01 // capability bit, Req_SectorCRC and Select_Sectors are supported
+#define DFU_SECTOR_DESCRIPTION 0x01 // sector flag, shares flash with the description and is always rewritten
+#define DFU_MAX_SECTORS        256
+#define DFU_SECTOR_ENTRIES     4 // sectors per Rep_SectorCRC packet
+#define DFU_SECTOR_ENTRY_SIZE  13
+
 /* Exported functions ------------------------------------------------------- */
 void processComand(uint8_t *Receive_Buffer);
 void DataDownload(DownloadAction);
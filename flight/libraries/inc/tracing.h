@@ -0,0 +1,37 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tracing.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Event trace infrastructure
+ *             UAVObject wrapper layer for the PiOS trace buffer
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef TRACING_H
+#define TRACING_H
+#include <tracecontrol.h>
+#include <tracedata.h>
+
+/**
+ * Initialize the trace UAVObject wrapper
+ * @return 0 on success, -1 on failure
+ */
+int32_t TracingInit();
+
+#endif /* TRACING_H */
@@ -0,0 +1,124 @@
+/**
+ ******************************************************************************
+ *
+ * @file       latencystats.c
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Latency statistics
+ *             Min/mean/max and a linear histogram of microsecond durations
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <string.h>
+#include <latencystats.h>
+#include <pios_delay.h>
+
+void LatencyStatsInit(LatencyStats *stats, uint16_t bucketWidth)
+{
+    stats->bucketWidth = bucketWidth ? bucketWidth : 1;
+    LatencyStatsReset(stats);
+}
+
+void LatencyStatsReset(LatencyStats *stats)
+{
+    stats->count = 0;
+    stats->min   = UINT32_MAX;
+    stats->max   = 0;
+    stats->sum   = 0;
+    memset(stats->histogram, 0, sizeof(stats->histogram));
+}
+
+void LatencyStatsAdd(LatencyStats *stats, uint32_t us)
+{
+    uint32_t bucket = us / stats->bucketWidth;
+
+    if (bucket >= LATENCYSTATS_BUCKETS) {
+        bucket = LATENCYSTATS_BUCKETS - 1;
+    }
+    // saturate rather than wrap, the shape stays meaningful
+    if (stats->histogram[bucket] < UINT16_MAX) {
+        stats->histogram[bucket]++;
+    }
+    if (us < stats->min) {
+        stats->min = us;
+    }
+    if (us > stats->max) {
+        stats->max = us;
+    }
+    stats->sum += us;
+    stats->count++;
+}
+
+uint32_t LatencyStatsMean(const LatencyStats *stats)
+{
+    return stats->count ? (uint32_t)(stats->sum / stats->count) : 0;
+}
+
+uint32_t LatencyStatsPercentile(const LatencyStats *stats, uint8_t percentile)
+{
+    uint32_t total = 0;
+
+    for (uint8_t t = 0; t < LATENCYSTATS_BUCKETS; t++) {
+        total += stats->histogram[t];
+    }
+    if (!total) {
+        return 0;
+    }
+
+    uint32_t threshold = (total * percentile + 99) / 100;
+    uint32_t count     = 0;
+    for (uint8_t t = 0; t < LATENCYSTATS_BUCKETS - 1; t++) {
+        count += stats->histogram[t];
+        if (count >= threshold) {
+            uint32_t bound = (uint32_t)(t + 1) * stats->bucketWidth;
+            return bound < stats->max ? bound : stats->max;
+        }
+    }
+    return stats->max;
+}
+
+void LatencyTrackerInit(LatencyTracker *tracker, uint16_t latencyBucketWidth, uint16_t jitterBucketWidth)
+{
+    LatencyStatsInit(&tracker->latency, latencyBucketWidth);
+    LatencyStatsInit(&tracker->jitter, jitterBucketWidth);
+    tracker->lastSampleTime = 0;
+    tracker->lastLatency    = 0;
+}
+
+uint8_t LatencyTrackerAdd(LatencyTracker *tracker, uint32_t sampleTime, uint32_t now)
+{
+    if (!sampleTime || sampleTime == tracker->lastSampleTime) {
+        return 0;
+    }
+
+    // raw ticks, on F4 the us clock wraps with the cycle counter every 25.5 s
+    uint32_t latency = PIOS_DELAY_DiffuS2(sampleTime, now);
+    if (tracker->lastSampleTime) {
+        LatencyStatsAdd(&tracker->jitter, latency > tracker->lastLatency ? latency - tracker->lastLatency : tracker->lastLatency - latency);
+    }
+    LatencyStatsAdd(&tracker->latency, latency);
+    tracker->lastSampleTime = sampleTime;
+    tracker->lastLatency    = latency;
+    return 1;
+}
+
+void LatencyTrackerReset(LatencyTracker *tracker)
+{
+    LatencyStatsReset(&tracker->latency);
+    LatencyStatsReset(&tracker->jitter);
+}
@@ -8,6 +8,7 @@
  * @file       butterworth.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
  * @brief      Direct form two of a second order Butterworth low pass filter
+ *             and of general biquads
  *
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -98,3 +99,82 @@ float FilterButterWorthDF2(const float xn, const struct ButterWorthDF2Filter *fi
     *wn1Ptr = wn;
     return val;
 }
+
+
+/**
+ * Initialization function for a second order Butterworth low pass filter as a general biquad.
+ * @param[in]  ff Cut-off frequency ratio
+ * @param[out] filterPtr Pointer to filter coefficients
+ * @returns Nothing
+ */
+void InitBiquadDF2Lowpass(const float ff, struct BiquadDF2Filter *filterPtr)
+{
+    struct ButterWorthDF2Filter butterworth;
+
+    InitButterWorthDF2Filter(ff, &butterworth);
+    filterPtr->b0 = butterworth.b0;
+    filterPtr->b1 = 2.0f * butterworth.b0;
+    filterPtr->b2 = butterworth.b0;
+    filterPtr->a1 = butterworth.a1;
+    filterPtr->a2 = butterworth.a2;
+}
+
+
+/**
+ * Initialization function for coefficients of a second order notch filter with unity gain away from the notch.
+ * @param[in]  ff Notch frequency ratio
+ * @param[in]  q Quality factor, notch frequency over -3dB bandwidth
+ * @param[out] filterPtr Pointer to filter coefficients
+ * @returns Nothing
+ */
+void InitBiquadDF2Notch(const float ff, const float q, struct BiquadDF2Filter *filterPtr)
+{
+    const float omega = 2.0f * M_PI_F * ff;
+    const float cs    = cosf(omega);
+    const float alpha = sinf(omega) / (2.0f * q);
+    const float a0inv = 1.0f / (1.0f + alpha);
+
+    filterPtr->b0 = a0inv;
+    filterPtr->b1 = -2.0f * cs * a0inv;
+    filterPtr->b2 = a0inv;
+    filterPtr->a1 = 2.0f * cs * a0inv;
+    filterPtr->a2 = -(1.0f - alpha) * a0inv;
+}
+
+
+/**
+ * Initialization function for intermediate values of a general biquad, such that a constant
+ * input x0 gives a constant output from the first sample on.
+ * @param[in]  x0 Prescribed value
+ * @param[in]  filterPtr Pointer to filter coefficients
+ * @param[out] wn1Ptr Pointer to first intermediate value
+ * @param[out] wn2Ptr Pointer to second intermediate value
+ * @returns Nothing
+ */
+void InitBiquadDF2Values(const float x0, const struct BiquadDF2Filter *filterPtr, float *wn1Ptr, float *wn2Ptr)
+{
+    const float wn = x0 / (1.0f - filterPtr->a1 - filterPtr->a2);
+
+    *wn1Ptr = wn;
+    *wn2Ptr = wn;
+}
+
+
+/**
+ * General biquadratic filter in direct form 2.
+ * Function takes care of updating the values wn1 and wn2.
+ * @param[in]  xn New raw value
+ * @param[in]  filterPtr Pointer to filter coefficients
+ * @param[out] wn1Ptr Pointer to first intermediate value
+ * @param[out] wn2Ptr Pointer to second intermediate value
+ * @returns Filtered value
+ */
+float FilterBiquadDF2(const float xn, const struct BiquadDF2Filter *filterPtr, float *wn1Ptr, float *wn2Ptr)
+{
+    const float wn  = xn + filterPtr->a1 * (*wn1Ptr) + filterPtr->a2 * (*wn2Ptr);
+    const float val = filterPtr->b0 * wn + filterPtr->b1 * (*wn1Ptr) + filterPtr->b2 * (*wn2Ptr);
+
+    *wn2Ptr = *wn1Ptr;
+    *wn1Ptr = wn;
+    return val;
+}
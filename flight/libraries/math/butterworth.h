@@ -8,6 +8,7 @@
  * @file       butterworth.h
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
  * @brief      Direct form two of a second order Butterworth low pass filter
+ *             and of general biquads
  *
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -38,9 +39,23 @@ struct ButterWorthDF2Filter {
     float a2;
 };
 
+// Coefficients of a general biquadratic filter in direct form 2, a1 and a2 with the same sign as above
+struct BiquadDF2Filter {
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+};
+
 // Function declarations
 void InitButterWorthDF2Filter(const float ff, struct ButterWorthDF2Filter *filterPtr);
 void InitButterWorthDF2Values(const float x0, const struct ButterWorthDF2Filter *filterPtr, float *wn1Ptr, float *wn2Ptr);
 float FilterButterWorthDF2(const float xn, const struct ButterWorthDF2Filter *filterPtr, float *wn1Ptr, float *wn2Ptr);
 
+void InitBiquadDF2Lowpass(const float ff, struct BiquadDF2Filter *filterPtr);
+void InitBiquadDF2Notch(const float ff, const float q, struct BiquadDF2Filter *filterPtr);
+void InitBiquadDF2Values(const float x0, const struct BiquadDF2Filter *filterPtr, float *wn1Ptr, float *wn2Ptr);
+float FilterBiquadDF2(const float xn, const struct BiquadDF2Filter *filterPtr, float *wn1Ptr, float *wn2Ptr);
+
 #endif
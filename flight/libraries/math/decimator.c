@@ -0,0 +1,140 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Decimation filter for oversampled 3 axis sensors
+ * @{
+ *
+ * @file       decimator.c
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      CIC decimator followed by a biquad cascade at the decimated rate
+ *
+ *             The CIC (cascaded integrator comb) stage needs no multiplies and
+ *             puts its zeros on all multiples of the output rate, so everything
+ *             that would alias onto low frequencies is suppressed before the
+ *             rate drops. The biquads then shape the passband at the lower rate.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <string.h>
+#include "decimator.h"
+
+bool DecimatorInit(struct Decimator *d, uint8_t order, uint8_t ratio)
+{
+    uint32_t gain = 1;
+
+    if (order < 1 || order > DECIMATOR_MAX_ORDER || ratio < 1) {
+        return false;
+    }
+    for (uint8_t i = 0; i < order; i++) {
+        gain *= ratio;
+    }
+    if (gain > DECIMATOR_MAX_GAIN) {
+        return false;
+    }
+
+    memset(d, 0, sizeof(*d));
+    d->order = order;
+    d->ratio = ratio;
+    d->gain  = 1.0f / (float)gain;
+    DecimatorReset(d);
+    return true;
+}
+
+bool DecimatorAddBiquad(struct Decimator *d, const struct BiquadDF2Filter *biquad)
+{
+    if (d->num_biquads >= DECIMATOR_MAX_BIQUADS) {
+        return false;
+    }
+    d->biquad[d->num_biquads++] = *biquad;
+    return true;
+}
+
+void DecimatorReset(struct Decimator *d)
+{
+    memset(d->integrator, 0, sizeof(d->integrator));
+    memset(d->comb, 0, sizeof(d->comb));
+    d->phase  = 0;
+    // each comb needs one output of history before the CIC output is valid
+    d->warmup = d->order;
+}
+
+bool DecimatorPush(struct Decimator *d, const Vector3i16 *sample)
+{
+    const int16_t in[3] = { sample->x, sample->y, sample->z };
+    const uint8_t order = d->order;
+
+    // integrators at the input rate, wrapping is harmless as the combs undo it
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        uint32_t acc = (uint32_t)(int32_t)in[axis];
+        for (uint8_t i = 0; i < order; i++) {
+            d->integrator[axis][i] += acc;
+            acc = d->integrator[axis][i];
+        }
+    }
+
+    if (++d->phase < d->ratio) {
+        return false;
+    }
+    d->phase = 0;
+
+    // combs at the output rate
+    float out[3];
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        uint32_t acc = d->integrator[axis][order - 1];
+        for (uint8_t i = 0; i < order; i++) {
+            uint32_t prev = d->comb[axis][i];
+            d->comb[axis][i] = acc;
+            acc -= prev;
+        }
+        out[axis] = (float)(int32_t)acc * d->gain;
+    }
+
+    if (d->warmup) {
+        if (--d->warmup) {
+            return false;
+        }
+        // start the biquads settled on the first valid sample
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            for (uint8_t i = 0; i < d->num_biquads; i++) {
+                InitBiquadDF2Values(out[axis], &d->biquad[i], &d->wn[axis][i][0], &d->wn[axis][i][1]);
+            }
+        }
+    }
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        for (uint8_t i = 0; i < d->num_biquads; i++) {
+            out[axis] = FilterBiquadDF2(out[axis], &d->biquad[i], &d->wn[axis][i][0], &d->wn[axis][i][1]);
+        }
+    }
+    d->output.x = out[0];
+    d->output.y = out[1];
+    d->output.z = out[2];
+    return true;
+}
+
+bool DecimatorGet(struct Decimator *d, Vector3f *output)
+{
+    if (d->warmup) {
+        return false;
+    }
+    *output = d->output;
+    return true;
+}
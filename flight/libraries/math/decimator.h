@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Decimation filter for oversampled 3 axis sensors
+ * @{
+ *
+ * @file       decimator.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      CIC decimator followed by a biquad cascade at the decimated rate
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vectors.h>
+#include "butterworth.h"
+
+#define DECIMATOR_MAX_ORDER   3
+#define DECIMATOR_MAX_BIQUADS 2
+
+/*
+ * The CIC stage runs in wrapping 32 bit integer arithmetic on 16 bit samples,
+ * which is exact as long as the gain ratio^order stays below 2^16.
+ */
+#define DECIMATOR_MAX_GAIN    65536
+
+struct Decimator {
+    uint8_t  order; // CIC order, 1 is a plain moving average
+    uint8_t  ratio; // CIC decimation ratio
+    uint8_t  phase; // input samples since the last CIC output
+    uint8_t  num_biquads;
+    uint8_t  warmup; // CIC outputs still to discard after a reset
+    float    gain; // 1 / ratio^order
+    uint32_t integrator[3][DECIMATOR_MAX_ORDER];
+    uint32_t comb[3][DECIMATOR_MAX_ORDER];
+    struct BiquadDF2Filter biquad[DECIMATOR_MAX_BIQUADS];
+    float    wn[3][DECIMATOR_MAX_BIQUADS][2];
+    Vector3f output;
+};
+
+/**
+ * Set up a decimator without biquads.
+ * @param[out] d the decimator
+ * @param[in] order CIC order, 1 to DECIMATOR_MAX_ORDER
+ * @param[in] ratio CIC decimation ratio, at least 1
+ * @returns false if order and ratio are out of range
+ */
+bool DecimatorInit(struct Decimator *d, uint8_t order, uint8_t ratio);
+
+/**
+ * Append a biquad to the cascade that filters the CIC output.
+ * Frequencies of the biquad are relative to the CIC output rate.
+ * @returns false if the cascade is full
+ */
+bool DecimatorAddBiquad(struct Decimator *d, const struct BiquadDF2Filter *biquad);
+
+/**
+ * Clear the filter state, the next outputs settle on the incoming samples.
+ */
+void DecimatorReset(struct Decimator *d);
+
+/**
+ * Feed one raw sample at the input rate.
+ * @returns true if the sample completed a decimated output
+ */
+bool DecimatorPush(struct Decimator *d, const Vector3i16 *sample);
+
+/**
+ * Latest decimated output in raw sensor units.
+ * @returns false while the filter is still settling after a reset
+ */
+bool DecimatorGet(struct Decimator *d, Vector3f *output);
+
+/**
+ * Group delay of the CIC stage at low frequencies, in input samples.
+ */
+static inline float DecimatorCICDelay(const struct Decimator *d)
+{
+    return 0.5f * d->order * (d->ratio - 1);
+}
+
+#endif /* DECIMATOR_H */
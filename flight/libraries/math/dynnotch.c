@@ -0,0 +1,229 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Dynamic notch filter bank for 3 axis sensors
+ * @{
+ *
+ * @file       dynnotch.c
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Goertzel peak tracker steering a set of biquad notches
+ *
+ *             Each axis runs a bank of Goertzel filters over Hann windowed
+ *             blocks of samples, which costs one multiply-add per bin and sample
+ *             instead of a full FFT. Interleaved windows (DYNNOTCH_OVERLAP)
+ *             deliver a new spectrum more often than once per window. The bank
+ *             sees the first difference of the input so that manoeuvres do not
+ *             leak into the tracked range. The strongest local maxima of each
+ *             spectrum are located to a fraction of a bin and the notches
+ *             follow them.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <string.h>
+#include <pios_math.h>
+#include <mathmisc.h>
+#include "dynnotch.h"
+
+// a peak must stand this far above the mean power of its axis to be tracked
+#define DYNNOTCH_PEAK_RATIO   3.0f
+// an active notch follows a peak found within this many bins of it
+#define DYNNOTCH_CAPTURE_BINS 2.0f
+
+static float window[DYNNOTCH_WINDOW];
+static bool window_ready;
+
+bool DynNotchInit(struct DynNotch *dn, float sample_rate, float min_hz, float max_hz, uint8_t num_notches, float q, float min_amplitude)
+{
+    if (!(sample_rate > 0.0f) || !(min_hz > 0.0f) || !(max_hz > min_hz) || !(max_hz < 0.5f * sample_rate)
+        || num_notches < 1 || num_notches > DYNNOTCH_MAX_NOTCHES || !(q > 0.0f) || !(min_amplitude >= 0.0f)) {
+        return false;
+    }
+
+    if (!window_ready) {
+        for (uint8_t n = 0; n < DYNNOTCH_WINDOW; n++) {
+            window[n] = 0.5f - 0.5f * cosf(2.0f * M_PI_F * n / DYNNOTCH_WINDOW);
+        }
+        window_ready = true;
+    }
+
+    memset(dn, 0, sizeof(*dn));
+    dn->sample_rate = sample_rate;
+    dn->min_ff      = min_hz / sample_rate;
+    dn->bin_ff      = (max_hz - min_hz) / (sample_rate * (DYNNOTCH_BINS - 1));
+    dn->q = q;
+    dn->num_notches = num_notches;
+    for (uint8_t i = 0; i < DYNNOTCH_BINS; i++) {
+        const float omega = 2.0f * M_PI_F * (dn->min_ff + i * dn->bin_ff);
+        dn->coeff[i] = 2.0f * cosf(omega);
+        // a centred tone of amplitude a peaks at a * window sum / 2, times the gain of the difference
+        const float peak = min_amplitude * (DYNNOTCH_WINDOW / 4) * 2.0f * sinf(0.5f * omega);
+        dn->floor[i] = peak * peak;
+    }
+    return true;
+}
+
+void DynNotchReset(struct DynNotch *dn)
+{
+    memset(dn->s, 0, sizeof(dn->s));
+    memset(dn->center, 0, sizeof(dn->center));
+    memset(dn->wn, 0, sizeof(dn->wn));
+    dn->count  = 0;
+    dn->primed = false;
+}
+
+/**
+ * Close a Goertzel window of one axis and move its notches onto the strongest peaks.
+ * @param[in,out] s state of the window, cleared for the next one
+ * @param[in] x current input of the axis, to settle newly activated notches on
+ */
+static void retune(struct DynNotch *dn, float (*s)[2], uint8_t axis, float x)
+{
+    float power[DYNNOTCH_BINS];
+    float mean = 0.0f;
+
+    for (uint8_t i = 0; i < DYNNOTCH_BINS; i++) {
+        float s1 = s[i][0];
+        float s2 = s[i][1];
+        power[i] = s1 * s1 + s2 * s2 - dn->coeff[i] * s1 * s2;
+        mean    += power[i];
+        s[i][0]  = 0.0f;
+        s[i][1]  = 0.0f;
+    }
+    mean *= 1.0f / DYNNOTCH_BINS;
+
+    // strongest interior maxima, sorted by power
+    float peak_hz[DYNNOTCH_MAX_NOTCHES];
+    float peak_power[DYNNOTCH_MAX_NOTCHES];
+    uint8_t found = 0;
+    for (uint8_t i = 1; i < DYNNOTCH_BINS - 1; i++) {
+        const float p = power[i];
+        if (p <= power[i - 1] || p < power[i + 1] || p < DYNNOTCH_PEAK_RATIO * mean || p < dn->floor[i]) {
+            continue;
+        }
+
+        // a Hann main lobe is close to a gaussian, so a parabola through the log powers finds its centre
+        float lm    = logf(power[i - 1] + 1e-12f);
+        float l0    = logf(p + 1e-12f);
+        float lp    = logf(power[i + 1] + 1e-12f);
+        float denom = lm - 2.0f * l0 + lp;
+        float delta = denom < 0.0f ? boundf(0.5f * (lm - lp) / denom, -0.5f, 0.5f) : 0.0f;
+        float hz    = (dn->min_ff + (i + delta) * dn->bin_ff) * dn->sample_rate;
+
+        uint8_t j   = found < dn->num_notches ? found++ : dn->num_notches;
+        while (j > 0 && peak_power[j - 1] < p) {
+            if (j < dn->num_notches) {
+                peak_power[j] = peak_power[j - 1];
+                peak_hz[j]    = peak_hz[j - 1];
+            }
+            j--;
+        }
+        if (j < dn->num_notches) {
+            peak_power[j] = p;
+            peak_hz[j]    = hz;
+        }
+    }
+
+    // strongest peaks pick their notch first: the nearest active one in range, else an idle one, else the nearest
+    const float capture = DYNNOTCH_CAPTURE_BINS * dn->bin_ff * dn->sample_rate;
+    float *center = dn->center[axis];
+    bool used[DYNNOTCH_MAX_NOTCHES] = { false };
+    for (uint8_t k = 0; k < found; k++) {
+        int8_t slot = -1;
+        float best  = capture;
+        for (uint8_t m = 0; m < dn->num_notches; m++) {
+            if (!used[m] && center[m] > 0.0f && fabsf(center[m] - peak_hz[k]) < best) {
+                best = fabsf(center[m] - peak_hz[k]);
+                slot = m;
+            }
+        }
+        for (uint8_t m = 0; slot < 0 && m < dn->num_notches; m++) {
+            if (!used[m] && center[m] == 0.0f) {
+                slot = m;
+            }
+        }
+        best = INFINITY;
+        for (uint8_t m = 0; slot < 0 && m < dn->num_notches; m++) {
+            if (!used[m] && fabsf(center[m] - peak_hz[k]) < best) {
+                best = fabsf(center[m] - peak_hz[k]);
+                slot = m;
+            }
+        }
+        used[slot] = true;
+
+        // the overlapping windows already average, smoothing the estimates would only add lag
+        struct BiquadDF2Filter *notch = &dn->notch[axis][slot];
+        bool idle = center[slot] == 0.0f;
+        center[slot] = peak_hz[k];
+        InitBiquadDF2Notch(center[slot] / dn->sample_rate, dn->q, notch);
+        if (idle) {
+            InitBiquadDF2Values(x, notch, &dn->wn[axis][slot][0], &dn->wn[axis][slot][1]);
+        }
+    }
+}
+
+void DynNotchApply(struct DynNotch *dn, Vector3f *sample)
+{
+    float x[3] = { sample->x, sample->y, sample->z };
+
+    if (!dn->primed) {
+        // no jump from zero into the first difference
+        dn->last[0] = x[0];
+        dn->last[1] = x[1];
+        dn->last[2] = x[2];
+        dn->primed  = true;
+    }
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        const float dx = x[axis] - dn->last[axis];
+        dn->last[axis] = x[axis];
+        for (uint8_t k = 0; k < DYNNOTCH_OVERLAP; k++) {
+            const float xw = dx * window[(dn->count + k * (DYNNOTCH_WINDOW / DYNNOTCH_OVERLAP)) % DYNNOTCH_WINDOW];
+            float (*s)[2]  = dn->s[k][axis];
+            for (uint8_t i = 0; i < DYNNOTCH_BINS; i++) {
+                float s0 = xw + dn->coeff[i] * s[i][0] - s[i][1];
+                s[i][1] = s[i][0];
+                s[i][0] = s0;
+            }
+        }
+    }
+
+    // window k ends when count + k * WINDOW / OVERLAP wraps
+    dn->count = (dn->count + 1) % DYNNOTCH_WINDOW;
+    if (dn->count % (DYNNOTCH_WINDOW / DYNNOTCH_OVERLAP) == 0) {
+        const uint8_t k = (DYNNOTCH_OVERLAP - dn->count / (DYNNOTCH_WINDOW / DYNNOTCH_OVERLAP)) % DYNNOTCH_OVERLAP;
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            retune(dn, dn->s[k][axis], axis, x[axis]);
+        }
+    }
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        for (uint8_t m = 0; m < dn->num_notches; m++) {
+            if (dn->center[axis][m] > 0.0f) {
+                x[axis] = FilterBiquadDF2(x[axis], &dn->notch[axis][m], &dn->wn[axis][m][0], &dn->wn[axis][m][1]);
+            }
+        }
+    }
+
+    sample->x = x[0];
+    sample->y = x[1];
+    sample->z = x[2];
+}
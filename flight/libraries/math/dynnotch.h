@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Dynamic notch filter bank for 3 axis sensors
+ * @{
+ *
+ * @file       dynnotch.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Goertzel peak tracker steering a set of biquad notches
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef DYNNOTCH_H
+#define DYNNOTCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vectors.h>
+#include "butterworth.h"
+
+#define DYNNOTCH_BINS        16 // Goertzel bins spread evenly over the tracked range
+#define DYNNOTCH_WINDOW      64 // samples per spectrum estimate
+#define DYNNOTCH_OVERLAP     2 // interleaved windows, a new estimate every DYNNOTCH_WINDOW / DYNNOTCH_OVERLAP samples
+#define DYNNOTCH_MAX_NOTCHES 3
+
+struct DynNotch {
+    float   sample_rate;
+    float   min_ff; // normalised frequency of the first bin
+    float   bin_ff; // normalised bin spacing
+    float   q;
+    uint8_t num_notches;
+    uint8_t count; // samples in the oldest open window
+    bool    primed; // last holds a sample
+    float   coeff[DYNNOTCH_BINS]; // 2 cos(w) of each bin
+    float   floor[DYNNOTCH_BINS]; // power of a min_amplitude tone in each bin
+    float   last[3]; // previous input, the tracker sees the first difference
+    float   s[DYNNOTCH_OVERLAP][3][DYNNOTCH_BINS][2]; // Goertzel state of each open window
+    float   center[3][DYNNOTCH_MAX_NOTCHES]; // tracked frequency in Hz, 0 while idle
+    struct BiquadDF2Filter notch[3][DYNNOTCH_MAX_NOTCHES];
+    float   wn[3][DYNNOTCH_MAX_NOTCHES][2];
+};
+
+/**
+ * Set up the tracker over [min_hz, max_hz], all notches idle.
+ * @param[out] dn the filter bank
+ * @param[in] sample_rate rate of the samples passed to DynNotchApply(), in Hz
+ * @param[in] min_hz lowest frequency to track
+ * @param[in] max_hz highest frequency to track, below half the sample rate
+ * @param[in] num_notches notches per axis, 1 to DYNNOTCH_MAX_NOTCHES
+ * @param[in] q quality factor of the notches
+ * @param[in] min_amplitude smallest tone worth a notch, in sample units
+ * @returns false if the parameters are out of range
+ */
+bool DynNotchInit(struct DynNotch *dn, float sample_rate, float min_hz, float max_hz, uint8_t num_notches, float q, float min_amplitude);
+
+/**
+ * Forget the tracked peaks and the filter state.
+ */
+void DynNotchReset(struct DynNotch *dn);
+
+/**
+ * Feed one sample to the tracker and pass it through the active notches.
+ * Whenever a window completes the strongest peaks of each axis retune the notches.
+ * @param[in,out] sample unfiltered on input, filtered on output
+ */
+void DynNotchApply(struct DynNotch *dn, Vector3f *sample);
+
+/**
+ * Centre frequency of a notch in Hz, 0 if no peak has been found for it yet.
+ */
+static inline float DynNotchFrequency(const struct DynNotch *dn, uint8_t axis, uint8_t notch)
+{
+    return dn->center[axis][notch];
+}
+
+#endif /* DYNNOTCH_H */
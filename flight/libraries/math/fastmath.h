@@ -0,0 +1,178 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Fast polynomial approximations of libm functions
+ * @{
+ *
+ * @file       fastmath.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Polynomial sin/cos/atan2/asin for hot loops
+ *
+ *             Branch light single precision approximations after Cephes,
+ *             meant to replace libm calls in attitude and navigation code.
+ *             The bounds below are the maximum absolute error found by the
+ *             sweeps in flight/tests/math. Square roots are left to the
+ *             FPU, see fast_invsqrtf() in mathmisc.h for the estimate.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+#include <math.h>
+#include <pios_math.h>
+
+/* pi/2 split in a part exact in float and the remainder (Cody-Waite) */
+#define FASTMATH_PI_2_HI 1.5703125f
+#define FASTMATH_PI_2_LO 4.83826794896619e-4f
+
+/**
+ * sin(x) and cos(x) together, for |x| <= 1000 rad.
+ * Max error 1e-7.
+ */
+static inline void fast_sincosf(float x, float *s, float *c)
+{
+    // reduce to r in [-pi/4, pi/4] and the quadrant
+    int quadrant = (int32_t)(x * M_2_PI_F + (x >= 0.0f ? 0.5f : -0.5f));
+    float r  = (x - (float)quadrant * FASTMATH_PI_2_HI) - (float)quadrant * FASTMATH_PI_2_LO;
+    float z  = r * r;
+
+    float sr = r + r * z * ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f);
+    float cr = 1.0f - 0.5f * z + z * z * ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f);
+
+    switch (quadrant & 3) {
+    case 0:
+        *s = sr;
+        *c = cr;
+        break;
+    case 1:
+        *s = cr;
+        *c = -sr;
+        break;
+    case 2:
+        *s = -sr;
+        *c = -cr;
+        break;
+    default:
+        *s = -cr;
+        *c = sr;
+        break;
+    }
+}
+
+/**
+ * sin(x), same bounds as fast_sincosf()
+ */
+static inline float fast_sinf(float x)
+{
+    float s, c;
+
+    fast_sincosf(x, &s, &c);
+    return s;
+}
+
+/**
+ * cos(x), same bounds as fast_sincosf()
+ */
+static inline float fast_cosf(float x)
+{
+    float s, c;
+
+    fast_sincosf(x, &s, &c);
+    return c;
+}
+
+/* atan(x) for x in [-tan(pi/8), tan(pi/8)] */
+static inline float fast_atan_poly(float x)
+{
+    float z = x * x;
+
+    return x + x * z * (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f);
+}
+
+/**
+ * atan2(y, x) in [-pi, pi], 0 for (0, 0).
+ * Max error 3e-7 rad.
+ */
+static inline float fast_atan2f(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float angle;
+
+    if (ax == 0.0f && ay == 0.0f) {
+        return 0.0f;
+    }
+
+    // first octant: atan of the ratio <= 1, folded onto +-tan(pi/8) around 0 or pi/4
+    if (ay <= ax) {
+        float t = ay / ax;
+        if (t > 0.41421356f) {
+            angle = M_PI_4_F + fast_atan_poly((ay - ax) / (ay + ax));
+        } else {
+            angle = fast_atan_poly(t);
+        }
+    } else {
+        float t = ax / ay;
+        if (t > 0.41421356f) {
+            angle = M_PI_4_F - fast_atan_poly((ax - ay) / (ax + ay));
+        } else {
+            angle = M_PI_2_F - fast_atan_poly(t);
+        }
+    }
+
+    if (x < 0.0f) {
+        angle = M_PI_F - angle;
+    }
+    return y < 0.0f ? -angle : angle;
+}
+
+/**
+ * asin(x), x clamped to [-1, 1] instead of returning NaN for rounding
+ * overshoots. Max error 2e-7 rad.
+ */
+static inline float fast_asinf(float x)
+{
+    float a = fabsf(x);
+    float z, r;
+
+    if (a >= 1.0f) {
+        return x > 0.0f ? M_PI_2_F : -M_PI_2_F;
+    }
+
+    // asin(a) = pi/2 - 2 asin(sqrt((1 - a) / 2)) keeps the polynomial argument <= 0.5
+    if (a > 0.5f) {
+        z = 0.5f * (1.0f - a);
+        r = sqrtf(z);
+    } else {
+        z = a * a;
+        r = a;
+    }
+
+    r += r * z * ((((4.2163199048e-2f * z + 2.4181311049e-2f) * z + 4.5470025998e-2f) * z + 7.4953002686e-2f) * z + 1.6666752422e-1f);
+
+    if (a > 0.5f) {
+        r = M_PI_2_F - 2.0f * r;
+    }
+    return x < 0.0f ? -r : r;
+}
+
+#endif /* FASTMATH_H */
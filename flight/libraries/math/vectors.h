@@ -60,4 +60,141 @@ DECLAREVECTOR2(u16, uint16_t);
 DECLAREVECTOR2(u32, uint32_t);
 DECLAREVECTOR2(f, float);
 
+/*
+ * Single precision fused multiply-add, one VFMA on FPU targets,
+ * plain multiply and add where the hardware has none.
+ */
+#if defined(__ARM_FEATURE_FMA)
+#define VECTOR_FMAF(a, b, c) __builtin_fmaf((a), (b), (c))
+#else
+#define VECTOR_FMAF(a, b, c) ((a) * (b) + (c))
+#endif
+
+/**
+ * out = R * v
+ * @param[in] R a three by three matrix (first index is row)
+ * @param[in] v the source vector
+ * @param[out] out the output vector, must not alias v
+ */
+static inline void vector3_rotatef(const float R[3][3], const float v[3], float out[3])
+{
+    out[0] = VECTOR_FMAF(R[0][2], v[2], VECTOR_FMAF(R[0][1], v[1], R[0][0] * v[0]));
+    out[1] = VECTOR_FMAF(R[1][2], v[2], VECTOR_FMAF(R[1][1], v[1], R[1][0] * v[0]));
+    out[2] = VECTOR_FMAF(R[2][2], v[2], VECTOR_FMAF(R[2][1], v[1], R[2][0] * v[0]));
+}
+
+/**
+ * out = R' * v, the inverse rotation for an orthonormal R
+ */
+static inline void vector3_rotate_transposedf(const float R[3][3], const float v[3], float out[3])
+{
+    out[0] = VECTOR_FMAF(R[2][0], v[2], VECTOR_FMAF(R[1][0], v[1], R[0][0] * v[0]));
+    out[1] = VECTOR_FMAF(R[2][1], v[2], VECTOR_FMAF(R[1][1], v[1], R[0][1] * v[0]));
+    out[2] = VECTOR_FMAF(R[2][2], v[2], VECTOR_FMAF(R[1][2], v[1], R[0][2] * v[0]));
+}
+
+/**
+ * out = Quaternion2R(q) * v for a unit quaternion, without building the matrix
+ * (15 multiplies instead of 13 for the matrix and 9 to apply it)
+ * @param[in] q unit quaternion, rotation from e to b
+ * @param[in] v vector in e
+ * @param[out] out vector in b, must not alias v
+ */
+static inline void quat_rotatef(const float q[4], const float v[3], float out[3])
+{
+    // t = 2 v x q(1:3), out = v + q0 t + t x q(1:3)
+    const float t[3] = { 2.0f * (v[1] * q[3] - v[2] * q[2]),
+                         2.0f * (v[2] * q[1] - v[0] * q[3]),
+                         2.0f * (v[0] * q[2] - v[1] * q[1]) };
+
+    out[0] = VECTOR_FMAF(q[0], t[0], v[0]) + (t[1] * q[3] - t[2] * q[2]);
+    out[1] = VECTOR_FMAF(q[0], t[1], v[1]) + (t[2] * q[1] - t[0] * q[3]);
+    out[2] = VECTOR_FMAF(q[0], t[2], v[2]) + (t[0] * q[2] - t[1] * q[1]);
+}
+
+/*
+ * Affine sensor calibration out = M * v + b. Per axis scale, bias and the
+ * board rotation are folded into M and b once, when they change, so that
+ * applying it costs nine multiply-adds per sample.
+ */
+typedef struct {
+    float M[3][3];
+    float b[3];
+} Vector3Transformf;
+
+/**
+ * Build the transform out = R * (scale .* v - offset)
+ * @param[out] t the transform
+ * @param[in] R rotation (or any matrix) applied after scaling, NULL for identity
+ * @param[in] scale per axis scale, NULL for unity
+ * @param[in] offset per axis offset subtracted after scaling, NULL for none
+ */
+static inline void vector3_transform_setf(Vector3Transformf *t, const float R[3][3], const float scale[3], const float offset[3])
+{
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            t->M[i][j] = (R ? R[i][j] : (i == j ? 1.0f : 0.0f)) * (scale ? scale[j] : 1.0f);
+        }
+    }
+    if (offset) {
+        float b[3];
+        if (R) {
+            vector3_rotatef(R, offset, b);
+        } else {
+            b[0] = offset[0];
+            b[1] = offset[1];
+            b[2] = offset[2];
+        }
+        t->b[0] = -b[0];
+        t->b[1] = -b[1];
+        t->b[2] = -b[2];
+    } else {
+        t->b[0] = t->b[1] = t->b[2] = 0.0f;
+    }
+}
+
+/**
+ * Apply a transform to a batch of raw integer vectors, out[n] = M * (k * in[n]) + b.
+ * k carries the sensor scale and the averaging of accumulated samples.
+ * @param[in] t the transform
+ * @param[in] k scalar gain applied to the raw vectors
+ * @param[in] in raw vectors
+ * @param[out] out calibrated vectors
+ * @param[in] count number of vectors
+ */
+static inline void vector3_transform_i32f(const Vector3Transformf *t, float k, const Vector3i32 *in, Vector3f *out, uint32_t count)
+{
+    // scaling M once per batch keeps the per sample work at nine multiply-adds
+    const float m00 = t->M[0][0] * k, m01 = t->M[0][1] * k, m02 = t->M[0][2] * k;
+    const float m10 = t->M[1][0] * k, m11 = t->M[1][1] * k, m12 = t->M[1][2] * k;
+    const float m20 = t->M[2][0] * k, m21 = t->M[2][1] * k, m22 = t->M[2][2] * k;
+
+    for (uint32_t n = 0; n < count; n++) {
+        const float x = (float)in[n].x;
+        const float y = (float)in[n].y;
+        const float z = (float)in[n].z;
+
+        out[n].x = VECTOR_FMAF(m02, z, VECTOR_FMAF(m01, y, VECTOR_FMAF(m00, x, t->b[0])));
+        out[n].y = VECTOR_FMAF(m12, z, VECTOR_FMAF(m11, y, VECTOR_FMAF(m10, x, t->b[1])));
+        out[n].z = VECTOR_FMAF(m22, z, VECTOR_FMAF(m21, y, VECTOR_FMAF(m20, x, t->b[2])));
+    }
+}
+
+/**
+ * Apply a transform to a batch of float vectors, out[n] = M * in[n] + b.
+ * out may alias in.
+ */
+static inline void vector3_transformf(const Vector3Transformf *t, const Vector3f *in, Vector3f *out, uint32_t count)
+{
+    for (uint32_t n = 0; n < count; n++) {
+        const float x = in[n].x;
+        const float y = in[n].y;
+        const float z = in[n].z;
+
+        out[n].x = VECTOR_FMAF(t->M[0][2], z, VECTOR_FMAF(t->M[0][1], y, VECTOR_FMAF(t->M[0][0], x, t->b[0])));
+        out[n].y = VECTOR_FMAF(t->M[1][2], z, VECTOR_FMAF(t->M[1][1], y, VECTOR_FMAF(t->M[1][0], x, t->b[1])));
+        out[n].z = VECTOR_FMAF(t->M[2][2], z, VECTOR_FMAF(t->M[2][1], y, VECTOR_FMAF(t->M[2][0], x, t->b[2])));
+    }
+}
+
 #endif /* VECTORS_H_ */
@@ -32,6 +32,9 @@
 #include "op_dfu.h"
 #include "pios_bl_helper.h"
 #include <pios_board_info.h>
+#ifdef DFU_INCLUDE_SECTOR_CRC
+#include <pios_crc.h>
+#endif
 // programmable devices
 Device devicesTable[10];
 uint8_t numberOfDevices = 0;
@@ -67,6 +70,21 @@ uint32_t downSizeOfLastPacket = 0;
 uint32_t downPacketTotal = 0;
 uint32_t downPacketCurrent    = 0;
 DFUTransfer downType = 0;
+
+#ifdef DFU_INCLUDE_SECTOR_CRC
+// Differential upload, one bit per erase sector of the firmware area
+uint8_t PartialUpload = 0;
+uint8_t DirtySectors[DFU_MAX_SECTORS / 8];
+// Sector of the last isSectorDirty() lookup, the words of a sector are programmed in a row
+static uint32_t DirtyLookupStart = 0;
+static uint32_t DirtyLookupEnd   = 0;
+static bool DirtyLookupResult  = false;
+#else
+// No room for the sector CRCs, uploads always rewrite the whole firmware
+#define PartialUpload       0
+#define isSectorDirty(adr)  true
+#define eraseDirtySectors() false
+#endif
 /* Extern variables ----------------------------------------------------------*/
 extern DFUStates DeviceState;
 extern uint8_t JumpToApp;
@@ -75,6 +93,13 @@ extern int32_t platform_senddata(const uint8_t *msg, uint16_t msg_len);
 static uint32_t baseOfAdressType(uint8_t type);
 static uint8_t isBiggerThanAvailable(uint8_t type, uint32_t size);
 static void OPDfuIni(uint8_t discover);
+#ifdef DFU_INCLUDE_SECTOR_CRC
+static bool fwSector(uint32_t index, uint32_t *start, uint32_t *size);
+static uint32_t fwSectorCount(void);
+static bool isSectorDirty(uint32_t address);
+static bool eraseDirtySectors(void);
+static void sendSectorCRCs(uint32_t first);
+#endif
 bool flash_read(uint8_t *buffer, uint32_t adr, DFUProgType type);
 /* Private functions ---------------------------------------------------------*/
 void sendData(uint8_t *buf, uint16_t size);
@@ -161,7 +186,10 @@ void processComand(uint8_t *xReceive_Buffer)
             if (Data0 > 0) {
                 OPDfuIni(true);
             }
-            DeviceState = DFUidle;
+            DeviceState   = DFUidle;
+#ifdef DFU_INCLUDE_SECTOR_CRC
+            PartialUpload = 0;
+#endif
             currentProgrammingDestination = devicesTable[Data0].programmingType;
             currentDeviceCanRead  = devicesTable[Data0].readWriteFlags & 0x01;
             currentDeviceCanWrite = devicesTable[Data0].readWriteFlags >> 1
@@ -203,7 +231,7 @@ void processComand(uint8_t *xReceive_Buffer)
                     if (TransferType == FW) {
                         switch (currentProgrammingDestination) {
                         case Self_flash:
-                            result = PIOS_BL_HELPER_FLASH_Start();
+                            result = PartialUpload ? eraseDirtySectors() : PIOS_BL_HELPER_FLASH_Start();
                             break;
                         case Remote_flash_via_spi:
                             result = false;
@@ -223,7 +251,9 @@ void processComand(uint8_t *xReceive_Buffer)
                 if (Count > SizeOfTransfer) {
                     DeviceState = too_many_packets;
                     Aditionals  = Count;
-                } else if (Count == Next_Packet - 1) {
+                } else if ((Count == Next_Packet - 1) ||
+                           (PartialUpload && (TransferType == FW) && (Count > Next_Packet - 1))) {
+                    // a differential upload skips the packets of unchanged sectors
                     uint8_t numberOfWords = 14;
                     if (Count == SizeOfTransfer - 1) { // is this the last packet?
                         numberOfWords = SizeOfLastPacket;
@@ -239,6 +269,10 @@ void processComand(uint8_t *xReceive_Buffer)
                             aux    = baseOfAdressType(TransferType) + (uint32_t)(
                                 Count * 14 * 4 + x * 4);
                             result = 0;
+                            if (PartialUpload && (TransferType == FW) && !isSectorDirty(aux)) {
+                                // unchanged sector, it was not erased
+                                result = 1;
+                            }
                             for (int retry = 0; retry < MAX_WRI_RETRYS; ++retry) {
                                 if (result == 0) {
                                     result = (FLASH_ProgramWord(aux, Data)
@@ -259,7 +293,7 @@ void processComand(uint8_t *xReceive_Buffer)
                         Aditionals  = (uint32_t)Command;
                     }
 
-                    ++Next_Packet;
+                    Next_Packet = Count + 2;
                 } else {
                     DeviceState = wrong_packet_received;
                     Aditionals  = Count;
@@ -297,6 +331,9 @@ void processComand(uint8_t *xReceive_Buffer)
             pack_uint32(devicesTable[Data0 - 1].FW_Crc, &Buffer[10]);
             Buffer[14] = devicesTable[Data0 - 1].devID >> 8;
             Buffer[15] = devicesTable[Data0 - 1].devID;
+#ifdef DFU_INCLUDE_SECTOR_CRC
+            Buffer[16] = DFU_CAP_SECTOR_CRC;
+#endif
         }
         sendData(Buffer + 1, 63);
         break;
@@ -317,19 +354,28 @@ void processComand(uint8_t *xReceive_Buffer)
         PIOS_SYS_Reset();
         break;
     case Abort_Operation:
-        Next_Packet = 0;
-        DeviceState = DFUidle;
+        Next_Packet   = 0;
+#ifdef DFU_INCLUDE_SECTOR_CRC
+        PartialUpload = 0;
+#endif
+        DeviceState   = DFUidle;
         break;
 
     case Op_END:
         if (DeviceState == uploading) {
-            if (Next_Packet - 1 == SizeOfTransfer) {
+            if ((Next_Packet - 1 == SizeOfTransfer) || (PartialUpload && (TransferType == FW))) {
+                // skipped packets of a differential upload are covered by the CRC
                 Next_Packet = 0;
                 if ((TransferType != FW) || (Expected_CRC == CalcFirmCRC())) {
                     DeviceState = Last_operation_Success;
                 } else {
                     DeviceState = CRC_Fail;
                 }
+#ifdef DFU_INCLUDE_SECTOR_CRC
+                if (TransferType == FW) {
+                    PartialUpload = 0;
+                }
+#endif
             }
             if (Next_Packet - 1 < SizeOfTransfer) {
                 Next_Packet = 0;
@@ -379,12 +425,160 @@ void processComand(uint8_t *xReceive_Buffer)
     case Status_Rep:
 
         break;
+#ifdef DFU_INCLUDE_SECTOR_CRC
+    case Req_SectorCRC:
+        sendSectorCRCs(Count);
+        break;
+    case Select_Sectors:
+        // Count is the first sector of the bitmap, Data0 the number of sectors in it
+        if ((DeviceState == DFUidle) && (currentProgrammingDestination == Self_flash) &&
+            (Count + Data0 <= DFU_MAX_SECTORS)) {
+            if (Count == 0) {
+                memset(DirtySectors, 0, sizeof(DirtySectors));
+            }
+            for (uint32_t i = 0; i < Data0; ++i) {
+                if (xReceive_Buffer[DATA + 1 + i / 8] & (1 << (i % 8))) {
+                    DirtySectors[(Count + i) / 8] |= 1 << ((Count + i) % 8);
+                }
+            }
+            PartialUpload    = 1;
+            DirtyLookupStart = DirtyLookupEnd = 0;
+        } else {
+            DeviceState = Last_operation_failed;
+            Aditionals  = (uint32_t)Command;
+        }
+        break;
+#endif /* DFU_INCLUDE_SECTOR_CRC */
     }
     if (EchoReqFlag == 1) {
         echoBuffer[1] = echoBuffer[1] | EchoAnsFlag;
         sendData(echoBuffer + 1, 63);
     }
 }
+
+#ifdef DFU_INCLUDE_SECTOR_CRC
+/**
+ * Gets the index-th erase sector of the firmware and description area
+ * \return false past the last sector
+ */
+static bool fwSector(uint32_t index, uint32_t *start, uint32_t *size)
+{
+    const uint32_t end = currentDevice.startOfUserCode + currentDevice.sizeOfCode + currentDevice.sizeOfDescription;
+    uint32_t address   = currentDevice.startOfUserCode;
+
+    while (address < end && PIOS_BL_HELPER_FLASH_Sector_Info(address, start, size)) {
+        if (index-- == 0) {
+            return true;
+        }
+        address = *start + *size;
+    }
+    return false;
+}
+
+static uint32_t fwSectorCount(void)
+{
+    const uint32_t end = currentDevice.startOfUserCode + currentDevice.sizeOfCode + currentDevice.sizeOfDescription;
+    uint32_t address   = currentDevice.startOfUserCode;
+    uint32_t start, size, count = 0;
+
+    while (address < end && PIOS_BL_HELPER_FLASH_Sector_Info(address, &start, &size)) {
+        address = start + size;
+        ++count;
+    }
+    return count;
+}
+
+static bool isSectorDirty(uint32_t address)
+{
+    uint32_t sector = currentDevice.startOfUserCode;
+    uint32_t start, size;
+
+    if (address >= DirtyLookupStart && address < DirtyLookupEnd) {
+        return DirtyLookupResult;
+    }
+    for (uint32_t i = 0; i < DFU_MAX_SECTORS && PIOS_BL_HELPER_FLASH_Sector_Info(sector, &start, &size); ++i) {
+        if (address < start + size) {
+            if (address < start) {
+                return false;
+            }
+            DirtyLookupStart  = start;
+            DirtyLookupEnd    = start + size;
+            DirtyLookupResult = DirtySectors[i / 8] & (1 << (i % 8));
+            return DirtyLookupResult;
+        }
+        sector = start + size;
+    }
+    return false;
+}
+
+/**
+ * Erases the selected sectors, plus the ones holding the description
+ * which is uploaded again after the firmware.
+ */
+static bool eraseDirtySectors(void)
+{
+    const uint32_t code_end = currentDevice.startOfUserCode + currentDevice.sizeOfCode;
+    const uint32_t end = code_end + currentDevice.sizeOfDescription;
+    uint32_t sector    = currentDevice.startOfUserCode;
+    uint32_t start, size;
+
+    // the description sectors are added below
+    DirtyLookupStart = DirtyLookupEnd = 0;
+    for (uint32_t i = 0; i < DFU_MAX_SECTORS && sector < end && PIOS_BL_HELPER_FLASH_Sector_Info(sector, &start, &size); ++i) {
+        if (start + size > code_end) {
+            DirtySectors[i / 8] |= 1 << (i % 8);
+        }
+        if ((DirtySectors[i / 8] & (1 << (i % 8))) && !PIOS_BL_HELPER_FLASH_Erase_Sector(start)) {
+            return false;
+        }
+        sector = start + size;
+    }
+    return true;
+}
+
+/**
+ * Replies with the CRC32 of up to DFU_SECTOR_ENTRIES erase sectors starting at first.
+ * Each entry is the offset and size of the sector within the firmware (clipped to
+ * the code area), its CRC and DFU_SECTOR_DESCRIPTION flag. A sector count of zero
+ * tells the host to fall back to a full upload.
+ */
+static void sendSectorCRCs(uint32_t first)
+{
+    const uint32_t base     = currentDevice.startOfUserCode;
+    const uint32_t code_end = base + currentDevice.sizeOfCode;
+    uint32_t total = fwSectorCount();
+    uint8_t entries = 0;
+
+    if ((DeviceState != DFUidle) || (currentProgrammingDestination != Self_flash) || (total > DFU_MAX_SECTORS)) {
+        total = 0;
+    }
+    memset(Buffer, 0, sizeof(Buffer));
+    Buffer[0] = 0x01;
+    Buffer[1] = Rep_SectorCRC;
+    pack_uint32(first, &Buffer[2]);
+    Buffer[7] = total >> 8;
+    Buffer[8] = total;
+
+    uint32_t start, size;
+    while (first + entries < total && entries < DFU_SECTOR_ENTRIES && fwSector(first + entries, &start, &size)) {
+        const uint32_t sector_end = start + size;
+        uint32_t end = (sector_end < code_end) ? sector_end : code_end;
+        if (start < base) {
+            start = base;
+        }
+        uint32_t length = (end > start) ? end - start : 0;
+        uint8_t *entry  = &Buffer[9 + entries * DFU_SECTOR_ENTRY_SIZE];
+        pack_uint32(start - base, &entry[0]);
+        pack_uint32(length, &entry[4]);
+        pack_uint32(PIOS_CRC32_updateCRC(0xffffffff, PIOS_BL_HELPER_FLASH_If_Read(start), length), &entry[8]);
+        entry[12] = (sector_end > code_end) ? DFU_SECTOR_DESCRIPTION : 0;
+        ++entries;
+    }
+    Buffer[6] = entries;
+    sendData(Buffer + 1, 63);
+}
+#endif /* DFU_INCLUDE_SECTOR_CRC */
+
 void OPDfuIni(uint8_t discover)
 {
     const struct pios_board_info *bdinfo = &pios_board_info_blob;
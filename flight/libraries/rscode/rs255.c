@@ -0,0 +1,287 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rs255.c
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Table driven RS(255,k) codec for the radio link
+ *
+ *             Same field (x^8+x^4+x^3+x^2+1) and generator roots (a^1..a^n)
+ *             as rs.c, so both ends of a link may run either codec.
+ *
+ *             The parity shift register holds one parity byte per lane of a
+ *             32 bit word, so each data byte costs a single lookup in the
+ *             generator table. The receiver runs the same register to get
+ *             the remainder of the codeword modulo the generator, which is
+ *             zero for a clean packet; only otherwise are the syndromes
+ *             evaluated from the (at most four) remainder coefficients.
+ *             All decoder state lives on the stack.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "rs255.h"
+
+#define NPAR      RS_ECC_NPARITY
+#define TOP_SHIFT (8 * (NPAR - 1))
+#if NPAR == 4
+#define LFSR_MASK 0xffffffffu
+#else
+#define LFSR_MASK ((1u << (8 * NPAR)) - 1)
+#endif
+
+/* antilog table, doubled so that the sum of two logs needs no reduction */
+static const uint8_t rs255_exp[512] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1d, 0x3a, 0x74, 0xe8, 0xcd, 0x87, 0x13, 0x26,
+    0x4c, 0x98, 0x2d, 0x5a, 0xb4, 0x75, 0xea, 0xc9, 0x8f, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0,
+    0x9d, 0x27, 0x4e, 0x9c, 0x25, 0x4a, 0x94, 0x35, 0x6a, 0xd4, 0xb5, 0x77, 0xee, 0xc1, 0x9f, 0x23,
+    0x46, 0x8c, 0x05, 0x0a, 0x14, 0x28, 0x50, 0xa0, 0x5d, 0xba, 0x69, 0xd2, 0xb9, 0x6f, 0xde, 0xa1,
+    0x5f, 0xbe, 0x61, 0xc2, 0x99, 0x2f, 0x5e, 0xbc, 0x65, 0xca, 0x89, 0x0f, 0x1e, 0x3c, 0x78, 0xf0,
+    0xfd, 0xe7, 0xd3, 0xbb, 0x6b, 0xd6, 0xb1, 0x7f, 0xfe, 0xe1, 0xdf, 0xa3, 0x5b, 0xb6, 0x71, 0xe2,
+    0xd9, 0xaf, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0d, 0x1a, 0x34, 0x68, 0xd0, 0xbd, 0x67, 0xce,
+    0x81, 0x1f, 0x3e, 0x7c, 0xf8, 0xed, 0xc7, 0x93, 0x3b, 0x76, 0xec, 0xc5, 0x97, 0x33, 0x66, 0xcc,
+    0x85, 0x17, 0x2e, 0x5c, 0xb8, 0x6d, 0xda, 0xa9, 0x4f, 0x9e, 0x21, 0x42, 0x84, 0x15, 0x2a, 0x54,
+    0xa8, 0x4d, 0x9a, 0x29, 0x52, 0xa4, 0x55, 0xaa, 0x49, 0x92, 0x39, 0x72, 0xe4, 0xd5, 0xb7, 0x73,
+    0xe6, 0xd1, 0xbf, 0x63, 0xc6, 0x91, 0x3f, 0x7e, 0xfc, 0xe5, 0xd7, 0xb3, 0x7b, 0xf6, 0xf1, 0xff,
+    0xe3, 0xdb, 0xab, 0x4b, 0x96, 0x31, 0x62, 0xc4, 0x95, 0x37, 0x6e, 0xdc, 0xa5, 0x57, 0xae, 0x41,
+    0x82, 0x19, 0x32, 0x64, 0xc8, 0x8d, 0x07, 0x0e, 0x1c, 0x38, 0x70, 0xe0, 0xdd, 0xa7, 0x53, 0xa6,
+    0x51, 0xa2, 0x59, 0xb2, 0x79, 0xf2, 0xf9, 0xef, 0xc3, 0x9b, 0x2b, 0x56, 0xac, 0x45, 0x8a, 0x09,
+    0x12, 0x24, 0x48, 0x90, 0x3d, 0x7a, 0xf4, 0xf5, 0xf7, 0xf3, 0xfb, 0xeb, 0xcb, 0x8b, 0x0b, 0x16,
+    0x2c, 0x58, 0xb0, 0x7d, 0xfa, 0xe9, 0xcf, 0x83, 0x1b, 0x36, 0x6c, 0xd8, 0xad, 0x47, 0x8e, 0x01,
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1d, 0x3a, 0x74, 0xe8, 0xcd, 0x87, 0x13, 0x26, 0x4c,
+    0x98, 0x2d, 0x5a, 0xb4, 0x75, 0xea, 0xc9, 0x8f, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x9d,
+    0x27, 0x4e, 0x9c, 0x25, 0x4a, 0x94, 0x35, 0x6a, 0xd4, 0xb5, 0x77, 0xee, 0xc1, 0x9f, 0x23, 0x46,
+    0x8c, 0x05, 0x0a, 0x14, 0x28, 0x50, 0xa0, 0x5d, 0xba, 0x69, 0xd2, 0xb9, 0x6f, 0xde, 0xa1, 0x5f,
+    0xbe, 0x61, 0xc2, 0x99, 0x2f, 0x5e, 0xbc, 0x65, 0xca, 0x89, 0x0f, 0x1e, 0x3c, 0x78, 0xf0, 0xfd,
+    0xe7, 0xd3, 0xbb, 0x6b, 0xd6, 0xb1, 0x7f, 0xfe, 0xe1, 0xdf, 0xa3, 0x5b, 0xb6, 0x71, 0xe2, 0xd9,
+    0xaf, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0d, 0x1a, 0x34, 0x68, 0xd0, 0xbd, 0x67, 0xce, 0x81,
+    0x1f, 0x3e, 0x7c, 0xf8, 0xed, 0xc7, 0x93, 0x3b, 0x76, 0xec, 0xc5, 0x97, 0x33, 0x66, 0xcc, 0x85,
+    0x17, 0x2e, 0x5c, 0xb8, 0x6d, 0xda, 0xa9, 0x4f, 0x9e, 0x21, 0x42, 0x84, 0x15, 0x2a, 0x54, 0xa8,
+    0x4d, 0x9a, 0x29, 0x52, 0xa4, 0x55, 0xaa, 0x49, 0x92, 0x39, 0x72, 0xe4, 0xd5, 0xb7, 0x73, 0xe6,
+    0xd1, 0xbf, 0x63, 0xc6, 0x91, 0x3f, 0x7e, 0xfc, 0xe5, 0xd7, 0xb3, 0x7b, 0xf6, 0xf1, 0xff, 0xe3,
+    0xdb, 0xab, 0x4b, 0x96, 0x31, 0x62, 0xc4, 0x95, 0x37, 0x6e, 0xdc, 0xa5, 0x57, 0xae, 0x41, 0x82,
+    0x19, 0x32, 0x64, 0xc8, 0x8d, 0x07, 0x0e, 0x1c, 0x38, 0x70, 0xe0, 0xdd, 0xa7, 0x53, 0xa6, 0x51,
+    0xa2, 0x59, 0xb2, 0x79, 0xf2, 0xf9, 0xef, 0xc3, 0x9b, 0x2b, 0x56, 0xac, 0x45, 0x8a, 0x09, 0x12,
+    0x24, 0x48, 0x90, 0x3d, 0x7a, 0xf4, 0xf5, 0xf7, 0xf3, 0xfb, 0xeb, 0xcb, 0x8b, 0x0b, 0x16, 0x2c,
+    0x58, 0xb0, 0x7d, 0xfa, 0xe9, 0xcf, 0x83, 0x1b, 0x36, 0x6c, 0xd8, 0xad, 0x47, 0x8e, 0x01, 0x02
+};
+
+static const uint8_t rs255_log[256] = {
+    0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1a, 0xc6, 0x03, 0xdf, 0x33, 0xee, 0x1b, 0x68, 0xc7, 0x4b,
+    0x04, 0x64, 0xe0, 0x0e, 0x34, 0x8d, 0xef, 0x81, 0x1c, 0xc1, 0x69, 0xf8, 0xc8, 0x08, 0x4c, 0x71,
+    0x05, 0x8a, 0x65, 0x2f, 0xe1, 0x24, 0x0f, 0x21, 0x35, 0x93, 0x8e, 0xda, 0xf0, 0x12, 0x82, 0x45,
+    0x1d, 0xb5, 0xc2, 0x7d, 0x6a, 0x27, 0xf9, 0xb9, 0xc9, 0x9a, 0x09, 0x78, 0x4d, 0xe4, 0x72, 0xa6,
+    0x06, 0xbf, 0x8b, 0x62, 0x66, 0xdd, 0x30, 0xfd, 0xe2, 0x98, 0x25, 0xb3, 0x10, 0x91, 0x22, 0x88,
+    0x36, 0xd0, 0x94, 0xce, 0x8f, 0x96, 0xdb, 0xbd, 0xf1, 0xd2, 0x13, 0x5c, 0x83, 0x38, 0x46, 0x40,
+    0x1e, 0x42, 0xb6, 0xa3, 0xc3, 0x48, 0x7e, 0x6e, 0x6b, 0x3a, 0x28, 0x54, 0xfa, 0x85, 0xba, 0x3d,
+    0xca, 0x5e, 0x9b, 0x9f, 0x0a, 0x15, 0x79, 0x2b, 0x4e, 0xd4, 0xe5, 0xac, 0x73, 0xf3, 0xa7, 0x57,
+    0x07, 0x70, 0xc0, 0xf7, 0x8c, 0x80, 0x63, 0x0d, 0x67, 0x4a, 0xde, 0xed, 0x31, 0xc5, 0xfe, 0x18,
+    0xe3, 0xa5, 0x99, 0x77, 0x26, 0xb8, 0xb4, 0x7c, 0x11, 0x44, 0x92, 0xd9, 0x23, 0x20, 0x89, 0x2e,
+    0x37, 0x3f, 0xd1, 0x5b, 0x95, 0xbc, 0xcf, 0xcd, 0x90, 0x87, 0x97, 0xb2, 0xdc, 0xfc, 0xbe, 0x61,
+    0xf2, 0x56, 0xd3, 0xab, 0x14, 0x2a, 0x5d, 0x9e, 0x84, 0x3c, 0x39, 0x53, 0x47, 0x6d, 0x41, 0xa2,
+    0x1f, 0x2d, 0x43, 0xd8, 0xb7, 0x7b, 0xa4, 0x76, 0xc4, 0x17, 0x49, 0xec, 0x7f, 0x0c, 0x6f, 0xf6,
+    0x6c, 0xa1, 0x3b, 0x52, 0x29, 0x9d, 0x55, 0xaa, 0xfb, 0x60, 0x86, 0xb1, 0xbb, 0xcc, 0x3e, 0x5a,
+    0xcb, 0x59, 0x5f, 0xb0, 0x9c, 0xa9, 0xa0, 0x51, 0x0b, 0xf5, 0x16, 0xeb, 0x7a, 0x75, 0x2c, 0xd7,
+    0x4f, 0xae, 0xd5, 0xe9, 0xe6, 0xe7, 0xad, 0xe8, 0x74, 0xd6, 0xf4, 0xea, 0xa8, 0x50, 0x58, 0xaf
+};
+
+/* lane j holds generator coefficient g[j] times the table index */
+static uint32_t rs255_gen[256];
+
+static inline uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return rs255_exp[rs255_log[a] + rs255_log[b]];
+}
+
+static inline uint8_t gf_div(uint8_t a, uint8_t b)
+{
+    if (a == 0) {
+        return 0;
+    }
+    return rs255_exp[rs255_log[a] + 255 - rs255_log[b]];
+}
+
+void rs255_init(void)
+{
+    uint8_t g[NPAR + 1] = { 1 };
+
+    /* g(x) = (x + a^1)(x + a^2)...(x + a^n) */
+    for (uint8_t i = 1; i <= NPAR; i++) {
+        for (uint8_t j = i; j > 0; j--) {
+            g[j] = g[j - 1] ^ gf_mul(g[j], rs255_exp[i]);
+        }
+        g[0] = gf_mul(g[0], rs255_exp[i]);
+    }
+
+    for (uint16_t fb = 0; fb < 256; fb++) {
+        uint32_t word = 0;
+        for (uint8_t j = 0; j < NPAR; j++) {
+            word |= (uint32_t)gf_mul(g[j], fb) << (8 * j);
+        }
+        rs255_gen[fb] = word;
+    }
+}
+
+void rs255_encode(uint8_t *codeword, uint16_t len)
+{
+    uint32_t lfsr = 0;
+
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t fb = codeword[i] ^ (lfsr >> TOP_SHIFT);
+        lfsr = ((lfsr << 8) & LFSR_MASK) ^ rs255_gen[fb];
+    }
+    for (uint8_t i = 0; i < NPAR; i++) {
+        codeword[len + i] = lfsr >> (TOP_SHIFT - 8 * i);
+    }
+}
+
+/* codeword(x) mod g(x), coefficient j in lane j */
+static uint32_t rs255_remainder(const uint8_t *codeword, uint16_t len)
+{
+    uint32_t rem = 0;
+
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t top = rem >> TOP_SHIFT;
+        rem = (((rem << 8) & LFSR_MASK) ^ rs255_gen[top]) ^ codeword[i];
+    }
+    return rem;
+}
+
+int8_t rs255_decode(uint8_t *codeword, uint16_t len)
+{
+    uint32_t rem = rs255_remainder(codeword, len);
+
+    if (rem == 0) {
+        return 0;
+    }
+
+    /* S[j] = c(a^(j+1)) = rem(a^(j+1)) since g vanishes at its roots */
+    uint8_t s[NPAR];
+    for (uint8_t j = 0; j < NPAR; j++) {
+        uint8_t sum = 0;
+        for (uint8_t k = 0; k < NPAR; k++) {
+            uint8_t coeff = rem >> (8 * k);
+            if (coeff) {
+                sum ^= rs255_exp[rs255_log[coeff] + ((j + 1) * k) % 255];
+            }
+        }
+        s[j] = sum;
+    }
+
+    /* Berlekamp-Massey for the error locator lambda */
+    uint8_t lambda[NPAR + 1] = { 1 };
+    uint8_t prev[NPAR + 1]   = { 1 };
+    uint8_t nerrors = 0;
+    uint8_t shift   = 1;
+    uint8_t prev_d  = 1;
+    for (uint8_t n = 0; n < NPAR; n++) {
+        uint8_t d = s[n];
+        for (uint8_t i = 1; i <= nerrors; i++) {
+            d ^= gf_mul(lambda[i], s[n - i]);
+        }
+        if (d == 0) {
+            shift++;
+            continue;
+        }
+        uint8_t scale = gf_div(d, prev_d);
+        uint8_t tmp[NPAR + 1];
+        memcpy(tmp, lambda, sizeof(tmp));
+        for (uint8_t i = shift; i <= NPAR; i++) {
+            lambda[i] ^= gf_mul(scale, prev[i - shift]);
+        }
+        if (2 * nerrors <= n) {
+            nerrors = n + 1 - nerrors;
+            memcpy(prev, tmp, sizeof(prev));
+            prev_d = d;
+            shift  = 1;
+        } else {
+            shift++;
+        }
+    }
+    if (nerrors > NPAR / 2) {
+        return -1;
+    }
+
+    /* error evaluator omega = lambda * S mod x^n */
+    uint8_t omega[NPAR] = { 0 };
+    for (uint8_t i = 0; i < NPAR; i++) {
+        for (uint8_t j = 0; j <= i && j <= nerrors; j++) {
+            omega[i] ^= gf_mul(lambda[j], s[i - j]);
+        }
+    }
+
+    /*
+     * Chien search. Position p counts from the end of the codeword and is
+     * a root when lambda(a^-p) == 0. A single error is located directly,
+     * otherwise only the positions inside the codeword are visited and
+     * the search stops once all roots have been found.
+     */
+    uint8_t locs[NPAR / 2];
+    uint8_t nlocs = 0;
+    if (nerrors == 1) {
+        locs[nlocs++] = rs255_log[lambda[1]];
+    } else {
+        int16_t lg[NPAR / 2 + 1];
+        for (uint8_t j = 1; j <= nerrors; j++) {
+            lg[j] = lambda[j] ? rs255_log[lambda[j]] : -1;
+        }
+        for (uint16_t p = 0; p < len && nlocs < nerrors; p++) {
+            uint8_t sum = lambda[0];
+            for (uint8_t j = 1; j <= nerrors; j++) {
+                if (lg[j] >= 0) {
+                    sum   ^= rs255_exp[lg[j]];
+                    /* step to a^-(p+1): multiply term j by a^-j */
+                    lg[j] += 255 - j;
+                    if (lg[j] >= 255) {
+                        lg[j] -= 255;
+                    }
+                }
+            }
+            if (sum == 0) {
+                locs[nlocs++] = p;
+            }
+        }
+    }
+    if (nlocs != nerrors || locs[0] >= len) {
+        return -1;
+    }
+
+    /* Forney: e = omega(X^-1) / lambda'(X^-1) */
+    for (uint8_t r = 0; r < nlocs; r++) {
+        uint8_t xinv = (255 - locs[r]) % 255;
+        uint8_t num  = 0;
+        for (uint8_t j = 0; j < NPAR; j++) {
+            if (omega[j]) {
+                num ^= rs255_exp[rs255_log[omega[j]] + (xinv * j) % 255];
+            }
+        }
+        uint8_t denom = 0;
+        for (uint8_t j = 1; j <= nerrors; j += 2) {
+            if (lambda[j]) {
+                denom ^= rs255_exp[rs255_log[lambda[j]] + (xinv * (j - 1)) % 255];
+            }
+        }
+        if (denom == 0) {
+            return -1;
+        }
+        codeword[len - 1 - locs[r]] ^= gf_div(num, denom);
+    }
+    return nlocs;
+}
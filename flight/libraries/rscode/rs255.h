@@ -0,0 +1,62 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rs255.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Table driven RS(255,k) codec for the radio link
+ *             Byte compatible with encode_data()/correct_errors_erasures()
+ *             from the generic rscode library, but without global state.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef RS255_H
+#define RS255_H
+
+#include <openpilot.h>
+
+/*
+ * The parity of a codeword is kept in a single 32 bit shift register,
+ * so the codec handles up to four parity bytes (two correctable errors).
+ */
+#if RS_ECC_NPARITY > 4
+#error rs255 supports at most 4 parity bytes
+#endif
+
+/**
+ * Build the generator table. Must be called once before the first
+ * encode/decode, the codec is re-entrant afterwards.
+ */
+void rs255_init(void);
+
+/**
+ * Append RS_ECC_NPARITY parity bytes to a message.
+ * @param[in,out] codeword message of len bytes, followed by room for the parity
+ * @param[in] len message length, len + RS_ECC_NPARITY must not exceed 255
+ */
+void rs255_encode(uint8_t *codeword, uint16_t len);
+
+/**
+ * Check a received codeword and correct it in place.
+ * @param[in,out] codeword message followed by its parity bytes
+ * @param[in] len codeword length including the parity bytes
+ * @return 0 if the codeword was clean, the number of corrected bytes,
+ * or -1 if the codeword could not be corrected
+ */
+int8_t rs255_decode(uint8_t *codeword, uint16_t len);
+
+#endif /* RS255_H */
@@ -0,0 +1,100 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tracing.c
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Event trace infrastructure
+ *             UAVObject wrapper layer for the PiOS trace buffer
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <openpilot.h>
+#include <tracing.h>
+#include <pios_tracebuffer.h>
+
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+
+#define EVENT_SIZE       8
+#define EVENTS_PER_BLOCK (TRACEDATA_EVENTS_NUMELEM / EVENT_SIZE)
+
+// not on stack, event dispatcher stack might be insufficient
+static TraceDataData *data;
+static pios_tracebuffer_event_t events[EVENTS_PER_BLOCK];
+
+static void controlUpdatedCb(UAVObjEvent *ev);
+
+int32_t TracingInit()
+{
+    TraceControlInitialize();
+    TraceDataInitialize();
+    data = pios_malloc(sizeof(TraceDataData));
+    if (!data) {
+        // no way to download, do not spend the time recording
+        PIOS_TRACEBUFFER_Stop();
+        return -1;
+    }
+    TraceControlConnectCallback(controlUpdatedCb);
+
+    // record continuously, the ring always holds the most recent window
+    PIOS_TRACEBUFFER_Start();
+
+    return 0;
+}
+
+static void controlUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    TraceControlData control;
+
+    TraceControlGet(&control);
+    memset(data, 0, sizeof(TraceDataData));
+    switch (control.Operation) {
+    case TRACECONTROL_OPERATION_START:
+        PIOS_TRACEBUFFER_Start();
+        break;
+    case TRACECONTROL_OPERATION_STOP:
+        PIOS_TRACEBUFFER_Stop();
+        break;
+    case TRACECONTROL_OPERATION_RETRIEVE:
+        data->Count = PIOS_TRACEBUFFER_Read(control.Index, events, EVENTS_PER_BLOCK);
+        // serialize explicitly, the block format must not depend on the target's struct layout
+        for (uint8_t i = 0; i < data->Count; i++) {
+            uint8_t *out = &data->Events[i * EVENT_SIZE];
+            out[0] = events[i].timestamp;
+            out[1] = events[i].timestamp >> 8;
+            out[2] = events[i].timestamp >> 16;
+            out[3] = events[i].timestamp >> 24;
+            out[4] = events[i].id;
+            out[5] = events[i].id >> 8;
+            out[6] = events[i].type;
+            out[7] = 0;
+        }
+        break;
+    default:
+        return;
+    }
+
+    data->Index    = control.Index;
+    data->RawClock = PIOS_DELAY_GetRawHz();
+    data->Total    = PIOS_TRACEBUFFER_Count();
+    data->Dropped  = PIOS_TRACEBUFFER_Dropped();
+    data->Running  = PIOS_TRACEBUFFER_IsRunning() ? TRACEDATA_RUNNING_TRUE : TRACEDATA_RUNNING_FALSE;
+    TraceDataSet(data);
+}
+
+#endif /* PIOS_INCLUDE_TRACEBUFFER */
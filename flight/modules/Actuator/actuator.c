@@ -46,6 +46,8 @@
 #include "cameradesired.h"
 #include "manualcontrolcommand.h"
 #include "taskinfo.h"
+#include "controllatency.h"
+#include <latencystats.h>
 #include <systemsettings.h>
 #include <sanitycheck.h>
 #ifndef PIOS_EXCLUDE_ADVANCED_FEATURES
@@ -73,6 +75,10 @@ static int8_t counter;
 
 #define CAMERA_BOOT_DELAY_MS            7000
 
+#define LATENCY_BUCKET_WIDTH_US         100
+#define JITTER_BUCKET_WIDTH_US          20
+#define LATENCY_PUBLISH_PERIOD_US       1000000
+
 #define ACTUATOR_ONESHOT125_CLOCK       2000000
 #define ACTUATOR_ONESHOT125_PULSE_SCALE 4
 #define ACTUATOR_PWM_CLOCK              1000000
@@ -96,6 +102,10 @@ static bool spinWhileArmed;
 static MixerSettingsData mixerSettings;
 static int mixer_settings_count = 2;
 
+// gyro sample to servo update latency, see updateControlLatency()
+static LatencyTracker latencyTracker;
+static uint32_t latencyWindowStart;
+
 // Private functions
 static void actuatorTask(void *parameters);
 static int16_t scaleChannel(float value, int16_t max, int16_t min, int16_t neutral);
@@ -108,6 +118,7 @@ static void actuator_update_rate_if_changed(bool force_update);
 static void MixerSettingsUpdatedCb(UAVObjEvent *ev);
 static void ActuatorSettingsUpdatedCb(UAVObjEvent *ev);
 static void SettingsUpdatedCb(UAVObjEvent *ev);
+static void updateControlLatency(uint32_t sensorTimestamp);
 float ProcessMixer(const int index, const float curve1, const float curve2,
                    ActuatorDesiredData *desired,
                    const float period, bool multirotor);
@@ -161,6 +172,9 @@ int32_t ActuatorInitialize()
     // Primary output of this module
     ActuatorCommandInitialize();
 
+    ControlLatencyInitialize();
+    LatencyTrackerInit(&latencyTracker, LATENCY_BUCKET_WIDTH_US, JITTER_BUCKET_WIDTH_US);
+
 #ifdef DIAG_MIXERSTATUS
     // UAVO only used for inspecting the internal status of the mixer during debug
     MixerStatusInitialize();
@@ -538,6 +552,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
         }
 
         PIOS_Servo_Update();
+        updateControlLatency(desired.SensorTimestamp);
 
         if (!success) {
             command.NumFailedUpdates++;
@@ -551,6 +566,49 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
 }
 
 
+static inline uint16_t clampLatency(uint32_t us)
+{
+    return us > UINT16_MAX ? UINT16_MAX : (uint16_t)us;
+}
+
+/**
+ * Account the time from the Sensors task reading the gyro sample that
+ * ActuatorDesired was computed from to the servo update, publish the
+ * statistics once per period
+ */
+static void updateControlLatency(uint32_t sensorTimestamp)
+{
+    // not on stack, it is only needed once per period
+    static ControlLatencyData data;
+    uint32_t now = PIOS_DELAY_GetRaw();
+    const LatencyStats *latencyStats = &latencyTracker.latency;
+    const LatencyStats *jitterStats  = &latencyTracker.jitter;
+
+    // samples without timestamp or repeated ActuatorDesired updates are not counted
+    LatencyTrackerAdd(&latencyTracker, sensorTimestamp, now);
+
+    if (PIOS_DELAY_DiffuS2(latencyWindowStart, now) < LATENCY_PUBLISH_PERIOD_US) {
+        return;
+    }
+    latencyWindowStart = now;
+
+    data.Samples     = clampLatency(latencyStats->count);
+    data.LatencyMin  = latencyStats->count ? clampLatency(latencyStats->min) : 0;
+    data.LatencyMean = clampLatency(LatencyStatsMean(latencyStats));
+    data.Latency99   = clampLatency(LatencyStatsPercentile(latencyStats, 99));
+    data.LatencyMax  = clampLatency(latencyStats->max);
+    data.JitterMean  = clampLatency(LatencyStatsMean(jitterStats));
+    data.Jitter99    = clampLatency(LatencyStatsPercentile(jitterStats, 99));
+    data.JitterMax   = clampLatency(jitterStats->max);
+    data.LatencyBucketWidth = latencyStats->bucketWidth;
+    data.JitterBucketWidth  = jitterStats->bucketWidth;
+    memcpy(data.LatencyHistogram, latencyStats->histogram, sizeof(data.LatencyHistogram));
+    memcpy(data.JitterHistogram, jitterStats->histogram, sizeof(data.JitterHistogram));
+    ControlLatencySet(&data);
+
+    LatencyTrackerReset(&latencyTracker);
+}
+
 /**
  * Process mixing for one actuator
  */
@@ -358,6 +358,7 @@ static int32_t updateSensors(AccelStateData *accelState, GyroStateData *gyros)
         AlarmsSet(SYSTEMALARMS_ALARM_ATTITUDE, SYSTEMALARMS_ALARM_ERROR);
         return -1;
     }
+    gyros->SensorTimestamp = PIOS_DELAY_GetRaw();
 
     // Do not read raw sensor data in simulation mode
     if (GyroStateReadOnly() || AccelStateReadOnly()) {
@@ -493,6 +494,7 @@ static int32_t updateSensorsCC3D(AccelStateData *accelStateData, GyroStateData *
         ret = xQueueReceive(queue, (void *)mpu6000_data, 0);
     }
     PERF_TRACK_VALUE(counterAccelSamples, count);
+    gyrosData->SensorTimestamp = PIOS_DELAY_GetRaw();
 
     if (!count) {
         return -1; // Error, no data
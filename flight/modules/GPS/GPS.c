@@ -427,8 +427,10 @@ static void setHomeLocation(GPSPositionSensorData *gpsData)
 
         float LLA[3] = { (home.Latitude) / 10e6f, (home.Longitude) / 10e6f, (home.Altitude) };
 
-        /* Compute magnetic flux direction at home location */
-        if (WMM_GetMagVector(LLA[0], LLA[1], LLA[2], gps.Month, gps.Day, gps.Year, &home.Be[0]) == 0) {
+        /* Compute magnetic flux direction at home location, the model is not needed afterwards */
+        int32_t wmmResult = WMM_GetMagVector(LLA[0], LLA[1], LLA[2], gps.Month, gps.Day, gps.Year, &home.Be[0]);
+        WMM_Release();
+        if (wmmResult == 0) {
             /*Compute local acceleration due to gravity.  Vehicles that span a very large
              * range of altitude (say, weather balloons) may need to update this during the
              * flight. */
@@ -77,9 +77,10 @@ typedef struct {
                 // FIXME: remove this and retest when someone has time
                 uint8_t bufferPaddingForPiosBugAt2400Baud[2]; // must be at least 2 for 2400 to work, probably 1 for 4800 and 0 for 9600+
             } __attribute__((packed));
+            // naturally aligned like every XData, so the union is not packed
             GPSSettingsData gpsSettings;
-        } __attribute__((packed));
-    } __attribute__((packed));
+        };
+    };
     volatile ubx_autoconfig_settings_t currentSettings;
     int8_t  lastConfigSent;         // index of last configuration string sent
     struct UBX_ACK_ACK requiredAck; // Class and id of the message we are waiting for an ACK from GPS
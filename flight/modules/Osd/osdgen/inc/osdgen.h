@@ -33,6 +33,7 @@
 
 #include "openpilot.h"
 #include "pios.h"
+#include "fonts.h"
 
 int32_t osdgenInitialize(void);
 
@@ -63,8 +64,8 @@ int32_t osdgenInitialize(void);
 // Edge cases.
 #define COMPUTE_HLINE_EDGE_L_MASK(b)      ((1 << (8 - (b))) - 1)
 #define COMPUTE_HLINE_EDGE_R_MASK(b)      (~((1 << (7 - (b))) - 1))
-// This computes an island mask.
-#define COMPUTE_HLINE_ISLAND_MASK(b0, b1) (COMPUTE_HLINE_EDGE_L_MASK(b0) ^ COMPUTE_HLINE_EDGE_L_MASK(b1));
+// This computes an island mask, b0 and b1 inclusive like the edges.
+#define COMPUTE_HLINE_ISLAND_MASK(b0, b1) (COMPUTE_HLINE_EDGE_L_MASK(b0) & COMPUTE_HLINE_EDGE_R_MASK(b1))
 
 // Macro for initializing stroke/fill modes. Add new modes here
 // if necessary.
@@ -134,8 +135,8 @@ struct FontDimensions {
 #define CHECK_COORD_Y(y)     if (y >= GRAPHICS_HEIGHT_REAL) { return; }
 
 // Clip coordinates out of range - assumes unsigned coordinate
-#define CLIP_COORD_X(x)      { x = MIN(x, GRAPHICS_WIDTH_REAL); }
-#define CLIP_COORD_Y(y)      { y = MIN(y, GRAPHICS_HEIGHT_REAL); }
+#define CLIP_COORD_X(x)      { x = MIN(x, GRAPHICS_WIDTH_REAL - 1); }
+#define CLIP_COORD_Y(y)      { y = MIN(y, GRAPHICS_HEIGHT_REAL - 1); }
 #define CLIP_COORDS(x, y)    { CLIP_COORD_X(x); CLIP_COORD_Y(y); }
 
 // Macro to swap two variables using XOR swap.
@@ -162,6 +163,7 @@ uint8_t getCharData(uint16_t charPos);
 void introText();
 
 void clearGraphics();
+void mark_dirty(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1);
 uint8_t validPos(uint16_t x, uint16_t y);
 void setPixel(uint16_t x, uint16_t y, uint8_t state);
 void drawCircle(uint16_t x0, uint16_t y0, uint16_t radius);
@@ -196,9 +198,9 @@ void write_word_misaligned(uint8_t *buff, uint16_t word, unsigned int addr, unsi
 void write_word_misaligned_NAND(uint8_t *buff, uint16_t word, unsigned int addr, unsigned int xoff);
 void write_word_misaligned_OR(uint8_t *buff, uint16_t word, unsigned int addr, unsigned int xoff);
 void write_word_misaligned_lm(uint16_t wordl, uint16_t wordm, unsigned int addr, unsigned int xoff, int lmode, int mmode);
-// int fetch_font_info(char ch, int font, struct FontEntry *font_info, char *lookup);
+int fetch_font_info(uint8_t ch, int font, struct FontEntry *font_info, char *lookup);
 void write_char(char ch, unsigned int x, unsigned int y, int flags, int font);
-// void calc_text_dimensions(char *str, struct FontEntry font, int xs, int ys, struct FontDimensions *dim);
+void calc_text_dimensions(char *str, struct FontEntry font, int xs, int ys, struct FontDimensions *dim);
 void write_string(char *str, unsigned int x, unsigned int y, unsigned int xs, unsigned int ys, int va, int ha, int flags, int font);
 void write_string_formatted(char *str, unsigned int x, unsigned int y, unsigned int xs, unsigned int ys, int va, int ha, int flags);
 
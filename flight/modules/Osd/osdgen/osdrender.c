@@ -0,0 +1,1383 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilotModules OpenPilot Modules
+ * @{
+ * @addtogroup OSDgenModule osdgen Module
+ * @{
+ *
+ * @file       osdrender.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2010.
+ *             The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      OSD gen module, drawing primitives. Parts from CL-OSD and SUPEROSD projects
+ *             Kept free of UAVObject and RTOS dependencies so it also builds on the host.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <openpilot.h>
+
+#include "osdgen.h"
+
+#include "fonts.h"
+#include "font12x18.h"
+#include "font8x10.h"
+
+extern uint8_t *draw_buffer_level;
+extern uint8_t *draw_buffer_mask;
+
+// Full bytes of a span are filled a 32 bit word at a time
+typedef uint32_t __attribute__((__may_alias__)) osd_word_t;
+
+/**
+ * Bounding box of everything drawn into one pair of draw buffers since it
+ * was last cleared, in bytes horizontally and lines vertically. The video
+ * driver swaps two buffer pairs, so one box is kept per pair.
+ */
+struct osd_dirty_rect {
+    uint8_t  *buffer;
+    uint16_t col0, col1;
+    uint16_t row0, row1;
+};
+
+static struct osd_dirty_rect dirty_rects[2];
+static struct osd_dirty_rect *dirty_current = &dirty_rects[0];
+
+static inline void dirty_rect_reset(struct osd_dirty_rect *rect)
+{
+    rect->col0 = GRAPHICS_WIDTH;
+    rect->col1 = 0;
+    rect->row0 = GRAPHICS_HEIGHT;
+    rect->row1 = 0;
+}
+
+/**
+ * dirty_extend: grow the dirty box of the current draw buffers.
+ * Coordinates must be on screen, columns are in bytes.
+ */
+static inline void dirty_extend(unsigned int col0, unsigned int col1, unsigned int row0, unsigned int row1)
+{
+    struct osd_dirty_rect *rect = dirty_current;
+
+    if (rect->buffer != draw_buffer_level) {
+        // The buffers were swapped while drawing, nothing is known about
+        // the new draw buffer any more: force a full clear next time.
+        for (int i = 0; i < 2; i++) {
+            if (dirty_rects[i].buffer == draw_buffer_level) {
+                dirty_rects[i].buffer = NULL;
+            }
+        }
+        return;
+    }
+    if (col0 < rect->col0) {
+        rect->col0 = col0;
+    }
+    if (col1 > rect->col1) {
+        rect->col1 = col1;
+    }
+    if (row0 < rect->row0) {
+        rect->row0 = row0;
+    }
+    if (row1 > rect->row1) {
+        rect->row1 = row1;
+    }
+}
+
+/**
+ * mark_dirty: record that the pixels x0..x1, y0..y1 (inclusive) of the
+ * current draw buffers were written to outside of the drawing primitives.
+ */
+void mark_dirty(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1)
+{
+    if (x0 >= GRAPHICS_WIDTH_REAL || y0 >= GRAPHICS_HEIGHT_REAL) {
+        return;
+    }
+    x1 = MIN(x1, GRAPHICS_WIDTH_REAL - 1);
+    y1 = MIN(y1, GRAPHICS_HEIGHT_REAL - 1);
+    dirty_extend(x0 / 8, x1 / 8, y0, y1);
+}
+
+/**
+ * clearGraphics: clear the draw buffers before drawing a new frame.
+ *
+ * Only the area drawn into since these buffers were last cleared is
+ * wiped. Buffers never seen before are cleared completely.
+ */
+void clearGraphics()
+{
+    struct osd_dirty_rect *rect = NULL;
+
+    for (int i = 0; i < 2; i++) {
+        if (dirty_rects[i].buffer == draw_buffer_level) {
+            rect = &dirty_rects[i];
+        }
+    }
+    if (!rect) {
+        memset((uint8_t *)draw_buffer_mask, 0, GRAPHICS_WIDTH * GRAPHICS_HEIGHT);
+        memset((uint8_t *)draw_buffer_level, 0, GRAPHICS_WIDTH * GRAPHICS_HEIGHT);
+        rect = (dirty_current == &dirty_rects[0]) ? &dirty_rects[1] : &dirty_rects[0];
+        rect->buffer = draw_buffer_level;
+    } else if (rect->col0 <= rect->col1) {
+        unsigned int offset = rect->row0 * GRAPHICS_WIDTH + rect->col0;
+        unsigned int length = rect->col1 - rect->col0 + 1;
+        unsigned int rows   = rect->row1 - rect->row0 + 1;
+        if (length == GRAPHICS_WIDTH) {
+            // full lines are contiguous
+            length *= rows;
+            rows    = 1;
+        }
+        while (rows--) {
+            memset((uint8_t *)draw_buffer_mask + offset, 0, length);
+            memset((uint8_t *)draw_buffer_level + offset, 0, length);
+            offset += GRAPHICS_WIDTH;
+        }
+    }
+    dirty_rect_reset(rect);
+    dirty_current = rect;
+}
+
+// SUPEROSD routines, modified
+
+/**
+ * write_pixel: Write a pixel at an x,y position to a given surface.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       x               x coordinate
+ * @param       y               y coordinate
+ * @param       mode    0 = clear bit, 1 = set bit, 2 = toggle bit
+ */
+void write_pixel(uint8_t *buff, unsigned int x, unsigned int y, int mode)
+{
+    CHECK_COORDS(x, y);
+    // Determine the bit in the word to be set and the word
+    // index to set it in.
+    int bitnum    = CALC_BIT_IN_WORD(x);
+    int wordnum   = CALC_BUFF_ADDR(x, y);
+    // Apply a mask.
+    uint16_t mask = 1 << (7 - bitnum);
+    WRITE_WORD_MODE(buff, wordnum, mask, mode);
+    if (mode) {
+        dirty_extend(x / 8, x / 8, y, y);
+    }
+}
+
+/**
+ * write_pixel_lm: write the pixel on both surfaces (level and mask.)
+ * Uses current draw buffer.
+ *
+ * @param       x               x coordinate
+ * @param       y               y coordinate
+ * @param       mmode   0 = clear, 1 = set, 2 = toggle
+ * @param       lmode   0 = black, 1 = white, 2 = toggle
+ */
+void write_pixel_lm(unsigned int x, unsigned int y, int mmode, int lmode)
+{
+    CHECK_COORDS(x, y);
+    // Determine the bit in the word to be set and the word
+    // index to set it in.
+    int bitnum    = CALC_BIT_IN_WORD(x);
+    int wordnum   = CALC_BUFF_ADDR(x, y);
+    // Apply the masks.
+    uint16_t mask = 1 << (7 - bitnum);
+    WRITE_WORD_MODE(draw_buffer_mask, wordnum, mask, mmode);
+    WRITE_WORD_MODE(draw_buffer_level, wordnum, mask, lmode);
+    if (mmode || lmode) {
+        dirty_extend(x / 8, x / 8, y, y);
+    }
+}
+
+/**
+ * write_span_bytes: write full bytes from p up to (not including) end.
+ * Bytes are written one at a time up to the first word boundary, then
+ * a 32 bit word at a time.
+ *
+ * @param       p               first byte
+ * @param       end             end of the span
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+static inline void write_span_bytes(uint8_t *p, uint8_t *end, int mode)
+{
+    uint8_t m = 0xff;
+
+    while (p < end && ((uintptr_t)p & 3)) {
+        WRITE_WORD_MODE(p, 0, m, mode);
+        p++;
+    }
+    osd_word_t *w    = (osd_word_t *)p;
+    osd_word_t *wend = (osd_word_t *)((uintptr_t)end & ~(uintptr_t)3);
+    switch (mode) {
+    case 0:
+        while (w < wend) {
+            *w++ = 0;
+        }
+        break;
+    case 1:
+        while (w < wend) {
+            *w++ = 0xffffffff;
+        }
+        break;
+    case 2:
+        while (w < wend) {
+            *w++ ^= 0xffffffff;
+        }
+        break;
+    }
+    for (p = (uint8_t *)w; p < end; p++) {
+        WRITE_WORD_MODE(p, 0, m, mode);
+    }
+}
+
+/**
+ * write_span: write a horizontal span of bytes addr0..addr1 (inclusive),
+ * masking the first and last byte with the edge masks.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       addr0   address of the first byte
+ * @param       addr1   address of the last byte
+ * @param       mask_l  mask for the first byte
+ * @param       mask_r  mask for the last byte
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+static inline void write_span(uint8_t *buff, unsigned int addr0, unsigned int addr1, uint8_t mask_l, uint8_t mask_r, int mode)
+{
+    /* If the addresses are equal, we only need to write one word
+     * which is an island. */
+    if (addr0 == addr1) {
+        uint8_t mask = mask_l & mask_r;
+        WRITE_WORD_MODE(buff, addr0, mask, mode);
+    } else {
+        /* Otherwise we need to write the edges and then the middle. */
+        WRITE_WORD_MODE(buff, addr0, mask_l, mode);
+        WRITE_WORD_MODE(buff, addr1, mask_r, mode);
+        write_span_bytes(buff + addr0 + 1, buff + addr1, mode);
+    }
+}
+
+/**
+ * write_hspan: write the pixels x0..x1 (inclusive) of a line.
+ * Coordinates must be on screen and x0 <= x1.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       x0              x0 coordinate
+ * @param       x1              x1 coordinate
+ * @param       y               y coordinate
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+static void write_hspan(uint8_t *buff, unsigned int x0, unsigned int x1, unsigned int y, int mode)
+{
+    /* This is an optimised algorithm for writing horizontal lines.
+     * We begin by finding the addresses of the x0 and x1 points. */
+    unsigned int addr0 = CALC_BUFF_ADDR(x0, y);
+    unsigned int addr1 = CALC_BUFF_ADDR(x1, y);
+
+    write_span(buff, addr0, addr1, COMPUTE_HLINE_EDGE_L_MASK(CALC_BIT_IN_WORD(x0)),
+               COMPUTE_HLINE_EDGE_R_MASK(CALC_BIT_IN_WORD(x1)), mode);
+    if (mode) {
+        dirty_extend(x0 / 8, x1 / 8, y, y);
+    }
+}
+
+/**
+ * write_hline: optimised horizontal line writing algorithm
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       x0              x0 coordinate
+ * @param       x1              x1 coordinate
+ * @param       y               y coordinate
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+void write_hline(uint8_t *buff, unsigned int x0, unsigned int x1, unsigned int y, int mode)
+{
+    CLIP_COORDS(x0, y);
+    CLIP_COORDS(x1, y);
+    if (x0 > x1) {
+        SWAP(x0, x1);
+    }
+    if (x0 == x1) {
+        return;
+    }
+    write_hspan(buff, x0, x1, y, mode);
+}
+
+/**
+ * write_hline_lm: write both level and mask buffers.
+ *
+ * @param       x0              x0 coordinate
+ * @param       x1              x1 coordinate
+ * @param       y               y coordinate
+ * @param       lmode   0 = clear, 1 = set, 2 = toggle
+ * @param       mmode   0 = clear, 1 = set, 2 = toggle
+ */
+void write_hline_lm(unsigned int x0, unsigned int x1, unsigned int y, int lmode, int mmode)
+{
+    // TODO: an optimisation would compute the masks and apply to
+    // both buffers simultaneously.
+    write_hline(draw_buffer_level, x0, x1, y, lmode);
+    write_hline(draw_buffer_mask, x0, x1, y, mmode);
+}
+
+/**
+ * write_hline_outlined: outlined horizontal line with varying endcaps
+ * Always uses draw buffer.
+ *
+ * @param       x0                      x0 coordinate
+ * @param       x1                      x1 coordinate
+ * @param       y                       y coordinate
+ * @param       endcap0         0 = none, 1 = single pixel, 2 = full cap
+ * @param       endcap1         0 = none, 1 = single pixel, 2 = full cap
+ * @param       mode            0 = black outline, white body, 1 = white outline, black body
+ * @param       mmode           0 = clear, 1 = set, 2 = toggle
+ */
+void write_hline_outlined(unsigned int x0, unsigned int x1, unsigned int y, int endcap0, int endcap1, int mode, int mmode)
+{
+    int stroke, fill;
+
+    SETUP_STROKE_FILL(stroke, fill, mode)
+    if (x0 > x1) {
+        SWAP(x0, x1);
+    }
+    // Draw the main body of the line.
+    write_hline_lm(x0 + 1, x1 - 1, y - 1, stroke, mmode);
+    write_hline_lm(x0 + 1, x1 - 1, y + 1, stroke, mmode);
+    write_hline_lm(x0 + 1, x1 - 1, y, fill, mmode);
+    // Draw the endcaps, if any.
+    DRAW_ENDCAP_HLINE(endcap0, x0, y, stroke, fill, mmode);
+    DRAW_ENDCAP_HLINE(endcap1, x1, y, stroke, fill, mmode);
+}
+
+/**
+ * write_vline: optimised vertical line writing algorithm
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       x               x coordinate
+ * @param       y0              y0 coordinate
+ * @param       y1              y1 coordinate
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+void write_vline(uint8_t *buff, unsigned int x, unsigned int y0, unsigned int y1, int mode)
+{
+    unsigned int a;
+
+    CLIP_COORDS(x, y0);
+    CLIP_COORDS(x, y1);
+    if (y0 > y1) {
+        SWAP(y0, y1);
+    }
+    if (y0 == y1) {
+        return;
+    }
+    /* This is an optimised algorithm for writing vertical lines.
+     * We begin by finding the addresses of the x,y0 and x,y1 points. */
+    unsigned int addr0  = CALC_BUFF_ADDR(x, y0);
+    unsigned int addr1  = CALC_BUFF_ADDR(x, y1);
+    /* Then we calculate the pixel data to be written. */
+    unsigned int bitnum = CALC_BIT_IN_WORD(x);
+    uint16_t mask = 1 << (7 - bitnum);
+    /* Run from addr0 to addr1 placing pixels. Increment by the number
+     * of words n each graphics line. */
+    for (a = addr0; a <= addr1; a += GRAPHICS_WIDTH_REAL / 8) {
+        WRITE_WORD_MODE(buff, a, mask, mode);
+    }
+    if (mode) {
+        dirty_extend(x / 8, x / 8, y0, y1);
+    }
+}
+
+/**
+ * write_vline_lm: write both level and mask buffers.
+ *
+ * @param       x               x coordinate
+ * @param       y0              y0 coordinate
+ * @param       y1              y1 coordinate
+ * @param       lmode   0 = clear, 1 = set, 2 = toggle
+ * @param       mmode   0 = clear, 1 = set, 2 = toggle
+ */
+void write_vline_lm(unsigned int x, unsigned int y0, unsigned int y1, int lmode, int mmode)
+{
+    // TODO: an optimisation would compute the masks and apply to
+    // both buffers simultaneously.
+    write_vline(draw_buffer_level, x, y0, y1, lmode);
+    write_vline(draw_buffer_mask, x, y0, y1, mmode);
+}
+
+/**
+ * write_vline_outlined: outlined vertical line with varying endcaps
+ * Always uses draw buffer.
+ *
+ * @param       x                       x coordinate
+ * @param       y0                      y0 coordinate
+ * @param       y1                      y1 coordinate
+ * @param       endcap0         0 = none, 1 = single pixel, 2 = full cap
+ * @param       endcap1         0 = none, 1 = single pixel, 2 = full cap
+ * @param       mode            0 = black outline, white body, 1 = white outline, black body
+ * @param       mmode           0 = clear, 1 = set, 2 = toggle
+ */
+void write_vline_outlined(unsigned int x, unsigned int y0, unsigned int y1, int endcap0, int endcap1, int mode, int mmode)
+{
+    int stroke, fill;
+
+    if (y0 > y1) {
+        SWAP(y0, y1);
+    }
+    SETUP_STROKE_FILL(stroke, fill, mode);
+    // Draw the main body of the line.
+    write_vline_lm(x - 1, y0 + 1, y1 - 1, stroke, mmode);
+    write_vline_lm(x + 1, y0 + 1, y1 - 1, stroke, mmode);
+    write_vline_lm(x, y0 + 1, y1 - 1, fill, mmode);
+    // Draw the endcaps, if any.
+    DRAW_ENDCAP_VLINE(endcap0, x, y0, stroke, fill, mmode);
+    DRAW_ENDCAP_VLINE(endcap1, x, y1, stroke, fill, mmode);
+}
+
+/**
+ * write_filled_rectangle: draw a filled rectangle.
+ *
+ * Uses an optimised algorithm which is similar to the horizontal
+ * line writing algorithm, but optimised for writing the lines
+ * multiple times without recalculating lots of stuff.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       x               x coordinate (left)
+ * @param       y               y coordinate (top)
+ * @param       width   rectangle width
+ * @param       height  rectangle height
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+void write_filled_rectangle(uint8_t *buff, unsigned int x, unsigned int y, unsigned int width, unsigned int height, int mode)
+{
+    CHECK_COORDS(x, y);
+    CHECK_COORD_X(x + width);
+    CHECK_COORD_Y(y + height);
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    // Calculate as if the rectangle was only a horizontal line. We then
+    // step these addresses through each row until we iterate `height` times.
+    unsigned int addr0 = CALC_BUFF_ADDR(x, y);
+    unsigned int addr1 = CALC_BUFF_ADDR(x + width, y);
+    uint8_t mask_l     = COMPUTE_HLINE_EDGE_L_MASK(CALC_BIT_IN_WORD(x));
+    uint8_t mask_r     = COMPUTE_HLINE_EDGE_R_MASK(CALC_BIT_IN_WORD(x + width));
+    if (mode) {
+        dirty_extend(x / 8, (x + width) / 8, y, y + height - 1);
+    }
+    while (height--) {
+        write_span(buff, addr0, addr1, mask_l, mask_r, mode);
+        addr0 += GRAPHICS_WIDTH_REAL / 8;
+        addr1 += GRAPHICS_WIDTH_REAL / 8;
+    }
+}
+
+/**
+ * write_filled_rectangle_lm: draw a filled rectangle on both draw buffers.
+ *
+ * @param       x               x coordinate (left)
+ * @param       y               y coordinate (top)
+ * @param       width   rectangle width
+ * @param       height  rectangle height
+ * @param       lmode   0 = clear, 1 = set, 2 = toggle
+ * @param       mmode   0 = clear, 1 = set, 2 = toggle
+ */
+void write_filled_rectangle_lm(unsigned int x, unsigned int y, unsigned int width, unsigned int height, int lmode, int mmode)
+{
+    write_filled_rectangle(draw_buffer_mask, x, y, width, height, mmode);
+    write_filled_rectangle(draw_buffer_level, x, y, width, height, lmode);
+}
+
+/**
+ * write_rectangle_outlined: draw an outline of a rectangle. Essentially
+ * a convenience wrapper for draw_hline_outlined and draw_vline_outlined.
+ *
+ * @param       x               x coordinate (left)
+ * @param       y               y coordinate (top)
+ * @param       width   rectangle width
+ * @param       height  rectangle height
+ * @param       mode    0 = black outline, white body, 1 = white outline, black body
+ * @param       mmode   0 = clear, 1 = set, 2 = toggle
+ */
+void write_rectangle_outlined(unsigned int x, unsigned int y, int width, int height, int mode, int mmode)
+{
+    // CHECK_COORDS(x, y);
+    // CHECK_COORDS(x + width, y + height);
+    // if((x + width) > DISP_WIDTH) width = DISP_WIDTH - x;
+    // if((y + height) > DISP_HEIGHT) height = DISP_HEIGHT - y;
+    write_hline_outlined(x, x + width, y, ENDCAP_ROUND, ENDCAP_ROUND, mode, mmode);
+    write_hline_outlined(x, x + width, y + height, ENDCAP_ROUND, ENDCAP_ROUND, mode, mmode);
+    write_vline_outlined(x, y, y + height, ENDCAP_ROUND, ENDCAP_ROUND, mode, mmode);
+    write_vline_outlined(x + width, y, y + height, ENDCAP_ROUND, ENDCAP_ROUND, mode, mmode);
+}
+
+/**
+ * write_circle: draw the outline of a circle on a given buffer,
+ * with an optional dash pattern for the line instead of a normal line.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       cx              origin x coordinate
+ * @param       cy              origin y coordinate
+ * @param       r               radius
+ * @param       dashp   dash period (pixels) - zero for no dash
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+void write_circle(uint8_t *buff, unsigned int cx, unsigned int cy, unsigned int r, unsigned int dashp, int mode)
+{
+    CHECK_COORDS(cx, cy);
+    int error = -r, x = r, y = 0;
+    while (x >= y) {
+        if (dashp == 0 || (y % dashp) < (dashp / 2)) {
+            CIRCLE_PLOT_8(buff, cx, cy, x, y, mode);
+        }
+        error += (y * 2) + 1;
+        y++;
+        if (error >= 0) {
+            --x;
+            error -= x * 2;
+        }
+    }
+}
+
+/**
+ * write_circle_outlined: draw an outlined circle on the draw buffer.
+ *
+ * @param       cx              origin x coordinate
+ * @param       cy              origin y coordinate
+ * @param       r               radius
+ * @param       dashp   dash period (pixels) - zero for no dash
+ * @param       bmode   0 = 4-neighbour border, 1 = 8-neighbour border
+ * @param       mode    0 = black outline, white body, 1 = white outline, black body
+ * @param       mmode   0 = clear, 1 = set, 2 = toggle
+ */
+void write_circle_outlined(unsigned int cx, unsigned int cy, unsigned int r, unsigned int dashp, int bmode, int mode, int mmode)
+{
+    int stroke, fill;
+
+    CHECK_COORDS(cx, cy);
+    SETUP_STROKE_FILL(stroke, fill, mode);
+    // This is a two step procedure. First, we draw the outline of the
+    // circle, then we draw the inner part.
+    int error = -r, x = r, y = 0;
+    while (x >= y) {
+        if (dashp == 0 || (y % dashp) < (dashp / 2)) {
+            CIRCLE_PLOT_8(draw_buffer_mask, cx, cy, x + 1, y, mmode);
+            CIRCLE_PLOT_8(draw_buffer_level, cx, cy, x + 1, y, stroke);
+            CIRCLE_PLOT_8(draw_buffer_mask, cx, cy, x, y + 1, mmode);
+            CIRCLE_PLOT_8(draw_buffer_level, cx, cy, x, y + 1, stroke);
+            CIRCLE_PLOT_8(draw_buffer_mask, cx, cy, x - 1, y, mmode);
+            CIRCLE_PLOT_8(draw_buffer_level, cx, cy, x - 1, y, stroke);
+            CIRCLE_PLOT_8(draw_buffer_mask, cx, cy, x, y - 1, mmode);
+            CIRCLE_PLOT_8(draw_buffer_level, cx, cy, x, y - 1, stroke);
+            if (bmode == 1) {
+                CIRCLE_PLOT_8(draw_buffer_mask, cx, cy, x + 1, y + 1, mmode);
+                CIRCLE_PLOT_8(draw_buffer_level, cx, cy, x + 1, y + 1, stroke);
+                CIRCLE_PLOT_8(draw_buffer_mask, cx, cy, x - 1, y - 1, mmode);
+                CIRCLE_PLOT_8(draw_buffer_level, cx, cy, x - 1, y - 1, stroke);
+            }
+        }
+        error += (y * 2) + 1;
+        y++;
+        if (error >= 0) {
+            --x;
+            error -= x * 2;
+        }
+    }
+    error = -r;
+    x     = r;
+    y     = 0;
+    while (x >= y) {
+        if (dashp == 0 || (y % dashp) < (dashp / 2)) {
+            CIRCLE_PLOT_8(draw_buffer_mask, cx, cy, x, y, mmode);
+            CIRCLE_PLOT_8(draw_buffer_level, cx, cy, x, y, fill);
+        }
+        error += (y * 2) + 1;
+        y++;
+        if (error >= 0) {
+            --x;
+            error -= x * 2;
+        }
+    }
+}
+
+/**
+ * write_circle_filled: fill a circle on a given buffer.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       cx              origin x coordinate
+ * @param       cy              origin y coordinate
+ * @param       r               radius
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+void write_circle_filled(uint8_t *buff, unsigned int cx, unsigned int cy, unsigned int r, int mode)
+{
+    CHECK_COORDS(cx, cy);
+    int error = -r, x = r, y = 0, xch = 0;
+    // It turns out that filled circles can take advantage of the midpoint
+    // circle algorithm. We simply draw very fast horizontal lines across each
+    // pair of X,Y coordinates. In some cases, this can even be faster than
+    // drawing an outlined circle!
+    //
+    // Due to multiple writes to each set of pixels, we have a special exception
+    // for when using the toggling draw mode.
+    while (x >= y) {
+        if (y != 0) {
+            write_hline(buff, cx - x, cx + x, cy + y, mode);
+            write_hline(buff, cx - x, cx + x, cy - y, mode);
+            if (mode != 2 || (mode == 2 && xch && (cx - x) != (cx - y))) {
+                write_hline(buff, cx - y, cx + y, cy + x, mode);
+                write_hline(buff, cx - y, cx + y, cy - x, mode);
+                xch = 0;
+            }
+        }
+        error += (y * 2) + 1;
+        y++;
+        if (error >= 0) {
+            --x;
+            xch    = 1;
+            error -= x * 2;
+        }
+    }
+    // Handle toggle mode.
+    if (mode == 2) {
+        write_hline(buff, cx - r, cx + r, cy, mode);
+    }
+}
+
+/**
+ * write_line_run: write one horizontal run of a line, x0 <= x1.
+ * Pixels off screen are skipped like write_pixel does.
+ */
+static inline void write_line_run(uint8_t *buff, unsigned int x0, unsigned int x1, unsigned int y, int mode)
+{
+    if (x0 >= GRAPHICS_WIDTH_REAL || y >= GRAPHICS_HEIGHT_REAL) {
+        return;
+    }
+    write_hspan(buff, x0, MIN(x1, GRAPHICS_WIDTH_REAL - 1), y, mode);
+}
+
+/**
+ * write_line: Draw a line of arbitrary angle.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       x0              first x coordinate
+ * @param       y0              first y coordinate
+ * @param       x1              second x coordinate
+ * @param       y1              second y coordinate
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+void write_line(uint8_t *buff, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, int mode)
+{
+    // Based on http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
+    unsigned int steep = abs(y1 - y0) > abs(x1 - x0);
+
+    if (steep) {
+        SWAP(x0, y0);
+        SWAP(x1, y1);
+    }
+    if (x0 > x1) {
+        SWAP(x0, x1);
+        SWAP(y0, y1);
+    }
+    int deltax     = x1 - x0;
+    unsigned int deltay = abs(y1 - y0);
+    int error      = deltax / 2;
+    int ystep;
+    unsigned int y = y0;
+    unsigned int x; // , lasty = y, stox = 0;
+    if (y0 < y1) {
+        ystep = 1;
+    } else {
+        ystep = -1;
+    }
+    if (steep) {
+        for (x = x0; x < x1; x++) {
+            write_pixel(buff, y, x, mode);
+            error -= deltay;
+            if (error < 0) {
+                y     += ystep;
+                error += deltax;
+            }
+        }
+        return;
+    }
+    // Shallow lines are made of horizontal runs, write each run as a span
+    // instead of pixel by pixel.
+    unsigned int xs = x0;
+    for (x = x0; x < x1; x++) {
+        error -= deltay;
+        if (error < 0) {
+            write_line_run(buff, xs, x, y, mode);
+            xs     = x + 1;
+            y     += ystep;
+            error += deltax;
+        }
+    }
+    if (xs < x1) {
+        write_line_run(buff, xs, x1 - 1, y, mode);
+    }
+}
+
+/**
+ * write_line_lm: Draw a line of arbitrary angle.
+ *
+ * @param       x0              first x coordinate
+ * @param       y0              first y coordinate
+ * @param       x1              second x coordinate
+ * @param       y1              second y coordinate
+ * @param       mmode   0 = clear, 1 = set, 2 = toggle
+ * @param       lmode   0 = clear, 1 = set, 2 = toggle
+ */
+void write_line_lm(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, int mmode, int lmode)
+{
+    write_line(draw_buffer_mask, x0, y0, x1, y1, mmode);
+    write_line(draw_buffer_level, x0, y0, x1, y1, lmode);
+}
+
+/**
+ * write_line_outlined: Draw a line of arbitrary angle, with an outline.
+ *
+ * @param       buff            pointer to buffer to write in
+ * @param       x0                      first x coordinate
+ * @param       y0                      first y coordinate
+ * @param       x1                      second x coordinate
+ * @param       y1                      second y coordinate
+ * @param       endcap0         0 = none, 1 = single pixel, 2 = full cap
+ * @param       endcap1         0 = none, 1 = single pixel, 2 = full cap
+ * @param       mode            0 = black outline, white body, 1 = white outline, black body
+ * @param       mmode           0 = clear, 1 = set, 2 = toggle
+ */
+void write_line_outlined(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1,
+                         __attribute__((unused)) int endcap0, __attribute__((unused)) int endcap1,
+                         int mode, int mmode)
+{
+    // Based on http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
+    // This could be improved for speed.
+    int omode, imode;
+
+    if (mode == 0) {
+        omode = 0;
+        imode = 1;
+    } else {
+        omode = 1;
+        imode = 0;
+    }
+    int steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) {
+        SWAP(x0, y0);
+        SWAP(x1, y1);
+    }
+    if (x0 > x1) {
+        SWAP(x0, x1);
+        SWAP(y0, y1);
+    }
+    int deltax     = x1 - x0;
+    unsigned int deltay = abs(y1 - y0);
+    int error      = deltax / 2;
+    int ystep;
+    unsigned int y = y0;
+    unsigned int x;
+    if (y0 < y1) {
+        ystep = 1;
+    } else {
+        ystep = -1;
+    }
+    // Draw the outline.
+    for (x = x0; x < x1; x++) {
+        if (steep) {
+            write_pixel_lm(y - 1, x, mmode, omode);
+            write_pixel_lm(y + 1, x, mmode, omode);
+            write_pixel_lm(y, x - 1, mmode, omode);
+            write_pixel_lm(y, x + 1, mmode, omode);
+        } else {
+            write_pixel_lm(x - 1, y, mmode, omode);
+            write_pixel_lm(x + 1, y, mmode, omode);
+            write_pixel_lm(x, y - 1, mmode, omode);
+            write_pixel_lm(x, y + 1, mmode, omode);
+        }
+        error -= deltay;
+        if (error < 0) {
+            y     += ystep;
+            error += deltax;
+        }
+    }
+    // Now draw the innards.
+    error = deltax / 2;
+    y     = y0;
+    for (x = x0; x < x1; x++) {
+        if (steep) {
+            write_pixel_lm(y, x, mmode, imode);
+        } else {
+            write_pixel_lm(x, y, mmode, imode);
+        }
+        error -= deltay;
+        if (error < 0) {
+            y     += ystep;
+            error += deltax;
+        }
+    }
+}
+
+/**
+ * dirty_extend_word: mark the three bytes a misaligned word may touch.
+ */
+static inline void dirty_extend_word(unsigned int addr)
+{
+    unsigned int row = addr / GRAPHICS_WIDTH;
+    unsigned int col = addr % GRAPHICS_WIDTH;
+
+    if (row < GRAPHICS_HEIGHT) {
+        dirty_extend(col, MIN(col + 2, GRAPHICS_WIDTH - 1), row, row);
+    }
+}
+
+/**
+ * write_word_misaligned: Write a misaligned word across two addresses
+ * with an x offset.
+ *
+ * This allows for many pixels to be set in one write.
+ *
+ * @param       buff    buffer to write in
+ * @param       word    word to write (16 bits)
+ * @param       addr    address of first word
+ * @param       xoff    x offset (0-15)
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+void write_word_misaligned(uint8_t *buff, uint16_t word, unsigned int addr, unsigned int xoff, int mode)
+{
+    int16_t firstmask = word >> xoff;
+    int16_t lastmask  = word << (16 - xoff);
+
+    WRITE_WORD_MODE(buff, addr + 1, firstmask & 0x00ff, mode);
+    WRITE_WORD_MODE(buff, addr, (firstmask & 0xff00) >> 8, mode);
+    if (xoff > 0) {
+        WRITE_WORD_MODE(buff, addr + 2, (lastmask & 0xff00) >> 8, mode);
+    }
+    if (mode) {
+        dirty_extend_word(addr);
+    }
+}
+
+/**
+ * write_word_misaligned_NAND: Write a misaligned word across two addresses
+ * with an x offset, using a NAND mask.
+ *
+ * This allows for many pixels to be set in one write.
+ *
+ * @param       buff    buffer to write in
+ * @param       word    word to write (16 bits)
+ * @param       addr    address of first word
+ * @param       xoff    x offset (0-15)
+ *
+ * This is identical to calling write_word_misaligned with a mode of 0 but
+ * it doesn't go through a lot of switch logic which slows down text writing
+ * a lot.
+ */
+void write_word_misaligned_NAND(uint8_t *buff, uint16_t word, unsigned int addr, unsigned int xoff)
+{
+    uint16_t firstmask = word >> xoff;
+    uint16_t lastmask  = word << (16 - xoff);
+
+    WRITE_WORD_NAND(buff, addr + 1, firstmask & 0x00ff);
+    WRITE_WORD_NAND(buff, addr, (firstmask & 0xff00) >> 8);
+    if (xoff > 0) {
+        WRITE_WORD_NAND(buff, addr + 2, (lastmask & 0xff00) >> 8);
+    }
+}
+
+/**
+ * write_word_misaligned_OR: Write a misaligned word across two addresses
+ * with an x offset, using an OR mask.
+ *
+ * This allows for many pixels to be set in one write.
+ *
+ * @param       buff    buffer to write in
+ * @param       word    word to write (16 bits)
+ * @param       addr    address of first word
+ * @param       xoff    x offset (0-15)
+ *
+ * This is identical to calling write_word_misaligned with a mode of 1 but
+ * it doesn't go through a lot of switch logic which slows down text writing
+ * a lot.
+ */
+void write_word_misaligned_OR(uint8_t *buff, uint16_t word, unsigned int addr, unsigned int xoff)
+{
+    uint16_t firstmask = word >> xoff;
+    uint16_t lastmask  = word << (16 - xoff);
+
+    WRITE_WORD_OR(buff, addr + 1, firstmask & 0x00ff);
+    WRITE_WORD_OR(buff, addr, (firstmask & 0xff00) >> 8);
+    if (xoff > 0) {
+        WRITE_WORD_OR(buff, addr + 2, (lastmask & 0xff00) >> 8);
+    }
+    dirty_extend_word(addr);
+}
+
+/**
+ * write_word_misaligned_lm: Write a misaligned word across two
+ * words, in both level and mask buffers. This is core to the text
+ * writing routines.
+ *
+ * @param       buff    buffer to write in
+ * @param       word    word to write (16 bits)
+ * @param       addr    address of first word
+ * @param       xoff    x offset (0-15)
+ * @param       lmode   0 = clear, 1 = set, 2 = toggle
+ * @param       mmode   0 = clear, 1 = set, 2 = toggle
+ */
+void write_word_misaligned_lm(uint16_t wordl, uint16_t wordm, unsigned int addr, unsigned int xoff, int lmode, int mmode)
+{
+    write_word_misaligned(draw_buffer_level, wordl, addr, xoff, lmode);
+    write_word_misaligned(draw_buffer_mask, wordm, addr, xoff, mmode);
+}
+
+/**
+ * write_glyph_row: Write one row of a character to both draw buffers in
+ * a single pass. The row masks are shifted into place once, into a 32 bit
+ * word covering the (up to) three bytes the row touches.
+ *
+ * @param       addr    address of first byte
+ * @param       xoff    x offset (0-7)
+ * @param       mask    left aligned row mask, pixels to show
+ * @param       set             left aligned level bits to set
+ * @param       clear   left aligned level bits to clear after setting
+ */
+static inline void write_glyph_row(unsigned int addr, unsigned int xoff, uint16_t mask, uint16_t set, uint16_t clear)
+{
+    uint32_t m = (uint32_t)mask << (16 - xoff);
+    uint32_t s = (uint32_t)set << (16 - xoff);
+    uint32_t c = (uint32_t)clear << (16 - xoff);
+
+    draw_buffer_mask[addr]      |= m >> 24;
+    draw_buffer_level[addr]      = (draw_buffer_level[addr] | (s >> 24)) & ~(c >> 24);
+    draw_buffer_mask[addr + 1]  |= m >> 16;
+    draw_buffer_level[addr + 1]  = (draw_buffer_level[addr + 1] | (s >> 16)) & ~(c >> 16);
+    // Only touch the third byte if the row spills into it.
+    if (m & 0xff00) {
+        draw_buffer_mask[addr + 2]  |= m >> 8;
+        draw_buffer_level[addr + 2]  = (draw_buffer_level[addr + 2] | (s >> 8)) & ~(c >> 8);
+    }
+}
+
+/**
+ * fetch_font_info: Fetch font info structs.
+ *
+ * @param       ch              character
+ * @param       font    font id
+ */
+int fetch_font_info(uint8_t ch, int font, struct FontEntry *font_info, char *lookup)
+{
+    // First locate the font struct.
+    if ((unsigned int)font > SIZEOF_ARRAY(fonts)) {
+        return 0; // font does not exist, exit.
+    }
+    // Load the font info; IDs are always sequential.
+    *font_info = fonts[font];
+    // Locate character in font lookup table. (If required.)
+    if (lookup != NULL) {
+        *lookup = font_info->lookup[ch];
+        if ((uint8_t)*lookup == 0xff) {
+            return 0; // character doesn't exist, don't bother writing it.
+        }
+    }
+    return 1;
+}
+
+/**
+ * write_char16: Draw a character on the current draw buffer.
+ * Currently supports outlined characters and characters with
+ * a width of up to 8 pixels.
+ *
+ * @param       ch              character to write
+ * @param       x               x coordinate (left)
+ * @param       y               y coordinate (top)
+ * @param       flags   flags to write with (see gfx.h)
+ * @param       font    font to use
+ */
+void write_char16(char ch, unsigned int x, unsigned int y, int font)
+{
+    unsigned int yy, row, xshift, height;
+    uint16_t mask, levels;
+    struct FontEntry font_info;
+
+    // char lookup = 0;
+    fetch_font_info(0, font, &font_info, NULL);
+
+    // Compute starting address (for x,y) of character.
+    int addr = CALC_BUFF_ADDR(x, y);
+    int wbit = CALC_BIT_IN_WORD(x);
+    // If font only supports lowercase or uppercase, make the letter
+    // lowercase or uppercase.
+    // How big is the character? We handle characters up to 8 pixels
+    // wide for now. Support for large characters may be added in future.
+    {
+        // Ensure we don't overflow.
+        if (x + wbit > GRAPHICS_WIDTH_REAL || y >= GRAPHICS_HEIGHT_REAL) {
+            return;
+        }
+        height = MIN(font_info.height, GRAPHICS_HEIGHT_REAL - y);
+        // Load data pointer.
+        row    = ch * font_info.height;
+        xshift = 16 - font_info.width;
+        // Level bits are more complicated. We need to set or clear
+        // level bits, but only where the mask bit is set; otherwise,
+        // we need to leave them alone. To do this, for each word, we
+        // construct an AND mask and an OR mask, and apply each individually.
+        // Both buffers are written in the same pass.
+        for (yy = 0; yy < height; yy++) {
+            if (font == 3) {
+                mask   = font_mask12x18[row];
+                levels = font_frame12x18[row];
+            } else {
+                mask   = font_mask8x10[row];
+                levels = font_frame8x10[row];
+            }
+            // if(!(flags & FONT_INVERT)) // data is normally inverted
+            levels = ~levels;
+            // If we're not bold write the AND mask.
+            // if(!(flags & FONT_BOLD))
+            write_glyph_row(addr, wbit, mask << xshift, mask << xshift, (mask & levels) << xshift);
+            addr += GRAPHICS_WIDTH_REAL / 8;
+            row++;
+        }
+        dirty_extend(x / 8, MIN(x / 8 + 2, GRAPHICS_WIDTH - 1), y, y + height - 1);
+    }
+}
+
+/**
+ * write_char: Draw a character on the current draw buffer.
+ * Currently supports outlined characters and characters with
+ * a width of up to 8 pixels.
+ *
+ * @param       ch              character to write
+ * @param       x               x coordinate (left)
+ * @param       y               y coordinate (top)
+ * @param       flags   flags to write with (see gfx.h)
+ * @param       font    font to use
+ */
+void write_char(char ch, unsigned int x, unsigned int y, int flags, int font)
+{
+    unsigned int yy, row, xshift, height;
+    uint16_t mask, levels;
+    struct FontEntry font_info;
+    char lookup = 0;
+
+    fetch_font_info(ch, font, &font_info, &lookup);
+    // Compute starting address (for x,y) of character.
+    unsigned int addr = CALC_BUFF_ADDR(x, y);
+    unsigned int wbit = CALC_BIT_IN_WORD(x);
+    // If font only supports lowercase or uppercase, make the letter
+    // lowercase or uppercase.
+    /*if(font_info.flags & FONT_LOWERCASE_ONLY)
+       ch = tolower(ch);
+       if(font_info.flags & FONT_UPPERCASE_ONLY)
+       ch = toupper(ch);*/
+    if (!fetch_font_info(ch, font, &font_info, &lookup)) {
+        return;
+    }
+    // How big is the character? We handle characters up to 8 pixels
+    // wide for now. Support for large characters may be added in future.
+    if (font_info.width <= 8) {
+        // Ensure we don't overflow.
+        if (x + wbit > GRAPHICS_WIDTH_REAL || y >= GRAPHICS_HEIGHT_REAL) {
+            return;
+        }
+        height = MIN(font_info.height, GRAPHICS_HEIGHT_REAL - y);
+        // Load data pointer.
+        row    = lookup * font_info.height * 2;
+        xshift = 16 - font_info.width;
+        // Level bits are more complicated. We need to set or clear
+        // level bits, but only where the mask bit is set; otherwise,
+        // we need to leave them alone. To do this, for each word, we
+        // construct an AND mask and an OR mask, and apply each individually.
+        // Mask bits are written in the same pass.
+        for (yy = 0; yy < height; yy++) {
+            mask   = (uint8_t)font_info.data[row];
+            levels = (uint8_t)font_info.data[row + font_info.height];
+            if (!(flags & FONT_INVERT)) {
+                // data is normally inverted
+                levels = ~levels;
+            }
+            // If we're not bold write the AND mask.
+            // if(!(flags & FONT_BOLD))
+            write_glyph_row(addr, wbit, mask << xshift, mask << xshift, (mask & levels) << xshift);
+            addr += GRAPHICS_WIDTH_REAL / 8;
+            row++;
+        }
+        dirty_extend(x / 8, MIN(x / 8 + 2, GRAPHICS_WIDTH - 1), y, y + height - 1);
+    }
+}
+
+/**
+ * calc_text_dimensions: Calculate the dimensions of a
+ * string in a given font. Supports new lines and
+ * carriage returns in text.
+ *
+ * @param       str                     string to calculate dimensions of
+ * @param       font_info       font info structure
+ * @param       xs                      horizontal spacing
+ * @param       ys                      vertical spacing
+ * @param       dim                     return result: struct FontDimensions
+ */
+void calc_text_dimensions(char *str, struct FontEntry font, int xs, int ys, struct FontDimensions *dim)
+{
+    int max_length = 0, line_length = 0, lines = 1;
+
+    while (*str != 0) {
+        line_length++;
+        if (*str == '\n' || *str == '\r') {
+            if (line_length > max_length) {
+                max_length = line_length;
+            }
+            line_length = 0;
+            lines++;
+        }
+        str++;
+    }
+    if (line_length > max_length) {
+        max_length = line_length;
+    }
+    dim->width  = max_length * (font.width + xs);
+    dim->height = lines * (font.height + ys);
+}
+
+/**
+ * write_string: Draw a string on the screen with certain
+ * alignment parameters.
+ *
+ * @param       str             string to write
+ * @param       x               x coordinate
+ * @param       y               y coordinate
+ * @param       xs              horizontal spacing
+ * @param       ys              horizontal spacing
+ * @param       va              vertical align
+ * @param       ha              horizontal align
+ * @param       flags   flags (passed to write_char)
+ * @param       font    font
+ */
+void write_string(char *str, unsigned int x, unsigned int y, unsigned int xs, unsigned int ys, int va, int ha, int flags, int font)
+{
+    int xx = 0, yy = 0, xx_original = 0;
+    struct FontEntry font_info;
+    struct FontDimensions dim;
+
+    // Determine font info and dimensions/position of the string.
+    fetch_font_info(0, font, &font_info, NULL);
+    calc_text_dimensions(str, font_info, xs, ys, &dim);
+    switch (va) {
+    case TEXT_VA_TOP:
+        yy = y;
+        break;
+    case TEXT_VA_MIDDLE:
+        yy = y - (dim.height / 2);
+        break;
+    case TEXT_VA_BOTTOM:
+        yy = y - dim.height;
+        break;
+    }
+    switch (ha) {
+    case TEXT_HA_LEFT:
+        xx = x;
+        break;
+    case TEXT_HA_CENTER:
+        xx = x - (dim.width / 2);
+        break;
+    case TEXT_HA_RIGHT:
+        xx = x - dim.width;
+        break;
+    }
+    // Then write each character.
+    xx_original = xx;
+    while (*str != 0) {
+        if (*str == '\n' || *str == '\r') {
+            yy += ys + font_info.height;
+            xx  = xx_original;
+        } else {
+            if (xx >= 0 && xx < GRAPHICS_WIDTH_REAL) {
+                if (font_info.id < 2) {
+                    write_char(*str, xx, yy, flags, font);
+                } else {
+                    write_char16(*str, xx, yy, font);
+                }
+            }
+            xx += font_info.width + xs;
+        }
+        str++;
+    }
+}
+
+/**
+ * write_string_formatted: Draw a string with format escape
+ * sequences in it. Allows for complex text effects.
+ *
+ * @param       str             string to write (with format data)
+ * @param       x               x coordinate
+ * @param       y               y coordinate
+ * @param       xs              default horizontal spacing
+ * @param       ys              default horizontal spacing
+ * @param       va              vertical align
+ * @param       ha              horizontal align
+ * @param       flags   flags (passed to write_char)
+ */
+void write_string_formatted(char *str, unsigned int x, unsigned int y, unsigned int xs, unsigned int ys,
+                            __attribute__((unused)) int va, __attribute__((unused)) int ha, int flags)
+{
+    int fcode = 0, fptr = 0, font = 0, fwidth = 0, fheight = 0, xx = x, yy = y, max_xx = 0, max_height = 0;
+    struct FontEntry font_info;
+
+    // Retrieve sizes of the fonts: bigfont and smallfont.
+    fetch_font_info(0, 0, &font_info, NULL);
+    int smallfontwidth = font_info.width, smallfontheight = font_info.height;
+    fetch_font_info(0, 1, &font_info, NULL);
+    int bigfontwidth   = font_info.width, bigfontheight = font_info.height;
+    // 11 byte stack with last byte as NUL.
+    char fstack[11];
+    fstack[10] = '\0';
+    // First, we need to parse the string for format characters and
+    // work out a bounding box. We'll parse again for the final output.
+    // This is a simple state machine parser.
+    char *ostr = str;
+    while (*str) {
+        if (*str == '<' && fcode == 1) {
+            // escape code: skip
+            fcode = 0;
+        }
+        if (*str == '<' && fcode == 0) {
+            // begin format code?
+            fcode = 1;
+            fptr  = 0;
+        }
+        if (*str == '>' && fcode == 1) {
+            fcode = 0;
+            if (strcmp(fstack, "B")) {
+                // switch to "big" font (font #1)
+                fwidth  = bigfontwidth;
+                fheight = bigfontheight;
+            } else if (strcmp(fstack, "S")) {
+                // switch to "small" font (font #0)
+                fwidth  = smallfontwidth;
+                fheight = smallfontheight;
+            }
+            if (fheight > max_height) {
+                max_height = fheight;
+            }
+            // Skip over this byte. Go to next byte.
+            str++;
+            continue;
+        }
+        if (*str != '<' && *str != '>' && fcode == 1) {
+            // Add to the format stack (up to 10 bytes.)
+            if (fptr > 10) {
+                // stop adding bytes
+                str++; // go to next byte
+                continue;
+            }
+            fstack[fptr++] = *str;
+            fstack[fptr]   = '\0'; // clear next byte (ready for next char or to terminate string.)
+        }
+        if (fcode == 0) {
+            // Not a format code, raw text.
+            xx += fwidth + xs;
+            if (*str == '\n') {
+                if (xx > max_xx) {
+                    max_xx = xx;
+                }
+                xx  = x;
+                yy += fheight + ys;
+            }
+        }
+        str++;
+    }
+    // Reset string pointer.
+    str = ostr;
+    // Now we've parsed it and got a bbox, we need to work out the dimensions of it
+    // and how to align it.
+    /*int width = max_xx - x;
+       int height = yy - y;
+       int ay, ax;
+       switch(va)
+       {
+       case TEXT_VA_TOP:               ay = yy; break;
+       case TEXT_VA_MIDDLE:    ay = yy - (height / 2); break;
+       case TEXT_VA_BOTTOM:    ay = yy - height; break;
+       }
+       switch(ha)
+       {
+       case TEXT_HA_LEFT:              ax = x; break;
+       case TEXT_HA_CENTER:    ax = x - (width / 2); break;
+       case TEXT_HA_RIGHT:             ax = x - width; break;
+       }*/
+    // So ax,ay is our new text origin. Parse the text format again and paint
+    // the text on the display.
+    fcode = 0;
+    fptr  = 0;
+    font  = 0;
+    xx    = 0;
+    yy    = 0;
+    while (*str) {
+        if (*str == '<' && fcode == 1) {
+            // escape code: skip
+            fcode = 0;
+        }
+        if (*str == '<' && fcode == 0) {
+            // begin format code?
+            fcode = 1;
+            fptr  = 0;
+        }
+        if (*str == '>' && fcode == 1) {
+            fcode = 0;
+            if (strcmp(fstack, "B")) {
+                // switch to "big" font (font #1)
+                fwidth  = bigfontwidth;
+                fheight = bigfontheight;
+                font    = 1;
+            } else if (strcmp(fstack, "S")) {
+                // switch to "small" font (font #0)
+                fwidth  = smallfontwidth;
+                fheight = smallfontheight;
+                font    = 0;
+            }
+            // Skip over this byte. Go to next byte.
+            str++;
+            continue;
+        }
+        if (*str != '<' && *str != '>' && fcode == 1) {
+            // Add to the format stack (up to 10 bytes.)
+            if (fptr > 10) {
+                // stop adding bytes
+                str++; // go to next byte
+                continue;
+            }
+            fstack[fptr++] = *str;
+            fstack[fptr]   = '\0'; // clear next byte (ready for next char or to terminate string.)
+        }
+        if (fcode == 0) {
+            // Not a format code, raw text. So we draw it.
+            // TODO - different font sizes.
+            write_char(*str, xx, yy + (max_height - fheight), flags, font);
+            xx += fwidth + xs;
+            if (*str == '\n') {
+                if (xx > max_xx) {
+                    max_xx = xx;
+                }
+                xx  = x;
+                yy += fheight + ys;
+            }
+        }
+        str++;
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
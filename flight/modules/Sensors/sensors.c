@@ -61,6 +61,7 @@
 #include <revosettings.h>
 
 #include <mathmisc.h>
+#include <decimator.h>
 #include <taskinfo.h>
 #include <pios_math.h>
 #include <pios_constants.h>
@@ -101,12 +102,16 @@ static const float temp_alpha_baro = TEMP_DT_BARO / (TEMP_DT_BARO + 1.0f / (2.0f
 
 
 #define ZERO_ROT_ANGLE           0.00001f
+
+// task periods over which the gyro sample rate is measured for the decimator
+#define GYRO_RATE_PERIODS        32
 // Private types
 typedef struct {
     // used to accumulate all samples in a task iteration
     Vector3i32 accum[2];
     int32_t    temperature;
     uint32_t   count;
+    uint32_t   timestamp; // raw delay timer, the newest sample was read from the driver
 } sensor_fetch_context;
 
 #define MAX_SENSOR_DATA_SIZE (sizeof(PIOS_SENSORS_3Axis_SensorsWithTemp) + MAX_SENSORS_PER_INSTANCE * sizeof(Vector3i16))
@@ -129,17 +134,24 @@ PERF_DEFINE_COUNTER(counterSensorResets);
 static void SensorsTask(void *parameters);
 static void settingsUpdatedCb(UAVObjEvent *objEv);
 
-static void accumulateSamples(sensor_fetch_context *sensor_context, sensor_data *sample);
+static void accumulateSamples(sensor_fetch_context *sensor_context, sensor_data *sample, const PIOS_SENSORS_Instance *sensor);
 static void processSamples3d(sensor_fetch_context *sensor_context, const PIOS_SENSORS_Instance *sensor);
 static void processSamples1d(PIOS_SENSORS_1Axis_SensorsWithTemp *sample, const PIOS_SENSORS_Instance *sensor);
 
 static void clearContext(sensor_fetch_context *sensor_context);
 
-static void handleAccel(float *samples, float temperature);
-static void handleGyro(float *samples, float temperature);
-static void handleMag(float *samples, float temperature);
+static void handleAccel(const Vector3f *sample, float temperature);
+static void handleGyro(const Vector3f *sample, float temperature, uint32_t timestamp);
+static void handleMag(const Vector3f *sample, float temperature);
 static void handleBaro(float sample, float temperature);
 
+static void updateAccelCalibration(void);
+static void updateGyroCalibration(void);
+static void updateMagCalibration(void);
+
+static uint8_t gyroIndex(const PIOS_SENSORS_Instance *sensor);
+static void configureGyroDecimator(uint32_t samples_per_period);
+
 static void updateAccelTempBias(float temperature);
 static void updateGyroTempBias(float temperature);
 static void updateBaroTempBias(float temperature);
@@ -171,6 +183,21 @@ static uint8_t gyro_temp_calibration_count  = 0;
 static float R[3][3] = {
     { 0 }
 };
+
+// bias, scale, temperature bias and board rotation folded into one transform per sensor
+static Vector3Transformf accel_calibration;
+static Vector3Transformf gyro_calibration;
+static Vector3Transformf mag_calibration;
+
+// decimation of the oversampled gyro stream, see RevoSettings.GyroDecimation
+static struct Decimator gyro_decimator;
+static RevoSettingsGyroDecimationOptions gyro_decimation;
+static RevoSettingsGyroDecimationFilterData gyro_decimation_filter;
+static volatile bool gyro_decimator_dirty = true;
+static bool gyro_decimator_active = false;
+static uint32_t gyro_rate_samples = 0;
+static uint8_t gyro_rate_periods  = 0;
+
 // Variables used to handle baro temperature bias
 static RevoSettingsBaroTempCorrectionPolynomialData baroCorrection;
 static RevoSettingsBaroTempCorrectionExtentData baroCorrectionExtent;
@@ -299,7 +326,7 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
                 while (xQueueReceive(queue,
                                      (void *)source_data,
                                      (is_primary && !sensor_context.count) ? sensor_period_ticks : 0) == pdTRUE) {
-                    accumulateSamples(&sensor_context, source_data);
+                    accumulateSamples(&sensor_context, source_data, sensor);
                 }
                 if (sensor_context.count) {
                     processSamples3d(&sensor_context, sensor);
@@ -314,7 +341,7 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
                 if (PIOS_SENSORS_Poll(sensor)) {
                     PIOS_SENSOR_Fetch(sensor, (void *)source_data, MAX_SENSORS_PER_INSTANCE);
                     if (sensor->type & PIOS_SENSORS_TYPE_3D) {
-                        accumulateSamples(&sensor_context, source_data);
+                        accumulateSamples(&sensor_context, source_data, sensor);
                         processSamples3d(&sensor_context, sensor);
                     } else {
                         processSamples1d(&source_data->sensorSample1Axis, sensor);
@@ -341,8 +368,11 @@ static void clearContext(sensor_fetch_context *sensor_context)
     sensor_context->count = 0;
 }
 
-static void accumulateSamples(sensor_fetch_context *sensor_context, sensor_data *sample)
+static void accumulateSamples(sensor_fetch_context *sensor_context, sensor_data *sample, const PIOS_SENSORS_Instance *sensor)
 {
+    if (gyro_decimator_active && (sensor->type & PIOS_SENSORS_TYPE_3AXIS_GYRO)) {
+        DecimatorPush(&gyro_decimator, &sample->sensorSample3Axis.sample[gyroIndex(sensor)]);
+    }
     for (uint32_t i = 0; (i < MAX_SENSORS_PER_INSTANCE) && (i < sample->sensorSample3Axis.count); i++) {
         sensor_context->accum[i].x += sample->sensorSample3Axis.sample[i].x;
         sensor_context->accum[i].y += sample->sensorSample3Axis.sample[i].y;
@@ -350,47 +380,99 @@ static void accumulateSamples(sensor_fetch_context *sensor_context, sensor_data
     }
     sensor_context->temperature += sample->sensorSample3Axis.temperature;
     sensor_context->count++;
+    sensor_context->timestamp    = PIOS_DELAY_GetRaw();
 }
 
 static void processSamples3d(sensor_fetch_context *sensor_context, const PIOS_SENSORS_Instance *sensor)
 {
-    float samples[3];
-    float temperature;
+    Vector3f samples[MAX_SENSORS_PER_INSTANCE];
     float scales[MAX_SENSORS_PER_INSTANCE];
 
     PIOS_SENSORS_GetScales(sensor, scales, MAX_SENSORS_PER_INSTANCE);
-    float inv_count = 1.0f / (float)sensor_context->count;
-    if ((sensor->type & PIOS_SENSORS_TYPE_3AXIS_ACCEL) ||
-        (sensor->type == PIOS_SENSORS_TYPE_3AXIS_MAG)) {
-        float t = inv_count * scales[0];
-        samples[0]  = ((float)sensor_context->accum[0].x * t);
-        samples[1]  = ((float)sensor_context->accum[0].y * t);
-        samples[2]  = ((float)sensor_context->accum[0].z * t);
-        temperature = (float)sensor_context->temperature * inv_count * 0.01f;
-        if (sensor->type == PIOS_SENSORS_TYPE_3AXIS_MAG) {
-            handleMag(samples, temperature);
-            PERF_MEASURE_PERIOD(counterMagPeriod);
-            return;
-        } else {
-            PERF_TRACK_VALUE(counterAccelSamples, sensor_context->count);
-            PERF_MEASURE_PERIOD(counterAccelPeriod);
-            handleAccel(samples, temperature);
-        }
+    float inv_count   = 1.0f / (float)sensor_context->count;
+    float temperature = (float)sensor_context->temperature * inv_count * 0.01f;
+
+    if (sensor->type == PIOS_SENSORS_TYPE_3AXIS_MAG) {
+        vector3_transform_i32f(&mag_calibration, inv_count * scales[0], &sensor_context->accum[0], &samples[0], 1);
+        handleMag(&samples[0], temperature);
+        PERF_MEASURE_PERIOD(counterMagPeriod);
+        return;
+    }
+
+    if (sensor->type & PIOS_SENSORS_TYPE_3AXIS_ACCEL) {
+        updateAccelTempBias(temperature);
+        vector3_transform_i32f(&accel_calibration, inv_count * scales[0], &sensor_context->accum[0], &samples[0], 1);
+        PERF_TRACK_VALUE(counterAccelSamples, sensor_context->count);
+        PERF_MEASURE_PERIOD(counterAccelPeriod);
+        handleAccel(&samples[0], temperature);
     }
 
     if (sensor->type & PIOS_SENSORS_TYPE_3AXIS_GYRO) {
-        uint8_t index = 0;
-        if (sensor->type == PIOS_SENSORS_TYPE_3AXIS_GYRO_ACCEL) {
-            index = 1;
+        uint8_t index = gyroIndex(sensor);
+        Vector3f decimated;
+
+        if (gyro_decimator_dirty) {
+            // measure the gyro rate over some periods, a single one may hold a backlog
+            gyro_rate_samples += sensor_context->count;
+            if (++gyro_rate_periods == GYRO_RATE_PERIODS) {
+                configureGyroDecimator((gyro_rate_samples + GYRO_RATE_PERIODS / 2) / GYRO_RATE_PERIODS);
+                gyro_rate_samples = 0;
+                gyro_rate_periods = 0;
+            }
+        }
+        updateGyroTempBias(temperature);
+        if (gyro_decimator_active && DecimatorGet(&gyro_decimator, &decimated)) {
+            // newest output of the decimation filter
+            decimated.x *= scales[index];
+            decimated.y *= scales[index];
+            decimated.z *= scales[index];
+            vector3_transformf(&gyro_calibration, &decimated, &samples[index], 1);
+        } else {
+            // plain average of the period, also while the decimator settles
+            vector3_transform_i32f(&gyro_calibration, inv_count * scales[index], &sensor_context->accum[index], &samples[index], 1);
         }
-        float t = inv_count * scales[index];
-        samples[0]  = ((float)sensor_context->accum[index].x * t);
-        samples[1]  = ((float)sensor_context->accum[index].y * t);
-        samples[2]  = ((float)sensor_context->accum[index].z * t);
-        temperature = (float)sensor_context->temperature * inv_count * 0.01f;
-        handleGyro(samples, temperature);
+        handleGyro(&samples[index], temperature, sensor_context->timestamp);
+    }
+}
+
+static uint8_t gyroIndex(const PIOS_SENSORS_Instance *sensor)
+{
+    // combined sensors deliver the accels first
+    return (sensor->type == PIOS_SENSORS_TYPE_3AXIS_GYRO_ACCEL) ? 1 : 0;
+}
+
+/**
+ * Set up the gyro decimation for the number of gyro samples that arrive in one
+ * task period. The CIC decimates to four times the task rate, so that the task
+ * publishes an output at most a quarter period old, and the biquads run there.
+ */
+static void configureGyroDecimator(uint32_t samples_per_period)
+{
+    gyro_decimator_dirty  = false;
+    gyro_decimator_active = false;
+
+    if (gyro_decimation == REVOSETTINGS_GYRODECIMATION_AVERAGE || samples_per_period == 0) {
+        return;
+    }
+
+    const uint8_t order = (gyro_decimation == REVOSETTINGS_GYRODECIMATION_CIC3) ? 3 : 2;
+    const uint8_t ratio = (samples_per_period >= 8) ? MIN(samples_per_period / 4, 255) : 1;
+    if (!DecimatorInit(&gyro_decimator, order, ratio)) {
         return;
     }
+
+    const float rate = PIOS_SENSOR_RATE * (float)samples_per_period / (float)ratio;
+    struct BiquadDF2Filter biquad;
+    if (gyro_decimation_filter.LowpassCutoff > 0.0f && gyro_decimation_filter.LowpassCutoff < 0.5f * rate) {
+        InitBiquadDF2Lowpass(gyro_decimation_filter.LowpassCutoff / rate, &biquad);
+        DecimatorAddBiquad(&gyro_decimator, &biquad);
+    }
+    if (gyro_decimation_filter.NotchFrequency > 0.0f && gyro_decimation_filter.NotchFrequency < 0.5f * rate &&
+        gyro_decimation_filter.NotchQ > 0.0f) {
+        InitBiquadDF2Notch(gyro_decimation_filter.NotchFrequency / rate, gyro_decimation_filter.NotchQ, &biquad);
+        DecimatorAddBiquad(&gyro_decimator, &biquad);
+    }
+    gyro_decimator_active = true;
 }
 
 static void processSamples1d(PIOS_SENSORS_1Axis_SensorsWithTemp *sample, const PIOS_SENSORS_Instance *sensor)
@@ -406,53 +488,37 @@ static void processSamples1d(PIOS_SENSORS_1Axis_SensorsWithTemp *sample, const P
     }
 }
 
-static void handleAccel(float *samples, float temperature)
+static void handleAccel(const Vector3f *sample, float temperature)
 {
     AccelSensorData accelSensorData;
 
-    updateAccelTempBias(temperature);
-    float accels_out[3] = { (samples[0] - agcal.accel_bias.X) * agcal.accel_scale.X - accel_temp_bias[0],
-                            (samples[1] - agcal.accel_bias.Y) * agcal.accel_scale.Y - accel_temp_bias[1],
-                            (samples[2] - agcal.accel_bias.Z) * agcal.accel_scale.Z - accel_temp_bias[2] };
-
-    rot_mult(R, accels_out, samples);
-    accelSensorData.x = samples[0];
-    accelSensorData.y = samples[1];
-    accelSensorData.z = samples[2];
+    accelSensorData.x = sample->x;
+    accelSensorData.y = sample->y;
+    accelSensorData.z = sample->z;
     accelSensorData.temperature = temperature;
     AccelSensorSet(&accelSensorData);
 }
 
-static void handleGyro(float *samples, float temperature)
+static void handleGyro(const Vector3f *sample, float temperature, uint32_t timestamp)
 {
     GyroSensorData gyroSensorData;
 
-    updateGyroTempBias(temperature);
-    float gyros_out[3] = { samples[0] * agcal.gyro_scale.X - agcal.gyro_bias.X - gyro_temp_bias[0],
-                           samples[1] * agcal.gyro_scale.Y - agcal.gyro_bias.Y - gyro_temp_bias[1],
-                           samples[2] * agcal.gyro_scale.Z - agcal.gyro_bias.Z - gyro_temp_bias[2] };
-
-    rot_mult(R, gyros_out, samples);
     gyroSensorData.temperature = temperature;
-    gyroSensorData.x = samples[0];
-    gyroSensorData.y = samples[1];
-    gyroSensorData.z = samples[2];
+    gyroSensorData.x = sample->x;
+    gyroSensorData.y = sample->y;
+    gyroSensorData.z = sample->z;
+    gyroSensorData.SensorTimestamp = timestamp;
 
     GyroSensorSet(&gyroSensorData);
 }
 
-static void handleMag(float *samples, float temperature)
+static void handleMag(const Vector3f *sample, float temperature)
 {
     MagSensorData mag;
-    float mags[3] = { (float)samples[0] - mag_bias[0],
-                      (float)samples[1] - mag_bias[1],
-                      (float)samples[2] - mag_bias[2] };
-
-    rot_mult(mag_transform, mags, samples);
 
-    mag.x = samples[0];
-    mag.y = samples[1];
-    mag.z = samples[2];
+    mag.x = sample->x;
+    mag.y = sample->y;
+    mag.z = sample->z;
     mag.temperature = temperature;
 
     MagSensorSet(&mag);
@@ -492,6 +558,7 @@ static void updateAccelTempBias(float temperature)
             accel_temp_bias[0] = agcal.accel_temp_coeff.X * ctemp;
             accel_temp_bias[1] = agcal.accel_temp_coeff.Y * ctemp;
             accel_temp_bias[2] = agcal.accel_temp_coeff.Z * ctemp;
+            updateAccelCalibration();
         }
     }
     accel_temp_calibration_count--;
@@ -513,6 +580,7 @@ static void updateGyroTempBias(float temperature)
             gyro_temp_bias[0] = (agcal.gyro_temp_coeff.X + agcal.gyro_temp_coeff.X2 * ctemp) * ctemp;
             gyro_temp_bias[1] = (agcal.gyro_temp_coeff.Y + agcal.gyro_temp_coeff.Y2 * ctemp) * ctemp;
             gyro_temp_bias[2] = (agcal.gyro_temp_coeff.Z + agcal.gyro_temp_coeff.Z2 * ctemp) * ctemp;
+            updateGyroCalibration();
         }
     }
     gyro_temp_calibration_count--;
@@ -535,6 +603,34 @@ static void updateBaroTempBias(float temperature)
     }
     baro_temp_calibration_count--;
 }
+
+static void updateAccelCalibration(void)
+{
+    // (raw - bias) * scale - temp_bias, the bias moved behind the scale
+    const float scale[3]  = { agcal.accel_scale.X, agcal.accel_scale.Y, agcal.accel_scale.Z };
+    const float offset[3] = { agcal.accel_bias.X * agcal.accel_scale.X + accel_temp_bias[0],
+                              agcal.accel_bias.Y * agcal.accel_scale.Y + accel_temp_bias[1],
+                              agcal.accel_bias.Z * agcal.accel_scale.Z + accel_temp_bias[2] };
+
+    vector3_transform_setf(&accel_calibration, R, scale, offset);
+}
+
+static void updateGyroCalibration(void)
+{
+    // raw * scale - bias - temp_bias
+    const float scale[3]  = { agcal.gyro_scale.X, agcal.gyro_scale.Y, agcal.gyro_scale.Z };
+    const float offset[3] = { agcal.gyro_bias.X + gyro_temp_bias[0],
+                              agcal.gyro_bias.Y + gyro_temp_bias[1],
+                              agcal.gyro_bias.Z + gyro_temp_bias[2] };
+
+    vector3_transform_setf(&gyro_calibration, R, scale, offset);
+}
+
+static void updateMagCalibration(void)
+{
+    // mag_transform already contains the board rotation
+    vector3_transform_setf(&mag_calibration, mag_transform, NULL, mag_bias);
+}
 /**
  * Locally cache some variables from the AtttitudeSettings object
  */
@@ -589,6 +685,14 @@ static void settingsUpdatedCb(__attribute__((unused)) UAVObjEvent *objEv)
     }
     matrix_mult_3x3f((float(*)[3])RevoCalibrationmag_transformToArray(cal.mag_transform), R, mag_transform);
 
+    updateAccelCalibration();
+    updateGyroCalibration();
+    updateMagCalibration();
+
+    RevoSettingsGyroDecimationGet(&gyro_decimation);
+    RevoSettingsGyroDecimationFilterGet(&gyro_decimation_filter);
+    gyro_decimator_dirty = true;
+
     RevoSettingsBaroTempCorrectionPolynomialGet(&baroCorrection);
     RevoSettingsBaroTempCorrectionExtentGet(&baroCorrectionExtent);
     baro_temp_correction_enabled =
@@ -92,6 +92,7 @@ static void simulateModelAirplane();
 static float accel_bias[3];
 
 static float rand_gauss();
+static unsigned int rand_state;
 
 enum sensor_sim_type { CONSTANT, MODEL_AGNOSTIC, MODEL_QUADCOPTER, MODEL_AIRPLANE } sensor_sim_type;
 
@@ -102,6 +103,8 @@ enum sensor_sim_type { CONSTANT, MODEL_AGNOSTIC, MODEL_QUADCOPTER, MODEL_AIRPLAN
  */
 int32_t SensorsInitialize(void)
 {
+    // private generator state, other users of rand() must not change the noise sequence
+    rand_state    = PIOS_SIM_GetSeed();
     accel_bias[0] = rand_gauss() / 10;
     accel_bias[1] = rand_gauss() / 10;
     accel_bias[2] = rand_gauss() / 10;
@@ -208,7 +211,8 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
             simulateModelAirplane();
         }
 
-        vTaskDelay(2 / portTICK_RATE_MS);
+        // fixed model step, also when running on a virtual clock
+        vTaskDelayUntil(&lastSysTime, SENSOR_PERIOD / portTICK_RATE_MS);
     }
 }
 
@@ -226,6 +230,7 @@ static void simulateConstant()
     gyroSensorData.x = 0;
     gyroSensorData.y = 0;
     gyroSensorData.z = 0;
+    gyroSensorData.SensorTimestamp = PIOS_DELAY_GetRaw();
 
 /* TODO
     // Apply bias correction to the gyros
@@ -288,6 +293,7 @@ static void simulateModelAgnostic()
     gyroSensorData.x = rateDesired.Roll + rand_gauss();
     gyroSensorData.y = rateDesired.Pitch + rand_gauss();
     gyroSensorData.z = rateDesired.Yaw + rand_gauss();
+    gyroSensorData.SensorTimestamp = PIOS_DELAY_GetRaw();
 
 /* TODO
     // Apply bias correction to the gyros
@@ -354,7 +360,7 @@ static void simulateModelQuadcopter()
     ActuatorDesiredData actuatorDesired;
     ActuatorDesiredGet(&actuatorDesired);
 
-    float thrust = (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED) ? actuatorDesired.Throttle * MAX_THRUST : 0;
+    float thrust = (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED) ? actuatorDesired.Thrust * MAX_THRUST : 0;
     if (thrust < 0) {
         thrust = 0;
     }
@@ -385,6 +391,7 @@ static void simulateModelQuadcopter()
     gyroSensorData.x = rpy[0] + rand_gauss();
     gyroSensorData.y = rpy[1] + rand_gauss();
     gyroSensorData.z = rpy[2] + rand_gauss();
+    gyroSensorData.SensorTimestamp = PIOS_DELAY_GetRaw();
     GyroSensorSet(&gyroSensorData);
 
     // Predict the attitude forward in time
@@ -544,12 +551,12 @@ static void simulateModelQuadcopter()
     attitudeSimulated.q3 = q[2];
     attitudeSimulated.q4 = q[3];
     Quaternion2RPY(q, &attitudeSimulated.Roll);
-    attitudeSimulated.Position[0] = pos[0];
-    attitudeSimulated.Position[1] = pos[1];
-    attitudeSimulated.Position[2] = pos[2];
-    attitudeSimulated.Velocity[0] = vel[0];
-    attitudeSimulated.Velocity[1] = vel[1];
-    attitudeSimulated.Velocity[2] = vel[2];
+    attitudeSimulated.Position.North = pos[0];
+    attitudeSimulated.Position.East = pos[1];
+    attitudeSimulated.Position.Down = pos[2];
+    attitudeSimulated.Velocity.North = vel[0];
+    attitudeSimulated.Velocity.East = vel[1];
+    attitudeSimulated.Velocity.Down = vel[2];
     AttitudeSimulatedSet(&attitudeSimulated);
 }
 
@@ -597,7 +604,7 @@ static void simulateModelAirplane()
     ActuatorDesiredData actuatorDesired;
     ActuatorDesiredGet(&actuatorDesired);
 
-    float thrust = (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED) ? actuatorDesired.Throttle * MAX_THRUST : 0;
+    float thrust = (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED) ? actuatorDesired.Thrust * MAX_THRUST : 0;
     if (thrust < 0) {
         thrust = 0;
     }
@@ -637,6 +644,7 @@ static void simulateModelAirplane()
     gyroSensorData.x = rpy[0] + rand_gauss();
     gyroSensorData.y = rpy[1] + rand_gauss();
     gyroSensorData.z = rpy[2] + rand_gauss();
+    gyroSensorData.SensorTimestamp = PIOS_DELAY_GetRaw();
     GyroSensorSet(&gyroSensorData);
 
     // Predict the attitude forward in time
@@ -826,12 +834,12 @@ static void simulateModelAirplane()
     attitudeSimulated.q3 = q[2];
     attitudeSimulated.q4 = q[3];
     Quaternion2RPY(q, &attitudeSimulated.Roll);
-    attitudeSimulated.Position[0] = pos[0];
-    attitudeSimulated.Position[1] = pos[1];
-    attitudeSimulated.Position[2] = pos[2];
-    attitudeSimulated.Velocity[0] = vel[0];
-    attitudeSimulated.Velocity[1] = vel[1];
-    attitudeSimulated.Velocity[2] = vel[2];
+    attitudeSimulated.Position.North = pos[0];
+    attitudeSimulated.Position.East = pos[1];
+    attitudeSimulated.Position.Down = pos[2];
+    attitudeSimulated.Velocity.North = vel[0];
+    attitudeSimulated.Velocity.East = vel[1];
+    attitudeSimulated.Velocity.Down = vel[2];
     AttitudeSimulatedSet(&attitudeSimulated);
 }
 
@@ -840,8 +848,8 @@ static float rand_gauss(void)
     float v1, v2, s;
 
     do {
-        v1 = 2.0 * ((float)rand() / RAND_MAX) - 1;
-        v2 = 2.0 * ((float)rand() / RAND_MAX) - 1;
+        v1 = 2.0 * ((float)rand_r(&rand_state) / RAND_MAX) - 1;
+        v2 = 2.0 * ((float)rand_r(&rand_state) / RAND_MAX) - 1;
 
         s  = v1 * v1 + v2 * v2;
     } while (s >= 1.0);
@@ -35,6 +35,7 @@
 
 #include <openpilot.h>
 #include <pid.h>
+#include <dynnotch.h>
 #include <stabilizationsettings.h>
 #include <stabilizationbank.h>
 
@@ -45,6 +46,8 @@ typedef struct {
     StabilizationSettingsData settings;
     StabilizationBankData     stabBank;
     float gyro_alpha;
+    bool  gyro_notch_enabled;
+    struct DynNotch gyro_notch;
     struct {
         float min_thrust;
         float max_thrust;
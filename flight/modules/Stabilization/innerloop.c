@@ -50,6 +50,13 @@
 #include <virtualflybar.h>
 #include <cruisecontrol.h>
 #include <sanitycheck.h>
+
+#define PIOS_INSTRUMENT_MODULE
+#include <pios_instrumentation_helper.h>
+
+PERF_DEFINE_COUNTER(counterGyroNotch);
+PERF_DEFINE_COUNTER(counterGyroNotchFrequency);
+
 // Private constants
 
 #define CALLBACK_PRIORITY CALLBACK_PRIORITY_CRITICAL
@@ -62,6 +69,7 @@
 // Private variables
 static DelayedCallbackInfo *callbackHandle;
 static float gyro_filtered[3] = { 0, 0, 0 };
+static uint32_t gyro_timestamp = 0;
 static float axis_lock_accum[3] = { 0, 0, 0 };
 static uint8_t previous_mode[AXES] = { 255, 255, 255, 255 };
 static PiOSDeltatimeConfig timeval;
@@ -91,6 +99,9 @@ void stabilizationInnerloopInit()
 #endif
     PIOS_DELTATIME_Init(&timeval, UPDATE_EXPECTED, UPDATE_MIN, UPDATE_MAX, UPDATE_ALPHA);
 
+    PERF_INIT_COUNTER(counterGyroNotch, 0x53540001);
+    PERF_INIT_COUNTER(counterGyroNotchFrequency, 0x53540002);
+
     callbackHandle = PIOS_CALLBACKSCHEDULER_Create(&stabilizationInnerloopTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_STABILIZATION1, STACK_SIZE_BYTES);
     GyroStateConnectCallback(GyroStateUpdatedCb);
 
@@ -334,6 +345,7 @@ static void stabilizationInnerloopTask()
     }
 
     actuator.UpdateTime = dT * 1000;
+    actuator.SensorTimestamp = gyro_timestamp;
 
     if (cchain.Stabilization == FLIGHTSTATUS_CONTROLCHAIN_TRUE) {
         ActuatorDesiredSet(&actuator);
@@ -378,9 +390,19 @@ static void GyroStateUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 
     GyroStateGet(&gyroState);
 
-    gyro_filtered[0] = gyro_filtered[0] * stabSettings.gyro_alpha + gyroState.x * (1 - stabSettings.gyro_alpha);
-    gyro_filtered[1] = gyro_filtered[1] * stabSettings.gyro_alpha + gyroState.y * (1 - stabSettings.gyro_alpha);
-    gyro_filtered[2] = gyro_filtered[2] * stabSettings.gyro_alpha + gyroState.z * (1 - stabSettings.gyro_alpha);
+    Vector3f gyro = { gyroState.x, gyroState.y, gyroState.z };
+    if (stabSettings.gyro_notch_enabled) {
+        // take frame and motor resonances out before they reach the PIDs
+        PERF_TIMED_SECTION_START(counterGyroNotch);
+        DynNotchApply(&stabSettings.gyro_notch, &gyro);
+        PERF_TIMED_SECTION_END(counterGyroNotch);
+        PERF_TRACK_VALUE(counterGyroNotchFrequency, (int32_t)DynNotchFrequency(&stabSettings.gyro_notch, 0, 0));
+    }
+
+    gyro_filtered[0] = gyro_filtered[0] * stabSettings.gyro_alpha + gyro.x * (1 - stabSettings.gyro_alpha);
+    gyro_filtered[1] = gyro_filtered[1] * stabSettings.gyro_alpha + gyro.y * (1 - stabSettings.gyro_alpha);
+    gyro_filtered[2] = gyro_filtered[2] * stabSettings.gyro_alpha + gyro.z * (1 - stabSettings.gyro_alpha);
+    gyro_timestamp   = gyroState.SensorTimestamp;
 
     PIOS_CALLBACKSCHEDULER_Dispatch(callbackHandle);
     stabSettings.monitor.gyroupdates++;
@@ -50,7 +50,10 @@
 
 // Private constants
 
-#define CALLBACK_PRIORITY CALLBACK_PRIORITY_REGULAR
+#define CALLBACK_PRIORITY    CALLBACK_PRIORITY_REGULAR
+// the attitude is stale once the next sensor sample has been processed,
+// so start ahead of the round robin callbacks sharing the priority
+#define CALLBACK_DEADLINE_US ((uint32_t)(1.0e6f / PIOS_SENSOR_RATE))
 
 #define UPDATE_EXPECTED   (1.0f / PIOS_SENSOR_RATE)
 #define UPDATE_MIN        1.0e-6f
@@ -79,7 +82,7 @@ void stabilizationOuterloopInit()
 
     PIOS_DELTATIME_Init(&timeval, UPDATE_EXPECTED, UPDATE_MIN, UPDATE_MAX, UPDATE_ALPHA);
 
-    callbackHandle = PIOS_CALLBACKSCHEDULER_Create(&stabilizationOuterloopTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_STABILIZATION0, STACK_SIZE_BYTES);
+    callbackHandle = PIOS_CALLBACKSCHEDULER_CreateWithDeadline(&stabilizationOuterloopTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_STABILIZATION0, STACK_SIZE_BYTES, CALLBACK_DEADLINE_US);
     AttitudeStateConnectCallback(AttitudeStateUpdatedCb);
 }
 
@@ -364,6 +364,26 @@ static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
         stabSettings.gyro_alpha = expf(-fakeDt / stabSettings.settings.GyroTau);
     }
 
+    // dynamic notches ahead of the gyro filter, a count of 0 turns them off.
+    // Only set them up again when their own settings change, so tuning other
+    // fields in flight does not throw away the tracked frequencies.
+    static StabilizationSettingsGyroDynamicNotchData notchSettings;
+    static uint8_t notchCount;
+    static float notchRate;
+    if (stabSettings.settings.GyroDynamicNotchCount != notchCount || PIOS_SENSOR_RATE != notchRate
+        || memcmp(&stabSettings.settings.GyroDynamicNotch, &notchSettings, sizeof(notchSettings))) {
+        notchSettings = stabSettings.settings.GyroDynamicNotch;
+        notchCount    = stabSettings.settings.GyroDynamicNotchCount;
+        notchRate     = PIOS_SENSOR_RATE;
+        stabSettings.gyro_notch_enabled = notchCount > 0
+                                          && DynNotchInit(&stabSettings.gyro_notch, notchRate,
+                                                          notchSettings.MinFrequency,
+                                                          notchSettings.MaxFrequency,
+                                                          notchCount,
+                                                          notchSettings.Q,
+                                                          notchSettings.MinAmplitude);
+    }
+
     // force flight mode update
     cur_flight_mode = -1;
 
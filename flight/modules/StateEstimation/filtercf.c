@@ -42,6 +42,7 @@
 #include <revocalibration.h>
 
 #include <CoordinateConversions.h>
+#include <vectors.h>
 #include <pios_notify.h>
 // Private constants
 
@@ -367,11 +368,8 @@ static filterResult complementaryFilter(struct data *this, float gyro[3], float
     if (this->magUpdated && this->useMag) {
         // Rotate gravity to body frame and cross with accels
         float brot[3];
-        float Rbe[3][3];
 
-        Quaternion2R(attitude, Rbe);
-
-        rot_mult(Rbe, this->homeLocation.Be, brot);
+        quat_rotatef(attitude, this->homeLocation.Be, brot);
 
         float mag_len = sqrtf(mag[0] * mag[0] + mag[1] * mag[1] + mag[2] * mag[2]);
         mag[0]  /= mag_len;
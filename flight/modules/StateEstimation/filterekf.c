@@ -40,6 +40,7 @@
 
 #include <insgps.h>
 #include <CoordinateConversions.h>
+#include <vectors.h>
 
 // Private constants
 
@@ -405,10 +406,8 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
                                      this->ekfConfiguration.FakeR.FakeGPSVelAirspeed }
                         );
         // rotate airspeed vector into NED frame - airspeed is measured in X axis only
-        float R[3][3];
-        Quaternion2R(Nav.q, R);
         float vtas[3] = { this->work.airspeed[1], 0.0f, 0.0f };
-        rot_mult(R, vtas, this->work.vel);
+        quat_rotatef(Nav.q, vtas, this->work.vel);
     }
 
     /*
@@ -38,6 +38,7 @@
 #include <homelocation.h>
 #include <auxmagsettings.h>
 #include <CoordinateConversions.h>
+#include <vectors.h>
 #include <mathmisc.h>
 
 // Private constants
@@ -267,9 +268,7 @@ void magOffsetEstimation(struct data *this, float mag[3])
     Quaternion2R(&attitude.q1, Rot);
 
     // Rotate the mag into the NED frame
-    B_e[0] = Rot[0][0] * mag[0] + Rot[1][0] * mag[1] + Rot[2][0] * mag[2];
-    B_e[1] = Rot[0][1] * mag[0] + Rot[1][1] * mag[1] + Rot[2][1] * mag[2];
-    B_e[2] = Rot[0][2] * mag[0] + Rot[1][2] * mag[1] + Rot[2][2] * mag[2];
+    vector3_rotate_transposedf(Rot, mag, B_e);
 
     float cy = cosf(DEG2RAD(attitude.Yaw));
     float sy = sinf(DEG2RAD(attitude.Yaw));
@@ -54,6 +54,7 @@
 #include <systemsettings.h>
 #include <i2cstats.h>
 #include <taskinfo.h>
+#include <taskstats.h>
 #include <watchdogstatus.h>
 #include <callbackinfo.h>
 #include <hwsettings.h>
@@ -65,6 +66,10 @@
 #include <pios_instrumentation.h>
 #endif
 
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+#include <tracing.h>
+#endif
+
 #if defined(PIOS_INCLUDE_RFM22B)
 #include <oplinkstatus.h>
 #endif
@@ -106,8 +111,13 @@ volatile int initTaskDone = 0;
 
 // Private functions
 static void objectUpdatedCb(UAVObjEvent *ev);
+static int32_t saveObjectList(const ObjectPersistenceData *objper);
 static void checkSettingsUpdatedCb(UAVObjEvent *ev);
 #ifdef DIAG_TASKS
+struct taskMonitorContext {
+    TaskInfoData  *info;
+    TaskStatsData *stats;
+};
 static void taskMonitorForEachCallback(uint16_t task_id, const struct pios_task_info *task_info, void *context);
 static void callbackSchedulerForEachCallback(int16_t callback_id, const struct pios_callback_info *callback_info, void *context);
 #endif
@@ -152,6 +162,9 @@ int32_t SystemModInitialize(void)
     ObjectPersistenceInitialize();
 #ifdef DIAG_TASKS
     TaskInfoInitialize();
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+    TaskStatsInitialize();
+#endif
     CallbackInfoInitialize();
 #endif
 #ifdef DIAG_I2C_WDG_STATS
@@ -163,6 +176,13 @@ int32_t SystemModInitialize(void)
     InstrumentationInit();
 #endif
 
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+    // the system module runs without the trace, it is only a diagnostic
+    if (TracingInit() != 0) {
+        PIOS_DEBUGLOG_Printf("Tracing: out of memory, event trace disabled");
+    }
+#endif
+
     objectPersistenceQueue = xQueueCreate(1, sizeof(UAVObjEvent));
     if (objectPersistenceQueue == NULL) {
         return -1;
@@ -212,7 +232,9 @@ static void systemTask(__attribute__((unused)) void *parameters)
 
 #ifdef DIAG_TASKS
     TaskInfoData taskInfoData;
+    TaskStatsData taskStatsData;
     CallbackInfoData callbackInfoData;
+    struct taskMonitorContext taskMonitorContext = { &taskInfoData, &taskStatsData };
 #endif
     // Main system loop
     while (1) {
@@ -232,8 +254,12 @@ static void systemTask(__attribute__((unused)) void *parameters)
 
 #ifdef DIAG_TASKS
         // Update the task status object
-        PIOS_TASK_MONITOR_ForEachTask(taskMonitorForEachCallback, &taskInfoData);
+        PIOS_TASK_MONITOR_ForEachTask(taskMonitorForEachCallback, &taskMonitorContext);
         TaskInfoSet(&taskInfoData);
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+        // only measured in builds with the scheduler hooks
+        TaskStatsSet(&taskStatsData);
+#endif
         // Update the callback status object
 // if(FALSE){
         PIOS_CALLBACKSCHEDULER_ForEachCallback(callbackSchedulerForEachCallback, &callbackInfoData);
@@ -307,6 +333,45 @@ static void systemTask(__attribute__((unused)) void *parameters)
     }
 }
 
+/**
+ * Save the objects of an ObjectPersistence list request in one batch.
+ * The list ends at the first zero object id. An object listed more than once
+ * is saved once, the batch must not write the same slot twice.
+ * \return 0 if all objects were saved and verified, -1 otherwise
+ */
+static int32_t saveObjectList(const ObjectPersistenceData *objper)
+{
+    UAVObjHandle objs[OBJECTPERSISTENCE_OBJECTLIST_NUMELEM];
+    uint8_t count = 0;
+
+    for (uint8_t n = 0; n < OBJECTPERSISTENCE_OBJECTLIST_NUMELEM && objper->ObjectList[n] != 0; n++) {
+        UAVObjHandle obj = UAVObjGetByID(objper->ObjectList[n]);
+        if (obj == 0) {
+            return -1;
+        }
+
+        uint8_t i = 0;
+        while (i < count && objs[i] != obj) {
+            i++;
+        }
+        if (i == count) {
+            objs[count++] = obj;
+        }
+    }
+
+    if (UAVObjSaveList(objs, count, objper->InstanceID) != 0) {
+        return -1;
+    }
+
+    // Verify saving worked
+    for (uint8_t i = 0; i < count; i++) {
+        if (UAVObjLoad(objs[i], objper->InstanceID) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 /**
  * Function called in response to object updates
  */
@@ -363,6 +428,8 @@ static void objectUpdatedCb(UAVObjEvent *ev)
                 if (retval == 0) {
                     retval = UAVObjLoad(obj, objper.InstanceID);
                 }
+            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_OBJECTLIST) {
+                retval = saveObjectList(&objper);
             } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLSETTINGS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
                 retval = UAVObjSaveSettings();
             } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
@@ -414,7 +481,8 @@ static void checkSettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
     HwSettingsGet(&currentHwSettings);
     FrameType_t currentFrameType = GetCurrentFrameType();
     // check whether the Hw Configuration has changed from the one used at boot time
-    if ((memcmp(&bootHwSettings, &currentHwSettings, sizeof(HwSettingsData)) != 0) ||
+    // (only the object bytes, the trailing padding of HwSettingsData is never written)
+    if ((memcmp(&bootHwSettings, &currentHwSettings, HWSETTINGS_NUMBYTES) != 0) ||
         (currentFrameType != bootFrameType)) {
         ExtendedAlarmsSet(SYSTEMALARMS_ALARM_BOOTFAULT, SYSTEMALARMS_ALARM_CRITICAL, SYSTEMALARMS_EXTENDEDALARMSTATUS_REBOOTREQUIRED, 0);
     }
@@ -423,14 +491,23 @@ static void checkSettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 #ifdef DIAG_TASKS
 static void taskMonitorForEachCallback(uint16_t task_id, const struct pios_task_info *task_info, void *context)
 {
-    TaskInfoData *taskData = (TaskInfoData *)context;
+    struct taskMonitorContext *monitorContext = (struct taskMonitorContext *)context;
+    TaskInfoData *taskData   = monitorContext->info;
+    TaskStatsData *statsData = monitorContext->stats;
 
     // By convention, there is a direct mapping between task monitor task_id's and members
-    // of the TaskInfoXXXXElem enums
+    // of the TaskInfoXXXXElem and TaskStatsXXXXElem enums
     PIOS_DEBUG_Assert(task_id < TASKINFO_RUNNING_NUMELEM);
     TaskInfoRunningToArray(taskData->Running)[task_id] = task_info->is_running ? TASKINFO_RUNNING_TRUE : TASKINFO_RUNNING_FALSE;
     ((uint16_t *)&taskData->StackRemaining)[task_id]   = task_info->stack_remaining;
     ((uint8_t *)&taskData->RunningTime)[task_id] = task_info->running_time_percentage;
+
+    PIOS_DEBUG_Assert(task_id < TASKSTATS_LOAD_NUMELEM);
+    ((uint16_t *)&statsData->Load)[task_id]        = task_info->load;
+    ((uint16_t *)&statsData->LoadAvg)[task_id]     = task_info->load_avg;
+    ((uint16_t *)&statsData->MaxSlice)[task_id]    = task_info->max_slice_us > UINT16_MAX ? UINT16_MAX : task_info->max_slice_us;
+    ((uint16_t *)&statsData->MaxLatency)[task_id]  = task_info->max_latency_us > UINT16_MAX ? UINT16_MAX : task_info->max_latency_us;
+    ((uint16_t *)&statsData->Preemptions)[task_id] = task_info->preemptions;
 }
 
 static void callbackSchedulerForEachCallback(int16_t callback_id, const struct pios_callback_info *callback_info, void *context)
@@ -450,6 +527,11 @@ static void callbackSchedulerForEachCallback(int16_t callback_id, const struct p
     ((uint8_t *)&callbackData->Running)[callback_id] = callback_info->is_running;
     ((uint32_t *)&callbackData->RunningTime)[callback_id]   = callback_info->running_time_count;
     ((int16_t *)&callbackData->StackRemaining)[callback_id] = callback_info->stack_remaining;
+    ((uint32_t *)&callbackData->LatencyMax)[callback_id]    = callback_info->latency_max_us;
+    ((uint32_t *)&callbackData->Latency99)[callback_id]     = PIOS_CALLBACKSCHEDULER_HistogramPercentile(callback_info->latency_histogram, 99);
+    ((uint32_t *)&callbackData->RunTimeMax)[callback_id]    = callback_info->run_time_max_us;
+    ((uint32_t *)&callbackData->RunTime99)[callback_id]     = PIOS_CALLBACKSCHEDULER_HistogramPercentile(callback_info->run_time_histogram, 99);
+    ((uint16_t *)&callbackData->DeadlineMisses)[callback_id] = callback_info->deadline_misses;
 }
 #endif /* ifdef DIAG_TASKS */
 
@@ -160,6 +160,18 @@ static volatile portBASE_TYPE xPendYield = pdFALSE;
 static volatile portLONG lIndexOfLastAddedTask = 0;
 /*-----------------------------------------------------------*/
 
+/* Virtual time, see vPortEnableVirtualTime() */
+static volatile portBASE_TYPE xVirtualTime = pdFALSE;
+static double dVirtualTimeSpeed = 0.0;
+/* issued ticks times the tick period plus the offset into the current tick */
+static volatile unsigned long long ullVirtualTimeUS = 0;
+/* a busy wait reached the end of the current tick */
+static volatile portBASE_TYPE xVirtualTickDue = pdFALSE;
+
+/* wall time tasks may keep the cpu busy before a virtual tick preempts them anyway */
+#define portVIRTUAL_TIME_BUSY_US	( 20000 )
+/*-----------------------------------------------------------*/
+
 /*
  * Setup the timer to generate the tick interrupts.
  */
@@ -268,6 +280,127 @@ void vPortStartFirstTask( void )
 }
 /*-----------------------------------------------------------*/
 
+static unsigned long long prvGetMonotonicUS( void )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return 1000000ULL * now.tv_sec + now.tv_nsec / 1000;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableVirtualTime( double dSpeed )
+{
+	dVirtualTimeSpeed = dSpeed > 0.0 ? dSpeed : 0.0;
+	xVirtualTime = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+portBASE_TYPE xPortIsVirtualTime( void )
+{
+	return xVirtualTime;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Virtual time is the number of ticks times the tick period plus the offset
+ * into the current tick stepped by ullPortStepVirtualTimeUS(). The offset
+ * starts over at every tick, so time divided by the tick period always equals
+ * the tick count.
+ */
+unsigned long long ullPortGetVirtualTimeUS( void )
+{
+	return __sync_add_and_fetch( &ullVirtualTimeUS, 0 );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Move virtual time on towards ullUntilUS, but not into the next tick. The
+ * next tick is requested when the step had to be cut short.
+ * \return virtual time after the step
+ */
+unsigned long long ullPortStepVirtualTimeUS( unsigned long long ullUntilUS )
+{
+	unsigned long long ullLast, ullNow, ullTickEnd;
+
+	do {
+		ullLast = ullVirtualTimeUS;
+		ullTickEnd = ullLast - ullLast % portTICK_RATE_MICROSECONDS + portTICK_RATE_MICROSECONDS - 1;
+		ullNow = ullUntilUS < ullTickEnd ? ullUntilUS : ullTickEnd;
+		if ( ullNow < ullLast ) {
+			ullNow = ullLast;
+		}
+	} while ( !__sync_bool_compare_and_swap( &ullVirtualTimeUS, ullLast, ullNow ) );
+
+	if ( ullUntilUS > ullTickEnd ) {
+		xVirtualTickDue = pdTRUE;
+	}
+
+	return ullNow;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Start the next tick period at offset 0
+ */
+static void prvVirtualTimeTick( void )
+{
+	unsigned long long ullLast;
+
+	do {
+		ullLast = ullVirtualTimeUS;
+	} while ( !__sync_bool_compare_and_swap( &ullVirtualTimeUS, ullLast, ullLast - ullLast % portTICK_RATE_MICROSECONDS + portTICK_RATE_MICROSECONDS ) );
+
+	xVirtualTickDue = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Virtual time supervisor loop. Rather than following the wall clock, the next
+ * tick is issued as soon as all tasks are blocked and the idle task runs, so
+ * simulated time passes as fast as the host allows and does not depend on host
+ * load. A positive speed factor limits the tick rate to that multiple of real
+ * time.
+ */
+static void prvVirtualTimeLoop( void )
+{
+	unsigned long long ullStartUS = prvGetMonotonicUS();
+	unsigned long long ullTicks = 0;
+
+	while ( pdTRUE != xSchedulerEnd )
+	{
+		unsigned long long ullWaitStartUS = prvGetMonotonicUS();
+
+		/* wait for all tasks to block or wait for the tick, busy tasks get preempted after a grace period */
+		while ( xTaskGetCurrentTaskHandle() != xTaskGetIdleTaskHandle() && pdTRUE != xVirtualTickDue && pdTRUE != xSchedulerEnd &&
+				prvGetMonotonicUS() - ullWaitStartUS < portVIRTUAL_TIME_BUSY_US ) {
+			sched_yield();
+		}
+
+		if ( dVirtualTimeSpeed > 0.0 ) {
+			unsigned long long ullDueUS = ullStartUS + (unsigned long long)( ( ullTicks + 1 ) * portTICK_RATE_MICROSECONDS / dVirtualTimeSpeed );
+			unsigned long long ullNowUS = prvGetMonotonicUS();
+			if ( ullDueUS > ullNowUS ) {
+				struct timespec wait;
+				wait.tv_sec = ( ullDueUS - ullNowUS ) / 1000000;
+				wait.tv_nsec = 1000 * ( ( ullDueUS - ullNowUS ) % 1000000 );
+				nanosleep( &wait, NULL );
+			}
+		}
+
+		/* the tick handler defers the tick while the running task cannot be interrupted
+		 * or has suspended the scheduler, retry then */
+		unsigned long long ullTick = ullPortGetVirtualTimeUS() / portTICK_RATE_MICROSECONDS;
+		vPortSystemTickHandler();
+		if ( ullPortGetVirtualTimeUS() / portTICK_RATE_MICROSECONDS != ullTick ) {
+			ullTicks++;
+		} else {
+			sched_yield();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
 /**
  * After tasks have been set up the main thread goes into a sleeping loop, but
  * allows to be interrupted by timer ticks.
@@ -291,6 +424,10 @@ portBASE_TYPE xPortStartScheduler( void )
 	/* Start the first task. This gives up the RunningThreadMutex*/
 	vPortStartFirstTask();
 
+	if ( pdTRUE == xVirtualTime ) {
+		prvVirtualTimeLoop();
+	}
+
 	/**
 	 * Main scheduling loop. Call the tick handler every
 	 * portTICK_RATE_MICROSECONDS
@@ -644,19 +781,26 @@ void vPortSystemTickHandler()
 	 */
 
 	/**
-	 * call tick handler
+	 * a tick while the scheduler is suspended only counts on resume, a virtual
+	 * tick waits until then so virtual time and tick count stay in step
 	 */
-	xTaskIncrementTick();
+	if ( pdTRUE != xVirtualTime || taskSCHEDULER_SUSPENDED != xTaskGetSchedulerState() )
+	{
+		/**
+		 * call tick handler
+		 */
+		prvVirtualTimeTick();
+		xTaskIncrementTick();
 
-	
 #if ( configUSE_PREEMPTION == 1 )
-	/**
-	 * while we are here we can as well switch the running thread
-	 */
-	vTaskSwitchContext();
+		/**
+		 * while we are here we can as well switch the running thread
+		 */
+		vTaskSwitchContext();
 
-	xTaskToSuspend = prvGetThreadHandle( xTaskGetCurrentTaskHandle() );
+		xTaskToSuspend = prvGetThreadHandle( xTaskGetCurrentTaskHandle() );
 #endif
+	}
 
 	/**
 	 * wake up the task (again)
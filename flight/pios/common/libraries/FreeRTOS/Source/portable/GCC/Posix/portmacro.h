@@ -118,6 +118,13 @@ extern void vPortYield( void );
 
 #define portYIELD()					vPortYield()
 
+/* Virtual time, the tick advances as soon as all tasks are blocked instead of
+following the wall clock. Must be enabled before the scheduler is started. */
+extern void vPortEnableVirtualTime( double dSpeed );
+extern portBASE_TYPE xPortIsVirtualTime( void );
+extern unsigned long long ullPortGetVirtualTimeUS( void );
+extern unsigned long long ullPortStepVirtualTimeUS( unsigned long long ullUntilUS );
+
 #define portEND_SWITCHING_ISR( xSwitchRequired ) if( xSwitchRequired ) vPortYieldFromISR()
 /*-----------------------------------------------------------*/
 
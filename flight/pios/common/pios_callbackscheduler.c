@@ -28,6 +28,7 @@
 #ifdef PIOS_INCLUDE_CALLBACKSCHEDULER
 
 #include <utlist.h>
+#include <pios_tracebuffer.h>
 #include <uavobjectmanager.h>
 #include <taskinfo.h>
 
@@ -36,6 +37,7 @@
 #define STACK_SIZE        (300 + STACK_SAFETYSIZE)
 #define STACK_SAFETYSIZE  8
 #define MAX_SLEEP         1000
+#define HISTOGRAM_SHIFT   4 // first histogram bucket holds everything below 2^4 us
 
 // Private types
 /**
@@ -66,6 +68,13 @@ struct DelayedCallbackInfoStruct {
     uint16_t stackSafetyCount;
     uint16_t currentSafetyCount;
     uint32_t runCount;
+    uint32_t deadlineUs; // relative deadline for EDF scheduling, 0 for round robin
+    uint32_t volatile dispatchTime; // PIOS_DELAY raw time the callback became ready to run
+    uint32_t latencyMax;
+    uint32_t runTimeMax;
+    uint16_t deadlineMisses;
+    uint16_t latencyHistogram[CALLBACK_HISTOGRAM_BUCKETS];
+    uint16_t runTimeHistogram[CALLBACK_HISTOGRAM_BUCKETS];
     struct DelayedCallbackTaskStruct *task;
     struct DelayedCallbackInfoStruct *next;
 };
@@ -79,6 +88,8 @@ static bool schedulerStarted;
 // Private functions
 static void CallbackSchedulerTask(void *task);
 static int32_t runNextCallback(struct DelayedCallbackTaskStruct *task, DelayedCallbackPriority priority);
+static void markDispatched(DelayedCallbackInfo *cbinfo);
+static void markDispatchedFromISR(DelayedCallbackInfo *cbinfo);
 
 /**
  * Initialize the scheduler
@@ -208,7 +219,7 @@ int32_t PIOS_CALLBACKSCHEDULER_Dispatch(DelayedCallbackInfo *cbinfo)
     PIOS_Assert(cbinfo);
 
     // no semaphore needed for the callback
-    cbinfo->waiting = true;
+    markDispatched(cbinfo);
     // but the scheduler as a whole needs to be notified
     return xSemaphoreGive(cbinfo->task->signal);
 }
@@ -232,7 +243,7 @@ int32_t PIOS_CALLBACKSCHEDULER_DispatchFromISR(DelayedCallbackInfo *cbinfo, long
     PIOS_Assert(cbinfo);
 
     // no semaphore needed for the callback
-    cbinfo->waiting = true;
+    markDispatchedFromISR(cbinfo);
     // but the scheduler as a whole needs to be notified
     return xSemaphoreGiveFromISR(cbinfo->task->signal, pxHigherPriorityTaskWoken);
 }
@@ -255,6 +266,24 @@ DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(
     DelayedCallbackPriorityTask priorityTask,
     int16_t callbackID,
     uint32_t stacksize)
+{
+    return PIOS_CALLBACKSCHEDULER_CreateWithDeadline(cb, priority, priorityTask, callbackID, stacksize, 0);
+}
+
+/**
+ * Register a new callback with a relative deadline.
+ * Among the waiting callbacks of the same priority, those with a deadline are run
+ * earliest deadline first, ahead of the round robin callbacks.
+ * \param[in] deadlineUs Time in microseconds after dispatch by which the callback should have started, 0 for none
+ * \return CallbackInfo Pointer on success, NULL if failed.
+ */
+DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_CreateWithDeadline(
+    DelayedCallback cb,
+    DelayedCallbackPriority priority,
+    DelayedCallbackPriorityTask priorityTask,
+    int16_t callbackID,
+    uint32_t stacksize,
+    uint32_t deadlineUs)
 {
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -346,6 +375,13 @@ DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(
     info->stackFree          = 0;
     info->stackSafetyCount   = STACK_SAFETYCOUNT;
     info->currentSafetyCount = 0;
+    info->deadlineUs         = deadlineUs;
+    info->dispatchTime       = 0;
+    info->latencyMax         = 0;
+    info->runTimeMax         = 0;
+    info->deadlineMisses     = 0;
+    memset(info->latencyHistogram, 0, sizeof(info->latencyHistogram));
+    memset(info->runTimeHistogram, 0, sizeof(info->runTimeHistogram));
 
     // add to scheduling queue
     LL_APPEND(task->callbackQueue[priority], info);
@@ -380,6 +416,11 @@ void PIOS_CALLBACKSCHEDULER_ForEachCallback(CallbackSchedulerCallbackInfoCallbac
                 info.is_running = true;
                 info.stack_remaining    = cbinfo->stackNotFree;
                 info.running_time_count = cbinfo->runCount;
+                info.latency_max_us     = cbinfo->latencyMax;
+                info.run_time_max_us    = cbinfo->runTimeMax;
+                info.deadline_misses    = cbinfo->deadlineMisses;
+                memcpy(info.latency_histogram, cbinfo->latencyHistogram, sizeof(info.latency_histogram));
+                memcpy(info.run_time_histogram, cbinfo->runTimeHistogram, sizeof(info.run_time_histogram));
                 xSemaphoreGiveRecursive(mutex);
                 callback(cbinfo->callbackID, &info, context);
             }
@@ -387,6 +428,32 @@ void PIOS_CALLBACKSCHEDULER_ForEachCallback(CallbackSchedulerCallbackInfoCallbac
     }
 }
 
+/**
+ * Upper bound in microseconds of the histogram bucket holding the given percentile
+ * @param histogram  latency_histogram or run_time_histogram from struct pios_callback_info
+ * @param percentile 0 to 100
+ */
+uint32_t PIOS_CALLBACKSCHEDULER_HistogramPercentile(const uint16_t *histogram, uint8_t percentile)
+{
+    uint32_t total = 0;
+    uint32_t count = 0;
+    uint8_t t;
+
+    for (t = 0; t < CALLBACK_HISTOGRAM_BUCKETS; t++) {
+        total += histogram[t];
+    }
+    if (!total) {
+        return 0;
+    }
+    for (t = 0; t < CALLBACK_HISTOGRAM_BUCKETS - 1; t++) {
+        count += histogram[t];
+        if (count * 100 >= total * percentile) {
+            break;
+        }
+    }
+    return 1u << (t + HISTOGRAM_SHIFT);
+}
+
 /**
  * Stack magic, find how much stack is being used without affecting performance
  */
@@ -457,6 +524,134 @@ static void checkStack(DelayedCallbackInfo *current)
     }
 }
 
+/**
+ * Mark a callback as ready to run and remember when that happened,
+ * unless it is already waiting. The test and set must not be split by
+ * a dispatch from an ISR or by the scheduler resetting the flag.
+ */
+static void markDispatched(DelayedCallbackInfo *cbinfo)
+{
+    portENTER_CRITICAL();
+    if (!cbinfo->waiting) {
+        cbinfo->dispatchTime = PIOS_DELAY_GetRaw();
+        cbinfo->waiting = true;
+    }
+    portEXIT_CRITICAL();
+}
+
+/**
+ * markDispatched() for ISR context
+ */
+static void markDispatchedFromISR(DelayedCallbackInfo *cbinfo)
+{
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+    if (!cbinfo->waiting) {
+        cbinfo->dispatchTime = PIOS_DELAY_GetRaw();
+        cbinfo->waiting = true;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * Whether a callback is due, either dispatched or with an expired schedule.
+ * An expired schedule marks the callback as dispatched.
+ * Must be called with the mutex held.
+ */
+static bool isDue(DelayedCallbackInfo *cbinfo)
+{
+    if (!cbinfo->waiting && cbinfo->scheduletime && (int32_t)(cbinfo->scheduletime - xTaskGetTickCount()) <= 0) {
+        markDispatched(cbinfo);
+    }
+    return cbinfo->waiting;
+}
+
+/**
+ * Find the waiting callback with a deadline that is due first, including
+ * those whose schedule expired but which were not reached by the round robin yet.
+ * Must be called with the mutex held.
+ * \return the callback, or NULL if no waiting callback has a deadline
+ */
+static DelayedCallbackInfo *earliestDeadline(struct DelayedCallbackTaskStruct *task, DelayedCallbackPriority priority)
+{
+    DelayedCallbackInfo *cursor;
+    DelayedCallbackInfo *best = NULL;
+    int32_t bestSlack = 0;
+
+    LL_FOREACH(task->callbackQueue[priority], cursor) {
+        if (cursor->deadlineUs && isDue(cursor)) {
+            int32_t slack = (int32_t)cursor->deadlineUs - (int32_t)PIOS_DELAY_DiffuS(cursor->dispatchTime);
+            if (!best || slack < bestSlack) {
+                best = cursor;
+                bestSlack = slack;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Log2 histogram bucket for a duration in microseconds
+ */
+static inline uint8_t histogramBucket(uint32_t us)
+{
+    us >>= HISTOGRAM_SHIFT;
+    if (!us) {
+        return 0;
+    }
+    uint8_t bucket = 32 - __builtin_clz(us);
+    return (bucket < CALLBACK_HISTOGRAM_BUCKETS) ? bucket : (CALLBACK_HISTOGRAM_BUCKETS - 1);
+}
+
+/**
+ * Add a sample to a histogram. All buckets are halved when one of them
+ * saturates, so the distribution favours recent samples.
+ */
+static void histogramAdd(uint16_t *histogram, uint32_t us)
+{
+    uint8_t bucket = histogramBucket(us);
+
+    if (histogram[bucket] == 0xffff) {
+        for (uint8_t t = 0; t < CALLBACK_HISTOGRAM_BUCKETS; t++) {
+            histogram[t] >>= 1;
+        }
+    }
+    histogram[bucket]++;
+}
+
+/**
+ * Invoke a callback and account for its latency, run time and stack usage
+ */
+static void runCallback(DelayedCallbackInfo *current)
+{
+    uint32_t start   = PIOS_DELAY_GetRaw();
+    uint32_t latency = PIOS_DELAY_DiffuS(current->dispatchTime);
+
+    /* callback gets invoked here - check stack sizes */
+    markStack(current);
+
+    PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_CALLBACK_START, current->callbackID);
+    current->cb(); // call the callback
+    PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_CALLBACK_END, current->callbackID);
+
+    checkStack(current);
+
+    uint32_t runTime = PIOS_DELAY_DiffuS(start);
+
+    current->runCount++;
+    histogramAdd(current->latencyHistogram, latency);
+    histogramAdd(current->runTimeHistogram, runTime);
+    if (latency > current->latencyMax) {
+        current->latencyMax = latency;
+    }
+    if (runTime > current->runTimeMax) {
+        current->runTimeMax = runTime;
+    }
+    if (current->deadlineUs && latency > current->deadlineUs && current->deadlineMisses < 0xffff) {
+        current->deadlineMisses++;
+    }
+}
+
 /**
  * Scheduler subtask
  * \param[in] task The scheduler task in question
@@ -499,25 +694,26 @@ static int32_t runNextCallback(struct DelayedCallbackTaskStruct *task, DelayedCa
             if (current->scheduletime) {
                 diff = current->scheduletime - xTaskGetTickCount();
                 if (diff <= 0) {
-                    current->waiting = true;
+                    markDispatched(current);
                 } else if (diff < result) {
                     result = diff; // adjust sleep time
                 }
             }
             if (current->waiting) {
-                task->queueCursor[priority] = next;
+                // a waiting callback with a deadline takes precedence over round robin
+                DelayedCallbackInfo *edf = earliestDeadline(task, priority);
+                if (edf) {
+                    current = edf;
+                } else {
+                    task->queueCursor[priority] = next;
+                }
                 current->scheduletime = 0; // any schedules are reset
+                portENTER_CRITICAL();
                 current->waiting = false; // the flag is reset just before execution.
+                portEXIT_CRITICAL();
                 xSemaphoreGiveRecursive(mutex);
 
-                /* callback gets invoked here - check stack sizes */
-                markStack(current);
-
-                current->cb(); // call the callback
-
-                checkStack(current);
-
-                current->runCount++;
+                runCallback(current);
 
                 return 0;
             }
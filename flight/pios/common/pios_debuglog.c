@@ -60,7 +60,8 @@ static DebugLogEntryData staticbuffer;
 #endif
 
 #define LOG_ENTRY_MAX_DATA_SIZE (sizeof(((DebugLogEntryData *)0)->Data))
-#define LOG_ENTRY_HEADER_SIZE   (sizeof(DebugLogEntryData) - LOG_ENTRY_MAX_DATA_SIZE)
+// entries packed into Data are in wire format, they have no alignment or trailing padding
+#define LOG_ENTRY_HEADER_SIZE   (offsetof(DebugLogEntryDataPacked, Data))
 // build the obj_id as a DEBUGLOGENTRY ID with least significant byte zeroed and filled with flight number
 #define LOG_GET_FLIGHT_OBJID(x) ((DEBUGLOGENTRY_OBJID & ~0xFF) | (x & 0xFF))
 
@@ -91,7 +92,7 @@ void PIOS_DEBUGLOG_Initialize()
     fails_count = 0;
     used_buffer_space = 0;
     log_is_full = false;
-    while (PIOS_FLASHFS_ObjLoad(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0) {
+    while (PIOS_FLASHFS_ObjLoad(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, DEBUGLOGENTRY_NUMBYTES) == 0) {
         flightnum++;
     }
     mutexunlock();
@@ -162,7 +163,7 @@ void PIOS_DEBUGLOG_Printf(char *format, ...)
     buffer->InstanceID = 0;
     buffer->Size       = strlen((const char *)buffer->Data);
 
-    if (PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0) {
+    if (PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, DEBUGLOGENTRY_NUMBYTES) == 0) {
         lognum++;
     }
     mutexunlock();
@@ -184,7 +185,7 @@ void PIOS_DEBUGLOG_Printf(char *format, ...)
 int32_t PIOS_DEBUGLOG_Read(void *mybuffer, uint16_t flight, uint16_t inst)
 {
     PIOS_Assert(mybuffer);
-    return PIOS_FLASHFS_ObjLoad(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flight), inst, (uint8_t *)mybuffer, sizeof(DebugLogEntryData));
+    return PIOS_FLASHFS_ObjLoad(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flight), inst, (uint8_t *)mybuffer, DEBUGLOGENTRY_NUMBYTES);
 }
 
 /**
@@ -229,11 +230,11 @@ void PIOS_DEBUGLOG_Format(void)
 
 void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
 {
-    DebugLogEntryData *entry;
+    DebugLogEntryDataPacked *entry;
 
     // start a new block
     if (!used_buffer_space) {
-        entry = buffer;
+        entry = (DebugLogEntryDataPacked *)buffer;
         memset(buffer->Data, 0xff, sizeof(buffer->Data));
         used_buffer_space += size;
     } else {
@@ -243,11 +244,11 @@ void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
             if (!write_current_buffer()) {
                 return;
             }
-            entry = buffer;
+            entry = (DebugLogEntryDataPacked *)buffer;
             memset(buffer->Data, 0xff, sizeof(buffer->Data));
             used_buffer_space += size;
         } else {
-            entry = (DebugLogEntryData *)&buffer->Data[used_buffer_space];
+            entry = (DebugLogEntryDataPacked *)&buffer->Data[used_buffer_space];
             used_buffer_space += size + LOG_ENTRY_HEADER_SIZE;
         }
     }
@@ -269,7 +270,7 @@ void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
 bool write_current_buffer()
 {
     // not enough space, write the block and start a new one
-    if (PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0) {
+    if (PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, DEBUGLOGENTRY_NUMBYTES) == 0) {
         lognum++;
         fails_count = 0;
         used_buffer_space = 0;
@@ -148,6 +148,26 @@ int32_t PIOS_FLASHFS_ObjSave(__attribute__((unused)) uintptr_t fs_id, uint32_t o
     return 0;
 }
 
+/**
+ * @brief Saves a set of object instances to the filesystem
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] items The object instances to save
+ * @param[in] num_items Number of object instances to save
+ * @return 0 if success or the error code of the first object that failed to save
+ * @note Every object is a file of its own, there is nothing to gain from batching
+ */
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, const struct PIOS_FLASHFS_ObjItem *items, uint16_t num_items)
+{
+    for (uint16_t i = 0; i < num_items; i++) {
+        int32_t rc = PIOS_FLASHFS_ObjSave(fs_id, items[i].obj_id, items[i].obj_inst_id, items[i].obj_data, items[i].obj_size);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
 /**
  * @brief Load one object instance from the filesystem
  * @param[in] fs_id The filesystem to use for this action
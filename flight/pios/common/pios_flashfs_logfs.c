@@ -34,6 +34,7 @@
 #include <pios_math.h>
 #include <pios_wdg.h>
 #include "pios_flashfs_logfs_priv.h"
+#include "pios_flashfs.h" /* API for flash filesystem */
 
 /*
  * Filesystem state data tracked in RAM
@@ -788,6 +789,50 @@ out_exit:
     return rc;
 }
 
+/* NOTE: Must be called while holding the flash transaction lock */
+/* Obsoletes the active versions of all objects of a batch in a single pass over the log */
+static int8_t logfs_delete_objects(struct logfs_state *logfs, const struct PIOS_FLASHFS_ObjItem *items, uint16_t num_items)
+{
+    for (uint16_t slot_id = 1;
+         slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
+         slot_id++) {
+        struct slot_header slot_hdr;
+        uintptr_t slot_addr = logfs_get_addr(logfs, logfs->active_arena_id, slot_id);
+
+        if (logfs->driver->read_data(logfs->flash_id,
+                                     slot_addr,
+                                     (uint8_t *)&slot_hdr,
+                                     sizeof(slot_hdr)) != 0) {
+            return -1;
+        }
+        if (slot_hdr.state == SLOT_STATE_EMPTY) {
+            /* We hit the end of the log */
+            break;
+        }
+        if (slot_hdr.state == SLOT_STATE_ACTIVE) {
+            for (uint16_t i = 0; i < num_items; i++) {
+                if (slot_hdr.obj_id == items[i].obj_id &&
+                    slot_hdr.obj_inst_id == items[i].obj_inst_id) {
+                    slot_hdr.state = SLOT_STATE_OBSOLETE;
+                    if (logfs->driver->write_data(logfs->flash_id,
+                                                  slot_addr,
+                                                  (uint8_t *)&slot_hdr,
+                                                  sizeof(slot_hdr)) != 0) {
+                        return -2;
+                    }
+                    logfs->num_active_slots--;
+                    break;
+                }
+            }
+        }
+#ifdef PIOS_INCLUDE_WDG
+        PIOS_WDG_Clear();
+#endif
+    }
+
+    return 0;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int8_t logfs_reserve_free_slot(struct logfs_state *logfs, uint16_t *slot_id, struct slot_header *slot_hdr, uint32_t obj_id, uint16_t obj_inst_id, uint16_t obj_size)
 {
@@ -900,7 +945,6 @@ static int8_t logfs_append_to_log(struct logfs_state *logfs, uint32_t obj_id, ui
  * Provide a PIOS_FLASHFS_* driver
  *
  *********************************/
-#include "pios_flashfs.h" /* API for flash filesystem */
 
 /**
  * @brief Saves one object instance to the filesystem
@@ -990,6 +1034,83 @@ out_exit:
     return rc;
 }
 
+/**
+ * @brief Saves a set of object instances to the filesystem in one transaction.
+ * Previous versions of all objects are obsoleted in a single pass over the log and
+ * garbage collection runs at most once, before the first object is written.
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] items The object instances to save, each object instance must only be listed once
+ * @param[in] num_items Number of object instances to save
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if failure to delete any previous versions of the objects
+ * @retval -4 if filesystem has no room for all objects and garbage collection won't help
+ * @retval -5 if garbage collection failed
+ * @retval -6 if filesystem is full even after garbage collection should have freed space
+ * @retval -7 if writing the new objects to the filesystem failed
+ */
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, const struct PIOS_FLASHFS_ObjItem *items, uint16_t num_items)
+{
+    int8_t rc;
+
+    struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+    if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+        rc = -1;
+        goto out_exit;
+    }
+
+    for (uint16_t i = 0; i < num_items; i++) {
+        PIOS_Assert(items[i].obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header)));
+    }
+
+    if (logfs->driver->start_transaction(logfs->flash_id) != 0) {
+        rc = -2;
+        goto out_exit;
+    }
+
+    if (logfs_delete_objects(logfs, items, num_items) != 0) {
+        rc = -3;
+        goto out_end_trans;
+    }
+
+    /* Check if the arena can hold all objects once obsolete slots are reclaimed */
+    if (logfs->num_active_slots + num_items > (logfs->cfg->arena_size / logfs->cfg->slot_size) - 1) {
+        rc = -4;
+        goto out_end_trans;
+    }
+
+    /* Collect garbage once for the whole batch */
+    if (logfs->num_free_slots < num_items) {
+        if (logfs_garbage_collect(logfs) != 0) {
+            rc = -5;
+            goto out_end_trans;
+        }
+        if (logfs->num_free_slots < num_items) {
+            PIOS_DEBUG_Assert(0);
+            rc = -6;
+            goto out_end_trans;
+        }
+    }
+
+    for (uint16_t i = 0; i < num_items; i++) {
+        if (logfs_append_to_log(logfs, items[i].obj_id, items[i].obj_inst_id, items[i].obj_data, items[i].obj_size) != 0) {
+            rc = -7;
+            goto out_end_trans;
+        }
+    }
+
+    /* All objects successfully written to the log */
+    rc = 0;
+
+out_end_trans:
+    logfs->driver->end_transaction(logfs->flash_id);
+
+out_exit:
+    return rc;
+}
+
 /**
  * @brief Load one object instance from the filesystem
  * @param[in] fs_id The filesystem to use for this action
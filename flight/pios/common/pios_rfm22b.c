@@ -60,7 +60,7 @@
 #include <pios_spi_priv.h>
 #include <pios_rfm22b_priv.h>
 #include <pios_ppm_out.h>
-#include <ecc.h>
+#include <rs255.h>
 #include <sha1.h>
 
 /* Local Defines */
@@ -467,7 +467,7 @@ int32_t PIOS_RFM22B_Init(uint32_t *rfm22b_id, uint32_t spi_id, uint32_t slave_nu
 #endif /* PIOS_WDG_RFM22B */
 
     // Initialize the ECC library.
-    initialize_ecc();
+    rs255_init();
 
     // Set the state to initializing.
     rfm22b_dev->state = RADIO_STATE_UNINITIALIZED;
@@ -1841,7 +1841,7 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev *radio_dev)
     // Add the error correcting code.
     if (!radio_dev->ppm_only_mode) {
         if (len != 0) {
-            encode_data((unsigned char *)p, len, (unsigned char *)p);
+            rs255_encode(p, len);
         }
         len += RS_ECC_NPARITY;
     }
@@ -1919,12 +1919,11 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev *radio_d
 
         // Attempt to correct any errors in the packet.
         if (data_len > 0) {
-            decode_data((unsigned char *)p, rx_len);
-            good_packet = check_syndrome() == 0;
+            int8_t corrected = rs255_decode(p, rx_len);
+            good_packet = corrected == 0;
 
-            // We have an error.  Try to correct it.
-            if (!good_packet && (correct_errors_erasures((unsigned char *)p, rx_len, 0, 0) != 0)) {
-                // We corrected it
+            // We had an error, but it was corrected.
+            if (corrected > 0) {
                 corrected_packet = true;
             }
         }
@@ -29,6 +29,8 @@
 
 #ifdef PIOS_INCLUDE_TASK_MONITOR
 
+#include <pios_tracebuffer.h>
+
 // Private variables
 static xSemaphoreHandle mLock;
 static xTaskHandle *mTaskHandles;
@@ -36,6 +38,34 @@ static uint32_t mLastMonitorTime;
 static uint32_t mLastIdleMonitorTime;
 static uint16_t mMaxTasks;
 
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+// Number of ForEachTask() samples spanned by the long load window
+#define LOAD_WINDOW_SAMPLES 8
+
+// Per task accounting, written from the scheduler hooks
+struct task_stats {
+    uint32_t readyTime; // raw delay timer when the task became runnable
+    uint32_t switchInTime; // raw delay timer at the last switch in
+    uint32_t runTime; // us of cpu time, wraps
+    uint32_t maxSlice; // us, longest continuous run since the last sample
+    uint32_t maxLatency; // us, longest ready to running delay since the last sample
+    uint16_t preemptions; // since the last sample
+    bool     waiting; // ready but not running, readyTime is valid
+    uint32_t runTimeHistory[LOAD_WINDOW_SAMPLES]; // runTime at the last samples
+};
+
+static struct task_stats *mTaskStats;
+static int32_t mRunningTask = -1;
+static int32_t mPreemptedTask = -1;
+// us, summed from the raw intervals between samples, which the System
+// module takes far less than a raw timer period apart
+static uint32_t mSampleTimeHistory[LOAD_WINDOW_SAMPLES];
+static uint32_t mSampleTime;
+static uint32_t mSampleRaw;
+static uint8_t mSampleIndex;
+static uint8_t mSampleCount;
+#endif
+
 /**
  * Initialize the Task Monitor
  */
@@ -52,6 +82,18 @@ int32_t PIOS_TASK_MONITOR_Initialize(uint16_t max_tasks)
     }
     memset(mTaskHandles, 0, max_tasks * sizeof(xTaskHandle));
 
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+    mTaskStats = (struct task_stats *)pios_malloc(max_tasks * sizeof(struct task_stats));
+    if (!mTaskStats) {
+        return -1;
+    }
+    memset(mTaskStats, 0, max_tasks * sizeof(struct task_stats));
+    mSampleIndex = 0;
+    mSampleCount = 0;
+    mSampleTime  = 0;
+    mSampleRaw   = PIOS_DELAY_GetRaw();
+#endif
+
     mMaxTasks = max_tasks;
 #if (configGENERATE_RUN_TIME_STATS == 1)
     mLastMonitorTime     = portGET_RUN_TIME_COUNTER_VALUE();
@@ -71,6 +113,10 @@ int32_t PIOS_TASK_MONITOR_RegisterTask(uint16_t task_id, xTaskHandle handle)
     if (mTaskHandles && task_id < mMaxTasks) {
         xSemaphoreTakeRecursive(mLock, portMAX_DELAY);
         mTaskHandles[task_id] = handle;
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+        // the tag lets the scheduler hooks find the task without a lookup, 0 means unmonitored
+        vTaskSetApplicationTaskTag(handle, (pdTASK_HOOK_CODE)(uintptr_t)(task_id + 1));
+#endif
         xSemaphoreGiveRecursive(mLock);
         return 0;
     } else {
@@ -101,6 +147,103 @@ bool PIOS_TASK_MONITOR_IsRunning(uint16_t task_id)
     return mTaskHandles && task_id <= mMaxTasks && mTaskHandles[task_id];
 }
 
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+/**
+ * Map a task tag back to the task_id, -1 for unmonitored tasks
+ */
+static inline int32_t taskIdFromTag(void *tag)
+{
+    uint32_t id = (uint32_t)(uintptr_t)tag;
+
+    return (mTaskStats && id && id <= mMaxTasks) ? (int32_t)id - 1 : -1;
+}
+
+/**
+ * Scheduler hook: a task has been moved to the ready list
+ */
+void PIOS_TASK_MONITOR_TaskReady(void *tag)
+{
+    int32_t id = taskIdFromTag(tag);
+
+    // priority changes re-insert the running task, that is not a wake up
+    if (id < 0 || id == mRunningTask || mTaskStats[id].waiting) {
+        return;
+    }
+    mTaskStats[id].readyTime = PIOS_DELAY_GetRaw();
+    mTaskStats[id].waiting   = true;
+}
+
+/**
+ * Scheduler hook: the current task is about to be switched out
+ */
+void PIOS_TASK_MONITOR_TaskSwitchedOut(void *tag, int still_ready)
+{
+    int32_t id = taskIdFromTag(tag);
+
+    mPreemptedTask = -1;
+    if (id < 0 || id != mRunningTask) {
+        return;
+    }
+    struct task_stats *stats = &mTaskStats[id];
+    // raw ticks, on F4 the us clock wraps with the cycle counter every 25.5 s
+    uint32_t now   = PIOS_DELAY_GetRaw();
+    uint32_t slice = PIOS_DELAY_DiffuS2(stats->switchInTime, now);
+    stats->runTime += slice;
+    if (slice > stats->maxSlice) {
+        stats->maxSlice = slice;
+    }
+    if (still_ready) {
+        // only a preemption if another task actually gets the cpu, see TaskSwitchedIn()
+        mPreemptedTask   = id;
+        stats->readyTime = now;
+        stats->waiting   = true;
+    }
+}
+
+/**
+ * Scheduler hook: a task has just been switched in
+ */
+void PIOS_TASK_MONITOR_TaskSwitchedIn(void *tag)
+{
+    int32_t id = taskIdFromTag(tag);
+
+    PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_TASK_SWITCH, id < 0 ? PIOS_TRACEBUFFER_ID_UNKNOWN : (uint16_t)id);
+
+    if (mPreemptedTask >= 0 && mPreemptedTask != id) {
+        mTaskStats[mPreemptedTask].preemptions++;
+    }
+    mPreemptedTask = -1;
+    mRunningTask   = id;
+    if (id < 0) {
+        return;
+    }
+    struct task_stats *stats = &mTaskStats[id];
+    uint32_t now = PIOS_DELAY_GetRaw();
+    stats->switchInTime = now;
+    if (stats->waiting) {
+        uint32_t latency = PIOS_DELAY_DiffuS2(stats->readyTime, now);
+        if (latency > stats->maxLatency) {
+            stats->maxLatency = latency;
+        }
+        stats->waiting = false;
+    }
+}
+
+/**
+ * Load in 1/100 % between two samples
+ */
+static uint16_t loadSince(uint32_t runTime, uint32_t lastRunTime, uint32_t now, uint32_t lastTime)
+{
+    uint32_t interval = now - lastTime;
+
+    if (!interval) {
+        return 0;
+    }
+    uint64_t load = ((uint64_t)(runTime - lastRunTime) * 10000) / interval;
+    return load > 0xFFFF ? 0xFFFF : (uint16_t)load;
+}
+#endif /* PIOS_TASK_MONITOR_SCHEDULER_HOOKS */
+
 /**
  * Tell the caller the status of all tasks via a task-by-task callback
  */
@@ -120,10 +263,55 @@ void PIOS_TASK_MONITOR_ForEachTask(TaskMonitorTaskInfoCallback callback, void *c
     /* avoid divide-by-zero if the interval is too small */
     uint32_t deltaTime   = ((currentTime - mLastMonitorTime) / 100) ? : 1;
     mLastMonitorTime = currentTime;
+#endif
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+    /* The short window is the time since the previous sample, the long window
+     * spans up to LOAD_WINDOW_SAMPLES samples. The slot about to be written
+     * holds the oldest sample once the history is full. */
+    uint32_t raw = PIOS_DELAY_GetRaw();
+    mSampleTime += PIOS_DELAY_DiffuS2(mSampleRaw, raw);
+    mSampleRaw   = raw;
+    uint32_t now = mSampleTime;
+    uint8_t previous = (mSampleIndex + LOAD_WINDOW_SAMPLES - 1) % LOAD_WINDOW_SAMPLES;
+    uint8_t oldest   = (mSampleCount < LOAD_WINDOW_SAMPLES) ? 0 : mSampleIndex;
 #endif
     /* Update all task information */
     for (uint16_t n = 0; n < mMaxTasks; ++n) {
         struct pios_task_info info;
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+        struct task_stats *stats = &mTaskStats[n];
+        uint32_t runTime;
+
+        /* Snapshot and reset the per window values, the hooks run with
+         * the same interrupts masked so this only needs a few cycles */
+        portENTER_CRITICAL();
+        runTime = stats->runTime;
+        if (n == mRunningTask) {
+            runTime += PIOS_DELAY_DiffuS2(stats->switchInTime, raw);
+        }
+        info.max_slice_us   = stats->maxSlice;
+        info.max_latency_us = stats->maxLatency;
+        info.preemptions    = stats->preemptions;
+        stats->maxSlice     = 0;
+        stats->maxLatency   = 0;
+        stats->preemptions  = 0;
+        portEXIT_CRITICAL();
+
+        if (mSampleCount) {
+            info.load     = loadSince(runTime, stats->runTimeHistory[previous], now, mSampleTimeHistory[previous]);
+            info.load_avg = loadSince(runTime, stats->runTimeHistory[oldest], now, mSampleTimeHistory[oldest]);
+        } else {
+            info.load     = 0;
+            info.load_avg = 0;
+        }
+        stats->runTimeHistory[mSampleIndex] = runTime;
+#else
+        info.load           = 0;
+        info.load_avg       = 0;
+        info.max_slice_us   = 0;
+        info.max_latency_us = 0;
+        info.preemptions    = 0;
+#endif
         if (mTaskHandles[n]) {
             info.is_running = true;
 #if defined(ARCH_POSIX) || defined(ARCH_WIN32)
@@ -145,6 +333,13 @@ void PIOS_TASK_MONITOR_ForEachTask(TaskMonitorTaskInfoCallback callback, void *c
         /* Pass the information for this task back to the caller */
         callback(n, &info, context);
     }
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+    mSampleTimeHistory[mSampleIndex] = now;
+    mSampleIndex = (mSampleIndex + 1) % LOAD_WINDOW_SAMPLES;
+    if (mSampleCount < LOAD_WINDOW_SAMPLES) {
+        mSampleCount++;
+    }
+#endif
 
     xSemaphoreGiveRecursive(mLock);
 }
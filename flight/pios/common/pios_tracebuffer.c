@@ -0,0 +1,115 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_tracebuffer.c
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      PiOS event trace buffer
+ *             Records timestamped scheduling events into a RAM ring
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <pios.h>
+
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+
+#include <pios_tracebuffer.h>
+
+pios_tracebuffer_event_t *pios_tracebuffer_events = NULL;
+volatile uint32_t pios_tracebuffer_head = 0;
+uint32_t pios_tracebuffer_mask = 0;
+volatile bool pios_tracebuffer_enabled = false;
+
+int32_t PIOS_TRACEBUFFER_Init(uint16_t maxEvents)
+{
+    if (maxEvents == 0) {
+        return -1;
+    }
+
+    // round down to a power of two so the write index can wrap with a mask
+    uint32_t size = 1;
+    while ((size << 1) <= maxEvents) {
+        size <<= 1;
+    }
+
+    pios_tracebuffer_events = (pios_tracebuffer_event_t *)pios_malloc(size * sizeof(pios_tracebuffer_event_t));
+    if (!pios_tracebuffer_events) {
+        return -1;
+    }
+    memset(pios_tracebuffer_events, 0, size * sizeof(pios_tracebuffer_event_t));
+    pios_tracebuffer_mask    = size - 1;
+    pios_tracebuffer_head    = 0;
+    pios_tracebuffer_enabled = false;
+
+    return 0;
+}
+
+void PIOS_TRACEBUFFER_Start(void)
+{
+    if (!pios_tracebuffer_events) {
+        return;
+    }
+    pios_tracebuffer_head    = 0;
+    pios_tracebuffer_enabled = true;
+}
+
+void PIOS_TRACEBUFFER_Stop(void)
+{
+    pios_tracebuffer_enabled = false;
+}
+
+bool PIOS_TRACEBUFFER_IsRunning(void)
+{
+    return pios_tracebuffer_enabled;
+}
+
+uint16_t PIOS_TRACEBUFFER_Count(void)
+{
+    if (!pios_tracebuffer_events) {
+        return 0;
+    }
+    uint32_t head = pios_tracebuffer_head;
+    return (head > pios_tracebuffer_mask) ? pios_tracebuffer_mask + 1 : head;
+}
+
+uint32_t PIOS_TRACEBUFFER_Dropped(void)
+{
+    uint32_t head = pios_tracebuffer_head;
+
+    return (head > pios_tracebuffer_mask) ? head - (pios_tracebuffer_mask + 1) : 0;
+}
+
+uint16_t PIOS_TRACEBUFFER_Read(uint16_t first, pios_tracebuffer_event_t *events, uint16_t maxEvents)
+{
+    uint16_t count = PIOS_TRACEBUFFER_Count();
+
+    if (first >= count) {
+        return 0;
+    }
+    if (maxEvents > count - first) {
+        maxEvents = count - first;
+    }
+
+    uint32_t oldest = pios_tracebuffer_head - count;
+    for (uint16_t i = 0; i < maxEvents; i++) {
+        events[i] = pios_tracebuffer_events[(oldest + first + i) & pios_tracebuffer_mask];
+    }
+    return maxEvents;
+}
+
+#endif /* PIOS_INCLUDE_TRACEBUFFER */
@@ -38,5 +38,7 @@ extern void PIOS_BL_HELPER_FLASH_Read_Description(uint8_t *array, uint8_t size);
 extern uint8_t PIOS_BL_HELPER_FLASH_Start();
 extern uint8_t PIOS_BL_HELPER_FLASH_Erase_Bootloader();
 extern void PIOS_BL_HELPER_CRC_Ini();
+extern bool PIOS_BL_HELPER_FLASH_Sector_Info(uint32_t address, uint32_t *sector_start, uint32_t *sector_size);
+extern uint8_t PIOS_BL_HELPER_FLASH_Erase_Sector(uint32_t address);
 
 #endif /* PIOS_BL_HELPER_H */
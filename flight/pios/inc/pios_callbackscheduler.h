@@ -145,6 +145,22 @@ DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(
     int16_t callbackID,
     uint32_t stacksize);
 
+/**
+ * Register a new callback with a deadline, see PIOS_CALLBACKSCHEDULER_Create().
+ * Waiting callbacks that have a deadline are run earliest deadline first (EDF)
+ * ahead of the round robin callbacks of the same priority. Deadline misses
+ * are counted and reported through PIOS_CALLBACKSCHEDULER_ForEachCallback().
+ * \param[in] deadlineUs Time in microseconds after dispatch by which the callback should have started, 0 for none
+ * \return CallbackInfo Pointer on success, NULL if failed.
+ */
+DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_CreateWithDeadline(
+    DelayedCallback cb,
+    DelayedCallbackPriority priority,
+    DelayedCallbackPriorityTask priorityTask,
+    int16_t callbackID,
+    uint32_t stacksize,
+    uint32_t deadlineUs);
+
 /**
  * Schedule dispatching a callback at some point in the future. The function returns immediately.
  * \param[in] *cbinfo the callback handle
@@ -186,6 +202,13 @@ int32_t PIOS_CALLBACKSCHEDULER_Dispatch(DelayedCallbackInfo *cbinfo);
  */
 int32_t PIOS_CALLBACKSCHEDULER_DispatchFromISR(DelayedCallbackInfo *cbinfo, long *pxHigherPriorityTaskWoken);
 
+/**
+ * Number of log2 buckets in the latency and run time histograms.
+ * Bucket 0 counts durations below 16us, bucket n durations in [2^(n+3), 2^(n+4)) us,
+ * the last bucket everything above.
+ */
+#define CALLBACK_HISTOGRAM_BUCKETS 10
+
 /**
  * Information about a running callback that has been registered
  * via a call to PIOS_CALLBACKSCHEDULER_Create().
@@ -197,8 +220,25 @@ struct pios_callback_info {
     bool     is_running;
     /** Count of executions of the callback since system start */
     uint32_t running_time_count;
+    /** Longest time from dispatch to start of execution in microseconds */
+    uint32_t latency_max_us;
+    /** Longest execution time in microseconds */
+    uint32_t run_time_max_us;
+    /** Number of times the callback started after its deadline */
+    uint16_t deadline_misses;
+    /** Dispatch to start latency distribution, see CALLBACK_HISTOGRAM_BUCKETS */
+    uint16_t latency_histogram[CALLBACK_HISTOGRAM_BUCKETS];
+    /** Execution time distribution, see CALLBACK_HISTOGRAM_BUCKETS */
+    uint16_t run_time_histogram[CALLBACK_HISTOGRAM_BUCKETS];
 };
 
+/**
+ * Upper bound in microseconds of the histogram bucket holding the given percentile
+ * @param histogram  latency_histogram or run_time_histogram from struct pios_callback_info
+ * @param percentile 0 to 100
+ */
+uint32_t PIOS_CALLBACKSCHEDULER_HistogramPercentile(const uint16_t *histogram, uint8_t percentile);
+
 /**
  * Iterator callback, called for each monitored callback by PIOS_CALLBACKSCHEDULER_ForEachCallback().
  *
@@ -34,11 +34,20 @@ struct PIOS_FLASHFS_Stats {
     uint16_t num_active_slots; /* slots in active state */
 };
 
+/* One object instance of a batch save */
+struct PIOS_FLASHFS_ObjItem {
+    uint32_t obj_id;
+    uint16_t obj_inst_id;
+    uint16_t obj_size;
+    uint8_t  *obj_data;
+};
+
 // define logfs subdirectory of a yaffs flash device
 #define PIOS_LOGFS_DIR "logfs"
 
 int32_t PIOS_FLASHFS_Format(uintptr_t fs_id);
 int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size);
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, const struct PIOS_FLASHFS_ObjItem *items, uint16_t num_items);
 int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size);
 int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id);
 int32_t PIOS_FLASHFS_GetStats(uintptr_t fs_id, struct PIOS_FLASHFS_Stats *stats);
@@ -28,6 +28,7 @@
 #include <pios.h>
 #include <pios_debug.h>
 #include <pios_delay.h>
+#include <pios_tracebuffer.h>
 #include <FreeRTOS.h>
 typedef struct {
     uint32_t id;
@@ -75,6 +76,7 @@ static inline void PIOS_Instrumentation_TimeStart(pios_counter_t counter_handle)
     vPortEnterCritical();
     pios_perf_counter_t *counter = (pios_perf_counter_t *)counter_handle;
 
+    PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_MARKER_START, counter - pios_instrumentation_perf_counters);
     counter->lastUpdateTS = PIOS_DELAY_GetRaw();
     vPortExitCritical();
 }
@@ -89,6 +91,7 @@ static inline void PIOS_Instrumentation_TimeEnd(pios_counter_t counter_handle)
     vPortEnterCritical();
     pios_perf_counter_t *counter = (pios_perf_counter_t *)counter_handle;
 
+    PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_MARKER_END, counter - pios_instrumentation_perf_counters);
     counter->value = PIOS_DELAY_DiffuS(counter->lastUpdateTS);
     counter->max--;
     if (counter->value > counter->max) {
@@ -110,6 +113,7 @@ static inline void PIOS_Instrumentation_TrackPeriod(pios_counter_t counter_handl
 {
     PIOS_Assert(pios_instrumentation_perf_counters && counter_handle);
     pios_perf_counter_t *counter = (pios_perf_counter_t *)counter_handle;
+    PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_MARKER_INSTANT, counter - pios_instrumentation_perf_counters);
     if (counter->lastUpdateTS != 0) {
         vPortEnterCritical();
         uint32_t period = PIOS_DELAY_DiffuS(counter->lastUpdateTS);
@@ -32,7 +32,7 @@
 typedef enum { FALSE = 0, TRUE = !FALSE } bool;
 #endif
 
-#ifndef false
+#if !defined(false) && !defined(__cplusplus)
         #define false FALSE
         #define true  TRUE
 #endif
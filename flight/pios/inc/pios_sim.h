@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_sim.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Simulator run options for the posix target
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef PIOS_SIM_H
+#define PIOS_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Parse the simulator command line, must be called before the scheduler is started
+ *   --speed=<factor>  run on a virtual clock at <factor> times real time, 0 runs as fast as possible
+ *   --seed=<n>        seed for the noise of the simulation models
+ *   --port-offset=<n> added to the UDP ports, to run several simulators on one host
+ * \return 0 on success, -1 on invalid arguments
+ */
+int32_t PIOS_SIM_Init(int argc, char *argv[]);
+
+/**
+ * \return true if time is simulated rather than taken from the wall clock
+ */
+bool PIOS_SIM_IsVirtualTime(void);
+
+/**
+ * \return seed for the noise of the simulation models
+ */
+uint32_t PIOS_SIM_GetSeed(void);
+
+/**
+ * \return offset added to the UDP ports of the board
+ */
+uint16_t PIOS_SIM_GetPortOffset(void);
+
+#endif /* PIOS_SIM_H */
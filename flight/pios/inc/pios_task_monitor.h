@@ -84,6 +84,20 @@ struct pios_task_info {
      *  to PIOS_TASK_MONITOR_ForEachTask(). Low-load tasks may
      *  report 0% load even though they have run during the interval. */
     uint8_t running_time_percentage;
+    /** Cpu load in 1/100 % since the last call to PIOS_TASK_MONITOR_ForEachTask().
+     *  Measured at every context switch, so short runs are not lost.
+     *  This and the following fields are only collected when the board
+     *  defines PIOS_TASK_MONITOR_SCHEDULER_HOOKS (builds with the trace
+     *  buffer), they read 0 otherwise. */
+    uint16_t load;
+    /** Cpu load in 1/100 % over the last several calls to PIOS_TASK_MONITOR_ForEachTask(). */
+    uint16_t load_avg;
+    /** Longest time in us the task ran without being switched out. */
+    uint32_t max_slice_us;
+    /** Longest time in us the task waited between becoming ready and running. */
+    uint32_t max_latency_us;
+    /** Number of times the task lost the cpu while still ready to run. */
+    uint16_t preemptions;
 };
 
 /**
@@ -109,4 +123,15 @@ extern void PIOS_TASK_MONITOR_ForEachTask(TaskMonitorTaskInfoCallback callback,
  */
 extern uint8_t PIOS_TASK_MONITOR_GetIdlePercentage();
 
+#ifdef PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+/**
+ * FreeRTOS scheduler hooks, called from FreeRTOSConfig.h trace macros with
+ * the task tag set by PIOS_TASK_MONITOR_RegisterTask(). They run with the
+ * kernel interrupts masked and must stay short.
+ */
+extern void PIOS_TASK_MONITOR_TaskReady(void *tag);
+extern void PIOS_TASK_MONITOR_TaskSwitchedOut(void *tag, int still_ready);
+extern void PIOS_TASK_MONITOR_TaskSwitchedIn(void *tag);
+#endif
+
 #endif // PIOS_TASK_MONITOR_H
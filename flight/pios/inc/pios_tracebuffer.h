@@ -0,0 +1,137 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_tracebuffer.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      PiOS event trace buffer
+ *             Records timestamped scheduling events into a RAM ring
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef PIOS_TRACEBUFFER_H
+#define PIOS_TRACEBUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Event types. The numeric values are part of the download format, do not reorder.
+ */
+enum pios_tracebuffer_event_type {
+    PIOS_TRACEBUFFER_EVENT_NONE = 0,
+    PIOS_TRACEBUFFER_EVENT_TASK_SWITCH, /* id = TaskInfo task index, 0xFFFF for unmonitored tasks */
+    PIOS_TRACEBUFFER_EVENT_CALLBACK_START, /* id = CallbackInfo callback index */
+    PIOS_TRACEBUFFER_EVENT_CALLBACK_END,
+    PIOS_TRACEBUFFER_EVENT_ISR_ENTER, /* id = interrupt line */
+    PIOS_TRACEBUFFER_EVENT_ISR_EXIT,
+    PIOS_TRACEBUFFER_EVENT_MARKER_START, /* id = PerfCounter instance */
+    PIOS_TRACEBUFFER_EVENT_MARKER_END,
+    PIOS_TRACEBUFFER_EVENT_MARKER_INSTANT,
+};
+
+#define PIOS_TRACEBUFFER_ID_UNKNOWN 0xFFFF
+
+/**
+ * A single trace record, 8 bytes, little endian on the wire
+ */
+typedef struct {
+    uint32_t timestamp; /* raw delay timer ticks, see PIOS_DELAY_GetRawHz() */
+    uint16_t id;
+    uint8_t  type;
+    uint8_t  reserved;
+} pios_tracebuffer_event_t;
+
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+
+#include <pios_delay.h>
+
+extern pios_tracebuffer_event_t *pios_tracebuffer_events;
+extern volatile uint32_t pios_tracebuffer_head;
+extern uint32_t pios_tracebuffer_mask;
+extern volatile bool pios_tracebuffer_enabled;
+
+/**
+ * Append an event to the ring. Lock free, safe to call from tasks, ISRs and the scheduler.
+ * @param type event type @see pios_tracebuffer_event_type
+ * @param id the id of the traced entity
+ */
+static inline void PIOS_TRACEBUFFER_Record(uint8_t type, uint16_t id)
+{
+    if (!pios_tracebuffer_enabled) {
+        return;
+    }
+    uint32_t slot = __sync_fetch_and_add(&pios_tracebuffer_head, 1) & pios_tracebuffer_mask;
+    pios_tracebuffer_event_t *event = &pios_tracebuffer_events[slot];
+    // not GetuS(), the F4 us clock wraps with the cycle counter, after
+    // 2^32 ticks rather than 2^32 us, the ticks are unwrapped by the GCS
+    event->timestamp = PIOS_DELAY_GetRaw();
+    event->id   = id;
+    event->type = type;
+}
+
+/**
+ * Initialize the trace buffer
+ * @param maxEvents ring size, rounded down to a power of two
+ * @return 0 on success, -1 if the ring could not be allocated
+ */
+int32_t PIOS_TRACEBUFFER_Init(uint16_t maxEvents);
+
+/**
+ * Clear the ring and start recording
+ */
+void PIOS_TRACEBUFFER_Start(void);
+
+/**
+ * Stop recording, the ring content is kept until the next start
+ */
+void PIOS_TRACEBUFFER_Stop(void);
+
+/**
+ * \return true while events are being recorded
+ */
+bool PIOS_TRACEBUFFER_IsRunning(void);
+
+/**
+ * \return number of events held in the ring
+ */
+uint16_t PIOS_TRACEBUFFER_Count(void);
+
+/**
+ * \return number of events overwritten since the last start
+ */
+uint32_t PIOS_TRACEBUFFER_Dropped(void);
+
+/**
+ * Copy events out of the ring, oldest first
+ * \param[in] first index of the first event to copy, 0 is the oldest event held
+ * \param[out] events destination
+ * \param[in] maxEvents capacity of the destination
+ * \return number of events copied
+ */
+uint16_t PIOS_TRACEBUFFER_Read(uint16_t first, pios_tracebuffer_event_t *events, uint16_t maxEvents);
+
+#else /* PIOS_INCLUDE_TRACEBUFFER */
+
+#define PIOS_TRACEBUFFER_Record(type, id)
+
+#endif /* PIOS_INCLUDE_TRACEBUFFER */
+
+#define PIOS_TRACEBUFFER_ISR_ENTER(id) PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_ISR_ENTER, id)
+#define PIOS_TRACEBUFFER_ISR_EXIT(id)  PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_ISR_EXIT, id)
+
+#endif /* PIOS_TRACEBUFFER_H */
@@ -73,6 +73,7 @@
 /* PIOS Hardware Includes (posix) */
 #include <pios_sys.h>
 #include <pios_delay.h>
+#include <pios_sim.h>
 #include <pios_led.h>
 /* FIXME: simposix needs its own custom include directory into
  * which a custom pios_led.h can be put that includes the following
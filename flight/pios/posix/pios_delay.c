@@ -33,14 +33,29 @@
 
 #if defined(PIOS_INCLUDE_DELAY)
 
+#include <time.h>
+
+/**
+ * On a virtual clock a busy wait must not sleep, it steps virtual time by
+ * the wait time instead. Waits across a tick spin until the tick is issued.
+ */
+static int32_t PIOS_DELAY_VirtualWait(uint32_t uS)
+{
+    unsigned long long until = ullPortGetVirtualTimeUS() + uS;
+
+    while (ullPortStepVirtualTimeUS(until) < until) {
+        ;
+    }
+
+    return 0;
+}
+
 /**
  * Initialises the Timer used by PIOS_DELAY functions<BR>
  * This is called from pios.c as part of the main() function
  * at system start up.
  * \return < 0 if initialisation failed
  */
-#include <time.h>
-
 int32_t PIOS_DELAY_Init(void)
 {
     // stub
@@ -63,6 +78,10 @@ int32_t PIOS_DELAY_WaituS(uint32_t uS)
 {
     static struct timespec wait, rest;
 
+    if (PIOS_SIM_IsVirtualTime()) {
+        return PIOS_DELAY_VirtualWait(uS);
+    }
+
     wait.tv_sec  = 0;
     wait.tv_nsec = 1000 * uS;
     while (nanosleep(&wait, &rest) != 0) {
@@ -90,6 +109,10 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
     // PIOS_DELAY_WaituS(1000);
     static struct timespec wait, rest;
 
+    if (PIOS_SIM_IsVirtualTime()) {
+        return PIOS_DELAY_VirtualWait(mS * 1000);
+    }
+
     wait.tv_sec  = mS / 1000;
     wait.tv_nsec = (mS % 1000) * 1000000;
     while (nanosleep(&wait, &rest) != 0) {
@@ -109,6 +132,10 @@ uint32_t PIOS_DELAY_GetuS()
 {
     static struct timespec current;
 
+    if (PIOS_SIM_IsVirtualTime()) {
+        return (uint32_t)ullPortGetVirtualTimeUS();
+    }
+
     clock_gettime(CLOCK_REALTIME, &current);
     return (current.tv_sec * 1000000) + (current.tv_nsec / 1000);
 }
@@ -141,5 +168,25 @@ uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
     return PIOS_DELAY_GetuS() - raw;
 }
 
+/**
+ * @brief Compare two raw times and convert to us
+ * @param[in] raw the earlier raw time
+ * @param[in] later the later raw time
+ * @return A microsecond value
+ */
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later)
+{
+    return later - raw;
+}
+
+/**
+ * @brief Rate of the raw delay timer
+ * @return Raw ticks per second
+ */
+uint32_t PIOS_DELAY_GetRawHz()
+{
+    return 1000000;
+}
+
 
 #endif /* if defined(PIOS_INCLUDE_DELAY) */
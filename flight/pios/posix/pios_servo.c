@@ -68,4 +68,24 @@ void PIOS_Servo_Set(uint8_t Servo, uint16_t Position)
 #endif // PIOS_ENABLE_DEBUG_PINS
 }
 
+/**
+ * Latch the positions set since the last update, nothing to do here
+ */
+void PIOS_Servo_Update()
+{}
+
+/**
+ * Set the pulse mode of a bank of outputs, all outputs are simulated alike
+ */
+void PIOS_Servo_SetBankMode(__attribute__((unused)) uint8_t bank, __attribute__((unused)) uint8_t mode)
+{}
+
+/**
+ * All simulated outputs share one bank
+ */
+uint8_t PIOS_Servo_GetPinBank(__attribute__((unused)) uint8_t pin)
+{
+    return 0;
+}
+
 #endif /* if defined(PIOS_INCLUDE_SERVO) */
@@ -0,0 +1,100 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_sim.c
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Simulator run options for the posix target
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#include <getopt.h>
+
+static bool virtual_time = false;
+static uint32_t seed     = 1;
+static uint16_t port_offset;
+
+int32_t PIOS_SIM_Init(int argc, char *argv[])
+{
+    static const struct option options[] = {
+        { "speed", required_argument, NULL, 's' },
+        { "seed",  required_argument, NULL, 'r' },
+        { "port-offset", required_argument, NULL, 'p' },
+        { NULL,    0,                 NULL, 0   }
+    };
+    char *end;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (opt) {
+        case 's':
+        {
+            double speed = strtod(optarg, &end);
+            if (*end || speed < 0) {
+                fprintf(stderr, "invalid speed factor %s\n", optarg);
+                return -1;
+            }
+#if defined(PIOS_INCLUDE_FREERTOS)
+            vPortEnableVirtualTime(speed);
+#endif
+            virtual_time = true;
+            break;
+        }
+        case 'r':
+            seed = strtoul(optarg, &end, 0);
+            if (*end) {
+                fprintf(stderr, "invalid seed %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'p':
+        {
+            unsigned long offset = strtoul(optarg, &end, 0);
+            if (*end || offset > 1000) {
+                fprintf(stderr, "invalid port offset %s\n", optarg);
+                return -1;
+            }
+            port_offset = offset;
+            break;
+        }
+        default:
+            fprintf(stderr, "usage: %s [--speed=<factor>] [--seed=<n>] [--port-offset=<n>]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+bool PIOS_SIM_IsVirtualTime(void)
+{
+    return virtual_time;
+}
+
+uint32_t PIOS_SIM_GetSeed(void)
+{
+    return seed;
+}
+
+uint16_t PIOS_SIM_GetPortOffset(void)
+{
+    return port_offset;
+}
@@ -36,11 +36,20 @@
 #include <stm32f0xx_flash.h>
 #include <stdbool.h>
 
+#define FLASH_PAGE_BYTES 1024
+
 uint8_t *PIOS_BL_HELPER_FLASH_If_Read(uint32_t SectorAddress)
 {
     return (uint8_t *)(SectorAddress);
 }
 
+bool PIOS_BL_HELPER_FLASH_Sector_Info(uint32_t address, uint32_t *sector_start, uint32_t *sector_size)
+{
+    *sector_start = address & ~(FLASH_PAGE_BYTES - 1);
+    *sector_size  = FLASH_PAGE_BYTES;
+    return true;
+}
+
 #if defined(PIOS_INCLUDE_BL_HELPER_WRITE_SUPPORT)
 
 static bool erase_flash(uint32_t startAddress, uint32_t endAddress);
@@ -62,6 +71,13 @@ uint8_t PIOS_BL_HELPER_FLASH_Start()
     return (success) ? 1 : 0;
 }
 
+uint8_t PIOS_BL_HELPER_FLASH_Erase_Sector(uint32_t address)
+{
+    bool success = erase_flash(address & ~(FLASH_PAGE_BYTES - 1), address + 1);
+
+    return (success) ? 1 : 0;
+}
+
 uint8_t PIOS_BL_HELPER_FLASH_Erase_Bootloader()
 {
 /// Bootloader memory space erase
@@ -87,7 +103,7 @@ static bool erase_flash(uint32_t startAddress, uint32_t endAddress)
                 fail = true;
             }
         }
-        pageAddress += 1024;
+        pageAddress += FLASH_PAGE_BYTES;
     }
     return !fail;
 }
@@ -168,6 +168,28 @@ uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
     return diff / us_ticks;
 }
 
+/**
+ * @brief Compare two raw times and convert to us
+ * @param[in] raw the earlier raw time
+ * @param[in] later the later raw time
+ * @return A microsecond value
+ */
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later)
+{
+    uint32_t diff = later - raw;
+
+    return diff / us_ticks;
+}
+
+/**
+ * @brief Rate of the raw delay timer
+ * @return Raw ticks per second
+ */
+uint32_t PIOS_DELAY_GetRawHz()
+{
+    return us_ticks * 1000000;
+}
+
 #endif /* PIOS_INCLUDE_DELAY */
 
 /**
@@ -41,17 +41,6 @@ uint8_t *PIOS_BL_HELPER_FLASH_If_Read(uint32_t SectorAddress)
     return (uint8_t *)(SectorAddress);
 }
 
-#if defined(PIOS_INCLUDE_BL_HELPER_WRITE_SUPPORT)
-
-static bool erase_flash(uint32_t startAddress, uint32_t endAddress);
-
-uint8_t PIOS_BL_HELPER_FLASH_Ini()
-{
-    FLASH_Unlock();
-    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
-    return 1;
-}
-
 struct device_flash_sector {
     uint32_t start;
     uint32_t size;
@@ -138,6 +127,24 @@ static bool PIOS_BL_HELPER_FLASH_GetSectorInfo(uint32_t address, uint8_t *sector
     return false;
 }
 
+bool PIOS_BL_HELPER_FLASH_Sector_Info(uint32_t address, uint32_t *sector_start, uint32_t *sector_size)
+{
+    uint8_t sector_number;
+
+    return PIOS_BL_HELPER_FLASH_GetSectorInfo(address, &sector_number, sector_start, sector_size);
+}
+
+#if defined(PIOS_INCLUDE_BL_HELPER_WRITE_SUPPORT)
+
+static bool erase_flash(uint32_t startAddress, uint32_t endAddress);
+
+uint8_t PIOS_BL_HELPER_FLASH_Ini()
+{
+    FLASH_Unlock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    return 1;
+}
+
 uint8_t PIOS_BL_HELPER_FLASH_Start()
 {
     const struct pios_board_info *bdinfo = &pios_board_info_blob;
@@ -150,6 +157,13 @@ uint8_t PIOS_BL_HELPER_FLASH_Start()
 }
 
 
+uint8_t PIOS_BL_HELPER_FLASH_Erase_Sector(uint32_t address)
+{
+    bool success = erase_flash(address, address + 1);
+
+    return (success) ? 1 : 0;
+}
+
 uint8_t PIOS_BL_HELPER_FLASH_Erase_Bootloader()
 {
 /// Bootloader memory space erase
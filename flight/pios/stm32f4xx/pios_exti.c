@@ -30,6 +30,7 @@
  */
 
 #include "pios.h"
+#include <pios_tracebuffer.h>
 
 #ifdef PIOS_INCLUDE_EXTI
 
@@ -206,7 +207,9 @@ static bool PIOS_EXTI_generic_irq_handler(uint8_t line_index)
 #define PIOS_EXTI_HANDLE_LINE(line, woken)                      \
     if (EXTI_GetITStatus(EXTI_Line##line) != RESET) {       \
         EXTI_ClearITPendingBit(EXTI_Line##line);        \
+        PIOS_TRACEBUFFER_ISR_ENTER(line);               \
         woken = PIOS_EXTI_generic_irq_handler(line) ? pdTRUE : woken; \
+        PIOS_TRACEBUFFER_ISR_EXIT(line);                \
     }
 #else
 #define PIOS_EXTI_HANDLE_LINE(line, woken)                      \
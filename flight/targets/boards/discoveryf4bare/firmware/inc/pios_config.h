@@ -57,6 +57,7 @@
 #define PIOS_INCLUDE_TASK_MONITOR
 
 #define PIOS_INSTRUMENTATION_MAX_COUNTERS 10
+#define PIOS_TRACEBUFFER_MAX_EVENTS       1024
 #define PIOS_INCLUDE_INSTRUMENTATION
 
 /* PIOS hardware peripherals */
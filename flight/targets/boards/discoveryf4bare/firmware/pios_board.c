@@ -40,6 +40,9 @@
 #ifdef PIOS_INCLUDE_INSTRUMENTATION
 #include <pios_instrumentation.h>
 #endif
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+#include <pios_tracebuffer.h>
+#endif
 
 /*
  * Pull in the board-specific static HW definitions.
@@ -350,6 +353,9 @@ void PIOS_Board_Init(void)
 #ifdef PIOS_INCLUDE_INSTRUMENTATION
     PIOS_Instrumentation_Init(PIOS_INSTRUMENTATION_MAX_COUNTERS);
 #endif
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+    PIOS_TRACEBUFFER_Init(PIOS_TRACEBUFFER_MAX_EVENTS);
+#endif
 
 
 #if false
@@ -41,6 +41,9 @@
 #ifdef PIOS_INCLUDE_INSTRUMENTATION
 #include <pios_instrumentation.h>
 #endif
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+#include <pios_tracebuffer.h>
+#endif
 
 /*
  * Pull in the board-specific static HW definitions.
@@ -372,6 +375,9 @@ void PIOS_Board_Init(void)
 #ifdef PIOS_INCLUDE_INSTRUMENTATION
     PIOS_Instrumentation_Init(PIOS_INSTRUMENTATION_MAX_COUNTERS);
 #endif
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+    PIOS_TRACEBUFFER_Init(PIOS_TRACEBUFFER_MAX_EVENTS);
+#endif
 
     /* Set up the SPI interface to the gyro/acelerometer */
     if (PIOS_SPI_Init(&pios_spi_gyro_id, &pios_spi_gyro_cfg)) {
@@ -70,8 +70,11 @@ typedef enum {
     Download_Req, // 9
     Download, // 10
     Status_Request, // 11
-    Status_Rep
-// 12
+    Status_Rep, // 12
+    Req_SectorCRC, // 13
+    Rep_SectorCRC, // 14
+    Select_Sectors
+// 15
 } DFUCommands;
 
 typedef enum {
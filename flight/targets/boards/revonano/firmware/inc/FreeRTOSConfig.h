@@ -96,6 +96,23 @@
     while (0)
 #define portGET_RUN_TIME_COUNTER_VALUE() (*(unsigned long *)0xe0001004) /* DWT_CYCCNT */
 
+#if defined(PIOS_INCLUDE_TRACEBUFFER)
+/* Per task cpu accounting and context switch tracing in the PiOS task monitor.
+ * These run on every context switch, so only in builds with DIAG_TRACEBUFFER.
+ * Monitored tasks carry their task monitor id + 1 as application tag. */
+#define PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+#define configUSE_APPLICATION_TASK_TAG 1
+extern void PIOS_TASK_MONITOR_TaskReady(void *tag);
+extern void PIOS_TASK_MONITOR_TaskSwitchedOut(void *tag, int still_ready);
+extern void PIOS_TASK_MONITOR_TaskSwitchedIn(void *tag);
+/* no trailing semicolon where tasks.c expands this one */
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB) PIOS_TASK_MONITOR_TaskReady((pxTCB)->pxTaskTag);
+#define traceTASK_SWITCHED_OUT() \
+    PIOS_TASK_MONITOR_TaskSwitchedOut(pxCurrentTCB->pxTaskTag, \
+                                      listIS_CONTAINED_WITHIN(&pxReadyTasksLists[pxCurrentTCB->uxPriority], &pxCurrentTCB->xGenericListItem))
+#define traceTASK_SWITCHED_IN() PIOS_TASK_MONITOR_TaskSwitchedIn(pxCurrentTCB->pxTaskTag)
+#endif
+
 
 /**
  * @}
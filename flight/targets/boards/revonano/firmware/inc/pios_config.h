@@ -58,6 +58,7 @@
 
 #define PIOS_INCLUDE_INSTRUMENTATION
 #define PIOS_INSTRUMENTATION_MAX_COUNTERS 40
+#define PIOS_TRACEBUFFER_MAX_EVENTS       1024
 
 /* PIOS hardware peripherals */
 #define PIOS_INCLUDE_IRQ
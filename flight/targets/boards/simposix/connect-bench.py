@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+#
+# GCS connect time benchmark against a running simposix firmware.
+#
+# Requests the objects the GCS TelemetryMonitor retrieves on connect
+# (all metaobjects, settings and on-change data objects) over the UDP
+# telemetry port and reports how long retrieval takes, either one request
+# at a time or with the adaptive window of outstanding requests that
+# TelemetryMonitor uses. A link latency is emulated by holding back every
+# packet in both directions.
+#
+# The request and window rules mirror telemetrymonitor.cpp and telemetry.cpp
+# (250ms request timeout, 2 retries), keep them in sync when those change.
+#
+# (c) 2015, The LibrePilot Project, http://www.librepilot.org
+# See also: The GNU Public License (GPL) Version 3
+#
+
+import argparse
+import glob
+import heapq
+import os
+import re
+import select
+import socket
+import struct
+import time
+import xml.etree.ElementTree as ET
+
+SYNC = 0x3C
+TYPE_OBJ = 0x20
+TYPE_OBJ_REQ = 0x21
+TYPE_NACK = 0x24
+HEADER_LENGTH = 10
+
+REQ_TIMEOUT_S = 0.250
+MAX_RETRIES = 2
+
+MIN_WINDOW = 1
+INITIAL_WINDOW = 4
+MAX_WINDOW = 16
+RTT_SLACK_MS = 10
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def request_frame(objid):
+    header = struct.pack('<BBHIH', SYNC, TYPE_OBJ_REQ, HEADER_LENGTH, objid, 0)
+    return header + bytes([crc8(header)])
+
+
+def retrieved_objects(definitions, synthetics):
+    """Object ids in the order TelemetryMonitor queues them"""
+    objids = {}
+    for header in glob.glob(os.path.join(synthetics, '*.h')):
+        with open(header) as f:
+            for name, objid in re.findall(r'#define (\w+)_OBJID (0x[0-9A-Fa-f]+)', f.read()):
+                objids[name] = int(objid, 16)
+
+    queue = []
+    for xml in sorted(glob.glob(os.path.join(definitions, '*.xml'))):
+        obj = ET.parse(xml).getroot().find('object')
+        objid = objids.get(obj.get('name').upper())
+        if objid is None:
+            continue
+        # metaobject
+        queue.append(objid + 1)
+        flight = obj.find('telemetryflight')
+        if obj.get('settings') == 'true' or (flight is not None and flight.get('updatemode') == 'onchange'):
+            queue.append(objid)
+    return queue
+
+
+class Link:
+    """UDP link to the firmware with a fixed one way delay"""
+
+    def __init__(self, address, delay):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.setblocking(False)
+        self.address = address
+        self.delay = delay
+        self.outgoing = []
+        self.incoming = []
+        self.seq = 0
+        self.rx = b''
+
+    def send(self, data):
+        self.seq += 1
+        heapq.heappush(self.outgoing, (time.monotonic() + self.delay, self.seq, data))
+
+    def poll(self, timeout):
+        """Move packets along, return the frames that arrived"""
+        now = time.monotonic()
+        while self.outgoing and self.outgoing[0][0] <= now:
+            self.sock.sendto(heapq.heappop(self.outgoing)[2], self.address)
+        due = [q[0][0] for q in (self.outgoing, self.incoming) if q]
+        wait = max(0, min([now + timeout] + due) - now)
+        if select.select([self.sock], [], [], wait)[0]:
+            data = self.sock.recv(65536)
+            self.seq += 1
+            heapq.heappush(self.incoming, (time.monotonic() + self.delay, self.seq, data))
+        frames = []
+        now = time.monotonic()
+        while self.incoming and self.incoming[0][0] <= now:
+            self.rx += heapq.heappop(self.incoming)[2]
+            frames += self.parse()
+        return frames
+
+    def parse(self):
+        frames = []
+        while True:
+            start = self.rx.find(bytes([SYNC]))
+            if start < 0:
+                self.rx = b''
+                return frames
+            self.rx = self.rx[start:]
+            if len(self.rx) < 8:
+                return frames
+            kind, length, objid = struct.unpack_from('<BHI', self.rx, 1)
+            if length < 8 or length > 512:
+                self.rx = self.rx[1:]
+                continue
+            if len(self.rx) < length + 1:
+                return frames
+            if crc8(self.rx[:length]) == self.rx[length]:
+                frames.append((kind & 0x7F, objid))
+                self.rx = self.rx[length + 1:]
+            else:
+                self.rx = self.rx[1:]
+
+
+def retrieve(link, queue, adaptive):
+    queue = list(queue)
+    pending = {}  # objid -> (first sent, last sent, retries left)
+    retried = set()
+    window = float(INITIAL_WINDOW if adaptive else 1)
+    min_rtt = None
+    retrieved = failed = 0
+    start = time.monotonic()
+
+    def complete(objid, success):
+        nonlocal window, min_rtt, retrieved, failed
+        first, _, _ = pending.pop(objid)
+        if not adaptive:
+            retrieved += success
+            failed += not success
+            return
+        rtt = (time.monotonic() - first) * 1000
+        if not success:
+            # nacked objects do not exist on the board, only losses shrink the window
+            if rtt >= REQ_TIMEOUT_S * 1000:
+                window = max(MIN_WINDOW, window / 2)
+            if objid not in retried:
+                retried.add(objid)
+                queue.append(objid)
+            else:
+                failed += 1
+            return
+        retrieved += 1
+        min_rtt = rtt if min_rtt is None else min(min_rtt, rtt)
+        if rtt <= 2 * min_rtt + RTT_SLACK_MS:
+            window = min(MAX_WINDOW, window + 1.0 / window)
+        else:
+            window = max(MIN_WINDOW, window - 1.0 / window)
+
+    while queue or pending:
+        while queue and len(pending) < int(window):
+            objid = queue.pop(0)
+            now = time.monotonic()
+            pending[objid] = (now, now, MAX_RETRIES)
+            link.send(request_frame(objid))
+        for kind, objid in link.poll(0.005):
+            if objid in pending and kind in (TYPE_OBJ, TYPE_NACK):
+                complete(objid, kind == TYPE_OBJ)
+        now = time.monotonic()
+        for objid, (first, sent, retries) in list(pending.items()):
+            if now - sent >= REQ_TIMEOUT_S:
+                if retries:
+                    pending[objid] = (first, now, retries - 1)
+                    link.send(request_frame(objid))
+                else:
+                    complete(objid, False)
+    return time.monotonic() - start, retrieved, failed, window
+
+
+def main():
+    root = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..', '..', '..'))
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=9000)
+    parser.add_argument('--delays', default='0,25,50,100', help='one way link delays in ms')
+    parser.add_argument('--runs', type=int, default=3)
+    parser.add_argument('--definitions', default=os.path.join(root, 'shared', 'uavobjectdefinition'))
+    parser.add_argument('--synthetics', default=os.path.join(root, 'build', 'uavobject-synthetics', 'flight'))
+    args = parser.parse_args()
+
+    queue = retrieved_objects(args.definitions, args.synthetics)
+    print('%d objects to retrieve' % len(queue))
+    print('%8s %10s %10s %10s %8s %8s' % ('delay', 'mode', 'time [ms]', 'retrieved', 'failed', 'window'))
+    for delay in [int(d) for d in args.delays.split(',')]:
+        for adaptive in (False, True):
+            times = []
+            for _ in range(args.runs):
+                link = Link((args.host, args.port), delay / 1000.0)
+                elapsed, retrieved, failed, window = retrieve(link, queue, adaptive)
+                times.append(elapsed)
+            times.sort()
+            print('%8d %10s %10.0f %10d %8d %8.1f' % (delay, 'window' if adaptive else 'serial',
+                                                      1000 * times[len(times) // 2], retrieved, failed, window))
+
+
+if __name__ == '__main__':
+    main()
@@ -85,6 +85,7 @@
 #define INCLUDE_vTaskDelay                           1
 #define INCLUDE_xTaskGetSchedulerState               1
 #define INCLUDE_xTaskGetCurrentTaskHandle            1
+#define INCLUDE_xTaskGetIdleTaskHandle               1
 #define INCLUDE_uxTaskGetStackHighWaterMark          0
 
 
@@ -100,4 +101,21 @@
    NVIC value of 255. */
 #define configLIBRARY_KERNEL_INTERRUPT_PRIORITY      15
 
+#if defined(PIOS_INCLUDE_TRACEBUFFER)
+/* Per task cpu accounting and context switch tracing in the PiOS task monitor.
+ * These run on every context switch, so only in builds with DIAG_TRACEBUFFER.
+ * Monitored tasks carry their task monitor id + 1 as application tag. */
+#define PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+#define configUSE_APPLICATION_TASK_TAG 1
+extern void PIOS_TASK_MONITOR_TaskReady(void *tag);
+extern void PIOS_TASK_MONITOR_TaskSwitchedOut(void *tag, int still_ready);
+extern void PIOS_TASK_MONITOR_TaskSwitchedIn(void *tag);
+/* no trailing semicolon where tasks.c expands this one */
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB) PIOS_TASK_MONITOR_TaskReady((pxTCB)->pxTaskTag);
+#define traceTASK_SWITCHED_OUT() \
+    PIOS_TASK_MONITOR_TaskSwitchedOut(pxCurrentTCB->pxTaskTag, \
+                                      listIS_CONTAINED_WITHIN(&pxReadyTasksLists[pxCurrentTCB->uxPriority], &pxCurrentTCB->xGenericListItem))
+#define traceTASK_SWITCHED_IN() PIOS_TASK_MONITOR_TaskSwitchedIn(pxCurrentTCB->pxTaskTag)
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
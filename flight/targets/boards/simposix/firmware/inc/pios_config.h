@@ -52,6 +52,7 @@
 #define PIOS_INCLUDE_SPI
 #define PIOS_INCLUDE_SYS
 #define PIOS_INCLUDE_TASK_MONITOR
+#define PIOS_TRACEBUFFER_MAX_EVENTS 8192
 #define PIOS_INCLUDE_USART
 // #define PIOS_INCLUDE_USB
 #define PIOS_INCLUDE_USB_HID
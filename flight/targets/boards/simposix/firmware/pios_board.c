@@ -33,6 +33,9 @@
 #include <hwsettings.h>
 #include <manualcontrolsettings.h>
 #include <taskinfo.h>
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+#include <pios_tracebuffer.h>
+#endif
 
 
 /*
@@ -135,6 +138,10 @@ void PIOS_Board_Init(void)
         PIOS_Assert(0);
     }
 
+#ifdef PIOS_INCLUDE_TRACEBUFFER
+    PIOS_TRACEBUFFER_Init(PIOS_TRACEBUFFER_MAX_EVENTS);
+#endif
+
     /* Initialize the delayed callback library */
     PIOS_CALLBACKSCHEDULER_Initialize();
 
@@ -80,16 +80,22 @@ extern void InitModules(void);
 /**
  * OpenPilot Main function:
  *
+ * Parse the simulator options (PIOS_SIM_Init)<BR>
  * Initialize PiOS<BR>
  * Create the "System" task (SystemModInitializein Modules/System/systemmod.c) <BR>
  * Start FreeRTOS Scheduler (vTaskStartScheduler)<BR>
  * If something goes wrong, blink LED1 and LED2 every 100ms
  *
  */
-int main()
+int main(int argc, char *argv[])
 {
     int result;
 
+    /* Simulator options, e.g. a virtual clock, must be known before anything runs */
+    if (PIOS_SIM_Init(argc, argv) < 0) {
+        return 1;
+    }
+
     /* NOTE: Do NOT modify the following start-up sequence */
     /* Any new initialization functions should be added in OpenPilotInit() */
 
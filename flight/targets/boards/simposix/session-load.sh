@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# Per vehicle CPU and memory load of the GCS telemetry sessions.
+#
+# Starts <vehicles> simposix instances next to each other, 10 UDP ports
+# apart, and runs the sessionload tool of the GCS against them. It opens
+# one session per vehicle, one at a time, and prints the CPU and resident
+# memory of the process after each one, then the cost of one vehicle.
+#
+# usage: session-load.sh <sessionload> [vehicles] [seconds per step]
+#
+# (c) 2015, The LibrePilot Project, http://www.librepilot.org
+# See also: The GNU Public License (GPL) Version 3
+#
+
+ROOT=$(cd "$(dirname "$0")/../../../.." && pwd)
+FIRMWARE=${FIRMWARE:-$ROOT/build/fw_simposix/fw_simposix.elf}
+SESSIONLOAD=$1
+VEHICLES=${2:-4}
+SECONDS_PER_STEP=${3:-10}
+
+if [ -z "$SESSIONLOAD" ] || [ ! -x "$SESSIONLOAD" ] || [ ! -x "$FIRMWARE" ]; then
+    echo "usage: $0 <sessionload> [vehicles] [seconds per step]" >&2
+    echo "       FIRMWARE=$FIRMWARE" >&2
+    exit 1
+fi
+
+PIDS=
+trap 'kill $PIDS 2>/dev/null' EXIT INT TERM
+
+i=0
+while [ $i -lt "$VEHICLES" ]; do
+    "$FIRMWARE" --port-offset=$((i * 10)) > /dev/null 2>&1 &
+    PIDS="$PIDS $!"
+    i=$((i + 1))
+done
+# let the firmware start its tasks before connecting
+sleep 2
+
+"$SESSIONLOAD" -vehicles "$VEHICLES" -port 9000 -port-step 10 -seconds "$SECONDS_PER_STEP"
@@ -0,0 +1,35 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef void *xTaskHandle;
+typedef void *xSemaphoreHandle;
+typedef unsigned long UBaseType_t;
+
+#define pdTRUE                   1
+#define pdFALSE                  0
+#define portMAX_DELAY            0xffffffff
+#define portTICK_RATE_MS         1
+#define tskIDLE_PRIORITY         0
+
+extern uint32_t ut_tick;
+extern int ut_critical;
+#define xTaskGetTickCount()                       ut_tick
+int32_t xTaskCreate(void (*code)(void *), const char *name, uint16_t stack, void *param, UBaseType_t prio, xTaskHandle *handle);
+
+#define xSemaphoreCreateRecursiveMutex()          ((xSemaphoreHandle)1)
+#define xSemaphoreTakeRecursive(m, t)             ((void)(m), (void)(t))
+#define xSemaphoreGiveRecursive(m)                ((void)(m))
+#define vSemaphoreCreateBinary(s)                 ((s) = (xSemaphoreHandle)1)
+int32_t xSemaphoreGive(xSemaphoreHandle semaphore);
+int32_t xSemaphoreGiveFromISR(xSemaphoreHandle semaphore, long *woken);
+int32_t xSemaphoreTake(xSemaphoreHandle semaphore, uint32_t ticksToWait);
+
+#define portENTER_CRITICAL()                      (ut_critical++)
+#define portEXIT_CRITICAL()                       (ut_critical--)
+#define portSET_INTERRUPT_MASK_FROM_ISR()         (ut_critical++)
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)      ((void)(x), ut_critical--)
+
+#endif /* FREERTOS_H */
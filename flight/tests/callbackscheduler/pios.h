@@ -0,0 +1,26 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+#ifdef PIOS_INCLUDE_FREERTOS
+/* FreeRTOS Includes */
+#include "FreeRTOS.h"
+#endif
+#include "pios_mem.h"
+
+#define PIOS_Assert(x) \
+    if (!(x)) { abort(); \
+    }
+
+#include <pios_delay.h>
+#include <pios_callbackscheduler.h>
+
+void PIOS_TASK_MONITOR_RegisterTask(int task_id, xTaskHandle handle);
+
+#endif /* PIOS_H */
@@ -1,13 +1,13 @@
 /**
  ******************************************************************************
  *
- * @file       trailitem.cpp
- * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @brief      A graphicsItem representing a trail point
- * @see        The GNU Public License (GPL) Version 3
- * @defgroup   OPMapWidget
+ * @file       pios_mem.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup PiOS
  * @{
- *
+ * @addtogroup PiOS
+ * @{
+ * @brief PiOS memory allocation API
  *****************************************************************************/
 /*
  * This program is free software; you can redistribute it and/or modify
@@ -24,25 +24,11 @@
  * with this program; if not, write to the Free Software Foundation, Inc.,
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
-#include "traillineitem.h"
-
-namespace mapcontrol {
-TrailLineItem::TrailLineItem(internals::PointLatLng const & coord1, internals::PointLatLng const & coord2, QBrush color, MapGraphicItem *map) : QGraphicsLineItem(map), coord1(coord1), coord2(coord2), m_brush(color), m_map(map)
-{
-    QPen pen;
-
-    pen.setBrush(m_brush);
-    pen.setWidth(1);
-    this->setPen(pen);
-}
+#ifndef PIOS_MEM_H
+#define PIOS_MEM_H
 
-int TrailLineItem::type() const
-{
-    return Type;
-}
+#define pios_fastheapmalloc(size) (malloc(size))
+#define pios_malloc(size)         (malloc(size))
+#define pios_free(p)              (free(p))
 
-void TrailLineItem::setLineSlot()
-{
-    setLine(m_map->FromLatLngToLocal(this->coord1).X(), m_map->FromLatLngToLocal(this->coord1).Y(), m_map->FromLatLngToLocal(this->coord2).X(), m_map->FromLatLngToLocal(this->coord2).Y());
-}
-}
+#endif /* PIOS_MEM_H */
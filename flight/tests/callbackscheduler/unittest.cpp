@@ -0,0 +1,215 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+
+extern "C" {
+#include "pios.h"
+
+uint32_t ut_tick     = 1000;
+int ut_critical      = 0;
+static uint32_t ut_us = 0;
+
+uint32_t PIOS_DELAY_GetRaw()
+{
+    return ut_us;
+}
+
+uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
+{
+    return ut_us - raw;
+}
+
+void PIOS_TASK_MONITOR_RegisterTask(__attribute__((unused)) int task_id, __attribute__((unused)) xTaskHandle handle) {}
+
+// the scheduler tasks are never started, the test runs their loop body itself
+int32_t xTaskCreate(__attribute__((unused)) void (*code)(void *), __attribute__((unused)) const char *name, __attribute__((unused)) uint16_t stack,
+                    __attribute__((unused)) void *param, __attribute__((unused)) UBaseType_t prio, __attribute__((unused)) xTaskHandle *handle)
+{
+    return pdTRUE;
+}
+
+int32_t xSemaphoreGive(__attribute__((unused)) xSemaphoreHandle semaphore)
+{
+    return pdTRUE;
+}
+
+int32_t xSemaphoreGiveFromISR(__attribute__((unused)) xSemaphoreHandle semaphore, __attribute__((unused)) long *woken)
+{
+    return pdTRUE;
+}
+
+int32_t xSemaphoreTake(__attribute__((unused)) xSemaphoreHandle semaphore, __attribute__((unused)) uint32_t ticksToWait)
+{
+    return pdTRUE;
+}
+
+int32_t ut_run_next_callback(DelayedCallbackPriorityTask priorityTask);
+}
+
+#define NUM_CALLBACKS 4
+#define STACK_SIZE    256
+
+static char order[16];
+static int orderLength;
+
+static void record(char name)
+{
+    if (orderLength < (int)sizeof(order) - 1) {
+        order[orderLength++] = name;
+        order[orderLength]   = 0;
+    }
+    // each callback runs 10us
+    ut_us += 10;
+}
+
+static void callbackA()
+{
+    record('A');
+}
+static void callbackB()
+{
+    record('B');
+}
+static void callbackC()
+{
+    record('C');
+}
+static void callbackD()
+{
+    record('D');
+}
+
+static void missCounter(__attribute__((unused)) int16_t task_id, const struct pios_callback_info *callback_info, void *context)
+{
+    *(uint32_t *)context += callback_info->deadline_misses;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class CallbackSchedulerTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        // the scheduler keeps its callbacks for good, start over with a new task each time
+        static int taskPriority = CALLBACK_TASK_AUXILIARY;
+
+        priorityTask = (DelayedCallbackPriorityTask)taskPriority++;
+        order[0]     = 0;
+        orderLength  = 0;
+        ut_critical  = 0;
+    }
+
+    virtual void TearDown()
+    {
+        // every critical section is left again
+        EXPECT_EQ(0, ut_critical);
+    }
+
+    DelayedCallbackInfo *create(DelayedCallback cb, uint32_t deadlineUs)
+    {
+        DelayedCallbackInfo *info = PIOS_CALLBACKSCHEDULER_CreateWithDeadline(cb, CALLBACK_PRIORITY_REGULAR, priorityTask, -1, STACK_SIZE, deadlineUs);
+
+        EXPECT_TRUE(info != NULL);
+        return info;
+    }
+
+    void runAll()
+    {
+        while (!ut_run_next_callback(priorityTask)) {
+            ;
+        }
+    }
+
+    DelayedCallbackPriorityTask priorityTask;
+};
+
+static bool initialized = (PIOS_CALLBACKSCHEDULER_Initialize() == 0);
+
+TEST_F(CallbackSchedulerTest, RoundRobinWithoutDeadlines) {
+    ASSERT_TRUE(initialized);
+    DelayedCallbackInfo *a = create(callbackA, 0);
+    DelayedCallbackInfo *b = create(callbackB, 0);
+    DelayedCallbackInfo *c = create(callbackC, 0);
+
+    PIOS_CALLBACKSCHEDULER_Dispatch(c);
+    PIOS_CALLBACKSCHEDULER_Dispatch(a);
+    PIOS_CALLBACKSCHEDULER_Dispatch(b);
+    runAll();
+    EXPECT_STREQ("ABC", order);
+}
+
+TEST_F(CallbackSchedulerTest, EarliestDeadlineFirst) {
+    DelayedCallbackInfo *a = create(callbackA, 0);
+    DelayedCallbackInfo *b = create(callbackB, 5000);
+    DelayedCallbackInfo *c = create(callbackC, 1000);
+    DelayedCallbackInfo *d = create(callbackD, 3000);
+
+    // C is dispatched last, but has the earliest absolute deadline
+    PIOS_CALLBACKSCHEDULER_Dispatch(a);
+    PIOS_CALLBACKSCHEDULER_Dispatch(b);
+    ut_us += 500;
+    PIOS_CALLBACKSCHEDULER_Dispatch(d);
+    ut_us += 500;
+    PIOS_CALLBACKSCHEDULER_Dispatch(c);
+    runAll();
+    EXPECT_STREQ("CDBA", order);
+}
+
+TEST_F(CallbackSchedulerTest, DispatchTimeDecidesDeadline) {
+    DelayedCallbackInfo *b = create(callbackB, 1000);
+    DelayedCallbackInfo *c = create(callbackC, 2000);
+
+    // B has the shorter relative deadline but has been dispatched much later
+    PIOS_CALLBACKSCHEDULER_Dispatch(c);
+    ut_us += 1500;
+    PIOS_CALLBACKSCHEDULER_Dispatch(b);
+    runAll();
+    EXPECT_STREQ("CB", order);
+
+    // a second dispatch of a waiting callback keeps the first dispatch time
+    order[0]    = 0;
+    orderLength = 0;
+    PIOS_CALLBACKSCHEDULER_Dispatch(b);
+    ut_us += 1500;
+    PIOS_CALLBACKSCHEDULER_Dispatch(c);
+    PIOS_CALLBACKSCHEDULER_Dispatch(b);
+    runAll();
+    EXPECT_STREQ("BC", order);
+}
+
+TEST_F(CallbackSchedulerTest, ExpiredScheduleCompetesOnDeadline) {
+    DelayedCallbackInfo *a = create(callbackA, 0);
+    DelayedCallbackInfo *b = create(callbackB, 0);
+    DelayedCallbackInfo *d = create(callbackD, 1000);
+
+    // D is only scheduled, and is not reached by the round robin before A and B
+    EXPECT_EQ(1, PIOS_CALLBACKSCHEDULER_Schedule(d, 5, CALLBACK_UPDATEMODE_OVERRIDE));
+    PIOS_CALLBACKSCHEDULER_Dispatch(a);
+    PIOS_CALLBACKSCHEDULER_Dispatch(b);
+    EXPECT_FALSE(ut_run_next_callback(priorityTask));
+    EXPECT_STREQ("A", order);
+
+    ut_tick += 5;
+    runAll();
+    EXPECT_STREQ("ADB", order);
+}
+
+TEST_F(CallbackSchedulerTest, CountsDeadlineMisses) {
+    DelayedCallbackInfo *b = create(callbackB, 100);
+    DelayedCallbackInfo *c = create(callbackC, 100);
+    uint32_t before = 0;
+    uint32_t after  = 0;
+
+    // callbacks of the earlier tests are listed as well
+    PIOS_CALLBACKSCHEDULER_ForEachCallback(missCounter, &before);
+
+    PIOS_CALLBACKSCHEDULER_Dispatch(b);
+    PIOS_CALLBACKSCHEDULER_Dispatch(c);
+    ut_us += 95;
+    runAll();
+
+    // B starts after 95us, C after 105us
+    PIOS_CALLBACKSCHEDULER_ForEachCallback(missCounter, &after);
+    EXPECT_EQ(1u, after - before);
+}
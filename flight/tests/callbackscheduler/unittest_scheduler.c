@@ -0,0 +1,22 @@
+/*
+ * The scheduler is built here as C, the test needs to step
+ * its private round robin directly instead of running its tasks.
+ */
+
+#include "pios_callbackscheduler.c"
+
+/**
+ * Run at most one due callback of the given scheduler task
+ * \return wait time until the next schedule, 0 if a callback was run
+ */
+int32_t ut_run_next_callback(DelayedCallbackPriorityTask priorityTask)
+{
+    struct DelayedCallbackTaskStruct *task;
+
+    LL_FOREACH(schedulerTasks, task) {
+        if (task->priorityTask == priorityTask) {
+            return runNextCallback(task, CALLBACK_PRIORITY_CRITICAL);
+        }
+    }
+    return MAX_SLEEP;
+}
@@ -0,0 +1,341 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort, getenv */
+#include <string.h> /* memset */
+#include <math.h> /* sin */
+
+extern "C" {
+#include "openpilot.h"
+#include "decimator.h"
+}
+
+/* an MPU6000 without DLPF at 8kHz read by the sensor task at 500Hz */
+#define INPUT_RATE         8000
+#define TASK_RATE          500
+#define SAMPLES_PER_PERIOD (INPUT_RATE / TASK_RATE)
+#define STREAM_SECONDS     10
+#define STREAM_LEN         (INPUT_RATE * STREAM_SECONDS)
+#define LSB_DPS            (2000.0 / 32768.0)
+/* delays searched when matching the output against the zero phase reference */
+#define MAX_DELAY_SAMPLES  48
+
+static int16_t stream[STREAM_LEN];
+static double reference[STREAM_LEN];
+static int stream_len;
+
+/*
+ * Synthetic gyro axis: slow manoeuvres, an in band motor line, a blade pass
+ * harmonic above the task Nyquist and a frame resonance close to 4x the task
+ * rate that aliases down to 30Hz, plus sensor noise.
+ */
+static void syntheticStream()
+{
+    srand(1);
+    for (int i = 0; i < STREAM_LEN; i++) {
+        double t = (double)i / INPUT_RATE;
+        double dps = 100.0 * sin(2 * M_PI * 3.0 * t) + 60.0 * sin(2 * M_PI * 11.0 * t + 1.0)
+                     + 20.0 * sin(2 * M_PI * 180.0 * t)
+                     + 40.0 * sin(2 * M_PI * 760.0 * t)
+                     + 40.0 * sin(2 * M_PI * 2030.0 * t)
+                     + 1.0 * ((double)rand() / RAND_MAX - 0.5) * 3.46;
+        stream[i] = (int16_t)lrint(dps / LSB_DPS);
+    }
+    stream_len = STREAM_LEN;
+}
+
+/*
+ * A recorded stream can be replayed with DECIMATOR_STREAM=<file>, raw 16 bit
+ * little endian samples of one gyro axis at INPUT_RATE.
+ */
+static bool recordedStream()
+{
+    const char *path = getenv("DECIMATOR_STREAM");
+
+    if (!path) {
+        return false;
+    }
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    stream_len = fread(stream, sizeof(int16_t), STREAM_LEN, f);
+    fclose(f);
+    printf("decimator: replaying %d samples from %s\n", stream_len, path);
+    return stream_len > INPUT_RATE;
+}
+
+/* forward and backward second order low pass, the zero phase "true" motion */
+static void zeroPhaseReference(double cutoff)
+{
+    const double ita = 1.0 / tan(M_PI * cutoff / INPUT_RATE);
+    const double b0  = 1.0 / (1.0 + M_SQRT2 * ita + ita * ita);
+    const double a1  = 2.0 * b0 * (ita * ita - 1.0);
+    const double a2  = -b0 * (1.0 - M_SQRT2 * ita + ita * ita);
+    double w1, w2;
+
+    w1 = w2 = stream[0] / (1.0 - a1 - a2);
+    for (int i = 0; i < stream_len; i++) {
+        double w = stream[i] + a1 * w1 + a2 * w2;
+        reference[i] = b0 * (w + 2.0 * w1 + w2);
+        w2 = w1;
+        w1 = w;
+    }
+    w1 = w2 = reference[stream_len - 1] / (1.0 - a1 - a2);
+    for (int i = stream_len - 1; i >= 0; i--) {
+        double w = reference[i] + a1 * w1 + a2 * w2;
+        reference[i] = b0 * (w + 2.0 * w1 + w2);
+        w2 = w1;
+        w1 = w;
+    }
+}
+
+struct Result {
+    double delay_ms;
+    double noise_dps;
+};
+
+/*
+ * Run the stream through the sensor task: every period pushes its samples
+ * and publishes either the plain average (d == NULL) or the newest decimator
+ * output. The delay is the shift of the reference that best matches the
+ * published values, the noise the rms difference at that shift.
+ */
+static Result runStream(struct Decimator *d)
+{
+    static double published[STREAM_LEN / SAMPLES_PER_PERIOD];
+    const int periods = stream_len / SAMPLES_PER_PERIOD;
+    // skip the settling of the filters
+    const int first   = TASK_RATE / 10;
+
+    for (int p = 0; p < periods; p++) {
+        int32_t sum = 0;
+        for (int i = 0; i < SAMPLES_PER_PERIOD; i++) {
+            Vector3i16 sample = { stream[p * SAMPLES_PER_PERIOD + i], 0, 0 };
+            sum += sample.x;
+            if (d) {
+                DecimatorPush(d, &sample);
+            }
+        }
+        Vector3f out;
+        if (d && DecimatorGet(d, &out)) {
+            published[p] = out.x;
+        } else {
+            published[p] = (double)sum / SAMPLES_PER_PERIOD;
+        }
+    }
+
+    Result best = { 0.0, 1e9 };
+    // quarter input sample steps with linear interpolation of the reference
+    for (int shift = 0; shift < 4 * MAX_DELAY_SAMPLES; shift++) {
+        double sq = 0.0;
+        for (int p = first; p < periods; p++) {
+            double pos  = p * SAMPLES_PER_PERIOD + SAMPLES_PER_PERIOD - 1 - shift * 0.25;
+            int i       = (int)floor(pos);
+            double frac = pos - i;
+            double ref  = reference[i] * (1.0 - frac) + reference[i + 1] * frac;
+            sq += (published[p] - ref) * (published[p] - ref);
+        }
+        double rms = sqrt(sq / (periods - first)) * LSB_DPS;
+        if (rms < best.noise_dps) {
+            best.noise_dps = rms;
+            best.delay_ms  = shift * 0.25 * 1000.0 / INPUT_RATE;
+        }
+    }
+    return best;
+}
+
+/* as configureGyroDecimator() in sensors.c sets it up */
+static void configure(struct Decimator *d, uint8_t order, uint8_t ratio, float lowpass, float notch, float q)
+{
+    const float rate = (float)INPUT_RATE / ratio;
+    struct BiquadDF2Filter biquad;
+
+    ASSERT_TRUE(DecimatorInit(d, order, ratio));
+    if (lowpass > 0.0f) {
+        InitBiquadDF2Lowpass(lowpass / rate, &biquad);
+        ASSERT_TRUE(DecimatorAddBiquad(d, &biquad));
+    }
+    if (notch > 0.0f) {
+        InitBiquadDF2Notch(notch / rate, q, &biquad);
+        ASSERT_TRUE(DecimatorAddBiquad(d, &biquad));
+    }
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class DecimatorTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        srand(1);
+    }
+};
+
+TEST_F(DecimatorTest, RejectsBadConfig) {
+    struct Decimator d;
+    struct BiquadDF2Filter biquad;
+
+    EXPECT_FALSE(DecimatorInit(&d, 0, 4));
+    EXPECT_FALSE(DecimatorInit(&d, DECIMATOR_MAX_ORDER + 1, 4));
+    EXPECT_FALSE(DecimatorInit(&d, 2, 0));
+    // 41^3 exceeds the exact integer range
+    EXPECT_FALSE(DecimatorInit(&d, 3, 41));
+    EXPECT_TRUE(DecimatorInit(&d, 3, 40));
+
+    InitBiquadDF2Lowpass(0.1f, &biquad);
+    for (int i = 0; i < DECIMATOR_MAX_BIQUADS; i++) {
+        EXPECT_TRUE(DecimatorAddBiquad(&d, &biquad));
+    }
+    EXPECT_FALSE(DecimatorAddBiquad(&d, &biquad));
+}
+
+TEST_F(DecimatorTest, CICMatchesDirectSum) {
+    for (uint8_t order = 1; order <= DECIMATOR_MAX_ORDER; order++) {
+        for (uint8_t ratio = 1; ratio <= 16; ratio++) {
+            struct Decimator d;
+            static int16_t in[2000];
+            // impulse response of the CIC, the boxcar convolved order times
+            int64_t h[DECIMATOR_MAX_ORDER * 16] = { 0 };
+            int len = 1;
+
+            h[0] = 1;
+            for (int o = 0; o < order; o++) {
+                int64_t next[DECIMATOR_MAX_ORDER * 16] = { 0 };
+                for (int i = 0; i < len; i++) {
+                    for (int j = 0; j < ratio; j++) {
+                        next[i + j] += h[i];
+                    }
+                }
+                len += ratio - 1;
+                memcpy(h, next, sizeof(h));
+            }
+
+            ASSERT_TRUE(DecimatorInit(&d, order, ratio));
+            for (int n = 0; n < 2000; n++) {
+                // full scale extremes exercise the wrapping integrators
+                in[n] = (rand() & 1) ? 32767 : -32768;
+                if (rand() & 1) {
+                    in[n] = rand() % 65536 - 32768;
+                }
+                Vector3i16 sample = { in[n], (int16_t)(in[n] >> 3), 0 };
+                if (DecimatorPush(&d, &sample)) {
+                    int64_t sum = 0, sum_y = 0;
+                    for (int i = 0; i < len && n - i >= 0; i++) {
+                        sum   += h[i] * in[n - i];
+                        sum_y += h[i] * (in[n - i] >> 3);
+                    }
+                    Vector3f out;
+                    ASSERT_TRUE(DecimatorGet(&d, &out));
+                    ASSERT_EQ((float)sum * d.gain, out.x) << "order " << (int)order << " ratio " << (int)ratio << " n " << n;
+                    ASSERT_EQ((float)sum_y * d.gain, out.y);
+                    ASSERT_EQ(0.0f, out.z);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(DecimatorTest, OrderOneIsTheAverage) {
+    struct Decimator d;
+
+    ASSERT_TRUE(DecimatorInit(&d, 1, SAMPLES_PER_PERIOD));
+    for (int p = 0; p < 100; p++) {
+        int32_t sum = 0;
+        bool done   = false;
+        for (int i = 0; i < SAMPLES_PER_PERIOD; i++) {
+            Vector3i16 sample = { (int16_t)(rand() % 65536 - 32768), 0, 0 };
+            sum += sample.x;
+            done = DecimatorPush(&d, &sample);
+        }
+        Vector3f out;
+        ASSERT_TRUE(done);
+        ASSERT_TRUE(DecimatorGet(&d, &out));
+        ASSERT_FLOAT_EQ((float)sum / SAMPLES_PER_PERIOD, out.x);
+    }
+}
+
+TEST_F(DecimatorTest, ConstantInputSettles) {
+    struct Decimator d;
+    Vector3i16 sample = { 1000, -2000, 3000 };
+    Vector3f out;
+
+    configure(&d, 3, 4, 150.0f, 400.0f, 3.0f);
+    EXPECT_FALSE(DecimatorGet(&d, &out));
+    // not before every comb has a full window
+    for (int i = 0; i < 3 * 4 - 1; i++) {
+        DecimatorPush(&d, &sample);
+        EXPECT_FALSE(DecimatorGet(&d, &out));
+    }
+    EXPECT_TRUE(DecimatorPush(&d, &sample));
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(DecimatorGet(&d, &out));
+        ASSERT_NEAR(1000.0f, out.x, 0.05f);
+        ASSERT_NEAR(-2000.0f, out.y, 0.05f);
+        ASSERT_NEAR(3000.0f, out.z, 0.05f);
+        DecimatorPush(&d, &sample);
+    }
+
+    DecimatorReset(&d);
+    EXPECT_FALSE(DecimatorGet(&d, &out));
+}
+
+TEST_F(DecimatorTest, NotchRejectsTone) {
+    const float notch = 300.0f;
+    double in_band = 0.0, at_notch = 0.0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        struct Decimator d;
+        const double f = pass ? notch : 50.0;
+        double peak    = 0.0;
+
+        configure(&d, 2, 4, 0.0f, notch, 3.0f);
+        for (int i = 0; i < INPUT_RATE; i++) {
+            Vector3i16 sample = { (int16_t)lrint(10000.0 * sin(2 * M_PI * f * i / INPUT_RATE)), 0, 0 };
+            Vector3f out;
+            // after 0.5s the notch has settled
+            if (DecimatorPush(&d, &sample) && i > INPUT_RATE / 2 && DecimatorGet(&d, &out)) {
+                peak = fmax(peak, fabs(out.x));
+            }
+        }
+        (pass ? at_notch : in_band) = peak;
+    }
+    printf("decimator: 300Hz notch, 50Hz gain %.3f, 300Hz gain %.4f\n", in_band / 10000.0, at_notch / 10000.0);
+    EXPECT_GT(in_band, 9000.0);
+    EXPECT_LT(at_notch, 100.0);
+}
+
+TEST_F(DecimatorTest, StreamReport) {
+    if (!recordedStream()) {
+        syntheticStream();
+    }
+    zeroPhaseReference(30.0);
+
+    struct {
+        const char *name;
+        uint8_t    order;
+        uint8_t    ratio;
+        float      lowpass;
+        float      notch;
+    } configs[] = {
+        { "CIC2 /4",                  2, 4, 0.0f,   0.0f   },
+        { "CIC2 /4 + LPF 250Hz",      2, 4, 250.0f, 0.0f   },
+        { "CIC2 /4 + LPF 150Hz",      2, 4, 150.0f, 0.0f   },
+        { "CIC3 /4 + LPF 150Hz",      3, 4, 150.0f, 0.0f   },
+        { "CIC2 /4 + LPF 250 + N180", 2, 4, 250.0f, 180.0f },
+    };
+
+    Result average = runStream(NULL);
+    printf("decimator: %-26s delay %5.2f ms  noise %6.2f deg/s rms\n", "average (previous)", average.delay_ms, average.noise_dps);
+
+    for (unsigned c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        struct Decimator d;
+        configure(&d, configs[c].order, configs[c].ratio, configs[c].lowpass, configs[c].notch, 3.0f);
+        Result r = runStream(&d);
+        printf("decimator: %-26s delay %5.2f ms  noise %6.2f deg/s rms\n", configs[c].name, r.delay_ms, r.noise_dps);
+        if (!getenv("DECIMATOR_STREAM") && configs[c].lowpass > 0.0f) {
+            // the low pass removes what the average aliases, the notch the in band motor line
+            EXPECT_LT(r.noise_dps, (configs[c].notch > 0.0f ? 0.2 : 1.0) * average.noise_dps) << configs[c].name;
+            EXPECT_LT(r.delay_ms, 2.5) << configs[c].name;
+        }
+    }
+}
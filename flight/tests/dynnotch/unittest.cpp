@@ -0,0 +1,248 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* getenv */
+#include <string.h> /* strchr */
+#include <math.h> /* sin */
+#include <time.h> /* clock_gettime */
+
+extern "C" {
+#include "openpilot.h"
+#include "dynnotch.h"
+}
+
+/* GyroState as seen by the stabilization inner loop */
+#define SAMPLE_RATE 500.0f
+#define MIN_HZ      80.0f
+#define MAX_HZ      240.0f
+#define Q           3.0f
+#define MIN_AMPLITUDE 1.0f
+#define LOG_SECONDS 20
+#define LOG_LEN     ((int)SAMPLE_RATE * LOG_SECONDS)
+
+static float log_in[LOG_LEN][3];
+static float log_out[LOG_LEN][3];
+static float motor_hz[LOG_LEN];
+static int log_len;
+
+/* Hann windowed power of x[0..n) at hz, the same estimate the tracker uses */
+static double tonePower(const float *x, int stride, int n, double hz)
+{
+    const double coeff = 2.0 * cos(2.0 * M_PI * hz / SAMPLE_RATE);
+    double s1 = 0.0, s2 = 0.0;
+
+    for (int i = 0; i < n; i++) {
+        double w  = 0.5 - 0.5 * cos(2.0 * M_PI * i / n);
+        double s0 = x[i * stride] * w + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    return s1 * s1 + s2 * s2 - coeff * s1 * s2;
+}
+
+/* single axis sine through the bank, returns the peak output over the last window */
+static float runTones(struct DynNotch *dn, const float *hz, const float *amplitude, int tones, int samples)
+{
+    float peak = 0.0f;
+
+    for (int i = 0; i < samples; i++) {
+        float x = 0.0f;
+        for (int k = 0; k < tones; k++) {
+            x += amplitude[k] * sinf(2.0f * M_PI_F * hz[k] * i / SAMPLE_RATE);
+        }
+        Vector3f v = { x, 0.0f, 0.0f };
+        DynNotchApply(dn, &v);
+        if (i >= samples - DYNNOTCH_WINDOW && fabsf(v.x) > peak) {
+            peak = fabsf(v.x);
+        }
+    }
+    return peak;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class DynNotchTest : public testing::Test {
+protected:
+    struct DynNotch dn;
+};
+
+TEST_F(DynNotchTest, RejectsBadConfig) {
+    EXPECT_FALSE(DynNotchInit(&dn, 0.0f, MIN_HZ, MAX_HZ, 1, Q, MIN_AMPLITUDE));
+    EXPECT_FALSE(DynNotchInit(&dn, SAMPLE_RATE, 0.0f, MAX_HZ, 1, Q, MIN_AMPLITUDE));
+    EXPECT_FALSE(DynNotchInit(&dn, SAMPLE_RATE, MAX_HZ, MIN_HZ, 1, Q, MIN_AMPLITUDE));
+    EXPECT_FALSE(DynNotchInit(&dn, SAMPLE_RATE, MIN_HZ, 0.5f * SAMPLE_RATE, 1, Q, MIN_AMPLITUDE));
+    EXPECT_FALSE(DynNotchInit(&dn, SAMPLE_RATE, MIN_HZ, MAX_HZ, 0, Q, MIN_AMPLITUDE));
+    EXPECT_FALSE(DynNotchInit(&dn, SAMPLE_RATE, MIN_HZ, MAX_HZ, DYNNOTCH_MAX_NOTCHES + 1, Q, MIN_AMPLITUDE));
+    EXPECT_FALSE(DynNotchInit(&dn, SAMPLE_RATE, MIN_HZ, MAX_HZ, 1, 0.0f, MIN_AMPLITUDE));
+    EXPECT_TRUE(DynNotchInit(&dn, SAMPLE_RATE, MIN_HZ, MAX_HZ, DYNNOTCH_MAX_NOTCHES, Q, MIN_AMPLITUDE));
+};
+
+TEST_F(DynNotchTest, LocksOntoTone) {
+    const float hz = 150.0f, amplitude = 10.0f;
+
+    ASSERT_TRUE(DynNotchInit(&dn, SAMPLE_RATE, MIN_HZ, MAX_HZ, 1, Q, MIN_AMPLITUDE));
+    float residual = runTones(&dn, &hz, &amplitude, 1, (int)SAMPLE_RATE);
+
+    EXPECT_NEAR(hz, DynNotchFrequency(&dn, 0, 0), 1.0f);
+    EXPECT_EQ(0.0f, DynNotchFrequency(&dn, 1, 0));
+    EXPECT_EQ(0.0f, DynNotchFrequency(&dn, 2, 0));
+    // better than 20dB
+    EXPECT_LT(residual, 0.1f * amplitude);
+};
+
+TEST_F(DynNotchTest, TracksTwoPeaks) {
+    const float hz[2] = { 110.0f, 205.0f }, amplitude[2] = { 10.0f, 6.0f };
+
+    ASSERT_TRUE(DynNotchInit(&dn, SAMPLE_RATE, MIN_HZ, MAX_HZ, 2, Q, MIN_AMPLITUDE));
+    float residual = runTones(&dn, hz, amplitude, 2, (int)SAMPLE_RATE);
+
+    float a = DynNotchFrequency(&dn, 0, 0);
+    float b = DynNotchFrequency(&dn, 0, 1);
+    EXPECT_NEAR(hz[0], fminf(a, b), 1.0f);
+    EXPECT_NEAR(hz[1], fmaxf(a, b), 1.0f);
+    EXPECT_LT(residual, 0.1f * amplitude[0]);
+};
+
+TEST_F(DynNotchTest, IgnoresManoeuvres) {
+    const float hz[2] = { 3.0f, 11.0f }, amplitude[2] = { 100.0f, 60.0f };
+
+    ASSERT_TRUE(DynNotchInit(&dn, SAMPLE_RATE, MIN_HZ, MAX_HZ, DYNNOTCH_MAX_NOTCHES, Q, MIN_AMPLITUDE));
+    for (int i = 0; i < (int)SAMPLE_RATE; i++) {
+        float x = amplitude[0] * sinf(2.0f * M_PI_F * hz[0] * i / SAMPLE_RATE) + amplitude[1] * sinf(2.0f * M_PI_F * hz[1] * i / SAMPLE_RATE);
+        Vector3f v = { x, -x, 0.5f * x };
+        DynNotchApply(&dn, &v);
+        // no notch engaged, the samples pass untouched
+        ASSERT_EQ(x, v.x);
+        ASSERT_EQ(-x, v.y);
+        ASSERT_EQ(0.5f * x, v.z);
+    }
+};
+
+/*
+ * Synthetic flight: manoeuvres on all axes, a motor line following the
+ * throttle, a fixed frame resonance on roll and pitch and sensor noise.
+ */
+static void syntheticLog()
+{
+    double phase = 0.0;
+
+    srand(1);
+    for (int i = 0; i < LOG_LEN; i++) {
+        double t = i / SAMPLE_RATE;
+        motor_hz[i] = 140.0 + 30.0 * sin(2 * M_PI * 0.1 * t);
+        phase += 2 * M_PI * motor_hz[i] / SAMPLE_RATE;
+        double motor = 15.0 * sin(phase);
+        double frame = 8.0 * sin(2 * M_PI * 205.0 * t);
+        double noise[3];
+        for (int a = 0; a < 3; a++) {
+            noise[a] = ((double)rand() / RAND_MAX - 0.5) * 2.0;
+        }
+        log_in[i][0] = 150.0 * sin(2 * M_PI * 1.5 * t) + motor + frame + noise[0];
+        log_in[i][1] = 80.0 * sin(2 * M_PI * 0.7 * t + 1.0) + 0.7 * motor + frame + noise[1];
+        log_in[i][2] = 40.0 * sin(2 * M_PI * 0.3 * t) + 0.4 * motor + noise[2];
+    }
+    log_len = LOG_LEN;
+}
+
+/*
+ * A recorded flight can be replayed with DYNNOTCH_LOG=<file>, one GyroState
+ * sample per line as x y z in deg/s at SAMPLE_RATE, separated by spaces or
+ * commas, e.g. exported from a GCS log. Lines that do not parse are skipped.
+ */
+static bool recordedLog()
+{
+    const char *path = getenv("DYNNOTCH_LOG");
+
+    if (!path) {
+        return false;
+    }
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    char line[256];
+    log_len = 0;
+    while (log_len < LOG_LEN && fgets(line, sizeof(line), f)) {
+        for (char *c = strchr(line, ','); c; c = strchr(c, ',')) {
+            *c = ' ';
+        }
+        if (sscanf(line, "%f %f %f", &log_in[log_len][0], &log_in[log_len][1], &log_in[log_len][2]) == 3) {
+            log_len++;
+        }
+    }
+    fclose(f);
+    printf("dynnotch: replaying %d samples from %s\n", log_len, path);
+    return log_len > 2 * DYNNOTCH_WINDOW;
+}
+
+static double nanoseconds(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+/*
+ * Replays the log through the bank and reports, per axis, the notches at the
+ * end and the attenuation at the tracked peaks: input against output power at
+ * the notch frequencies of every window once the tracker has settled. The
+ * synthetic log also reports the attenuation of the motor line at its true
+ * frequency, which includes the tracking error.
+ */
+TEST_F(DynNotchTest, ReplayReport) {
+    const bool recorded = recordedLog();
+
+    if (!recorded) {
+        syntheticLog();
+    }
+
+    ASSERT_TRUE(DynNotchInit(&dn, SAMPLE_RATE, MIN_HZ, MAX_HZ, 2, Q, MIN_AMPLITUDE));
+    const int blocks = log_len / DYNNOTCH_WINDOW;
+    // one second to settle
+    const int first  = (int)SAMPLE_RATE / DYNNOTCH_WINDOW;
+    double tracked_in[3]    = { 0 }, tracked_out[3] = { 0 };
+    double motor_in[3]      = { 0 }, motor_out[3] = { 0 };
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int b = 0; b < blocks; b++) {
+        const int base = b * DYNNOTCH_WINDOW;
+        for (int i = base; i < base + DYNNOTCH_WINDOW; i++) {
+            Vector3f v = { log_in[i][0], log_in[i][1], log_in[i][2] };
+            DynNotchApply(&dn, &v);
+            log_out[i][0] = v.x;
+            log_out[i][1] = v.y;
+            log_out[i][2] = v.z;
+        }
+        if (b < first) {
+            continue;
+        }
+        for (int a = 0; a < 3; a++) {
+            for (int m = 0; m < dn.num_notches; m++) {
+                float hz = DynNotchFrequency(&dn, a, m);
+                if (hz > 0.0f) {
+                    tracked_in[a]  += tonePower(&log_in[base][a], 3, DYNNOTCH_WINDOW, hz);
+                    tracked_out[a] += tonePower(&log_out[base][a], 3, DYNNOTCH_WINDOW, hz);
+                }
+            }
+            if (!recorded) {
+                double hz = motor_hz[base + DYNNOTCH_WINDOW / 2];
+                motor_in[a]  += tonePower(&log_in[base][a], 3, DYNNOTCH_WINDOW, hz);
+                motor_out[a] += tonePower(&log_out[base][a], 3, DYNNOTCH_WINDOW, hz);
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const double ns_per_sample = nanoseconds(&start, &end) / (blocks * DYNNOTCH_WINDOW);
+
+    printf("dynnotch: %d bins, %d sample window, %.0f ns per 3 axis sample on this host\n",
+           DYNNOTCH_BINS, DYNNOTCH_WINDOW, ns_per_sample);
+    printf("%-5s %9s %9s %12s %10s\n", "axis", "notch1", "notch2", "tracked dB", "motor dB");
+    for (int a = 0; a < 3; a++) {
+        double tracked = tracked_out[a] > 0.0 ? 10.0 * log10(tracked_in[a] / tracked_out[a]) : 0.0;
+        double motor   = motor_out[a] > 0.0 ? 10.0 * log10(motor_in[a] / motor_out[a]) : 0.0;
+        printf("%-5c %9.1f %9.1f %12.1f %10.1f\n", "xyz"[a],
+               DynNotchFrequency(&dn, a, 0), DynNotchFrequency(&dn, a, 1), tracked, motor);
+        if (!recorded) {
+            EXPECT_GT(tracked, 18.0) << "xyz"[a];
+            EXPECT_GT(motor, 18.0) << "xyz"[a];
+        }
+    }
+};
@@ -0,0 +1,46 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pios.h>
+#include <utlist.h>
+
+#define PIOS_Assert(x) \
+    if (!(x)) { while (1) {; } \
+    }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+/* Minimal UAVObject types used by the event dispatcher */
+typedef void *UAVObjHandle;
+typedef enum {
+    EV_NONE = 0x00,
+    EV_UPDATED_PERIODIC = 0x08,
+} UAVObjEventType;
+typedef struct {
+    UAVObjHandle    obj;
+    uint16_t        instId;
+    UAVObjEventType event;
+    bool lowPriority;
+} UAVObjEvent;
+typedef void (*UAVObjEventCallback)(UAVObjEvent *ev);
+uint32_t UAVObjGetID(UAVObjHandle obj);
+
+/* Callback scheduler stubs, the test invokes the scheduled callback itself */
+typedef void (*DelayedCallback)(void);
+typedef struct {
+    DelayedCallback cb;
+    int32_t lastDelayMs;
+} DelayedCallbackInfo;
+#define CALLBACK_PRIORITY_CRITICAL  0
+#define CALLBACK_TASK_FLIGHTCONTROL 0
+#define CALLBACK_UPDATEMODE_SOONER  0
+DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(DelayedCallback cb, int priority, int taskPriority, int callbackID, int stackSize);
+int32_t PIOS_CALLBACKSCHEDULER_Dispatch(DelayedCallbackInfo *cbinfo);
+int32_t PIOS_CALLBACKSCHEDULER_Schedule(DelayedCallbackInfo *cbinfo, int32_t milliseconds, int updatemode);
+
+#include <eventdispatcher.h>
+
+#endif /* OPENPILOT_H */
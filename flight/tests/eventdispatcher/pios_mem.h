@@ -1,13 +1,13 @@
 /**
  ******************************************************************************
  *
- * @file       traillineitem.h
- * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @brief      A graphicsItem representing a WayPoint
- * @see        The GNU Public License (GPL) Version 3
- * @defgroup   OPMapWidget
+ * @file       pios_mem.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup PiOS
  * @{
- *
+ * @addtogroup PiOS
+ * @{
+ * @brief PiOS memory allocation API
  *****************************************************************************/
 /*
  * This program is free software; you can redistribute it and/or modify
@@ -24,32 +24,11 @@
  * with this program; if not, write to the Free Software Foundation, Inc.,
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
-#ifndef TAILLINEITEM_H
-#define TAILLINEITEM_H
-
-#include <QGraphicsItem>
-#include <QPainter>
-#include <QLabel>
-#include "../internals/pointlatlng.h"
-#include <QObject>
-#include "mapgraphicitem.h"
+#ifndef PIOS_MEM_H
+#define PIOS_MEM_H
 
-namespace mapcontrol {
-class TrailLineItem : public QObject, public QGraphicsLineItem {
-    Q_OBJECT Q_INTERFACES(QGraphicsItem)
-public:
-    enum { Type = UserType + 7 };
-    TrailLineItem(internals::PointLatLng const & coord1, internals::PointLatLng const & coord2, QBrush color, MapGraphicItem *map);
-    int type() const;
-    internals::PointLatLng coord1;
-    internals::PointLatLng coord2;
-private:
-    QBrush m_brush;
-    MapGraphicItem *m_map;
-public slots:
-    void setLineSlot();
-signals:
-};
-}
+#define pios_fastheapmalloc(size) (malloc(size))
+#define pios_malloc(size)         (malloc(size))
+#define pios_free(p)              (free(p))
 
-#endif // TAILLINEITEM_H
+#endif /* PIOS_MEM_H */
@@ -0,0 +1,202 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+#include <time.h> /* clock_gettime */
+
+extern "C" {
+#include "eventdispatcher.c"
+
+uint32_t ut_tick = 1000;
+
+static DelayedCallbackInfo ut_callback;
+
+DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(DelayedCallback cb, __attribute__((unused)) int priority, __attribute__((unused)) int taskPriority, __attribute__((unused)) int callbackID, __attribute__((unused)) int stackSize)
+{
+    ut_callback.cb = cb;
+    ut_callback.lastDelayMs = 0;
+    return &ut_callback;
+}
+
+int32_t PIOS_CALLBACKSCHEDULER_Dispatch(__attribute__((unused)) DelayedCallbackInfo *cbinfo)
+{
+    return 0;
+}
+
+int32_t PIOS_CALLBACKSCHEDULER_Schedule(DelayedCallbackInfo *cbinfo, int32_t milliseconds, __attribute__((unused)) int updatemode)
+{
+    cbinfo->lastDelayMs = milliseconds;
+    return 0;
+}
+
+uint32_t UAVObjGetID(UAVObjHandle obj)
+{
+    return (uint32_t)(uintptr_t)obj;
+}
+
+int32_t xQueueSend(__attribute__((unused)) xQueueHandle queue, __attribute__((unused)) const void *item, __attribute__((unused)) uint32_t ticksToWait)
+{
+    return pdTRUE;
+}
+}
+
+#define NUM_OBJECTS 300
+#define RUN_TIME_MS 20000
+
+struct fire_record {
+    uint32_t count;
+    uint32_t lastFire;
+    uint32_t badIntervals;
+    uint16_t expectedPeriod;
+};
+
+static struct fire_record records[NUM_OBJECTS];
+
+static void onPeriodic(UAVObjEvent *ev)
+{
+    struct fire_record *rec = &records[(uintptr_t)ev->obj - 1];
+
+    // the first interval carries the randomized phase, the following ones must be exact
+    if (rec->count > 1 && ut_tick - rec->lastFire != rec->expectedPeriod) {
+        rec->badIntervals++;
+    }
+    rec->lastFire = ut_tick;
+    rec->count++;
+}
+
+static void makeEvent(UAVObjEvent *ev, int index)
+{
+    memset(ev, 0, sizeof(*ev));
+    ev->obj   = (UAVObjHandle)(uintptr_t)(index + 1);
+    ev->event = EV_UPDATED_PERIODIC;
+}
+
+static uint16_t periodOf(int index)
+{
+    // mix of typical telemetry and logging periods
+    static const uint16_t periods[] = { 5, 10, 20, 50, 100, 250, 333, 500, 1000, 2000 };
+
+    return periods[index % (sizeof(periods) / sizeof(periods[0]))];
+}
+
+/* Advance the simulated clock, only waking the dispatcher when it asked to be woken */
+static void runFor(uint32_t durationMs)
+{
+    uint32_t nextWake = ut_tick;
+    uint32_t end = ut_tick + durationMs;
+
+    for (; ut_tick < end; ut_tick++) {
+        if (ut_tick >= nextWake) {
+            ut_callback.cb();
+            ASSERT_GT(ut_callback.lastDelayMs, 0);
+            nextWake = ut_tick + ut_callback.lastDelayMs;
+        }
+    }
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class EventDispatcherTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        memset(records, 0, sizeof(records));
+        EXPECT_EQ(0, EventDispatcherInitialize());
+
+        for (int i = 0; i < NUM_OBJECTS; i++) {
+            UAVObjEvent ev;
+            makeEvent(&ev, i);
+            records[i].expectedPeriod = periodOf(i);
+            EXPECT_EQ(0, EventPeriodicCallbackCreate(&ev, onPeriodic, periodOf(i)));
+        }
+        EXPECT_EQ(NUM_OBJECTS, mHeapSize);
+    }
+};
+
+TEST_F(EventDispatcherTest, DuplicateRegistrationFails) {
+    UAVObjEvent ev;
+
+    makeEvent(&ev, 0);
+    EXPECT_EQ(-1, EventPeriodicCallbackCreate(&ev, onPeriodic, 10));
+    EXPECT_EQ(NUM_OBJECTS, mHeapSize);
+}
+
+TEST_F(EventDispatcherTest, HeapOrdered) {
+    for (uint16_t i = 0; i < mHeapSize; i++) {
+        EXPECT_EQ(i, mHeap[i]->heapIndex);
+        if (i > 0) {
+            EXPECT_LE(mHeap[(i - 1) / 2]->timeToNextUpdateMs, mHeap[i]->timeToNextUpdateMs);
+        }
+    }
+}
+
+TEST_F(EventDispatcherTest, FiresAtPeriod) {
+    runFor(RUN_TIME_MS);
+
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        EXPECT_EQ(0u, records[i].badIntervals) << "object " << i;
+        EXPECT_NEAR(RUN_TIME_MS / records[i].expectedPeriod, records[i].count, 1) << "object " << i;
+    }
+}
+
+TEST_F(EventDispatcherTest, UpdatePeriod) {
+    runFor(1000);
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        records[i].count = 0;
+    }
+
+    // Change the period of some entries and disable others
+    for (int i = 0; i < NUM_OBJECTS; i += 3) {
+        UAVObjEvent ev;
+        makeEvent(&ev, i);
+        EXPECT_EQ(0, EventPeriodicCallbackUpdate(&ev, onPeriodic, 40));
+        records[i].expectedPeriod = 40;
+    }
+    for (int i = 1; i < NUM_OBJECTS; i += 3) {
+        UAVObjEvent ev;
+        makeEvent(&ev, i);
+        EXPECT_EQ(0, EventPeriodicCallbackUpdate(&ev, onPeriodic, 0));
+    }
+    EXPECT_EQ(NUM_OBJECTS - NUM_OBJECTS / 3, mHeapSize);
+
+    runFor(RUN_TIME_MS);
+
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        if (i % 3 == 1) {
+            EXPECT_EQ(0u, records[i].count) << "object " << i;
+        } else {
+            EXPECT_EQ(0u, records[i].badIntervals) << "object " << i;
+            EXPECT_NEAR(RUN_TIME_MS / records[i].expectedPeriod, records[i].count, 2) << "object " << i;
+        }
+    }
+
+    // Re-enabling puts the entry back in the heap
+    UAVObjEvent ev;
+    makeEvent(&ev, 1);
+    EXPECT_EQ(0, EventPeriodicCallbackUpdate(&ev, onPeriodic, 100));
+    EXPECT_EQ(NUM_OBJECTS - NUM_OBJECTS / 3 + 1, mHeapSize);
+
+    // Unknown objects are reported
+    makeEvent(&ev, NUM_OBJECTS);
+    EXPECT_EQ(-1, EventPeriodicCallbackUpdate(&ev, onPeriodic, 100));
+}
+
+TEST_F(EventDispatcherTest, Benchmark) {
+    struct timespec start, stop;
+    uint32_t wakeups = 0;
+    uint32_t nextWake = ut_tick;
+    uint32_t end = ut_tick + RUN_TIME_MS;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (; ut_tick < end; ut_tick++) {
+        if (ut_tick >= nextWake) {
+            ut_callback.cb();
+            nextWake = ut_tick + ut_callback.lastDelayMs;
+            wakeups++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    double elapsedNs = (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec);
+    printf("%d periodic objects, %u wakeups, %.1f ns per wakeup\n", NUM_OBJECTS, wakeups, elapsedNs / wakeups);
+}
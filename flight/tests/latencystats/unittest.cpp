@@ -0,0 +1,166 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+
+extern "C" {
+#include "latencystats.h"
+#include "pios_delay.h"
+
+// a 1 MHz raw clock, the trace below wraps it
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later)
+{
+    return later - raw;
+}
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class LatencyStatsTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        LatencyStatsInit(&stats, 100);
+    }
+
+    LatencyStats stats;
+};
+
+TEST_F(LatencyStatsTest, Empty) {
+    EXPECT_EQ(0u, stats.count);
+    EXPECT_EQ(0u, LatencyStatsMean(&stats));
+    EXPECT_EQ(0u, LatencyStatsPercentile(&stats, 99));
+}
+
+TEST_F(LatencyStatsTest, MinMeanMax) {
+    LatencyStatsAdd(&stats, 250);
+    LatencyStatsAdd(&stats, 350);
+    LatencyStatsAdd(&stats, 450);
+
+    EXPECT_EQ(3u, stats.count);
+    EXPECT_EQ(250u, stats.min);
+    EXPECT_EQ(350u, LatencyStatsMean(&stats));
+    EXPECT_EQ(450u, stats.max);
+    EXPECT_EQ(1, stats.histogram[2]);
+    EXPECT_EQ(1, stats.histogram[3]);
+    EXPECT_EQ(1, stats.histogram[4]);
+}
+
+TEST_F(LatencyStatsTest, Percentile) {
+    // 99 fast samples and a single slow one
+    for (int i = 0; i < 99; i++) {
+        LatencyStatsAdd(&stats, 120);
+    }
+    LatencyStatsAdd(&stats, 900);
+
+    EXPECT_EQ(200u, LatencyStatsPercentile(&stats, 50));
+    EXPECT_EQ(200u, LatencyStatsPercentile(&stats, 99));
+    EXPECT_EQ(900u, LatencyStatsPercentile(&stats, 100));
+}
+
+TEST_F(LatencyStatsTest, PercentileNeverAboveMax) {
+    LatencyStatsAdd(&stats, 110);
+    EXPECT_EQ(110u, LatencyStatsPercentile(&stats, 99));
+}
+
+TEST_F(LatencyStatsTest, OverflowBucket) {
+    LatencyStatsAdd(&stats, 100000);
+
+    EXPECT_EQ(1, stats.histogram[LATENCYSTATS_BUCKETS - 1]);
+    EXPECT_EQ(100000u, LatencyStatsPercentile(&stats, 99));
+}
+
+TEST_F(LatencyStatsTest, Reset) {
+    LatencyStatsAdd(&stats, 500);
+    LatencyStatsReset(&stats);
+
+    EXPECT_EQ(0u, stats.count);
+    EXPECT_EQ(0u, stats.max);
+    EXPECT_EQ(100, stats.bucketWidth);
+    for (int i = 0; i < LATENCYSTATS_BUCKETS; i++) {
+        EXPECT_EQ(0, stats.histogram[i]);
+    }
+}
+
+/*
+ * A gyro to servo trace as the Actuator module sees it: the timestamp of the
+ * gyro sample ActuatorDesired was computed from, and the time of the servo
+ * update. The raw clock wraps at the fifth update, one update repeats the
+ * previous ActuatorDesired and one carries no timestamp.
+ */
+static const struct {
+    uint32_t sampleTime;
+    uint32_t servoTime;
+} trace[] = {
+    { 0xFFFFF000u, 0xFFFFF0FAu }, // 250
+    { 0xFFFFF3E8u, 0xFFFFF4ECu }, // 260
+    { 0xFFFFF7D0u, 0xFFFFF8C0u }, // 240
+    { 0xFFFFFBB8u, 0xFFFFFCB2u }, // 250
+    { 0xFFFFFBB8u, 0x00000100u }, // repeated, not counted
+    { 0xFFFFFFA0u, 0x0000009Fu }, // 255, across the wrap
+    { 0x00000388u, 0x0000047Du }, // 245
+    { 0x00000770u, 0x0000086Au }, // 250
+    { 0, 0x00000B00u }, // no timestamp, not counted
+    { 0x00000B58u, 0x00000C5Cu }, // 260
+    { 0x00000F40u, 0x000012C4u }, // 900, preempted
+    { 0x00001328u, 0x00001422u }, // 250
+    { 0x00001710u, 0x00001800u }, // 240
+    { 0x00001AF8u, 0x00001BF2u }, // 250
+    { 0x00001EE0u, 0x00001FDFu }, // 255
+    { 0x000022C8u, 0x000023BDu }, // 245
+    { 0x000026B0u, 0x000027AAu }, // 250
+    { 0x00002A98u, 0x00002B9Cu }, // 260
+    { 0x00002E80u, 0x00002F7Au }, // 250
+    { 0x00003268u, 0x00003358u }, // 240
+    { 0x00003650u, 0x0000374Fu }, // 255
+    { 0x00003A38u, 0x00003B32u }, // 250
+};
+
+TEST(LatencyTrackerTest, GyroToServoTrace) {
+    LatencyTracker tracker;
+    uint32_t counted = 0;
+
+    LatencyTrackerInit(&tracker, 100, 20);
+    for (uint32_t i = 0; i < sizeof(trace) / sizeof(trace[0]); i++) {
+        counted += LatencyTrackerAdd(&tracker, trace[i].sampleTime, trace[i].servoTime);
+    }
+
+    EXPECT_EQ(20u, counted);
+    EXPECT_EQ(20u, tracker.latency.count);
+    EXPECT_EQ(240u, tracker.latency.min);
+    EXPECT_EQ(900u, tracker.latency.max);
+    EXPECT_EQ(5655u / 20u, LatencyStatsMean(&tracker.latency));
+    // 19 samples in 200..299us, the preempted one in 900..999us
+    EXPECT_EQ(19, tracker.latency.histogram[2]);
+    EXPECT_EQ(1, tracker.latency.histogram[9]);
+    EXPECT_EQ(300u, LatencyStatsPercentile(&tracker.latency, 50));
+    EXPECT_EQ(300u, LatencyStatsPercentile(&tracker.latency, 95));
+    EXPECT_EQ(900u, LatencyStatsPercentile(&tracker.latency, 99));
+
+    // one change less than samples: 16 below 20us, a 20us step, and the
+    // 640us and 650us steps into and out of the preempted sample
+    EXPECT_EQ(19u, tracker.jitter.count);
+    EXPECT_EQ(5u, tracker.jitter.min);
+    EXPECT_EQ(650u, tracker.jitter.max);
+    EXPECT_EQ(1450u / 19u, LatencyStatsMean(&tracker.jitter));
+    EXPECT_EQ(16, tracker.jitter.histogram[0]);
+    EXPECT_EQ(1, tracker.jitter.histogram[1]);
+    EXPECT_EQ(2, tracker.jitter.histogram[LATENCYSTATS_BUCKETS - 1]);
+    EXPECT_EQ(20u, LatencyStatsPercentile(&tracker.jitter, 50));
+    EXPECT_EQ(650u, LatencyStatsPercentile(&tracker.jitter, 99));
+}
+
+TEST(LatencyTrackerTest, ResetKeepsLastSample) {
+    LatencyTracker tracker;
+
+    LatencyTrackerInit(&tracker, 100, 20);
+    EXPECT_EQ(1, LatencyTrackerAdd(&tracker, 1000, 1250));
+    LatencyTrackerReset(&tracker);
+    EXPECT_EQ(0u, tracker.latency.count);
+
+    // the jitter of the first sample after a publish period refers to the last one
+    EXPECT_EQ(0, LatencyTrackerAdd(&tracker, 1000, 1300));
+    EXPECT_EQ(1, LatencyTrackerAdd(&tracker, 2000, 2300));
+    EXPECT_EQ(1u, tracker.jitter.count);
+    EXPECT_EQ(50u, tracker.jitter.max);
+}
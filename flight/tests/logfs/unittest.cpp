@@ -3,6 +3,7 @@
 #include <stdio.h> /* printf */
 #include <stdlib.h> /* abort */
 #include <string.h> /* memset */
+#include <time.h> /* clock */
 
 extern "C" {
 #include "pios_flash.h" /* PIOS_FLASH_* API */
@@ -297,6 +298,176 @@ TEST_F(LogfsTestCooked, WriteManyVerify) {
     EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
 }
 
+TEST_F(LogfsTestCooked, WriteBatchVerify) {
+    struct PIOS_FLASHFS_ObjItem items[] = {
+        { OBJ1_ID, 0,   sizeof(obj1),     obj1     },
+        { OBJ1_ID, 123, sizeof(obj1_alt), obj1_alt },
+        { OBJ2_ID, 0,   sizeof(obj2),     obj2     },
+        { OBJ3_ID, 0,   sizeof(obj3),     obj3     },
+    };
+
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, items, 4));
+
+    /* Saving the set again replaces every object instead of adding new ones */
+    items[0].obj_data = obj1_alt;
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, items, 4));
+
+    struct PIOS_FLASHFS_Stats stats;
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(4, stats.num_active_slots);
+
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 123, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+    unsigned char obj3_check[OBJ3_SIZE];
+    memset(obj3_check, 0, sizeof(obj3_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ3_ID, 0, obj3_check, sizeof(obj3_check)));
+    EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
+}
+
+TEST_F(LogfsTestCooked, WriteBatchGarbageCollect) {
+    uint16_t num_slots = (flashfs_config_partition_a.arena_size / flashfs_config_partition_a.slot_size) - 1;
+
+    /* Fill up the log leaving room for two objects */
+    for (uint16_t i = 0; i < num_slots - 2; i++) {
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i, obj1, sizeof(obj1)));
+    }
+
+    /* Three new objects do not fit even after gc */
+    struct PIOS_FLASHFS_ObjItem new_items[] = {
+        { OBJ0_ID, 0, 0,            NULL },
+        { OBJ2_ID, 0, sizeof(obj2), obj2 },
+        { OBJ3_ID, 0, sizeof(obj3), obj3 },
+    };
+    EXPECT_EQ(-4, PIOS_FLASHFS_ObjSaveBatch(fs_id, new_items, 3));
+
+    struct PIOS_FLASHFS_ObjItem items[] = {
+        { OBJ1_ID, 0, sizeof(obj1_alt), obj1_alt },
+        { OBJ2_ID, 0, sizeof(obj2),     obj2 },
+        { OBJ3_ID, 0, sizeof(obj3),     obj3 },
+    };
+
+    /* Replacing obj1 frees its slot, so the three of them fit after one gc */
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, items, 3));
+
+    struct PIOS_FLASHFS_Stats stats;
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(num_slots, stats.num_active_slots);
+    EXPECT_EQ(0, stats.num_free_slots);
+
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 1, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+}
+
+/* Counts the flash accesses of a save sequence */
+static uint32_t ut_flash_reads;
+static uint32_t ut_flash_writes;
+
+static int32_t ut_counting_read(uintptr_t flash_id, uint32_t addr, uint8_t *data, uint16_t len)
+{
+    ut_flash_reads++;
+    return pios_ut_flash_driver.read_data(flash_id, addr, data, len);
+}
+
+static int32_t ut_counting_write(uintptr_t flash_id, uint32_t addr, uint8_t *data, uint16_t len)
+{
+    ut_flash_writes++;
+    return pios_ut_flash_driver.write_data(flash_id, addr, data, len);
+}
+
+#define SETTINGS_OBJECTS 60
+#define SETTINGS_SAVES   20
+#define SETTINGS_BATCH   16
+
+class LogfsTestSaveSet : public LogfsTestRaw {
+protected:
+    virtual void SetUp()
+    {
+        LogfsTestRaw::SetUp();
+
+        driver = pios_ut_flash_driver;
+        driver.read_data  = ut_counting_read;
+        driver.write_data = ut_counting_write;
+        EXPECT_EQ(0, PIOS_Flash_UT_Init(&flash_id, &flash_config));
+        EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_partition_a, &driver, flash_id));
+        ut_flash_reads  = 0;
+        ut_flash_writes = 0;
+    }
+
+    virtual void TearDown()
+    {
+        /* every object of the set must be readable */
+        unsigned char obj1_check[OBJ1_SIZE];
+        for (uint32_t i = 0; i < SETTINGS_OBJECTS; i++) {
+            EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i, 0, obj1_check, sizeof(obj1_check)));
+        }
+        PIOS_FLASHFS_Logfs_Destroy(fs_id);
+        PIOS_Flash_UT_Destroy(flash_id);
+    }
+
+    struct pios_flash_driver driver;
+    uintptr_t flash_id;
+    uintptr_t fs_id;
+};
+
+static uint32_t single_reads;
+static uint32_t single_writes;
+
+/* A full setup saved object by object, the way the GCS did it */
+TEST_F(LogfsTestSaveSet, SaveSingle) {
+    clock_t start = clock();
+
+    for (uint32_t n = 0; n < SETTINGS_SAVES; n++) {
+        for (uint32_t i = 0; i < SETTINGS_OBJECTS; i++) {
+            EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i, 0, obj1, sizeof(obj1)));
+        }
+    }
+
+    single_reads  = ut_flash_reads;
+    single_writes = ut_flash_writes;
+    printf("single saves: %u reads, %u writes, %.1f ms\n", ut_flash_reads, ut_flash_writes,
+           1000.0 * (clock() - start) / CLOCKS_PER_SEC);
+}
+
+/* The same setup saved in batches of one ObjectPersistence list request each */
+TEST_F(LogfsTestSaveSet, SaveBatch) {
+    struct PIOS_FLASHFS_ObjItem items[SETTINGS_BATCH];
+    clock_t start = clock();
+
+    for (uint32_t n = 0; n < SETTINGS_SAVES; n++) {
+        for (uint32_t i = 0; i < SETTINGS_OBJECTS; i += SETTINGS_BATCH) {
+            uint16_t count = 0;
+            for (; count < SETTINGS_BATCH && i + count < SETTINGS_OBJECTS; count++) {
+                items[count].obj_id      = OBJ1_ID + i + count;
+                items[count].obj_inst_id = 0;
+                items[count].obj_size    = sizeof(obj1);
+                items[count].obj_data    = obj1;
+            }
+            EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, items, count));
+        }
+    }
+
+    printf("batch saves: %u reads, %u writes, %.1f ms\n", ut_flash_reads, ut_flash_writes,
+           1000.0 * (clock() - start) / CLOCKS_PER_SEC);
+
+    /* the log is scanned once per batch instead of once per object */
+    if (single_reads) {
+        EXPECT_LT(ut_flash_reads * 4, single_reads);
+        EXPECT_LE(ut_flash_writes, single_writes);
+    }
+}
+
 class LogfsTestCookedMultiPart : public LogfsTestRaw {
 protected:
     virtual void SetUp()
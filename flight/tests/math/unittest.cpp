@@ -3,9 +3,13 @@
 #include <stdio.h> /* printf */
 #include <stdlib.h> /* abort */
 #include <string.h> /* memset */
+#include <time.h> /* clock_gettime */
 
 extern "C" {
 #include "mathmisc.h"
+#include "fastmath.h"
+#include "CoordinateConversions.h"
+#include "vectors.h"
 }
 
 #define epsilon 0.00001f
@@ -108,3 +112,309 @@ TEST_F(MathTestRaw, y_on_curve1) {
     EXPECT_NEAR(-0.35f, y_on_curve(1.250f, points, length(points)), epsilon);
     EXPECT_NEAR(-0.50f, y_on_curve(2.000f, points, length(points)), epsilon);
 }
+
+// To use a test fixture, derive a class from testing::Test.
+class FastMathTest : public testing::Test {};
+
+#define SWEEP_STEPS 1000000
+
+TEST_F(FastMathTest, SinCos) {
+    double worst = 0.0;
+
+    for (int i = -SWEEP_STEPS; i <= SWEEP_STEPS; i++) {
+        float x = i * (1000.0f / SWEEP_STEPS);
+        float s, c;
+        fast_sincosf(x, &s, &c);
+        worst = fmax(worst, fabs(s - sin((double)x)));
+        worst = fmax(worst, fabs(c - cos((double)x)));
+    }
+    printf("fast_sincosf max error %.3g\n", worst);
+    EXPECT_LT(worst, 1e-7);
+    EXPECT_EQ(0.0f, fast_sinf(0.0f));
+    EXPECT_EQ(1.0f, fast_cosf(0.0f));
+}
+
+TEST_F(FastMathTest, Atan2) {
+    double worst = 0.0;
+
+    for (int i = 0; i < SWEEP_STEPS; i++) {
+        double a = i * (2.0 * M_PI / SWEEP_STEPS) - M_PI;
+        // magnitudes over several decades
+        float r  = powf(10.0f, (float)(i % 9) - 4.0f);
+        float y  = r * (float)sin(a);
+        float x  = r * (float)cos(a);
+        double e = fabs(fast_atan2f(y, x) - atan2((double)y, (double)x));
+        worst = fmax(worst, fmin(e, fabs(e - 2.0 * M_PI)));
+    }
+    printf("fast_atan2f max error %.3g\n", worst);
+    EXPECT_LT(worst, 3e-7);
+    EXPECT_EQ(0.0f, fast_atan2f(0.0f, 0.0f));
+    EXPECT_NEAR(M_PI_F, fast_atan2f(0.0f, -1.0f), 1e-7f);
+    EXPECT_NEAR(-M_PI_2_F, fast_atan2f(-1.0f, 0.0f), 1e-7f);
+}
+
+TEST_F(FastMathTest, Asin) {
+    double worst = 0.0;
+
+    for (int i = -SWEEP_STEPS; i <= SWEEP_STEPS; i++) {
+        float x = (float)i / SWEEP_STEPS;
+        worst = fmax(worst, fabs(fast_asinf(x) - asin((double)x)));
+    }
+    printf("fast_asinf max error %.3g\n", worst);
+    EXPECT_LT(worst, 2e-7);
+    // rounding overshoots clamp instead of NaN
+    EXPECT_EQ(M_PI_2_F, fast_asinf(1.0000001f));
+    EXPECT_EQ(-M_PI_2_F, fast_asinf(-1.0000001f));
+}
+
+TEST_F(FastMathTest, QuaternionRoundTrip) {
+    float worst = 0.0f;
+
+    for (int roll = -180; roll < 180; roll += 5) {
+        for (int pitch = -85; pitch <= 85; pitch += 5) {
+            for (int yaw = -180; yaw < 180; yaw += 5) {
+                float rpy[3] = { (float)roll, (float)pitch, (float)yaw };
+                float q[4], out[3];
+                RPY2Quaternion(rpy, q);
+                Quaternion2RPY(q, out);
+                for (int i = 0; i < 3; i++) {
+                    float e = fabsf(out[i] - rpy[i]);
+                    worst = fmaxf(worst, fminf(e, fabsf(e - 360.0f)));
+                }
+            }
+        }
+    }
+    printf("RPY2Quaternion/Quaternion2RPY round trip max error %.3g deg\n", worst);
+    EXPECT_LT(worst, 1e-3f);
+
+    // a quaternion a hair beyond gimbal lock used to give a NaN pitch
+    float q[4] = { 0.70710683f, 0.0f, 0.70710683f, 0.0f };
+    float rpy[3];
+    Quaternion2RPY(q, rpy);
+    EXPECT_FLOAT_EQ(90.0f, rpy[1]);
+}
+
+#define BENCHMARK_CALLS 1000000
+
+static float bench_in[1024];
+
+static double elapsed(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9) * 1e9 / BENCHMARK_CALLS;
+}
+
+#define BENCHMARK(name, expr) \
+    do { \
+        volatile float sink = 0.0f; \
+        struct timespec start; \
+        clock_gettime(CLOCK_MONOTONIC, &start); \
+        for (int i = 0; i < BENCHMARK_CALLS; i++) { \
+            float x = bench_in[i & 1023]; \
+            sink += (expr); \
+        } \
+        printf("%-14s %6.2f ns/call\n", name, elapsed(&start)); \
+    } while (0)
+
+// Host numbers only: the tests build at -O0 against glibc, whose sinf/asinf
+// are table driven. newlib on the F4 has no such fast path.
+TEST_F(FastMathTest, Benchmark) {
+    for (int i = 0; i < 1024; i++) {
+        bench_in[i] = (float)i / 1024.0f - 0.5f;
+    }
+
+    BENCHMARK("sinf", sinf(x * 10.0f));
+    BENCHMARK("fast_sinf", fast_sinf(x * 10.0f));
+    BENCHMARK("atan2f", atan2f(x, 0.3f));
+    BENCHMARK("fast_atan2f", fast_atan2f(x, 0.3f));
+    BENCHMARK("asinf", asinf(x));
+    BENCHMARK("fast_asinf", fast_asinf(x));
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class VectorsTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        srand(1);
+    }
+
+    float randomf(float range)
+    {
+        return range * (2.0f * rand() / RAND_MAX - 1.0f);
+    }
+
+    void randomQuaternion(float q[4])
+    {
+        float rpy[3] = { randomf(180.0f), randomf(90.0f), randomf(180.0f) };
+
+        RPY2Quaternion(rpy, q);
+    }
+
+    // the per axis bias/scale and rotation sensors.c used to apply to accels
+    void referenceAccel(float R[3][3], const float bias[3], const float scale[3], const float temp_bias[3],
+                        float k, const Vector3i32 *raw, float out[3])
+    {
+        float samples[3] = { raw->x * k, raw->y * k, raw->z * k };
+        float accels[3]  = { (samples[0] - bias[0]) * scale[0] - temp_bias[0],
+                             (samples[1] - bias[1]) * scale[1] - temp_bias[1],
+                             (samples[2] - bias[2]) * scale[2] - temp_bias[2] };
+
+        rot_mult(R, accels, out);
+    }
+};
+
+#define VECTOR_TRIALS 10000
+/* MAX_SENSORS_PER_INSTANCE in sensors.c */
+#define SENSOR_BATCH  2
+
+TEST_F(VectorsTest, Rotate) {
+    for (int n = 0; n < VECTOR_TRIALS; n++) {
+        float q[4], R[3][3];
+        float v[3] = { randomf(100.0f), randomf(100.0f), randomf(100.0f) };
+        float out[3], back[3];
+
+        randomQuaternion(q);
+        Quaternion2R(q, R);
+        vector3_rotatef(R, v, out);
+        for (int i = 0; i < 3; i++) {
+            double ref = (double)R[i][0] * v[0] + (double)R[i][1] * v[1] + (double)R[i][2] * v[2];
+            ASSERT_NEAR(ref, out[i], 1e-4);
+        }
+        vector3_rotate_transposedf(R, out, back);
+        for (int i = 0; i < 3; i++) {
+            ASSERT_NEAR(v[i], back[i], 1e-4);
+        }
+    }
+}
+
+TEST_F(VectorsTest, QuaternionRotate) {
+    for (int n = 0; n < VECTOR_TRIALS; n++) {
+        float q[4], R[3][3];
+        float v[3] = { randomf(100.0f), randomf(100.0f), randomf(100.0f) };
+        float ref[3], out[3];
+
+        randomQuaternion(q);
+        Quaternion2R(q, R);
+        rot_mult(R, v, ref);
+        quat_rotatef(q, v, out);
+        for (int i = 0; i < 3; i++) {
+            ASSERT_NEAR(ref[i], out[i], 1e-4);
+        }
+    }
+}
+
+TEST_F(VectorsTest, Identity) {
+    Vector3Transformf t;
+    Vector3f v[2] = {
+        { 1.0f, -2.0f, 3.0f }, { -4.0f, 5.0f, -6.0f }
+    };
+
+    vector3_transform_setf(&t, NULL, NULL, NULL);
+    vector3_transformf(&t, v, v, 2);
+    EXPECT_EQ(1.0f, v[0].x);
+    EXPECT_EQ(-2.0f, v[0].y);
+    EXPECT_EQ(3.0f, v[0].z);
+    EXPECT_EQ(-4.0f, v[1].x);
+    EXPECT_EQ(5.0f, v[1].y);
+    EXPECT_EQ(-6.0f, v[1].z);
+}
+
+TEST_F(VectorsTest, SensorCalibration) {
+    for (int n = 0; n < VECTOR_TRIALS; n++) {
+        float q[4], R[3][3];
+        float bias[3]      = { randomf(1.0f), randomf(1.0f), randomf(1.0f) };
+        float scale[3]     = { 1.0f + randomf(0.1f), 1.0f + randomf(0.1f), 1.0f + randomf(0.1f) };
+        float temp_bias[3] = { randomf(0.2f), randomf(0.2f), randomf(0.2f) };
+        // averaged accumulator of up to 16 int16 samples, in m/s^2 after scaling
+        float k = 0.004788f / (1 + rand() % 16);
+        Vector3i32 raw[SENSOR_BATCH];
+
+        randomQuaternion(q);
+        Quaternion2R(q, R);
+        for (int i = 0; i < SENSOR_BATCH; i++) {
+            raw[i].x = (int32_t)randomf(32767.0f * 16);
+            raw[i].y = (int32_t)randomf(32767.0f * 16);
+            raw[i].z = (int32_t)randomf(32767.0f * 16);
+        }
+
+        Vector3Transformf t;
+        const float offset[3] = { bias[0] * scale[0] + temp_bias[0],
+                                  bias[1] * scale[1] + temp_bias[1],
+                                  bias[2] * scale[2] + temp_bias[2] };
+        Vector3f out[SENSOR_BATCH];
+        vector3_transform_setf(&t, R, scale, offset);
+        vector3_transform_i32f(&t, k, raw, out, SENSOR_BATCH);
+
+        for (int i = 0; i < SENSOR_BATCH; i++) {
+            float ref[3];
+            referenceAccel(R, bias, scale, temp_bias, k, &raw[i], ref);
+            // a few float roundings either way, relative to the input magnitude
+            float tolerance = 1e-5f + 1e-6f * k * (abs(raw[i].x) + abs(raw[i].y) + abs(raw[i].z));
+            ASSERT_NEAR(ref[0], out[i].x, tolerance);
+            ASSERT_NEAR(ref[1], out[i].y, tolerance);
+            ASSERT_NEAR(ref[2], out[i].z, tolerance);
+        }
+    }
+}
+
+TEST_F(VectorsTest, Benchmark) {
+    static Vector3i32 raw[1024];
+    static Vector3f out[1024];
+    const float bias[3]      = { 0.1f, -0.2f, 0.3f };
+    const float scale[3]     = { 1.01f, 0.99f, 1.02f };
+    const float temp_bias[3] = { 0.01f, 0.02f, -0.03f };
+    float rpy[3] = { 10.0f, 20.0f, 30.0f };
+    float q[4], R[3][3];
+    volatile float sink = 0.0f;
+    struct timespec start;
+
+    RPY2Quaternion(rpy, q);
+    Quaternion2R(q, R);
+    for (int i = 0; i < 1024; i++) {
+        raw[i].x = rand() % 65536 - 32768;
+        raw[i].y = rand() % 65536 - 32768;
+        raw[i].z = rand() % 65536 - 32768;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < BENCHMARK_CALLS; n++) {
+        float ref[3];
+        referenceAccel(R, bias, scale, temp_bias, 0.004788f, &raw[n & 1023], ref);
+        sink += ref[0];
+    }
+    printf("%-24s %6.2f ns/sample\n", "per axis + rot_mult", elapsed(&start));
+
+    Vector3Transformf t;
+    const float offset[3] = { bias[0] * scale[0] + temp_bias[0],
+                              bias[1] * scale[1] + temp_bias[1],
+                              bias[2] * scale[2] + temp_bias[2] };
+    vector3_transform_setf(&t, R, scale, offset);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < BENCHMARK_CALLS; n += 1024) {
+        vector3_transform_i32f(&t, 0.004788f, raw, out, 1024);
+        sink += out[n & 1023].x;
+    }
+    printf("%-24s %6.2f ns/sample\n", "vector3_transform_i32f", elapsed(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < BENCHMARK_CALLS; n++) {
+        float v[3] = { (float)raw[n & 1023].x, (float)raw[n & 1023].y, (float)raw[n & 1023].z };
+        float r[3];
+        Quaternion2R(q, R);
+        rot_mult(R, v, r);
+        sink += r[0];
+    }
+    printf("%-24s %6.2f ns/sample\n", "Quaternion2R + rot_mult", elapsed(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < BENCHMARK_CALLS; n++) {
+        float v[3] = { (float)raw[n & 1023].x, (float)raw[n & 1023].y, (float)raw[n & 1023].z };
+        float r[3];
+        quat_rotatef(q, v, r);
+        sink += r[0];
+    }
+    printf("%-24s %6.2f ns/sample\n", "quat_rotatef", elapsed(&start));
+}
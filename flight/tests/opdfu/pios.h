@@ -0,0 +1,29 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pios_helpers.h>
+
+/* Board */
+#define BOARD_READABLE true
+#define BOARD_WRITABLE true
+
+/* Simulated flash and system services, see unittest.cpp */
+typedef enum {
+    FLASH_BUSY = 1,
+    FLASH_ERROR_PG,
+    FLASH_ERROR_WRP,
+    FLASH_COMPLETE,
+    FLASH_TIMEOUT
+} FLASH_Status;
+
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data);
+void FLASH_Lock(void);
+
+void PIOS_IAP_WriteBootCount(uint16_t);
+void PIOS_IAP_WriteBootCmd(uint8_t number, uint32_t value);
+void PIOS_SYS_Reset(void);
+
+#endif /* PIOS_H */
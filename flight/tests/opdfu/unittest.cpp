@@ -0,0 +1,639 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* rand */
+#include <string.h> /* memcpy */
+#include <time.h> /* clock_gettime */
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "pios.h"
+#include "common.h"
+#include "op_dfu.h"
+#include "pios_bl_helper.h"
+#include <pios_board_info.h>
+#include <pios_crc.h>
+}
+
+#include "dfusectors.h"
+
+/*
+ * The bootloader side is the real op_dfu.c, the host side runs the GCS
+ * sector CRC code (dfusectors.cpp) and frames the packets as DFUObject in
+ * ground/openpilotgcs/src/plugins/uploader/op_dfu.cpp does. The two talk
+ * 64 byte HID reports over a socket pair.
+ */
+
+#define FLASH_BASE  0x08000000
+#define FLASH_BYTES (1024 * 1024)
+#define FW_BASE     0x08020000
+#define FW_SIZE     (0x60000 - 0x64)
+#define DESC_SIZE   0x64
+#define BUF_LEN     64
+
+/* Simulated flash, F4 sectors or uniform pages */
+static uint8_t flash[FLASH_BYTES];
+static uint32_t pageSize; // 0 for the F4 sector layout
+static uint32_t erasedBytes;
+static uint32_t programErrors;
+
+extern "C" {
+const struct pios_board_info pios_board_info_blob = {
+    PIOS_BOARD_INFO_BLOB_MAGIC, 0x09, 0x03, 0x05, 0, FW_BASE, FW_SIZE, FW_BASE + FW_SIZE, DESC_SIZE, 0, 0
+};
+
+DFUStates DeviceState = BLidle;
+uint8_t JumpToApp     = 0;
+
+static int bootloaderSocket = -1;
+
+int32_t platform_senddata(const uint8_t *msg, uint16_t msg_len)
+{
+    uint8_t report[BUF_LEN] = { 0x01 };
+
+    memcpy(report + 1, msg, msg_len < BUF_LEN - 1 ? msg_len : BUF_LEN - 1);
+    return write(bootloaderSocket, report, BUF_LEN);
+}
+
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data)
+{
+    uint32_t current;
+
+    memcpy(&current, &flash[Address - FLASH_BASE], 4);
+    if (current != 0xffffffff) {
+        // programming a word that was not erased
+        programErrors++;
+        return FLASH_ERROR_PG;
+    }
+    memcpy(&flash[Address - FLASH_BASE], &Data, 4);
+    return FLASH_COMPLETE;
+}
+
+void FLASH_Lock(void) {}
+void PIOS_IAP_WriteBootCount(uint16_t) {}
+void PIOS_IAP_WriteBootCmd(uint8_t, uint32_t) {}
+void PIOS_SYS_Reset(void) {}
+
+uint8_t *PIOS_BL_HELPER_FLASH_If_Read(uint32_t SectorAddress)
+{
+    return &flash[SectorAddress - FLASH_BASE];
+}
+
+uint8_t PIOS_BL_HELPER_FLASH_Ini()
+{
+    return 1;
+}
+
+bool PIOS_BL_HELPER_FLASH_Sector_Info(uint32_t address, uint32_t *sector_start, uint32_t *sector_size)
+{
+    static const uint32_t f4_sectors[] = { 16, 16, 16, 16, 64, 128, 128, 128, 128, 128, 128, 128 };
+
+    if (address < FLASH_BASE || address >= FLASH_BASE + FLASH_BYTES) {
+        return false;
+    }
+    if (pageSize) {
+        *sector_start = address & ~(pageSize - 1);
+        *sector_size  = pageSize;
+        return true;
+    }
+    uint32_t start = FLASH_BASE;
+    for (uint32_t i = 0; i < NELEMENTS(f4_sectors); i++) {
+        uint32_t size = f4_sectors[i] * 1024;
+        if (address < start + size) {
+            *sector_start = start;
+            *sector_size  = size;
+            return true;
+        }
+        start += size;
+    }
+    return false;
+}
+
+uint8_t PIOS_BL_HELPER_FLASH_Erase_Sector(uint32_t address)
+{
+    uint32_t start, size;
+
+    if (!PIOS_BL_HELPER_FLASH_Sector_Info(address, &start, &size)) {
+        return 0;
+    }
+    memset(&flash[start - FLASH_BASE], 0xff, size);
+    erasedBytes += size;
+    return 1;
+}
+
+uint8_t PIOS_BL_HELPER_FLASH_Start()
+{
+    for (uint32_t address = FW_BASE; address < FW_BASE + FW_SIZE + DESC_SIZE;) {
+        uint32_t start, size;
+        PIOS_BL_HELPER_FLASH_Sector_Info(address, &start, &size);
+        PIOS_BL_HELPER_FLASH_Erase_Sector(start);
+        address = start + size;
+    }
+    return 1;
+}
+
+void PIOS_BL_HELPER_CRC_Ini() {}
+}
+
+// STM32 hardware CRC on little endian words, as DFUObject::CRC32WideFast
+static uint32_t crcWords(uint32_t crc, const uint8_t *data, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i += 4) {
+        uint32_t word;
+        memcpy(&word, data + i, 4);
+        crc ^= word;
+        for (int bit = 0; bit < 32; bit++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+extern "C" uint32_t PIOS_BL_HELPER_CRC_Memory_Calc()
+{
+    return crcWords(0xffffffff, &flash[FW_BASE - FLASH_BASE], FW_SIZE);
+}
+
+static void *bootloaderThread(void *)
+{
+    uint8_t buf[BUF_LEN];
+
+    for (;;) {
+        struct pollfd pfd = { bootloaderSocket, POLLIN, 0 };
+        if (poll(&pfd, 1, 1) > 0) {
+            if (read(bootloaderSocket, buf, BUF_LEN) <= 0) {
+                break;
+            }
+            // the report ID is not passed on, as with PIOS_COM_MSG_Receive
+            processComand(buf + 1);
+        }
+        DataDownload(start);
+    }
+    return NULL;
+}
+
+/*
+ * Host side, the packet framing of DFUObject around the GCS sector CRC code
+ * (OP_DFU::SectorDiff), which decodes the replies, picks the sectors and
+ * packets to send and verifies the result.
+ */
+class Uploader {
+public:
+    Uploader(int fd) : fd(fd), packets(0), sectorCRC(false), sizeOfCode(0) {}
+
+    int fd;
+    uint32_t packets;
+    bool sectorCRC;
+    uint32_t sizeOfCode;
+
+    void send(uint8_t *buf)
+    {
+        ASSERT_EQ(BUF_LEN, write(fd, buf, BUF_LEN));
+        packets++;
+    }
+
+    bool receive(uint8_t *buf)
+    {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+
+        if (poll(&pfd, 1, 2000) <= 0 || read(fd, buf, BUF_LEN) != BUF_LEN) {
+            return false;
+        }
+        packets++;
+        return true;
+    }
+
+    void command(uint8_t *buf, uint8_t cmd, uint32_t count = 0)
+    {
+        memset(buf, 0, BUF_LEN);
+        buf[0] = 0x02;
+        buf[1] = cmd;
+        buf[2] = count >> 24;
+        buf[3] = count >> 16;
+        buf[4] = count >> 8;
+        buf[5] = count;
+    }
+
+    bool findDevices()
+    {
+        uint8_t buf[BUF_LEN];
+
+        command(buf, Req_Capabilities);
+        send(buf);
+        if (!receive(buf) || buf[7] != 1) {
+            return false;
+        }
+        command(buf, Req_Capabilities);
+        buf[6] = 1;
+        send(buf);
+        if (!receive(buf)) {
+            return false;
+        }
+        sizeOfCode = (buf[2] << 24) | (buf[3] << 16) | (buf[4] << 8) | buf[5];
+        sectorCRC  = buf[16] & DFU_CAP_SECTOR_CRC;
+        return true;
+    }
+
+    void enterDFU()
+    {
+        uint8_t buf[BUF_LEN];
+
+        command(buf, EnterDFU);
+        send(buf);
+    }
+
+    DFUStates status()
+    {
+        uint8_t buf[BUF_LEN];
+
+        command(buf, Status_Request);
+        send(buf);
+        if (!receive(buf) || buf[1] != Status_Rep) {
+            return Last_operation_failed;
+        }
+        return (DFUStates)buf[6];
+    }
+
+    static void packetCount(uint32_t bytes, uint32_t *numberOfPackets, uint32_t *lastPacketCount)
+    {
+        *numberOfPackets = bytes / 4 / 14;
+        uint32_t pad = (bytes - *numberOfPackets * 4 * 14) / 4;
+        if (pad == 0) {
+            *lastPacketCount = 14;
+        } else {
+            ++*numberOfPackets;
+            *lastPacketCount = pad;
+        }
+    }
+
+    void startUpload(uint32_t bytes, DFUTransfer type, uint32_t crc)
+    {
+        uint8_t buf[BUF_LEN];
+        uint32_t numberOfPackets, lastPacketCount;
+
+        packetCount(bytes, &numberOfPackets, &lastPacketCount);
+        command(buf, Upload | 0x20, numberOfPackets);
+        buf[6]  = type;
+        buf[7]  = lastPacketCount;
+        buf[8]  = crc >> 24;
+        buf[9]  = crc >> 16;
+        buf[10] = crc >> 8;
+        buf[11] = crc;
+        send(buf);
+    }
+
+    void uploadData(const std::vector<uint8_t> &data, const std::vector<bool> &mask)
+    {
+        uint8_t buf[BUF_LEN];
+        uint32_t numberOfPackets, lastPacketCount;
+
+        packetCount(data.size(), &numberOfPackets, &lastPacketCount);
+        for (uint32_t packet = 0; packet < numberOfPackets; packet++) {
+            if (!mask.empty() && !mask[packet]) {
+                continue;
+            }
+            uint32_t words = (packet == numberOfPackets - 1) ? lastPacketCount : 14;
+            command(buf, Upload, packet);
+            for (uint32_t x = 0; x < words * 4; x += 4) {
+                // CopyWords, big endian on the wire
+                for (int b = 0; b < 4; b++) {
+                    buf[6 + x + b] = data[packet * 56 + x + 3 - b];
+                }
+            }
+            send(buf);
+        }
+    }
+
+    void endOperation()
+    {
+        uint8_t buf[BUF_LEN];
+
+        command(buf, Op_END);
+        send(buf);
+    }
+
+    // RequestSectorCRCs
+    bool requestSectorCRCs(std::vector<OP_DFU::sector> &sectors)
+    {
+        uint8_t buf[BUF_LEN];
+        uint32_t total = 1;
+
+        sectors.clear();
+        while (sectors.size() < total) {
+            command(buf, Req_SectorCRC, sectors.size());
+            buf[6] = FW;
+            send(buf);
+            if (!receive(buf) || buf[1] != Rep_SectorCRC) {
+                return false;
+            }
+            total = OP_DFU::SectorDiff::parseReply((const char *)buf, sectors);
+            if (total == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // SelectSectors
+    void selectSectors(const std::vector<bool> &dirty)
+    {
+        uint8_t buf[BUF_LEN];
+
+        for (uint32_t first = 0; first < dirty.size();) {
+            command(buf, Select_Sectors, first);
+            first += OP_DFU::SectorDiff::selectRequest((char *)buf, dirty, first);
+            send(buf);
+        }
+    }
+
+    // the image padded to the code size, as CRCFromQBArray does
+    std::vector<uint8_t> padded(const std::vector<uint8_t> &image)
+    {
+        std::vector<uint8_t> full(image);
+
+        full.resize(sizeOfCode, 0xff);
+        return full;
+    }
+
+    DFUStates uploadFull(const std::vector<uint8_t> &image)
+    {
+        startUpload(image.size(), FW, crcWords(0xffffffff, &padded(image)[0], sizeOfCode));
+        DFUStates ret = status();
+        if (ret != uploading) {
+            return ret;
+        }
+        uploadData(image, std::vector<bool>());
+        endOperation();
+        return status();
+    }
+
+    // UploadFirmwareT and UploadFirmwareDiff with a bootloader that has DFU_CAP_SECTOR_CRC
+    DFUStates uploadDifferential(const std::vector<uint8_t> &image, bool *fallback)
+    {
+        std::vector<OP_DFU::sector> sectors;
+
+        *fallback = !sectorCRC || !requestSectorCRCs(sectors);
+        if (*fallback) {
+            return uploadFull(image);
+        }
+
+        OP_DFU::SectorDiff diff((const char *)&image[0], image.size(), sizeOfCode, sectors);
+        selectSectors(diff.dirty);
+        if (status() != DFUidle) {
+            return Last_operation_failed;
+        }
+        startUpload(image.size(), FW, crcWords(0xffffffff, &padded(image)[0], sizeOfCode));
+        DFUStates ret = status();
+        if (ret != uploading) {
+            return ret;
+        }
+        uploadData(image, diff.packets);
+        endOperation();
+        ret = status();
+        if (ret != Last_operation_Success) {
+            return ret;
+        }
+
+        // verify by CRC instead of reading the image back
+        std::vector<OP_DFU::sector> check;
+        if (!requestSectorCRCs(check) || !diff.verify(check)) {
+            return CRC_Fail;
+        }
+        return ret;
+    }
+
+    DFUStates uploadDescription(const std::vector<uint8_t> &desc)
+    {
+        startUpload(desc.size(), Descript, 0);
+        uploadData(desc, std::vector<bool>());
+        endOperation();
+        return status();
+    }
+};
+
+static std::vector<uint8_t> randomImage(uint32_t bytes, unsigned int seed)
+{
+    std::vector<uint8_t> image(bytes);
+
+    srand(seed);
+    for (uint32_t i = 0; i < bytes; i++) {
+        image[i] = rand();
+    }
+    return image;
+}
+
+static double milliseconds(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class OpDfuTest : public testing::Test {
+protected:
+    int sockets[2];
+    pthread_t thread;
+    Uploader *uploader;
+
+    virtual void SetUp()
+    {
+        memset(flash, 0xff, sizeof(flash));
+        pageSize = 0;
+        connect();
+    }
+
+    virtual void TearDown()
+    {
+        disconnect();
+    }
+
+    void connect()
+    {
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+        bootloaderSocket = sockets[1];
+        DeviceState = BLidle;
+        ASSERT_EQ(0, pthread_create(&thread, NULL, bootloaderThread, NULL));
+        uploader = new Uploader(sockets[0]);
+        ASSERT_TRUE(uploader->findDevices());
+        uploader->enterDFU();
+        ASSERT_EQ(DFUidle, uploader->status());
+        erasedBytes   = 0;
+        programErrors = 0;
+        uploader->packets = 0;
+    }
+
+    void disconnect()
+    {
+        close(sockets[0]);
+        pthread_join(thread, NULL);
+        close(sockets[1]);
+        delete uploader;
+    }
+
+    // a different board with pages of the given size
+    void reconnect(uint32_t bytes)
+    {
+        disconnect();
+        pageSize = bytes;
+        connect();
+    }
+
+    void expectFlash(const std::vector<uint8_t> &image)
+    {
+        const uint8_t *fw = &flash[FW_BASE - FLASH_BASE];
+
+        EXPECT_EQ(0, memcmp(fw, &image[0], image.size()));
+        for (uint32_t i = image.size(); i < FW_SIZE; i++) {
+            ASSERT_EQ(0xff, fw[i]) << "offset " << i;
+        }
+        EXPECT_EQ(0u, programErrors);
+    }
+};
+
+TEST_F(OpDfuTest, FullUpload) {
+    std::vector<uint8_t> image = randomImage(300 * 1024, 1);
+
+    EXPECT_TRUE(uploader->sectorCRC);
+    EXPECT_EQ((uint32_t)FW_SIZE, uploader->sizeOfCode);
+    EXPECT_EQ(Last_operation_Success, uploader->uploadFull(image));
+    expectFlash(image);
+    EXPECT_EQ(3u * 128 * 1024, erasedBytes);
+}
+
+TEST_F(OpDfuTest, SectorCRCs) {
+    std::vector<uint8_t> image = randomImage(200 * 1024, 2);
+    std::vector<OP_DFU::sector> sectors;
+
+    ASSERT_EQ(Last_operation_Success, uploader->uploadFull(image));
+    ASSERT_TRUE(uploader->requestSectorCRCs(sectors));
+    // sectors 5 to 7 of the F4, the last one holds the description
+    ASSERT_EQ(3u, sectors.size());
+    std::vector<uint8_t> full = uploader->padded(image);
+    for (uint32_t i = 0; i < sectors.size(); i++) {
+        EXPECT_EQ(i * 128 * 1024, sectors[i].Offset);
+        EXPECT_EQ(i < 2 ? 128u * 1024 : 128u * 1024 - DESC_SIZE, sectors[i].Size);
+        EXPECT_EQ(i == 2, sectors[i].Description);
+        EXPECT_EQ(PIOS_CRC32_updateCRC(0xffffffff, &full[sectors[i].Offset], sectors[i].Size), sectors[i].CRC);
+        // the GCS computes the same CRC from the image
+        EXPECT_EQ(OP_DFU::SectorDiff::CRC32(0xffffffff, (const char *)&full[sectors[i].Offset], sectors[i].Size), sectors[i].CRC);
+    }
+}
+
+TEST_F(OpDfuTest, DifferentialSkipsUnchangedSectors) {
+    std::vector<uint8_t> image = randomImage(300 * 1024, 3);
+    std::vector<uint8_t> desc(DESC_SIZE, 0x5a);
+    bool fallback;
+
+    ASSERT_EQ(Last_operation_Success, uploader->uploadFull(image));
+    ASSERT_EQ(Last_operation_Success, uploader->uploadDescription(desc));
+
+    // change a word in the second sector only
+    image[130 * 1024] ^= 0xff;
+    erasedBytes = 0;
+    uploader->packets = 0;
+    EXPECT_EQ(Last_operation_Success, uploader->uploadDifferential(image, &fallback));
+    EXPECT_FALSE(fallback);
+    expectFlash(image);
+    // sector 6 and the description sector, not sector 5
+    EXPECT_EQ(2u * 128 * 1024, erasedBytes);
+    EXPECT_LT(uploader->packets, (300u * 1024 / 56) * 2 / 3);
+
+    // the description area was erased with its sector and can be written again
+    EXPECT_EQ(Last_operation_Success, uploader->uploadDescription(desc));
+    EXPECT_EQ(0, memcmp(&flash[FW_BASE + FW_SIZE - FLASH_BASE], &desc[0], DESC_SIZE));
+    EXPECT_EQ(0u, programErrors);
+}
+
+TEST_F(OpDfuTest, DifferentialShorterImage) {
+    std::vector<uint8_t> image = randomImage(380 * 1024, 4);
+    bool fallback;
+
+    ASSERT_EQ(Last_operation_Success, uploader->uploadFull(image));
+    image.resize(100 * 1024);
+    EXPECT_EQ(Last_operation_Success, uploader->uploadDifferential(image, &fallback));
+    EXPECT_FALSE(fallback);
+    expectFlash(image);
+}
+
+TEST_F(OpDfuTest, DifferentialSmallPages) {
+    reconnect(2048);
+    std::vector<uint8_t> image = randomImage(300 * 1024, 5);
+    std::vector<OP_DFU::sector> sectors;
+    bool fallback;
+
+    ASSERT_EQ(Last_operation_Success, uploader->uploadFull(image));
+    ASSERT_TRUE(uploader->requestSectorCRCs(sectors));
+    EXPECT_EQ(192u, sectors.size());
+
+    image[1000] ^= 0xff;
+    image[200 * 1024] ^= 0xff;
+    erasedBytes = 0;
+    EXPECT_EQ(Last_operation_Success, uploader->uploadDifferential(image, &fallback));
+    EXPECT_FALSE(fallback);
+    expectFlash(image);
+    // the two changed pages and the description page
+    EXPECT_EQ(3u * 2048, erasedBytes);
+}
+
+TEST_F(OpDfuTest, FallsBackWithTooManySectors) {
+    // 384 pages of 1k is more than DFU_MAX_SECTORS
+    reconnect(1024);
+    std::vector<uint8_t> image = randomImage(64 * 1024, 6);
+    bool fallback;
+
+    EXPECT_EQ(Last_operation_Success, uploader->uploadDifferential(image, &fallback));
+    EXPECT_TRUE(fallback);
+    expectFlash(image);
+}
+
+TEST_F(OpDfuTest, BadCRCFails) {
+    std::vector<uint8_t> image = randomImage(64 * 1024, 7);
+
+    uploader->startUpload(image.size(), FW, 0x12345678);
+    ASSERT_EQ(uploading, uploader->status());
+    uploader->uploadData(image, std::vector<bool>());
+    uploader->endOperation();
+    EXPECT_EQ(CRC_Fail, uploader->status());
+}
+
+// Host numbers only, the real link is one 64 byte HID report per ms each way
+// and F4 sector erases take around a second each.
+TEST_F(OpDfuTest, Benchmark) {
+    static const uint32_t pages[] = { 0, 2048 };
+
+    for (uint32_t l = 0; l < NELEMENTS(pages); l++) {
+        if (pages[l]) {
+            reconnect(pages[l]);
+        }
+        std::vector<uint8_t> image = randomImage(350 * 1024, 8);
+        struct timespec start, end;
+        bool fallback;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ASSERT_EQ(Last_operation_Success, uploader->uploadFull(image));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        const uint32_t full_packets = uploader->packets;
+        const uint32_t full_erased  = erasedBytes;
+        const double full_ms = milliseconds(&start, &end);
+
+        // a few changed words, all within the second F4 sector
+        image[140 * 1024] ^= 1;
+        image[200 * 1024] ^= 1;
+        uploader->packets = 0;
+        erasedBytes = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ASSERT_EQ(Last_operation_Success, uploader->uploadDifferential(image, &fallback));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ASSERT_FALSE(fallback);
+        EXPECT_LT(uploader->packets, full_packets);
+
+        printf("opdfu: %-8s full %6u bytes %4u kB erased %6.1f ms (%4.1f s on HID), "
+               "differential %6u bytes %4u kB erased %6.1f ms (%4.1f s on HID)\n",
+               pages[l] ? "2k pages" : "F4",
+               full_packets * BUF_LEN, full_erased / 1024, full_ms, full_packets / 1000.0,
+               uploader->packets * BUF_LEN, erasedBytes / 1024, milliseconds(&start, &end), uploader->packets / 1000.0);
+    }
+}
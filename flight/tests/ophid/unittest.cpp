@@ -0,0 +1,298 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+#include <pthread.h> /* pthread_create */
+#include <time.h> /* clock_gettime */
+#include <deque>
+#include <vector>
+
+#include "ophid_reportring.h"
+
+// RawHIDReadThread and RawHIDWriteThread sizes
+#define READ_SIZE    64
+#define READ_TIMEOUT 200
+#define WRITE_SIZE   64
+
+/**
+ * Loopback stand in for opHID_hidapi, reports sent are received back
+ * in order. receive() waits up to timeout ms like hid_read_timeout().
+ */
+class FakeHidapi {
+public:
+    FakeHidapi()
+    {
+        pthread_mutex_init(&m_mutex, NULL);
+        pthread_cond_init(&m_cond, NULL);
+    }
+
+    ~FakeHidapi()
+    {
+        pthread_cond_destroy(&m_cond);
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    int send(__attribute__((unused)) int num, void *buf, int len, __attribute__((unused)) int timeout)
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_reports.push_back(std::vector<char>((char *)buf, (char *)buf + len));
+        pthread_cond_signal(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+        return len;
+    }
+
+    int receive(__attribute__((unused)) int num, void *buf, int len, int timeout)
+    {
+        struct timespec deadline;
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec  += timeout / 1000;
+        deadline.tv_nsec += (timeout % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&m_mutex);
+        while (m_reports.empty()) {
+            if (pthread_cond_timedwait(&m_cond, &m_mutex, &deadline)) {
+                pthread_mutex_unlock(&m_mutex);
+                return 0;
+            }
+        }
+        std::vector<char> report = m_reports.front();
+        m_reports.pop_front();
+        pthread_mutex_unlock(&m_mutex);
+
+        len = qMin(len, (int)report.size());
+        memcpy(buf, report.data(), len);
+        return len;
+    }
+
+private:
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+    std::deque<std::vector<char> > m_reports;
+};
+
+// Frames a payload the way RawHIDWriteThread::run() does
+static void sendReports(FakeHidapi *hid, const char *data, int size)
+{
+    while (size > 0) {
+        char buffer[WRITE_SIZE] = { 0 };
+        int chunk = qMin(WRITE_SIZE - 2, size);
+
+        memcpy(&buffer[2], data, chunk);
+        buffer[1] = chunk; // valid data length
+        buffer[0] = 2; // reportID
+        ASSERT_EQ(WRITE_SIZE, hid->send(0, buffer, WRITE_SIZE, 1000));
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+// One pass of RawHIDReadThread::run(), false if nothing was received
+static bool receiveReport(FakeHidapi *hid, opHID_ReportRing *ring, int timeout)
+{
+    char *buffer = ring->writeSlot();
+
+    if (!buffer) {
+        return false;
+    }
+    int ret = hid->receive(0, buffer, READ_SIZE, timeout);
+    if (ret <= 0) {
+        return false;
+    }
+    if (ret < 2) {
+        buffer[1] = 0;
+    }
+    ring->commit();
+    return true;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class ReportRing : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        ring = new opHID_ReportRing();
+    }
+
+    virtual void TearDown()
+    {
+        delete ring;
+    }
+
+    FakeHidapi hid;
+    opHID_ReportRing *ring;
+};
+
+TEST_F(ReportRing, Empty) {
+    char data[READ_SIZE];
+    const char *span;
+
+    EXPECT_EQ(0, ring->bytesAvailable());
+    EXPECT_EQ(0, ring->peek(&span));
+    EXPECT_EQ(0, ring->read(data, sizeof(data)));
+    EXPECT_FALSE(receiveReport(&hid, ring, 0));
+}
+
+TEST_F(ReportRing, LoopbackAcrossReports) {
+    char sent[1000];
+    char received[sizeof(sent)];
+
+    for (unsigned int i = 0; i < sizeof(sent); i++) {
+        sent[i] = (char)(i * 7 + 3);
+    }
+    sendReports(&hid, sent, sizeof(sent));
+    while (receiveReport(&hid, ring, 0)) {}
+
+    EXPECT_EQ((qint64)sizeof(sent), ring->bytesAvailable());
+    // reads do not line up with the reports
+    qint64 total = 0;
+    while (total < (qint64)sizeof(sent)) {
+        qint64 size = ring->read(received + total, qMin((qint64)37, (qint64)sizeof(sent) - total));
+        ASSERT_GT(size, 0);
+        total += size;
+    }
+    EXPECT_EQ(0, memcmp(sent, received, sizeof(sent)));
+    EXPECT_EQ(0, ring->bytesAvailable());
+    EXPECT_EQ(0, ring->read(received, sizeof(received)));
+}
+
+TEST_F(ReportRing, PeekIsInPlace) {
+    char sent[100];
+    const char *span;
+
+    memset(sent, 0x5A, sizeof(sent));
+    sendReports(&hid, sent, sizeof(sent));
+    while (receiveReport(&hid, ring, 0)) {}
+
+    // the first report, split by a partial consume
+    ASSERT_EQ(WRITE_SIZE - 2, ring->peek(&span));
+    EXPECT_EQ(0x5A, span[0]);
+    ring->consume(10);
+    const char *rest;
+    ASSERT_EQ(WRITE_SIZE - 12, ring->peek(&rest));
+    EXPECT_EQ(span + 10, rest);
+    ring->consume(WRITE_SIZE - 12);
+
+    // then the second one
+    ASSERT_EQ((int)sizeof(sent) - (WRITE_SIZE - 2), ring->peek(&span));
+    ring->consume(sizeof(sent) - (WRITE_SIZE - 2));
+    EXPECT_EQ(0, ring->peek(&span));
+    EXPECT_EQ(0, ring->bytesAvailable());
+}
+
+TEST_F(ReportRing, BadLengthsAreClipped) {
+    char report[WRITE_SIZE] = { 2, (char)0xFF };
+    char data[2 * READ_SIZE];
+
+    // a length beyond the report is clipped to the payload
+    hid.send(0, report, sizeof(report), 0);
+    // an empty report and a truncated one are skipped
+    report[1] = 0;
+    hid.send(0, report, sizeof(report), 0);
+    hid.send(0, report, 1, 0);
+    report[1] = 3;
+    report[2] = 'a';
+    report[3] = 'b';
+    report[4] = 'c';
+    hid.send(0, report, sizeof(report), 0);
+    while (receiveReport(&hid, ring, 0)) {}
+
+    EXPECT_EQ(opHID_ReportRing::PAYLOAD_MAX + 3, ring->bytesAvailable());
+    EXPECT_EQ(opHID_ReportRing::PAYLOAD_MAX + 3, ring->read(data, sizeof(data)));
+    EXPECT_EQ(0, memcmp("abc", &data[opHID_ReportRing::PAYLOAD_MAX], 3));
+    EXPECT_EQ(0, ring->bytesAvailable());
+}
+
+TEST_F(ReportRing, FullRingHoldsOffTheReader) {
+    char sent[(opHID_ReportRing::REPORTS + 1) * (WRITE_SIZE - 2)];
+    char received[sizeof(sent)];
+
+    for (unsigned int i = 0; i < sizeof(sent); i++) {
+        sent[i] = (char)(i % 251);
+    }
+    sendReports(&hid, sent, sizeof(sent));
+
+    int reports = 0;
+    while (receiveReport(&hid, ring, 0)) {
+        reports++;
+    }
+    EXPECT_EQ(opHID_ReportRing::REPORTS, reports);
+    EXPECT_EQ(NULL, ring->writeSlot());
+
+    // releasing one report makes room for the one left in the device
+    EXPECT_EQ(WRITE_SIZE - 2, ring->read(received, WRITE_SIZE - 2));
+    EXPECT_TRUE(receiveReport(&hid, ring, 0));
+    EXPECT_EQ((qint64)sizeof(sent) - (WRITE_SIZE - 2), ring->read(received + WRITE_SIZE - 2, sizeof(received)));
+    EXPECT_EQ(0, memcmp(sent, received, sizeof(sent)));
+}
+
+// The read thread of RawHID, stopped once it has seen the last report
+struct Producer {
+    FakeHidapi *hid;
+    opHID_ReportRing *ring;
+    int reports;
+};
+
+static void *produce(void *parameters)
+{
+    Producer *producer = (Producer *)parameters;
+    int received = 0;
+
+    while (received < producer->reports) {
+        if (!producer->ring->writeSlot()) {
+            // the reader is behind, let it drain the ring
+            struct timespec wait = { 0, 100000 };
+            nanosleep(&wait, NULL);
+            continue;
+        }
+        if (receiveReport(producer->hid, producer->ring, READ_TIMEOUT)) {
+            received++;
+        }
+    }
+    return NULL;
+}
+
+TEST_F(ReportRing, ThreadedLoopback) {
+    // several times the ring, so the producer has to wait for the reader
+    const int size = 8 * opHID_ReportRing::REPORTS * (WRITE_SIZE - 2) + 17;
+    std::vector<char> sent(size);
+    std::vector<char> received;
+
+    for (int i = 0; i < size; i++) {
+        sent[i] = (char)(rand() & 0xFF);
+    }
+    Producer producer = { &hid, ring, (size + WRITE_SIZE - 3) / (WRITE_SIZE - 2) };
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, produce, &producer));
+
+    sendReports(&hid, sent.data(), size);
+
+    // alternate the copying and the in place reads UAVTalk uses
+    int round = 0;
+    while ((int)received.size() < size) {
+        if (round++ & 1) {
+            char data[100];
+            qint64 got = ring->read(data, sizeof(data));
+            received.insert(received.end(), data, data + got);
+        } else {
+            const char *span;
+            int got = ring->peek(&span);
+            if (got > 0) {
+                got = qMin(got, 13);
+                received.insert(received.end(), span, span + got);
+                ring->consume(got);
+            }
+        }
+        ASSERT_GE(ring->bytesAvailable(), 0);
+    }
+
+    ASSERT_EQ(0, pthread_join(thread, NULL));
+    EXPECT_EQ(size, (int)received.size());
+    EXPECT_TRUE(sent == received);
+    EXPECT_EQ(0, ring->bytesAvailable());
+}
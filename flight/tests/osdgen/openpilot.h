@@ -0,0 +1,9 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,437 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+#include <time.h> /* clock_gettime */
+
+extern "C" {
+#include "osdgen.h"
+
+uint8_t *draw_buffer_level;
+uint8_t *draw_buffer_mask;
+}
+
+#define FRAME_SIZE (GRAPHICS_WIDTH * GRAPHICS_HEIGHT)
+
+// the two buffer pairs the video driver swaps between
+static uint8_t buffer_level[2][FRAME_SIZE] __attribute__((aligned(4)));
+static uint8_t buffer_mask[2][FRAME_SIZE] __attribute__((aligned(4)));
+// frames rendered by the reference rasteriser
+static uint8_t ref_level[FRAME_SIZE];
+static uint8_t ref_mask[FRAME_SIZE];
+
+/*
+ * Reference rasteriser: the straightforward pixel at a time version of each
+ * primitive, with the same coordinate conventions as the optimised one.
+ */
+static void ref_pixel(uint8_t *buff, unsigned int x, unsigned int y, int mode)
+{
+    if (x >= GRAPHICS_WIDTH_REAL || y >= GRAPHICS_HEIGHT_REAL) {
+        return;
+    }
+    uint8_t mask = 0x80 >> (x & 7);
+    uint8_t *p   = &buff[y * GRAPHICS_WIDTH + x / 8];
+    switch (mode) {
+    case 0: *p &= ~mask; break;
+    case 1: *p |= mask; break;
+    case 2: *p ^= mask; break;
+    }
+}
+
+static void ref_hline(uint8_t *buff, unsigned int x0, unsigned int x1, unsigned int y, int mode)
+{
+    x0 = MIN(x0, GRAPHICS_WIDTH_REAL - 1);
+    x1 = MIN(x1, GRAPHICS_WIDTH_REAL - 1);
+    y  = MIN(y, GRAPHICS_HEIGHT_REAL - 1);
+    if (x0 > x1) {
+        SWAP(x0, x1);
+    }
+    if (x0 == x1) {
+        return;
+    }
+    for (unsigned int x = x0; x <= x1; x++) {
+        ref_pixel(buff, x, y, mode);
+    }
+}
+
+static void ref_rectangle(uint8_t *buff, unsigned int x, unsigned int y, unsigned int width, unsigned int height, int mode)
+{
+    if (x + width >= GRAPHICS_WIDTH_REAL || y + height >= GRAPHICS_HEIGHT_REAL || !width || !height) {
+        return;
+    }
+    for (unsigned int yy = y; yy < y + height; yy++) {
+        for (unsigned int xx = x; xx <= x + width; xx++) {
+            ref_pixel(buff, xx, yy, mode);
+        }
+    }
+}
+
+static void ref_line(uint8_t *buff, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, int mode)
+{
+    unsigned int steep = abs((int)(y1 - y0)) > abs((int)(x1 - x0));
+
+    if (steep) {
+        SWAP(x0, y0);
+        SWAP(x1, y1);
+    }
+    if (x0 > x1) {
+        SWAP(x0, x1);
+        SWAP(y0, y1);
+    }
+    int deltax = x1 - x0;
+    int deltay = abs((int)(y1 - y0));
+    int error  = deltax / 2;
+    int ystep  = (y0 < y1) ? 1 : -1;
+    unsigned int y = y0;
+    for (unsigned int x = x0; x < x1; x++) {
+        if (steep) {
+            ref_pixel(buff, y, x, mode);
+        } else {
+            ref_pixel(buff, x, y, mode);
+        }
+        error -= deltay;
+        if (error < 0) {
+            y     += ystep;
+            error += deltax;
+        }
+    }
+}
+
+static void ref_circle_filled(uint8_t *buff, unsigned int cx, unsigned int cy, unsigned int r, int mode)
+{
+    int error = -r, x = r, y = 0, xch = 0;
+
+    while (x >= y) {
+        if (y != 0) {
+            ref_hline(buff, cx - x, cx + x, cy + y, mode);
+            ref_hline(buff, cx - x, cx + x, cy - y, mode);
+            if (mode != 2 || (xch && (cx - x) != (cx - y))) {
+                ref_hline(buff, cx - y, cx + y, cy + x, mode);
+                ref_hline(buff, cx - y, cx + y, cy - x, mode);
+                xch = 0;
+            }
+        }
+        error += (y * 2) + 1;
+        y++;
+        if (error >= 0) {
+            --x;
+            xch    = 1;
+            error -= x * 2;
+        }
+    }
+    if (mode == 2) {
+        ref_hline(buff, cx - r, cx + r, cy, mode);
+    }
+}
+
+// Outlined 8 pixel wide fonts: mask rows followed by level rows for each glyph
+static void ref_char(char ch, unsigned int x, unsigned int y, int flags, int font)
+{
+    struct FontEntry font_info;
+    char lookup = 0;
+
+    if (!fetch_font_info(ch, font, &font_info, &lookup)) {
+        return;
+    }
+    unsigned int row = lookup * font_info.height * 2;
+    for (unsigned int yy = 0; yy < font_info.height; yy++, row++) {
+        uint8_t mask   = font_info.data[row];
+        uint8_t levels = font_info.data[row + font_info.height];
+        if (!(flags & FONT_INVERT)) {
+            levels = ~levels;
+        }
+        for (unsigned int i = 0; i < font_info.width; i++) {
+            uint8_t bit = 1 << (font_info.width - 1 - i);
+            if (mask & bit) {
+                ref_pixel(draw_buffer_mask, x + i, y + yy, 1);
+                ref_pixel(draw_buffer_level, x + i, y + yy, (levels & bit) ? 0 : 1);
+            }
+        }
+    }
+}
+
+static void select_buffers(uint8_t *level, uint8_t *mask)
+{
+    draw_buffer_level = level;
+    draw_buffer_mask  = mask;
+}
+
+static uint32_t frame_hash(const uint8_t *level, const uint8_t *mask)
+{
+    // FNV-1a over both planes
+    uint32_t hash = 2166136261u;
+
+    for (int i = 0; i < FRAME_SIZE; i++) {
+        hash = (hash ^ level[i]) * 16777619u;
+        hash = (hash ^ mask[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Write a frame as a binary PGM: transparent pixels grey, black and
+ * white pixels as they appear over the video.
+ */
+static void dump_pgm(const char *name, const uint8_t *level, const uint8_t *mask)
+{
+    const char *dir = getenv("OSD_PGM_DIR");
+    char path[256];
+
+    if (!dir) {
+        return;
+    }
+    snprintf(path, sizeof(path), "%s/%s.pgm", dir, name);
+    FILE *f = fopen(path, "wb");
+    ASSERT_TRUE(f != NULL);
+    fprintf(f, "P5\n%d %d\n255\n", GRAPHICS_WIDTH_REAL, GRAPHICS_HEIGHT_REAL);
+    for (int i = 0; i < FRAME_SIZE * 8; i++) {
+        uint8_t bit = 0x80 >> (i & 7);
+        uint8_t pixel = 128;
+        if (mask[i / 8] & bit) {
+            pixel = (level[i / 8] & bit) ? 255 : 0;
+        }
+        fputc(pixel, f);
+    }
+    fclose(f);
+}
+
+/*
+ * The primitives covered by the reference rasteriser. The frame number
+ * moves things around like live telemetry would.
+ */
+static void draw_primitives(int frame)
+{
+    int dx = frame % 23;
+
+    write_filled_rectangle_lm(100 + dx, 40, 57, 20, 1, 1);
+    write_filled_rectangle(draw_buffer_mask, 203, 41, 3, 30, 1);
+    write_filled_rectangle(draw_buffer_level, 90, 50, 200, 5, 2);
+    write_hline_lm(81, 82, 100, 1, 1);
+    write_hline_lm(300 - dx, 100 + dx, 102, 1, 1);
+    write_hline(draw_buffer_level, 120, 400, 104, 2);
+    for (int a = 0; a < 24; a++) {
+        int x = (a * 37 + dx * 5) % 200;
+        int y = (a * 53 + dx * 3) % 120;
+        write_line_lm(160, 150, 100 + x, 100 + y, 1, a & 1);
+    }
+    write_line(draw_buffer_mask, 395, 10, 405, 260, 2);
+    write_line(draw_buffer_mask, 400, 200, 430, 205, 1);
+    write_circle_filled(draw_buffer_mask, 300, 200, 20 + dx, 1);
+    write_circle_filled(draw_buffer_level, 300, 200, 15, 2);
+    for (int i = 0; i < 16; i++) {
+        write_char('0' + i, 90 + i * 9 + dx, 230, i & FONT_INVERT, i & 1);
+    }
+}
+
+static void ref_primitives(int frame)
+{
+    int dx = frame % 23;
+
+    ref_rectangle(draw_buffer_mask, 100 + dx, 40, 57, 20, 1);
+    ref_rectangle(draw_buffer_level, 100 + dx, 40, 57, 20, 1);
+    ref_rectangle(draw_buffer_mask, 203, 41, 3, 30, 1);
+    ref_rectangle(draw_buffer_level, 90, 50, 200, 5, 2);
+    ref_hline(draw_buffer_level, 81, 82, 100, 1);
+    ref_hline(draw_buffer_mask, 81, 82, 100, 1);
+    ref_hline(draw_buffer_level, 300 - dx, 100 + dx, 102, 1);
+    ref_hline(draw_buffer_mask, 300 - dx, 100 + dx, 102, 1);
+    ref_hline(draw_buffer_level, 120, 400, 104, 2);
+    for (int a = 0; a < 24; a++) {
+        int x = (a * 37 + dx * 5) % 200;
+        int y = (a * 53 + dx * 3) % 120;
+        ref_line(draw_buffer_mask, 160, 150, 100 + x, 100 + y, 1);
+        ref_line(draw_buffer_level, 160, 150, 100 + x, 100 + y, a & 1);
+    }
+    ref_line(draw_buffer_mask, 395, 10, 405, 260, 2);
+    ref_line(draw_buffer_mask, 400, 200, 430, 205, 1);
+    ref_circle_filled(draw_buffer_mask, 300, 200, 20 + dx, 1);
+    ref_circle_filled(draw_buffer_level, 300, 200, 15, 2);
+    for (int i = 0; i < 16; i++) {
+        ref_char('0' + i, 90 + i * 9 + dx, 230, i & FONT_INVERT, i & 1);
+    }
+}
+
+// A full HUD-like frame, including the primitives without a reference
+static void draw_hud(int frame)
+{
+    char text[32];
+
+    draw_primitives(frame);
+    write_rectangle_outlined(100, 20, 150, 120, 0, 1);
+    write_circle_outlined(250, 120, 30, 0, 1, 0, 1);
+    write_circle(draw_buffer_mask, 250, 120, 40, 4, 1);
+    write_line_outlined(120, 200, 280, 160 + frame % 40, 0, 0, 1, 1);
+    snprintf(text, sizeof(text), "ALT %4d", frame);
+    write_string(text, 380, 20, 0, 0, TEXT_VA_TOP, TEXT_HA_RIGHT, 0, 3);
+    write_string(text, 90, 250, 1, 0, TEXT_VA_BOTTOM, TEXT_HA_LEFT, 0, 2);
+    write_string(text, 240, 180, 1, 0, TEXT_VA_MIDDLE, TEXT_HA_CENTER, 0, 0);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class OsdRenderTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        // make the renderer forget the buffers of the previous test
+        select_buffers(ref_level, ref_mask);
+        clearGraphics();
+        select_buffers(ref_mask, ref_level);
+        clearGraphics();
+
+        memset(buffer_level, 0x55, sizeof(buffer_level));
+        memset(buffer_mask, 0xaa, sizeof(buffer_mask));
+        current = 0;
+        select_buffers(buffer_level[0], buffer_mask[0]);
+    }
+
+    // what the vsync interrupt does every second field
+    void swap()
+    {
+        current ^= 1;
+        select_buffers(buffer_level[current], buffer_mask[current]);
+    }
+
+    void render_reference(void (*draw)(int), int frame)
+    {
+        uint8_t *level = draw_buffer_level;
+        uint8_t *mask  = draw_buffer_mask;
+
+        memset(ref_level, 0, sizeof(ref_level));
+        memset(ref_mask, 0, sizeof(ref_mask));
+        select_buffers(ref_level, ref_mask);
+        draw(frame);
+        select_buffers(level, mask);
+    }
+
+    int current;
+};
+
+TEST_F(OsdRenderTest, HlineSpans) {
+    // every start and end bit, within one byte and across several
+    for (unsigned int x0 = 96; x0 < 112; x0++) {
+        for (unsigned int x1 = x0; x1 < x0 + 80; x1++) {
+            for (int mode = 0; mode < 3; mode++) {
+                memset(ref_level, 0x5a, sizeof(ref_level));
+                memset(draw_buffer_level, 0x5a, FRAME_SIZE);
+                ref_hline(ref_level, x0, x1, 10, mode);
+                write_hline(draw_buffer_level, x1, x0, 10, mode);
+                ASSERT_EQ(0, memcmp(ref_level, draw_buffer_level, FRAME_SIZE)) << x0 << " " << x1 << " " << mode;
+            }
+        }
+    }
+}
+
+TEST_F(OsdRenderTest, LineRuns) {
+    for (int a = 0; a < 360; a += 3) {
+        int x1 = 200 + (a * 7919) % 250 - 125;
+        int y1 = 130 + (a * 104729) % 160 - 80;
+        memset(ref_mask, 0, sizeof(ref_mask));
+        memset(draw_buffer_mask, 0, FRAME_SIZE);
+        ref_line(ref_mask, 200, 130, x1, y1, 2);
+        write_line(draw_buffer_mask, 200, 130, x1, y1, 2);
+        ASSERT_EQ(0, memcmp(ref_mask, draw_buffer_mask, FRAME_SIZE)) << x1 << " " << y1;
+    }
+}
+
+TEST_F(OsdRenderTest, GlyphOffsets) {
+    for (unsigned int x = 96; x < 104; x++) {
+        for (int flags = 0; flags <= FONT_INVERT; flags += FONT_INVERT) {
+            memset(ref_level, 0, sizeof(ref_level));
+            memset(ref_mask, 0, sizeof(ref_mask));
+            select_buffers(ref_level, ref_mask);
+            ref_char('A', x, 30, flags, 0);
+            select_buffers(buffer_level[0], buffer_mask[0]);
+            memset(draw_buffer_level, 0, FRAME_SIZE);
+            memset(draw_buffer_mask, 0, FRAME_SIZE);
+            write_char('A', x, 30, flags, 0);
+            ASSERT_EQ(0, memcmp(ref_level, draw_buffer_level, FRAME_SIZE)) << x;
+            ASSERT_EQ(0, memcmp(ref_mask, draw_buffer_mask, FRAME_SIZE)) << x;
+        }
+    }
+}
+
+TEST_F(OsdRenderTest, MatchesReference) {
+    clearGraphics();
+    draw_primitives(7);
+    render_reference(ref_primitives, 7);
+    dump_pgm("osdgen_reference", ref_level, ref_mask);
+    dump_pgm("osdgen_primitives", draw_buffer_level, draw_buffer_mask);
+
+    EXPECT_EQ(0, memcmp(ref_level, draw_buffer_level, FRAME_SIZE));
+    EXPECT_EQ(0, memcmp(ref_mask, draw_buffer_mask, FRAME_SIZE));
+}
+
+TEST_F(OsdRenderTest, GoldenFrame) {
+    clearGraphics();
+    draw_hud(42);
+    dump_pgm("osdgen_hud", draw_buffer_level, draw_buffer_mask);
+
+    EXPECT_EQ(0xba81be74u, frame_hash(draw_buffer_level, draw_buffer_mask));
+}
+
+TEST_F(OsdRenderTest, DirtyClearMatchesFullClear) {
+    // animate for a while, each frame must look as if drawn on a blank buffer
+    for (int frame = 0; frame < 60; frame++) {
+        clearGraphics();
+        draw_hud(frame);
+        render_reference(draw_hud, frame);
+        ASSERT_EQ(0, memcmp(ref_level, draw_buffer_level, FRAME_SIZE)) << frame;
+        ASSERT_EQ(0, memcmp(ref_mask, draw_buffer_mask, FRAME_SIZE)) << frame;
+        swap();
+    }
+}
+
+TEST_F(OsdRenderTest, SwapWhileDrawing) {
+    clearGraphics();
+    write_filled_rectangle_lm(100, 100, 20, 20, 1, 1);
+    swap();
+    clearGraphics();
+    write_filled_rectangle_lm(100, 100, 20, 20, 1, 1);
+    // the frame overruns, the next one starts drawing in the old buffer
+    swap();
+    write_line_lm(300, 10, 390, 250, 1, 1);
+    swap();
+    swap();
+
+    // nothing is known about what was drawn, the buffer must be fully cleared
+    clearGraphics();
+    for (int i = 0; i < FRAME_SIZE; i++) {
+        ASSERT_EQ(0, draw_buffer_level[i]);
+        ASSERT_EQ(0, draw_buffer_mask[i]);
+    }
+}
+
+static double elapsed(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+#define BENCHMARK_FRAMES 2000
+
+TEST_F(OsdRenderTest, Benchmark) {
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        memset(ref_level, 0, sizeof(ref_level));
+        memset(ref_mask, 0, sizeof(ref_mask));
+        select_buffers(ref_level, ref_mask);
+        ref_primitives(frame);
+    }
+    double reference = BENCHMARK_FRAMES / elapsed(&start);
+
+    select_buffers(buffer_level[0], buffer_mask[0]);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        clearGraphics();
+        draw_primitives(frame);
+        swap();
+    }
+    double optimised = BENCHMARK_FRAMES / elapsed(&start);
+
+    printf("osd render: reference %.0f frames/s, word parallel with dirty clear %.0f frames/s\n", reference, optimised);
+}
@@ -0,0 +1,12 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* as configured by the boards with an RFM22B */
+#define RS_ECC_NPARITY 4
+
+#endif /* OPENPILOT_H */
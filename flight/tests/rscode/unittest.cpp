@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+#include <time.h> /* clock_gettime */
+
+extern "C" {
+#include "ecc.h"
+#include "rs255.h"
+}
+
+/* largest packet the RFM22B driver sends */
+#define PACKET_LEN        64
+#define DATA_LEN          (PACKET_LEN - RS_ECC_NPARITY)
+#define RANDOM_PACKETS    20000
+#define BENCHMARK_PACKETS 200000
+
+// To use a test fixture, derive a class from testing::Test.
+class RsCodeTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        initialize_ecc();
+        rs255_init();
+        srand(1);
+    }
+
+    void randomMessage(uint8_t *msg, int len)
+    {
+        for (int i = 0; i < len; i++) {
+            msg[i] = rand();
+        }
+    }
+
+    // flip nerrors distinct bytes, each to a different value
+    void injectErrors(uint8_t *codeword, int len, int nerrors)
+    {
+        int positions[RS_ECC_NPARITY * 2];
+
+        for (int e = 0; e < nerrors; e++) {
+            bool fresh;
+            do {
+                positions[e] = rand() % len;
+                fresh = true;
+                for (int i = 0; i < e; i++) {
+                    fresh &= positions[i] != positions[e];
+                }
+            } while (!fresh);
+            codeword[positions[e]] ^= 1 + rand() % 255;
+        }
+    }
+
+    // the generic codec as the RFM22B driver used it
+    int referenceDecode(uint8_t *codeword, int len)
+    {
+        decode_data(codeword, len);
+        if (check_syndrome() == 0) {
+            return 0;
+        }
+        return correct_errors_erasures(codeword, len, 0, 0) ? 1 : -1;
+    }
+};
+
+TEST_F(RsCodeTest, EncodeMatchesReference) {
+    uint8_t msg[255];
+    uint8_t reference[255];
+    uint8_t codeword[255];
+
+    for (int len = 1; len <= 255 - RS_ECC_NPARITY; len++) {
+        randomMessage(msg, len);
+        encode_data(msg, len, reference);
+        memcpy(codeword, msg, len);
+        rs255_encode(codeword, len);
+        ASSERT_EQ(0, memcmp(reference, codeword, len + RS_ECC_NPARITY)) << "len " << len;
+    }
+}
+
+TEST_F(RsCodeTest, CleanPacket) {
+    uint8_t codeword[PACKET_LEN];
+
+    randomMessage(codeword, DATA_LEN);
+    rs255_encode(codeword, DATA_LEN);
+    EXPECT_EQ(0, rs255_decode(codeword, PACKET_LEN));
+}
+
+TEST_F(RsCodeTest, CorrectsUpToHalfParity) {
+    uint8_t msg[255];
+    uint8_t codeword[255];
+
+    for (int n = 0; n < RANDOM_PACKETS; n++) {
+        int len     = RS_ECC_NPARITY + 1 + rand() % (255 - RS_ECC_NPARITY);
+        int nerrors = 1 + rand() % (RS_ECC_NPARITY / 2);
+
+        randomMessage(msg, len - RS_ECC_NPARITY);
+        memcpy(codeword, msg, len - RS_ECC_NPARITY);
+        rs255_encode(codeword, len - RS_ECC_NPARITY);
+        memcpy(msg, codeword, len);
+        injectErrors(codeword, len, nerrors);
+
+        ASSERT_EQ(nerrors, rs255_decode(codeword, len)) << "len " << len;
+        ASSERT_EQ(0, memcmp(msg, codeword, len));
+    }
+}
+
+TEST_F(RsCodeTest, AgreesWithReference) {
+    uint8_t msg[PACKET_LEN];
+    uint8_t codeword[PACKET_LEN];
+    uint8_t reference[PACKET_LEN];
+    int miscorrected = 0;
+    int rejected     = 0;
+
+    for (int n = 0; n < RANDOM_PACKETS; n++) {
+        int nerrors = rand() % (RS_ECC_NPARITY + 2);
+
+        randomMessage(msg, DATA_LEN);
+        rs255_encode(msg, DATA_LEN);
+        memcpy(codeword, msg, PACKET_LEN);
+        injectErrors(codeword, PACKET_LEN, nerrors);
+        memcpy(reference, codeword, PACKET_LEN);
+
+        int result   = rs255_decode(codeword, PACKET_LEN);
+        int expected = referenceDecode(reference, PACKET_LEN);
+
+        if (nerrors <= RS_ECC_NPARITY / 2) {
+            // within the correction capability both must restore the packet
+            ASSERT_EQ(nerrors, result);
+            ASSERT_EQ(nerrors ? 1 : 0, expected);
+            ASSERT_EQ(0, memcmp(msg, codeword, PACKET_LEN));
+            ASSERT_EQ(0, memcmp(msg, reference, PACKET_LEN));
+        } else if (result > 0) {
+            // beyond it a claimed correction must at least be a valid codeword
+            uint8_t check[PACKET_LEN];
+            memcpy(check, codeword, DATA_LEN);
+            rs255_encode(check, DATA_LEN);
+            ASSERT_EQ(0, memcmp(check, codeword, PACKET_LEN));
+            // and the reference must not have rejected a packet we accept
+            ASSERT_EQ(1, expected);
+            miscorrected++;
+        } else {
+            ASSERT_EQ(-1, result);
+            rejected++;
+        }
+    }
+    printf("rs255: %d packets beyond capability rejected, %d miscorrected\n", rejected, miscorrected);
+}
+
+static double elapsed(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+TEST_F(RsCodeTest, Benchmark) {
+    static uint8_t packets[16][PACKET_LEN];
+    struct timespec start;
+    volatile int sink = 0;
+
+    for (int i = 0; i < 16; i++) {
+        randomMessage(packets[i], DATA_LEN);
+        rs255_encode(packets[i], DATA_LEN);
+    }
+
+    // one in four packets carries a single byte error, as on a marginal link
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < BENCHMARK_PACKETS; n++) {
+        uint8_t *p = packets[n & 15];
+        encode_data(p, DATA_LEN, p);
+        if ((n & 3) == 0) {
+            p[n % PACKET_LEN] ^= 0x5a;
+        }
+        sink += referenceDecode(p, PACKET_LEN);
+    }
+    double reference = BENCHMARK_PACKETS / elapsed(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < BENCHMARK_PACKETS; n++) {
+        uint8_t *p = packets[n & 15];
+        rs255_encode(p, DATA_LEN);
+        if ((n & 3) == 0) {
+            p[n % PACKET_LEN] ^= 0x5a;
+        }
+        sink += rs255_decode(p, PACKET_LEN);
+    }
+    double optimised = BENCHMARK_PACKETS / elapsed(&start);
+
+    printf("rs255: reference %.0f packets/s, table driven %.0f packets/s\n", reference, optimised);
+    EXPECT_EQ(BENCHMARK_PACKETS / 4 * 2, sink);
+}
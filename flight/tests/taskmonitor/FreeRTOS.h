@@ -0,0 +1,27 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef void *xTaskHandle;
+typedef void *xSemaphoreHandle;
+typedef long (*pdTASK_HOOK_CODE)(void *);
+
+#define portMAX_DELAY 0xffffffff
+#define configGENERATE_RUN_TIME_STATS 0
+
+/* normally set by the board FreeRTOSConfig.h */
+#define PIOS_TASK_MONITOR_SCHEDULER_HOOKS
+
+/* single threaded test, no locking needed */
+#define xSemaphoreCreateRecursiveMutex() ((xSemaphoreHandle)1)
+#define xSemaphoreTakeRecursive(sem, ticks) do {} while (0)
+#define xSemaphoreGiveRecursive(sem)        do {} while (0)
+#define portENTER_CRITICAL()                do {} while (0)
+#define portEXIT_CRITICAL()                 do {} while (0)
+
+void vTaskSetApplicationTaskTag(xTaskHandle task, pdTASK_HOOK_CODE tag);
+unsigned long uxTaskGetStackHighWaterMark(xTaskHandle task);
+
+#endif /* FREERTOS_H */
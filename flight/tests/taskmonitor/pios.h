@@ -0,0 +1,22 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+#ifdef PIOS_INCLUDE_FREERTOS
+/* FreeRTOS Includes */
+#include "FreeRTOS.h"
+#endif
+#include "pios_mem.h"
+#include <pios_delay.h>
+
+#ifdef PIOS_INCLUDE_TASK_MONITOR
+#include <pios_task_monitor.h>
+#endif
+
+#endif /* PIOS_H */
@@ -0,0 +1,9 @@
+#ifndef PIOS_CONFIG_H
+#define PIOS_CONFIG_H
+
+/* Enable/Disable PiOS modules */
+#define PIOS_INCLUDE_FREERTOS
+#define PIOS_INCLUDE_TASK_MONITOR
+#define PIOS_INCLUDE_TRACEBUFFER
+
+#endif /* PIOS_CONFIG_H */
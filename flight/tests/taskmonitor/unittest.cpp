@@ -0,0 +1,234 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+
+extern "C" {
+#include "pios.h"
+#include "pios_tracebuffer.h"
+
+#define MAX_TASKS 4
+
+// a 168 MHz cycle counter, it wraps every 25.5 s
+#define UT_TICKS_PER_US 168
+
+static uint32_t ut_time = 0; // us
+static uint32_t ut_raw_offset = 0; // raw ticks at ut_time 0
+static int ut_tcb[MAX_TASKS];
+static void *ut_tag[MAX_TASKS];
+
+uint32_t PIOS_DELAY_GetRaw()
+{
+    return ut_raw_offset + ut_time * UT_TICKS_PER_US;
+}
+
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later)
+{
+    return (later - raw) / UT_TICKS_PER_US;
+}
+
+void vTaskSetApplicationTaskTag(xTaskHandle task, pdTASK_HOOK_CODE tag)
+{
+    ut_tag[(int *)task - ut_tcb] = (void *)tag;
+}
+
+unsigned long uxTaskGetStackHighWaterMark(__attribute__((unused)) xTaskHandle task)
+{
+    return 100;
+}
+}
+
+static struct pios_task_info infos[MAX_TASKS];
+
+static void collect(uint16_t task_id, const struct pios_task_info *task_info, __attribute__((unused)) void *context)
+{
+    infos[task_id] = *task_info;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class TaskMonitorTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        ut_time = 0;
+        ASSERT_EQ(0, PIOS_TASK_MONITOR_Initialize(MAX_TASKS));
+        for (int i = 0; i < MAX_TASKS; i++) {
+            ASSERT_EQ(0, PIOS_TASK_MONITOR_RegisterTask(i, (xTaskHandle)&ut_tcb[i]));
+        }
+        // start out in an unmonitored task, e.g. idle
+        PIOS_TASK_MONITOR_TaskSwitchedIn(NULL);
+        sample();
+    }
+
+    void sample()
+    {
+        memset(infos, 0, sizeof(infos));
+        PIOS_TASK_MONITOR_ForEachTask(collect, NULL);
+    }
+
+    // switch from the current task to the given one at the current time
+    void switchTo(int from, int to, bool fromStillReady)
+    {
+        PIOS_TASK_MONITOR_TaskSwitchedOut(from < 0 ? NULL : ut_tag[from], fromStillReady);
+        PIOS_TASK_MONITOR_TaskSwitchedIn(to < 0 ? NULL : ut_tag[to]);
+    }
+};
+
+TEST_F(TaskMonitorTest, RegisterSetsTag) {
+    for (int i = 0; i < MAX_TASKS; i++) {
+        EXPECT_EQ((uintptr_t)(i + 1), (uintptr_t)ut_tag[i]);
+    }
+}
+
+TEST_F(TaskMonitorTest, LoadAndSlices) {
+    switchTo(-1, 0, false);
+    ut_time = 300;
+    switchTo(0, 1, false);
+    ut_time = 400;
+    switchTo(1, -1, false);
+    ut_time = 600;
+    switchTo(-1, 1, false);
+    ut_time = 700;
+    switchTo(1, -1, false);
+    ut_time = 1000;
+    sample();
+
+    EXPECT_EQ(3000, infos[0].load);
+    EXPECT_EQ(2000, infos[1].load);
+    EXPECT_EQ(0, infos[2].load);
+    EXPECT_EQ(300u, infos[0].max_slice_us);
+    EXPECT_EQ(100u, infos[1].max_slice_us);
+
+    // maxima are per sample interval
+    ut_time = 2000;
+    sample();
+    EXPECT_EQ(0, infos[0].load);
+    EXPECT_EQ(0u, infos[0].max_slice_us);
+}
+
+TEST_F(TaskMonitorTest, RunningTaskCounted) {
+    switchTo(-1, 2, false);
+    ut_time = 1000;
+    sample();
+    EXPECT_EQ(10000, infos[2].load);
+}
+
+TEST_F(TaskMonitorTest, LatencyAndPreemption) {
+    switchTo(-1, 1, false);
+    ut_time = 100;
+    // task 0 wakes up and preempts task 1 50us later
+    PIOS_TASK_MONITOR_TaskReady(ut_tag[0]);
+    ut_time = 150;
+    switchTo(1, 0, true);
+    ut_time = 200;
+    // task 0 blocks, task 1 gets the cpu back
+    switchTo(0, 1, false);
+    ut_time = 1000;
+    sample();
+
+    EXPECT_EQ(50u, infos[0].max_latency_us);
+    EXPECT_EQ(0, infos[0].preemptions);
+    EXPECT_EQ(50u, infos[1].max_latency_us);
+    EXPECT_EQ(1, infos[1].preemptions);
+}
+
+TEST_F(TaskMonitorTest, ReselectIsNoPreemption) {
+    switchTo(-1, 0, false);
+    ut_time = 100;
+    // tick with nothing else ready, the same task keeps running
+    switchTo(0, 0, true);
+    // a priority change re-inserts the running task into the ready list
+    PIOS_TASK_MONITOR_TaskReady(ut_tag[0]);
+    ut_time = 1000;
+    sample();
+
+    EXPECT_EQ(0, infos[0].preemptions);
+    EXPECT_EQ(0u, infos[0].max_latency_us);
+    EXPECT_EQ(10000, infos[0].load);
+}
+
+TEST_F(TaskMonitorTest, LongWindow) {
+    // fully loaded for four intervals, idle for four
+    switchTo(-1, 3, false);
+    for (int i = 1; i <= 4; i++) {
+        ut_time = 1000 * i;
+        sample();
+        EXPECT_EQ(10000, infos[3].load);
+        EXPECT_EQ(10000, infos[3].load_avg);
+    }
+    switchTo(3, -1, false);
+    for (int i = 5; i <= 8; i++) {
+        ut_time = 1000 * i;
+        sample();
+        EXPECT_EQ(0, infos[3].load);
+    }
+    EXPECT_EQ(5000, infos[3].load_avg);
+
+    // the busy intervals slide out of the window
+    for (int i = 9; i <= 12; i++) {
+        ut_time = 1000 * i;
+        sample();
+    }
+    EXPECT_EQ(0, infos[3].load_avg);
+}
+
+TEST_F(TaskMonitorTest, TaskSwitchTraced) {
+    pios_tracebuffer_event_t events[3];
+
+    // replaces the trace buffer's own switch hook, the id comes from the task tag
+    ASSERT_EQ(0, PIOS_TRACEBUFFER_Init(16));
+    PIOS_TRACEBUFFER_Start();
+    switchTo(-1, 2, false);
+    ut_time = 100;
+    switchTo(2, -1, false);
+    ut_time = 200;
+    switchTo(-1, 0, false);
+    PIOS_TRACEBUFFER_Stop();
+
+    ASSERT_EQ(3, PIOS_TRACEBUFFER_Read(0, events, 3));
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(PIOS_TRACEBUFFER_EVENT_TASK_SWITCH, events[i].type);
+    }
+    EXPECT_EQ(2, events[0].id);
+    EXPECT_EQ(PIOS_TRACEBUFFER_ID_UNKNOWN, events[1].id);
+    EXPECT_EQ(0, events[2].id);
+    EXPECT_EQ(100u * UT_TICKS_PER_US, events[1].timestamp - events[0].timestamp);
+    free(pios_tracebuffer_events);
+    pios_tracebuffer_events = NULL;
+}
+
+// the raw timer wraps 500 us into the test
+class TaskMonitorWrapTest : public TaskMonitorTest {
+protected:
+    virtual void SetUp()
+    {
+        ut_raw_offset = 0u - 500 * UT_TICKS_PER_US;
+        TaskMonitorTest::SetUp();
+    }
+
+    virtual void TearDown()
+    {
+        ut_raw_offset = 0;
+    }
+};
+
+TEST_F(TaskMonitorWrapTest, IntervalsAcrossTheWrap) {
+    switchTo(-1, 1, false);
+    ut_time = 400;
+    // task 0 wakes up before the wrap and preempts task 1 after it
+    PIOS_TASK_MONITOR_TaskReady(ut_tag[0]);
+    ut_time = 600;
+    switchTo(1, 0, true);
+    ut_time = 900;
+    switchTo(0, 1, false);
+    ut_time = 1000;
+    sample();
+
+    EXPECT_EQ(200u, infos[0].max_latency_us);
+    EXPECT_EQ(300u, infos[0].max_slice_us);
+    EXPECT_EQ(600u, infos[1].max_slice_us);
+    EXPECT_EQ(3000, infos[0].load);
+    EXPECT_EQ(7000, infos[1].load);
+    EXPECT_EQ(7000, infos[1].load_avg);
+}
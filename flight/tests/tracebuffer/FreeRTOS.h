@@ -0,0 +1,9 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef void *xTaskHandle;
+
+#endif /* FREERTOS_H */
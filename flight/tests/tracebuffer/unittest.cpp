@@ -0,0 +1,135 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+#include <pthread.h>
+
+extern "C" {
+#include "pios.h"
+#include "pios_delay.h"
+#include "pios_tracebuffer.h"
+
+static uint32_t ut_time = 0;
+
+uint32_t PIOS_DELAY_GetRaw()
+{
+    return ut_time;
+}
+}
+
+#define RING_SIZE 512
+
+// To use a test fixture, derive a class from testing::Test.
+class TraceBufferTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        free(pios_tracebuffer_events);
+        ut_time = 0;
+        // not a power of two, must be rounded down
+        ASSERT_EQ(0, PIOS_TRACEBUFFER_Init(RING_SIZE + RING_SIZE / 2));
+    }
+
+    void record(uint16_t n)
+    {
+        for (uint16_t i = 0; i < n; i++) {
+            ut_time += 10;
+            PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_CALLBACK_START, i);
+        }
+    }
+};
+
+TEST_F(TraceBufferTest, IdleUntilStarted) {
+    record(10);
+    EXPECT_EQ(0, PIOS_TRACEBUFFER_Count());
+    EXPECT_FALSE(PIOS_TRACEBUFFER_IsRunning());
+}
+
+TEST_F(TraceBufferTest, ReadInOrder) {
+    pios_tracebuffer_event_t events[20];
+
+    PIOS_TRACEBUFFER_Start();
+    record(10);
+    EXPECT_EQ(10, PIOS_TRACEBUFFER_Count());
+    EXPECT_EQ(0u, PIOS_TRACEBUFFER_Dropped());
+
+    ASSERT_EQ(10, PIOS_TRACEBUFFER_Read(0, events, 20));
+    for (uint16_t i = 0; i < 10; i++) {
+        EXPECT_EQ(i, events[i].id);
+        EXPECT_EQ(PIOS_TRACEBUFFER_EVENT_CALLBACK_START, events[i].type);
+        EXPECT_EQ(10u * (i + 1), events[i].timestamp);
+    }
+
+    // reads past the end return nothing, partial reads are clipped
+    EXPECT_EQ(0, PIOS_TRACEBUFFER_Read(10, events, 20));
+    ASSERT_EQ(3, PIOS_TRACEBUFFER_Read(7, events, 20));
+    EXPECT_EQ(7, events[0].id);
+}
+
+TEST_F(TraceBufferTest, WrapKeepsNewest) {
+    pios_tracebuffer_event_t events[30];
+
+    PIOS_TRACEBUFFER_Start();
+    record(RING_SIZE + 100);
+    EXPECT_EQ(RING_SIZE, PIOS_TRACEBUFFER_Count());
+    EXPECT_EQ(100u, PIOS_TRACEBUFFER_Dropped());
+
+    // page through the ring the way the UAVObject download does
+    uint16_t expected = 100;
+    for (uint16_t index = 0; index < RING_SIZE;) {
+        uint16_t count = PIOS_TRACEBUFFER_Read(index, events, 30);
+        ASSERT_GT(count, 0);
+        for (uint16_t i = 0; i < count; i++) {
+            EXPECT_EQ(expected, events[i].id);
+            expected++;
+        }
+        index += count;
+    }
+    EXPECT_EQ(RING_SIZE + 100, expected);
+}
+
+TEST_F(TraceBufferTest, StopFreezesStartClears) {
+    PIOS_TRACEBUFFER_Start();
+    record(10);
+    PIOS_TRACEBUFFER_Stop();
+    record(10);
+    EXPECT_EQ(10, PIOS_TRACEBUFFER_Count());
+
+    PIOS_TRACEBUFFER_Start();
+    EXPECT_EQ(0, PIOS_TRACEBUFFER_Count());
+}
+
+#define WRITER_THREADS 4
+#define WRITER_EVENTS  100000
+
+static void *writer(void *arg)
+{
+    uint16_t id = (uint16_t)(uintptr_t)arg;
+
+    for (uint32_t i = 0; i < WRITER_EVENTS; i++) {
+        PIOS_TRACEBUFFER_Record(PIOS_TRACEBUFFER_EVENT_MARKER_INSTANT, id);
+    }
+    return NULL;
+}
+
+TEST_F(TraceBufferTest, ConcurrentWriters) {
+    pthread_t threads[WRITER_THREADS];
+    pios_tracebuffer_event_t events[RING_SIZE];
+
+    PIOS_TRACEBUFFER_Start();
+    for (uintptr_t i = 0; i < WRITER_THREADS; i++) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, writer, (void *)i));
+    }
+    for (int i = 0; i < WRITER_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // no slot claim may be lost
+    EXPECT_EQ((uint32_t)WRITER_THREADS * WRITER_EVENTS - RING_SIZE, PIOS_TRACEBUFFER_Dropped());
+    ASSERT_EQ(RING_SIZE, PIOS_TRACEBUFFER_Read(0, events, RING_SIZE));
+    for (int i = 0; i < RING_SIZE; i++) {
+        EXPECT_EQ(PIOS_TRACEBUFFER_EVENT_MARKER_INSTANT, events[i].type);
+        EXPECT_LT(events[i].id, WRITER_THREADS);
+    }
+}
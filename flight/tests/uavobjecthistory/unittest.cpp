@@ -0,0 +1,362 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* snprintf */
+#include <stdlib.h> /* rand */
+#include <string.h> /* memcmp */
+#include <unistd.h> /* access, getpid */
+#include <math.h> /* sin, NAN, INFINITY */
+#include <vector>
+
+#include "uavobjecthistorycolumn.h"
+
+#define BLOCK UAVObjectHistoryColumn::BLOCK_SAMPLES
+
+// Samples as the history feeds them, compared bit for bit
+struct Series {
+    std::vector<int64_t> times;
+    std::vector<double> values;
+
+    void add(int64_t time, double value)
+    {
+        times.push_back(time);
+        values.push_back(value);
+    }
+
+    void appendTo(UAVObjectHistoryColumn *column) const
+    {
+        for (size_t i = 0; i < times.size(); i++) {
+            column->append(times[i], values[i]);
+        }
+    }
+
+    // the samples with from <= time <= to
+    Series slice(int64_t from, int64_t to) const
+    {
+        Series result;
+
+        for (size_t i = 0; i < times.size(); i++) {
+            if (times[i] >= from && times[i] <= to) {
+                result.add(times[i], values[i]);
+            }
+        }
+        return result;
+    }
+};
+
+static void expectSame(const Series & expected, const std::vector<int64_t> & times, const std::vector<double> & values)
+{
+    ASSERT_EQ(expected.times.size(), times.size());
+    ASSERT_EQ(expected.values.size(), values.size());
+    EXPECT_TRUE(expected.times == times);
+    // NaN and -0.0 must come back as they went in
+    EXPECT_EQ(0, memcmp(expected.values.data(), values.data(), values.size() * sizeof(double)));
+}
+
+static void expectRange(const UAVObjectHistoryColumn & column, UAVObjectHistorySpill *spill,
+                        const Series & series, int64_t from, int64_t to)
+{
+    std::vector<int64_t> times;
+    std::vector<double> values;
+
+    column.range(from, to, spill, times, values);
+    expectSame(series.slice(from, to), times, values);
+}
+
+// 500 Hz telemetry starting 2015-01-01
+static const int64_t START = 1420070400000LL;
+
+static Series telemetry(int count)
+{
+    Series series;
+
+    for (int i = 0; i < count; i++) {
+        series.add(START + i * 2, 20.0f * (float)sin(i / 50.0));
+    }
+    return series;
+}
+
+static std::string tempName(const char *name)
+{
+    char path[64];
+
+    snprintf(path, sizeof(path), "/tmp/ut_uavobjecthistory-%d-%s", (int)getpid(), name);
+    return path;
+}
+
+class Column : public testing::Test {};
+
+TEST_F(Column, Empty) {
+    UAVObjectHistoryColumn column;
+    std::vector<int64_t> times;
+    std::vector<double> values;
+
+    column.range(INT64_MIN, INT64_MAX, NULL, times, values);
+    EXPECT_TRUE(times.empty());
+    EXPECT_EQ(0u, column.count());
+    EXPECT_EQ(0, column.memory());
+    EXPECT_EQ(0, column.releaseOldest(NULL));
+}
+
+TEST_F(Column, SealsEveryBlock) {
+    UAVObjectHistoryColumn column;
+
+    for (uint32_t i = 1; i <= 3 * BLOCK; i++) {
+        EXPECT_EQ(i % BLOCK == 0, column.append(START + i, i));
+    }
+    EXPECT_EQ(3u * BLOCK, column.count());
+}
+
+TEST_F(Column, ConstantSeriesTakesTwoBitsASample) {
+    UAVObjectHistoryColumn column;
+    Series series;
+
+    for (uint32_t i = 0; i < BLOCK; i++) {
+        series.add(START + i * 10, 1.5);
+    }
+    series.appendTo(&column);
+
+    // 16 bytes for the first sample, 9 bits for the first delta, then
+    // 1 bit of time and 1 of value
+    EXPECT_EQ(16 + (int64_t)(9 + (BLOCK - 1) * 2 + 7) / 8, column.memory());
+    expectRange(column, NULL, series, INT64_MIN, INT64_MAX);
+}
+
+TEST_F(Column, TelemetryRoundTrip) {
+    UAVObjectHistoryColumn column;
+    Series series = telemetry(5 * BLOCK + 100);
+
+    series.appendTo(&column);
+    expectRange(column, NULL, series, INT64_MIN, INT64_MAX);
+    // floats widened to double keep most of their mantissa zero, the
+    // regular times take a bit, less than the raw float and a byte each
+    EXPECT_LT(column.memory(), (int64_t)(series.times.size() * (sizeof(float) + 1)));
+}
+
+TEST_F(Column, IrregularTimesAndValues) {
+    UAVObjectHistoryColumn column;
+    Series series;
+    int64_t time = START;
+
+    srand(1);
+    for (uint32_t i = 0; i < 3 * BLOCK; i++) {
+        // each bit length of the delta of delta, gaps, repeats and going back in time
+        static const int64_t steps[] = { 0, 1, 2, 70, -60, 300, 5000, -4000, 1LL << 40, -(1LL << 40) + 7, 33, 33, 33 };
+        time += steps[rand() % (sizeof(steps) / sizeof(steps[0]))];
+        double value;
+        switch (rand() % 6) {
+        case 0:
+            value = (double)rand() / RAND_MAX * 1e6 - 5e5;
+            break;
+        case 1:
+            value = rand() % 256;
+            break;
+        case 2:
+            value = series.values.empty() ? 0 : series.values.back();
+            break;
+        case 3:
+            value = -0.0;
+            break;
+        case 4:
+            value = (rand() & 1) ? NAN : -INFINITY;
+            break;
+        default:
+            value = 4294967295.0;
+            break;
+        }
+        series.add(time, value);
+    }
+    series.appendTo(&column);
+    expectRange(column, NULL, series, INT64_MIN, INT64_MAX);
+}
+
+TEST_F(Column, PartialRanges) {
+    UAVObjectHistoryColumn column;
+    Series series = telemetry(3 * BLOCK + 10);
+
+    series.appendTo(&column);
+    int64_t last = series.times.back();
+
+    // inside a block, across blocks, into the open block, and off both ends
+    expectRange(column, NULL, series, START + 100, START + 200);
+    expectRange(column, NULL, series, START + 2 * (BLOCK - 3), START + 2 * (2 * BLOCK + 3));
+    expectRange(column, NULL, series, START + 2 * (3 * BLOCK - 1), last);
+    expectRange(column, NULL, series, START - 1000, START + 1);
+    expectRange(column, NULL, series, last, last + 1000);
+    expectRange(column, NULL, series, last + 1, last + 1000);
+    expectRange(column, NULL, series, START + 200, START + 100);
+}
+
+TEST_F(Column, ReleaseDropsTheOldestBlock) {
+    UAVObjectHistoryColumn column;
+    Series series = telemetry(3 * BLOCK + 10);
+
+    series.appendTo(&column);
+    int64_t memory   = column.memory();
+    int64_t released = column.releaseOldest(NULL);
+
+    EXPECT_GT(released, 0);
+    EXPECT_EQ(memory - released, column.memory());
+    EXPECT_EQ(2u * BLOCK + 10, column.count());
+    expectRange(column, NULL, series.slice(series.times[BLOCK], INT64_MAX), INT64_MIN, INT64_MAX);
+
+    // the open block stays
+    EXPECT_GT(column.releaseOldest(NULL), 0);
+    EXPECT_GT(column.releaseOldest(NULL), 0);
+    EXPECT_EQ(0, column.releaseOldest(NULL));
+    EXPECT_EQ(10u, column.count());
+    expectRange(column, NULL, series.slice(series.times[3 * BLOCK], INT64_MAX), INT64_MIN, INT64_MAX);
+}
+
+TEST_F(Column, SpillKeepsEverySample) {
+    std::string fileName = tempName("column");
+    Series series = telemetry(4 * BLOCK + 10);
+    {
+        UAVObjectHistorySpill spill(fileName);
+        ASSERT_TRUE(spill.isOpen());
+        UAVObjectHistoryColumn column;
+        series.appendTo(&column);
+
+        int64_t spilled = 0;
+        spilled += column.releaseOldest(&spill);
+        spilled += column.releaseOldest(&spill);
+        EXPECT_EQ(spilled, spill.size());
+        EXPECT_EQ(4u * BLOCK + 10, column.count());
+
+        // read back from the file, from memory, and from both
+        expectRange(column, &spill, series, INT64_MIN, INT64_MAX);
+        expectRange(column, &spill, series, START + 100, START + 200);
+        expectRange(column, &spill, series, START + 2 * (2 * BLOCK - 5), START + 2 * (2 * BLOCK + 5));
+
+        // a later write does not disturb the blocks already in the file
+        column.releaseOldest(&spill);
+        expectRange(column, &spill, series, INT64_MIN, INT64_MAX);
+    }
+    // the file goes with the spill
+    EXPECT_NE(0, access(fileName.c_str(), F_OK));
+}
+
+TEST_F(Column, SpillThatCannotOpenDrops) {
+    UAVObjectHistorySpill spill("/nonexistent/ut_uavobjecthistory.spill");
+    UAVObjectHistoryColumn column;
+
+    EXPECT_FALSE(spill.isOpen());
+    telemetry(2 * BLOCK).appendTo(&column);
+    EXPECT_GT(column.releaseOldest(&spill), 0);
+    EXPECT_EQ(BLOCK, column.count());
+}
+
+class Store : public testing::Test {
+protected:
+    // the memory of the columns equals the memory the store accounts for
+    static int64_t columnsMemory(const std::vector<UAVObjectHistoryColumn *> & columns)
+    {
+        int64_t memory = 0;
+
+        for (size_t i = 0; i < columns.size(); i++) {
+            memory += columns[i]->memory();
+        }
+        return memory;
+    }
+};
+
+TEST_F(Store, StaysUnderTheLimit) {
+    // above the open blocks of all columns, those are never released
+    const int64_t limit = 64 * 1024;
+    UAVObjectHistoryStore store(limit);
+    std::vector<UAVObjectHistoryColumn *> columns;
+    Series series = telemetry(40 * BLOCK);
+
+    for (int i = 0; i < 8; i++) {
+        columns.push_back(store.addColumn());
+    }
+    int64_t peak = 0;
+    for (size_t s = 0; s < series.times.size(); s++) {
+        for (size_t c = 0; c < columns.size(); c++) {
+            store.append(columns[c], series.times[s], series.values[s] * (c + 1));
+        }
+        peak = std::max(peak, store.memoryUsed());
+        ASSERT_EQ(columnsMemory(columns), store.memoryUsed());
+    }
+    EXPECT_LE(peak, limit);
+    EXPECT_LT(store.samples(), (uint64_t)series.times.size() * columns.size());
+
+    // what is left is the newest of every column
+    for (size_t c = 0; c < columns.size(); c++) {
+        std::vector<int64_t> times;
+        std::vector<double> values;
+        store.range(columns[c], INT64_MIN, INT64_MAX, times, values);
+        ASSERT_FALSE(times.empty());
+        EXPECT_EQ(series.times.back(), times.back());
+        EXPECT_EQ(columns[c]->count(), times.size());
+    }
+    EXPECT_EQ(0, store.spilledBytes());
+}
+
+TEST_F(Store, ReleasesInSealOrder) {
+    UAVObjectHistoryStore store(INT64_MAX);
+    UAVObjectHistoryColumn *fast = store.addColumn();
+    UAVObjectHistoryColumn *slow = store.addColumn();
+    Series series = telemetry(4 * BLOCK);
+
+    // slow seals its only block first, then fast seals four
+    for (uint32_t i = 0; i < BLOCK; i++) {
+        store.append(slow, series.times[i], series.values[i]);
+    }
+    for (uint32_t i = 0; i < 4 * BLOCK; i++) {
+        store.append(fast, series.times[i], series.values[i]);
+    }
+
+    // lowering the limit applies at once, oldest sealed block first
+    store.setMemoryLimit(store.memoryUsed() - 1);
+    EXPECT_EQ(0u, slow->count());
+    EXPECT_EQ(4u * BLOCK, fast->count());
+
+    store.setMemoryLimit(0);
+    EXPECT_EQ(0u, fast->count());
+    EXPECT_EQ(0, store.memoryUsed());
+    EXPECT_EQ(0u, store.samples());
+}
+
+TEST_F(Store, SpillsInsteadOfDropping) {
+    std::string fileName = tempName("store");
+    {
+        UAVObjectHistoryStore store(4 * 1024);
+        ASSERT_TRUE(store.setSpillFile(fileName));
+        std::vector<UAVObjectHistoryColumn *> columns;
+        Series series = telemetry(10 * BLOCK);
+
+        for (int i = 0; i < 4; i++) {
+            columns.push_back(store.addColumn());
+        }
+        for (size_t s = 0; s < series.times.size(); s++) {
+            for (size_t c = 0; c < columns.size(); c++) {
+                store.append(columns[c], series.times[s], series.values[s]);
+            }
+        }
+        EXPECT_LE(store.memoryUsed(), 4 * 1024);
+        EXPECT_GT(store.spilledBytes(), 0);
+        EXPECT_EQ((uint64_t)series.times.size() * columns.size(), store.samples());
+
+        for (size_t c = 0; c < columns.size(); c++) {
+            std::vector<int64_t> times;
+            std::vector<double> values;
+            store.range(columns[c], INT64_MIN, INT64_MAX, times, values);
+            expectSame(series, times, values);
+        }
+
+        // once blocks are in the file it stays
+        EXPECT_FALSE(store.setSpillFile(std::string()));
+        EXPECT_FALSE(store.setSpillFile(tempName("other")));
+        EXPECT_EQ(0, access(fileName.c_str(), F_OK));
+    }
+    EXPECT_NE(0, access(fileName.c_str(), F_OK));
+}
+
+TEST_F(Store, SpillFileCanChangeBeforeUse) {
+    UAVObjectHistoryStore store(1024);
+
+    EXPECT_FALSE(store.setSpillFile("/nonexistent/ut_uavobjecthistory.spill"));
+    EXPECT_TRUE(store.setSpillFile(tempName("first")));
+    EXPECT_TRUE(store.setSpillFile(std::string()));
+    EXPECT_EQ(0, store.spilledBytes());
+}
@@ -0,0 +1,31 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define pvPortMalloc(xSize) (malloc(xSize))
+#define vPortFree(pv)       (free(pv))
+
+typedef void *xSemaphoreHandle;
+typedef void *xQueueHandle;
+
+#define pdTRUE                   1
+#define pdFALSE                  0
+#define portMAX_DELAY            0xffffffff
+#define portTICK_RATE_MS         1
+#define configMINIMAL_STACK_SIZE 128
+
+/* Simulated tick, advanced by the test */
+extern uint32_t ut_tick;
+#define xTaskGetTickCount()                ut_tick
+
+#define xSemaphoreCreateRecursiveMutex()   ((xSemaphoreHandle)1)
+#define xSemaphoreTakeRecursive(m, t)      ((void)(m), (void)(t))
+#define xSemaphoreGiveRecursive(m)         ((void)(m))
+
+#define xQueueCreate(length, size)         ((xQueueHandle)0)
+#define xQueueReceive(q, item, t)          ((void)(q), (void)(item), (void)(t), pdFALSE)
+int32_t xQueueSend(xQueueHandle queue, const void *item, uint32_t ticksToWait);
+
+#endif /* FREERTOS_H */
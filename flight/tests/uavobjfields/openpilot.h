@@ -0,0 +1,24 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pios.h>
+#include <utlist.h>
+
+#define PIOS_Assert(x) \
+    if (!(x)) { while (1) {; } \
+    }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+#define PIOS_STATIC_ASSERT(test) ((void)sizeof(int[1 - 2 * !(test)]))
+#define NELEMENTS(x)             (sizeof(x) / sizeof((x)[0]))
+
+uint8_t PIOS_CRC_updateCRC(uint8_t crc, const uint8_t *data, int32_t length);
+
+#include <uavobjectmanager.h>
+#include <eventdispatcher.h>
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,413 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <string.h> /* memcpy */
+#include <time.h> /* clock_gettime */
+#include <dirent.h> /* opendir */
+#include <fstream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "openpilot.h"
+#include "uavobjectsinit.h"
+#include "actuatorcommand.h"
+#include "attitudestate.h"
+#include "gpspositionsensor.h"
+#include "stabilizationsettings.h"
+
+int32_t xQueueSend(__attribute__((unused)) xQueueHandle queue, __attribute__((unused)) const void *item, __attribute__((unused)) uint32_t ticksToWait)
+{
+    return pdTRUE;
+}
+
+int32_t EventCallbackDispatch(__attribute__((unused)) UAVObjEvent *ev, __attribute__((unused)) UAVObjEventCallback cb)
+{
+    return pdTRUE;
+}
+
+uint8_t PIOS_CRC_updateCRC(uint8_t crc, __attribute__((unused)) const uint8_t *data, __attribute__((unused)) int32_t length)
+{
+    return crc;
+}
+}
+
+#define MAX_OBJECTS 512
+
+static UAVObjHandle objects[MAX_OBJECTS];
+static uint32_t numObjects;
+
+static void collect(UAVObjHandle obj)
+{
+    // only data objects carry descriptors
+    if (!UAVObjIsMetaobject(obj) && numObjects < MAX_OBJECTS) {
+        objects[numObjects++] = obj;
+    }
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVObjFieldsTest : public testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+        UAVObjInitialize();
+        UAVObjectsInitializeAll();
+        UAVObjIterate(&collect);
+    }
+};
+
+static const UAVObjFieldInfo *findField(UAVObjHandle obj, const char *name)
+{
+    int16_t index = UAVObjFindField(obj, UAVObjFieldNameHash(name));
+
+    return index < 0 ? NULL : UAVObjGetFieldInfo(obj, index);
+}
+
+static std::string readFile(const std::string & path)
+{
+    std::ifstream file(path.c_str());
+    std::stringstream text;
+
+    text << file.rdbuf();
+    return text.str();
+}
+
+static std::string attribute(const std::string & attributes, const char *name)
+{
+    std::smatch match;
+
+    if (std::regex_search(attributes, match, std::regex(std::string("\\b") + name + "\\s*=\\s*\"([^\"]*)\""))) {
+        return match[1];
+    }
+    return "";
+}
+
+struct DefinedField {
+    std::string name;
+    int type;
+    int numElements;
+};
+
+static const char *const definedTypes[] = { "int8", "int16", "int32", "uint8", "uint16", "uint32", "float", "enum" };
+static const int definedTypeSizes[] = { 1, 2, 4, 1, 2, 4, 4, 1 };
+
+/*
+ * The fields of a definition in the order the GCS lays them out: as in the
+ * XML, cloned fields copy their parent, then stable sorted by element size
+ * (see UAVObjectParser::parseXML and UAVObjectField offsets).
+ */
+static std::vector<DefinedField> definedFields(const std::string & xml)
+{
+    std::string text = std::regex_replace(xml, std::regex("<!--[\\s\\S]*?-->"), "");
+    std::regex fieldTag("<field\\b([^>]*?)(/>|>([\\s\\S]*?)</field>)");
+    std::vector<DefinedField> fields;
+
+    for (std::sregex_iterator it(text.begin(), text.end(), fieldTag), end; it != end; ++it) {
+        std::string attributes = (*it)[1];
+        std::string body = (*it)[3];
+        DefinedField field;
+
+        field.name = attribute(attributes, "name");
+        std::string parent = attribute(attributes, "cloneof");
+        if (!parent.empty()) {
+            for (size_t n = 0; n < fields.size(); n++) {
+                if (fields[n].name == parent) {
+                    field.type = fields[n].type;
+                    field.numElements = fields[n].numElements;
+                }
+            }
+        } else {
+            std::string type = attribute(attributes, "type");
+            field.type = -1;
+            for (int n = 0; n < 8; n++) {
+                if (type == definedTypes[n]) {
+                    field.type = n;
+                }
+            }
+            std::string names = attribute(attributes, "elementnames");
+            if (!names.empty()) {
+                std::stringstream list(names);
+                std::string name;
+                field.numElements = 0;
+                while (std::getline(list, name, ',')) {
+                    field.numElements += name.find_first_not_of(" \t") != std::string::npos;
+                }
+            } else {
+                std::regex elementName("<elementname>[^<]+</elementname>");
+                field.numElements = std::distance(std::sregex_iterator(body.begin(), body.end(), elementName), std::sregex_iterator());
+                if (field.numElements == 0) {
+                    field.numElements = atoi(attribute(attributes, "elements").c_str());
+                }
+            }
+        }
+        fields.push_back(field);
+    }
+    std::stable_sort(fields.begin(), fields.end(), [](const DefinedField & a, const DefinedField & b) {
+        return definedTypeSizes[a.type] > definedTypeSizes[b.type];
+    });
+    return fields;
+}
+
+// The GCS lays out the fields one after the other in definition order
+// (UAVObjectField offsets), the descriptors must describe the same packing.
+TEST_F(UAVObjFieldsTest, DescriptorsMatchGcsLayout) {
+    ASSERT_GT(numObjects, 100u);
+    ASSERT_LT(numObjects, (uint32_t)MAX_OBJECTS);
+
+    for (uint32_t i = 0; i < numObjects; i++) {
+        UAVObjHandle obj  = objects[i];
+        uint8_t numFields = UAVObjGetNumFields(obj);
+        uint32_t offset   = 0;
+
+        ASSERT_GT(numFields, 0) << "object " << std::hex << UAVObjGetID(obj);
+        ASSERT_LE(numFields, UAVOBJ_MAX_FIELDS);
+        for (uint8_t n = 0; n < numFields; n++) {
+            const UAVObjFieldInfo *field = UAVObjGetFieldInfo(obj, n);
+            ASSERT_TRUE(field != NULL);
+            EXPECT_EQ(offset, field->offset) << "object " << std::hex << UAVObjGetID(obj) << std::dec << " field " << (int)n;
+            EXPECT_LE(field->type, UAVOBJ_FIELDTYPE_ENUM);
+            EXPECT_GE(field->numElements, 1);
+            // names must be unique within the object for the hash lookup
+            EXPECT_EQ(n, UAVObjFindField(obj, field->nameHash)) << "object " << std::hex << UAVObjGetID(obj) << std::dec << " field " << (int)n;
+            offset += UAVObjFieldNumBytes(field);
+        }
+        EXPECT_EQ(UAVObjGetNumBytes(obj), offset) << "object " << std::hex << UAVObjGetID(obj);
+        EXPECT_TRUE(UAVObjGetFieldInfo(obj, numFields) == NULL);
+    }
+}
+
+// The generated tables against the object definitions themselves, so a
+// generator that reorders, drops or mistypes a field is caught.
+TEST_F(UAVObjFieldsTest, DescriptorsMatchDefinitions) {
+    std::map<std::string, uint32_t> objIds;
+    DIR *dir = opendir(UAVOBJ_SYNTH_DIR);
+
+    ASSERT_TRUE(dir != NULL);
+    for (struct dirent *entry; (entry = readdir(dir)) != NULL;) {
+        std::string header = entry->d_name;
+        if (header.size() > 2 && header.compare(header.size() - 2, 2, ".h") == 0) {
+            std::string text = readFile(std::string(UAVOBJ_SYNTH_DIR "/") + header);
+            std::smatch match;
+            if (std::regex_search(text, match, std::regex("#define (\\w+)_OBJID (0x[0-9A-Fa-f]+)"))) {
+                objIds[match[1]] = strtoul(match[2].str().c_str(), NULL, 16);
+            }
+        }
+    }
+    closedir(dir);
+
+    dir = opendir(UAVOBJ_XML_DIR);
+    ASSERT_TRUE(dir != NULL);
+    uint32_t checked = 0;
+    for (struct dirent *entry; (entry = readdir(dir)) != NULL;) {
+        std::string file = entry->d_name;
+        if (file.size() < 4 || file.compare(file.size() - 4, 4, ".xml")) {
+            continue;
+        }
+        std::string xml = readFile(std::string(UAVOBJ_XML_DIR "/") + file);
+        std::string name;
+        std::smatch match;
+        ASSERT_TRUE(std::regex_search(xml, match, std::regex("<object\\b([^>]*)>"))) << file;
+        for (char c : attribute(match[1], "name")) {
+            name += toupper(c);
+        }
+        ASSERT_TRUE(objIds.count(name)) << file;
+        UAVObjHandle obj = UAVObjGetByID(objIds[name]);
+        ASSERT_TRUE(obj != NULL) << file;
+
+        std::vector<DefinedField> fields = definedFields(xml);
+        ASSERT_EQ(fields.size(), UAVObjGetNumFields(obj)) << file;
+        uint32_t offset = 0;
+        for (uint8_t n = 0; n < fields.size(); n++) {
+            const UAVObjFieldInfo *field = UAVObjGetFieldInfo(obj, n);
+            EXPECT_EQ(UAVObjFieldNameHash(fields[n].name.c_str()), field->nameHash) << file << " " << fields[n].name;
+            EXPECT_EQ(fields[n].type, field->type) << file << " " << fields[n].name;
+            EXPECT_EQ(fields[n].numElements, field->numElements) << file << " " << fields[n].name;
+            EXPECT_EQ(offset, field->offset) << file << " " << fields[n].name;
+            offset += definedTypeSizes[fields[n].type] * fields[n].numElements;
+        }
+        checked++;
+    }
+    closedir(dir);
+    EXPECT_EQ(numObjects, checked);
+}
+
+TEST_F(UAVObjFieldsTest, DescriptorsMatchCompiler) {
+    UAVObjHandle obj = AttitudeStateHandle();
+    const UAVObjFieldInfo *field = findField(obj, "Roll");
+
+    ASSERT_TRUE(field != NULL);
+    EXPECT_EQ(offsetof(AttitudeStateData, Roll), field->offset);
+    EXPECT_EQ(UAVOBJ_FIELDTYPE_FLOAT32, field->type);
+    EXPECT_EQ(1, field->numElements);
+
+    obj   = StabilizationSettingsHandle();
+    field = findField(obj, "GyroDynamicNotch");
+    ASSERT_TRUE(field != NULL);
+    EXPECT_EQ(offsetof(StabilizationSettingsData, GyroDynamicNotch), field->offset);
+    EXPECT_EQ(STABILIZATIONSETTINGS_GYRODYNAMICNOTCH_NUMELEM, field->numElements);
+    EXPECT_EQ(sizeof(StabilizationSettingsGyroDynamicNotchData), UAVObjFieldNumBytes(field));
+
+    field = findField(obj, "FlightModeMap");
+    ASSERT_TRUE(field != NULL);
+    EXPECT_EQ(offsetof(StabilizationSettingsData, FlightModeMap), field->offset);
+    EXPECT_EQ(UAVOBJ_FIELDTYPE_ENUM, field->type);
+    EXPECT_EQ(STABILIZATIONSETTINGS_FLIGHTMODEMAP_NUMELEM, field->numElements);
+
+    field = findField(obj, "VbarGyroSuppress");
+    ASSERT_TRUE(field != NULL);
+    EXPECT_EQ(offsetof(StabilizationSettingsData, VbarGyroSuppress), field->offset);
+    EXPECT_EQ(UAVOBJ_FIELDTYPE_INT8, field->type);
+
+    EXPECT_TRUE(findField(obj, "NoSuchField") == NULL);
+}
+
+TEST_F(UAVObjFieldsTest, MetaObjectsHaveNoFields) {
+    UAVObjHandle meta = UAVObjGetLinkedObj(AttitudeStateHandle());
+
+    ASSERT_TRUE(UAVObjIsMetaobject(meta));
+    EXPECT_EQ(0, UAVObjGetNumFields(meta));
+    EXPECT_TRUE(UAVObjGetFieldInfo(meta, 0) == NULL);
+    EXPECT_EQ(-1, UAVObjFindField(meta, UAVObjFieldNameHash("Roll")));
+}
+
+TEST_F(UAVObjFieldsTest, PartialUpdate) {
+    UAVObjHandle obj = AttitudeStateHandle();
+    AttitudeStateData data;
+
+    memset(&data, 0, sizeof(data));
+    data.Roll  = 10.0f;
+    data.Pitch = 20.0f;
+    AttitudeStateSet(&data);
+
+    float yaw = 30.0f;
+    ASSERT_EQ(0, UAVObjSetInstanceField(obj, 0, UAVObjFindField(obj, UAVObjFieldNameHash("Yaw")), &yaw));
+    AttitudeStateGet(&data);
+    EXPECT_EQ(10.0f, data.Roll);
+    EXPECT_EQ(20.0f, data.Pitch);
+    EXPECT_EQ(30.0f, data.Yaw);
+
+    float pitch = 0.0f;
+    ASSERT_EQ(0, UAVObjGetInstanceField(obj, 0, UAVObjFindField(obj, UAVObjFieldNameHash("Pitch")), &pitch));
+    EXPECT_EQ(20.0f, pitch);
+
+    EXPECT_EQ(-1, UAVObjSetInstanceField(obj, 0, UAVObjGetNumFields(obj), &yaw));
+    EXPECT_EQ(-1, UAVObjGetInstanceField(obj, 1, 0, &pitch));
+}
+
+TEST_F(UAVObjFieldsTest, ChangeDetection) {
+    UAVObjHandle obj = StabilizationSettingsHandle();
+    StabilizationSettingsData reference;
+    StabilizationSettingsData data;
+    uint64_t changed = ~0ull;
+
+    StabilizationSettingsGet(&reference);
+    EXPECT_EQ(0, UAVObjGetChangedFields(obj, 0, &reference, &changed));
+    EXPECT_EQ(0ull, changed);
+
+    memcpy(&data, &reference, sizeof(data));
+    data.GyroDynamicNotch.Q += 1.0f;
+    data.FlightModeAssistMap[5] = (StabilizationSettingsFlightModeAssistMapOptions)(data.FlightModeAssistMap[5] + 1);
+    StabilizationSettingsSet(&data);
+
+    EXPECT_EQ(2, UAVObjGetChangedFields(obj, 0, &reference, &changed));
+    uint64_t expected = (1ull << UAVObjFindField(obj, UAVObjFieldNameHash("GyroDynamicNotch"))) |
+                        (1ull << UAVObjFindField(obj, UAVObjFieldNameHash("FlightModeAssistMap")));
+    EXPECT_EQ(expected, changed);
+
+    EXPECT_EQ(0, UAVObjGetChangedFields(obj, 0, &data, &changed));
+    EXPECT_EQ(-1, UAVObjGetChangedFields(obj, 1, &data, &changed));
+    StabilizationSettingsSet(&reference);
+}
+
+// The aligned structs used by the firmware must keep the wire layout,
+// only the padding at the end may differ.
+TEST_F(UAVObjFieldsTest, AlignedLayoutMatchesWire) {
+    EXPECT_EQ(29u, ACTUATORCOMMAND_NUMBYTES);
+    EXPECT_EQ(32u, sizeof(ActuatorCommandData));
+    EXPECT_EQ(offsetof(ActuatorCommandDataPacked, NumFailedUpdates), offsetof(ActuatorCommandData, NumFailedUpdates));
+    EXPECT_EQ(41u, GPSPOSITIONSENSOR_NUMBYTES);
+
+    ActuatorCommandData data;
+    uint8_t wire[ACTUATORCOMMAND_NUMBYTES + 4];
+    memset(&data, 0, sizeof(data));
+    for (int n = 0; n < ACTUATORCOMMAND_CHANNEL_NUMELEM; n++) {
+        data.Channel[n] = 1000 + n;
+    }
+    data.UpdateTime = 5;
+    data.MaxUpdateTime    = 7;
+    data.NumFailedUpdates = 9;
+    ActuatorCommandSet(&data);
+
+    memset(wire, 0xa5, sizeof(wire));
+    ASSERT_EQ(0, UAVObjPack(ActuatorCommandHandle(), 0, wire));
+    EXPECT_EQ(0, memcmp(&data, wire, ACTUATORCOMMAND_NUMBYTES));
+    // nothing is written past the wire size
+    EXPECT_EQ(0xa5, wire[ACTUATORCOMMAND_NUMBYTES]);
+
+    const ActuatorCommandDataPacked *packed = (const ActuatorCommandDataPacked *)wire;
+    EXPECT_EQ(1011, packed->Channel[11]);
+    EXPECT_EQ(9, packed->NumFailedUpdates);
+}
+
+static double nanoseconds(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+#define BENCH_OBJECTS 64
+#define BENCH_LOOPS   20000
+
+// Host numbers only, targets without fast unaligned access are not measured.
+// The packed array reproduces the previous layout: back to back wire sized
+// instances where most floats are misaligned.
+template<typename T> static double sumFields(T *data, volatile float *sink)
+{
+    struct timespec start, end;
+    float sum = 0.0f;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int l = 0; l < BENCH_LOOPS; l++) {
+        for (int n = 0; n < BENCH_OBJECTS; n++) {
+            data[n].Altitude += 1.0f;
+            sum += data[n].Altitude + data[n].Heading + data[n].Groundspeed + data[n].Latitude * 1e-7f;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *sink = sum;
+    return nanoseconds(&start, &end) / (BENCH_LOOPS * BENCH_OBJECTS);
+}
+
+TEST_F(UAVObjFieldsTest, Benchmark) {
+    static GPSPositionSensorDataPacked packed[BENCH_OBJECTS];
+    static GPSPositionSensorData aligned[BENCH_OBJECTS];
+    volatile float sink;
+    struct timespec start, end;
+
+    memset(packed, 0, sizeof(packed));
+    memset(aligned, 0, sizeof(aligned));
+    const double packed_ns  = sumFields(packed, &sink);
+    const double aligned_ns = sumFields(aligned, &sink);
+
+    AttitudeStateData attitude;
+    ActuatorCommandData command;
+    memset(&attitude, 0, sizeof(attitude));
+    memset(&command, 0, sizeof(command));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int l = 0; l < BENCH_LOOPS; l++) {
+        AttitudeStateGet(&attitude);
+        attitude.Roll += 1.0f;
+        AttitudeStateSet(&attitude);
+        ActuatorCommandGet(&command);
+        command.Channel[l % ACTUATORCOMMAND_CHANNEL_NUMELEM]++;
+        ActuatorCommandSet(&command);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const double getset_ns = nanoseconds(&start, &end) / (BENCH_LOOPS * 2);
+
+    printf("uavobjfields: field access %.2f ns packed (previous), %.2f ns aligned per object\n", packed_ns, aligned_ns);
+    printf("uavobjfields: %.1f ns per Get/Set pair\n", getset_ns);
+    EXPECT_EQ(aligned[0].Altitude, packed[0].Altitude);
+}
@@ -0,0 +1,48 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/* the simposix settings the posix port depends on */
+#define COND_SIGNALING
+#define CHECK_TASK_RESUMES
+#define RUNNING_THREAD_MUTEX
+#define IDLE_SLEEPS
+
+#define configUSE_PREEMPTION              1
+#define configIDLE_SHOULD_YIELD           0
+#define configUSE_IDLE_HOOK               0
+#define configUSE_TICK_HOOK               0
+#define configCPU_CLOCK_HZ                ((unsigned long)72000000)
+#define configTICK_RATE_HZ                ((portTickType)1000)
+#define configMAX_PRIORITIES              ((unsigned portBASE_TYPE)5)
+#define configMINIMAL_STACK_SIZE          ((unsigned short)256)
+#define configTOTAL_HEAP_SIZE             ((size_t)(45 * 1024))
+#define configMAX_TASK_NAME_LEN           (16)
+#define configUSE_TRACE_FACILITY          0
+#define configUSE_16_BIT_TICKS            0
+#define configUSE_MUTEXES                 1
+#define configUSE_RECURSIVE_MUTEXES       1
+#define configUSE_COUNTING_SEMAPHORES     0
+#define configUSE_ALTERNATIVE_API         0
+#define configCHECK_FOR_STACK_OVERFLOW    0
+#define configQUEUE_REGISTRY_SIZE         0
+#define configUSE_CO_ROUTINES             0
+#define configMAX_CO_ROUTINE_PRIORITIES   (2)
+
+#define INCLUDE_vTaskPrioritySet          0
+#define INCLUDE_uxTaskPriorityGet         0
+#define INCLUDE_vTaskDelete               1
+#define INCLUDE_vTaskCleanUpResources     0
+#define INCLUDE_vTaskSuspend              1
+#define INCLUDE_vTaskDelayUntil           1
+#define INCLUDE_vTaskDelay                1
+#define INCLUDE_xTaskGetSchedulerState    1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_xTaskGetIdleTaskHandle    1
+
+/* 64 bit host */
+#define portPOINTER_SIZE_TYPE             uintptr_t
+
+#define configKERNEL_INTERRUPT_PRIORITY   15 << 4
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY 3 << 4
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+#include <unistd.h> /* fork */
+#include <sys/mman.h> /* mmap */
+#include <sys/wait.h> /* waitpid */
+
+extern "C" {
+#include "pios.h"
+
+bool PIOS_SIM_IsVirtualTime(void)
+{
+    return true;
+}
+}
+
+#define TICKS 500
+
+// what the task saw, shared with the test process
+struct Seen {
+    TickType_t tickAfterDelay[TICKS];
+    uint32_t   usAfterDelay[TICKS];
+    TickType_t tickBeforeWait;
+    TickType_t tickAfterShortWait;
+    uint32_t   usAfterShortWait;
+    TickType_t tickAfterLongWait;
+    uint32_t   usAfterLongWait;
+};
+static Seen *seen;
+
+static void stepTask(__attribute__((unused)) void *parameters)
+{
+    for (int i = 0; i < TICKS; i++) {
+        vTaskDelay(1);
+        seen->tickAfterDelay[i] = xTaskGetTickCount();
+        seen->usAfterDelay[i]   = PIOS_DELAY_GetuS();
+    }
+
+    // busy waits step virtual time within the tick and across ticks
+    seen->tickBeforeWait     = xTaskGetTickCount();
+    PIOS_DELAY_WaituS(300);
+    seen->tickAfterShortWait = xTaskGetTickCount();
+    seen->usAfterShortWait   = PIOS_DELAY_GetuS();
+    PIOS_DELAY_WaituS(2500);
+    seen->tickAfterLongWait  = xTaskGetTickCount();
+    seen->usAfterLongWait    = PIOS_DELAY_GetuS();
+
+    // the posix port cannot shut the scheduler down cleanly
+    _exit(0);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class VirtualTime : public testing::Test {};
+
+TEST_F(VirtualTime, TickCountAndMicrosecondsAgree) {
+    seen = (Seen *)mmap(NULL, sizeof(*seen), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(MAP_FAILED, (void *)seen);
+    memset(seen, 0, sizeof(*seen));
+
+    // the scheduler never returns, run it in a child process
+    pid_t child = fork();
+    ASSERT_NE(-1, child);
+    if (child == 0) {
+        alarm(10);
+        vPortEnableVirtualTime(0);
+        if (xTaskCreate(stepTask, "step", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS) {
+            _exit(1);
+        }
+        vTaskStartScheduler();
+        _exit(1);
+    }
+    int status;
+    ASSERT_EQ(child, waitpid(child, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+
+    for (int i = 0; i < TICKS; i++) {
+        EXPECT_EQ((TickType_t)(i + 1), seen->tickAfterDelay[i]);
+        EXPECT_EQ(seen->tickAfterDelay[i] * portTICK_RATE_MICROSECONDS, seen->usAfterDelay[i]);
+    }
+
+    EXPECT_EQ(seen->tickBeforeWait, seen->tickAfterShortWait);
+    EXPECT_EQ(seen->tickBeforeWait * portTICK_RATE_MICROSECONDS + 300, seen->usAfterShortWait);
+    EXPECT_EQ(seen->tickBeforeWait + 2, seen->tickAfterLongWait);
+    EXPECT_EQ(seen->tickBeforeWait * portTICK_RATE_MICROSECONDS + 2800, seen->usAfterLongWait);
+    EXPECT_EQ(seen->usAfterLongWait / portTICK_RATE_MICROSECONDS, seen->tickAfterLongWait);
+
+    munmap(seen, sizeof(*seen));
+}
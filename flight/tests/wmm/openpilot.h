@@ -0,0 +1,27 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* blocks currently allocated by the model, checked by the test */
+extern int wmmBlocks;
+
+static inline void *wmmMalloc(size_t size)
+{
+    wmmBlocks++;
+    return malloc(size);
+}
+
+static inline void wmmFree(void *ptr)
+{
+    wmmBlocks--;
+    free(ptr);
+}
+
+#define pios_malloc(size) wmmMalloc(size)
+#define vPortFree(ptr)    wmmFree(ptr)
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,208 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+#include <math.h> /* fabsf */
+#include <time.h> /* clock_gettime */
+
+extern "C" {
+#include "openpilot.h"
+#include "WorldMagModel.h"
+#include "WMMInternal.h"
+
+int wmmBlocks = 0;
+}
+
+#define MONTH 5
+#define DAY   5
+#define YEAR  2014
+
+/*
+ * The full expansion step by step: geodetic to spherical, harmonics of the
+ * longitude, Legendre recursion, summation and rotation, all computed for
+ * every point.
+ */
+static void referenceMagVector(float Lat, float Lon, float Alt, float B[3])
+{
+    WMMtype_CoordGeodetic CoordGeodetic;
+    WMMtype_CoordSpherical CoordSpherical;
+    WMMtype_SphericalHarmonicVariables SphVariables;
+    WMMtype_LegendreFunction LegendreFunction;
+    WMMtype_MagneticResults MagneticResultsSph;
+    WMMtype_MagneticResults MagneticResultsGeo;
+
+    CoordGeodetic.lambda = Lon;
+    CoordGeodetic.phi    = Lat;
+    CoordGeodetic.HeightAboveEllipsoid = Alt / 1000.0f;
+    WMM_GeodeticToSpherical(&CoordGeodetic, &CoordSpherical);
+    WMM_ComputeSphericalHarmonicVariables(&CoordSpherical, WMM_MAX_MODEL_DEGREES, &SphVariables);
+    WMM_AssociatedLegendreFunction(&CoordSpherical, WMM_MAX_MODEL_DEGREES, &LegendreFunction);
+    WMM_Summation(&LegendreFunction, &SphVariables, &CoordSpherical, &MagneticResultsSph);
+    WMM_RotateMagneticVector(&CoordSpherical, &CoordGeodetic, &MagneticResultsSph, &MagneticResultsGeo);
+
+    B[0] = MagneticResultsGeo.Bx * 1e-2f;
+    B[1] = MagneticResultsGeo.By * 1e-2f;
+    B[2] = MagneticResultsGeo.Bz * 1e-2f;
+}
+
+static float maxError(const float a[3], const float b[3])
+{
+    float err = 0.0f;
+
+    for (int i = 0; i < 3; i++) {
+        err = fmaxf(err, fabsf(a[i] - b[i]));
+    }
+    return err;
+}
+
+static double elapsed(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class WorldMagModelTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        ASSERT_EQ(0, WMM_Initialize());
+        ASSERT_EQ(0, WMM_DateToYear(MONTH, DAY, YEAR));
+        srand(1);
+    }
+
+    virtual void TearDown()
+    {
+        WMM_Release();
+        EXPECT_EQ(0, wmmBlocks);
+    }
+
+    float randomFloat(float min, float max)
+    {
+        return min + (max - min) * (float)rand() / (float)RAND_MAX;
+    }
+};
+
+/* values of the implementation before the speed-up, in units of 100nT */
+static const float golden[][6] = {
+    { -90.0f, -180.0f, -500.0f,  -144.798f, -0.000f,  -524.124f },
+    { -75.0f, -150.0f, 9500.0f,  21.664f,   137.568f, -575.422f },
+    { -60.0f, -120.0f, 19500.0f, 159.141f,  128.289f, -447.017f },
+    { -45.0f, -90.0f,  29500.0f, 203.083f,  79.267f,  -239.527f },
+    { -30.0f, -50.0f,  -500.0f,  166.447f,  -51.255f, -145.978f },
+    { -15.0f, -20.0f,  9500.0f,  162.714f,  -66.224f, -202.194f },
+    { 0.0f,   10.0f,   19500.0f, 283.307f,  -11.946f, -157.511f },
+    { 15.0f,  40.0f,   29500.0f, 355.357f,  16.145f,  108.495f  },
+    { 30.0f,  80.0f,   -500.0f,  335.752f,  5.656f,   356.815f  },
+    { 45.0f,  110.0f,  9500.0f,  242.394f,  -23.134f, 519.176f  },
+    { 60.0f,  140.0f,  19500.0f, 159.979f,  -39.869f, 547.607f  },
+    { 75.0f,  170.0f,  29500.0f, 74.727f,   -1.956f,  567.955f  },
+};
+
+TEST_F(WorldMagModelTest, Golden) {
+    float B[3];
+
+    for (unsigned i = 0; i < sizeof(golden) / sizeof(golden[0]); i++) {
+        ASSERT_EQ(0, WMM_GetMagVector(golden[i][0], golden[i][1], golden[i][2], MONTH, DAY, YEAR, B));
+        EXPECT_NEAR(golden[i][3], B[0], 0.01f);
+        EXPECT_NEAR(golden[i][4], B[1], 0.01f);
+        EXPECT_NEAR(golden[i][5], B[2], 0.01f);
+    }
+}
+
+TEST_F(WorldMagModelTest, RangeCheck) {
+    float B[3];
+
+    EXPECT_GT(0, WMM_GetMagVector(-91.0f, 0.0f, 0.0f, MONTH, DAY, YEAR, B));
+    EXPECT_GT(0, WMM_GetMagVector(0.0f, 181.0f, 0.0f, MONTH, DAY, YEAR, B));
+    EXPECT_GT(0, WMM_GetMagVector(0.0f, 0.0f, 0.0f, 2, 30, YEAR, B));
+}
+
+TEST_F(WorldMagModelTest, GlobalSweep) {
+    float B[3], ref[3], worst = 0.0f;
+
+    // altitude innermost exercises the extrapolated Legendre functions,
+    // the latitude steps force a full recursion
+    for (float lat = -89.0f; lat <= 89.0f; lat += 7.0f) {
+        for (float lon = -180.0f; lon <= 180.0f; lon += 13.0f) {
+            for (float alt = -500.0f; alt <= 30000.0f; alt += 2500.0f) {
+                ASSERT_EQ(0, WMM_GetMagVector(lat, lon, alt, MONTH, DAY, YEAR, B));
+                referenceMagVector(lat, lon, alt, ref);
+                worst = fmaxf(worst, maxError(B, ref));
+            }
+        }
+    }
+    printf("wmm: sweep max error %.4f x 100nT\n", worst);
+    EXPECT_LT(worst, 0.01f);
+}
+
+TEST_F(WorldMagModelTest, DateChange) {
+    float B2014[3], B2012[3], ref[3];
+
+    ASSERT_EQ(0, WMM_GetMagVector(47.0f, 8.0f, 500.0f, MONTH, DAY, YEAR, B2014));
+    ASSERT_EQ(0, WMM_GetMagVector(47.0f, 8.0f, 500.0f, MONTH, DAY, 2012, B2012));
+    referenceMagVector(47.0f, 8.0f, 500.0f, ref);
+
+    // the coefficients follow the date
+    EXPECT_LT(maxError(B2012, ref), 1e-4f);
+    EXPECT_GT(maxError(B2012, B2014), 0.1f);
+}
+
+TEST_F(WorldMagModelTest, Release) {
+    float B[3];
+
+    EXPECT_EQ(1, wmmBlocks);
+    WMM_Release();
+    EXPECT_EQ(0, wmmBlocks);
+
+    // the next lookup starts over, as GPS does when the home location changes
+    ASSERT_EQ(0, WMM_GetMagVector(golden[9][0], golden[9][1], golden[9][2], MONTH, DAY, YEAR, B));
+    EXPECT_EQ(1, wmmBlocks);
+    EXPECT_NEAR(golden[9][3], B[0], 0.01f);
+    EXPECT_NEAR(golden[9][4], B[1], 0.01f);
+    EXPECT_NEAR(golden[9][5], B[2], 0.01f);
+}
+
+#define BENCHMARK_POINTS 20000
+
+TEST_F(WorldMagModelTest, Benchmark) {
+    static float lat[BENCHMARK_POINTS], lon[BENCHMARK_POINTS], alt[BENCHMARK_POINTS];
+    struct timespec start;
+    float B[3];
+    volatile float sink = 0.0f;
+
+    for (int i = 0; i < BENCHMARK_POINTS; i++) {
+        lat[i] = randomFloat(-85.0f, 85.0f);
+        lon[i] = randomFloat(-180.0f, 180.0f);
+        alt[i] = randomFloat(0.0f, 10000.0f);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_POINTS; i++) {
+        referenceMagVector(lat[i], lon[i], alt[i], B);
+        sink += B[0];
+    }
+    double reference = BENCHMARK_POINTS / elapsed(&start);
+
+    // random points, the coefficients are reused
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_POINTS; i++) {
+        WMM_GetMagVector(lat[i], lon[i], alt[i], MONTH, DAY, YEAR, B);
+        sink += B[0];
+    }
+    double cold = BENCHMARK_POINTS / elapsed(&start);
+
+    // one lookup from scratch, the way GPS sets the home location
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_POINTS; i++) {
+        WMM_GetMagVector(lat[i], lon[i], alt[i], MONTH, DAY, YEAR, B);
+        WMM_Release();
+        sink += B[0];
+    }
+    double home = BENCHMARK_POINTS / elapsed(&start);
+
+    printf("wmm: reference %.0f/s, repeated %.0f/s, single %.0f/s\n", reference, cold, home);
+}
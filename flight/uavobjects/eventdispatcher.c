@@ -44,6 +44,8 @@
 #define CALLBACK_PRIORITY    CALLBACK_PRIORITY_CRITICAL
 #define TASK_PRIORITY        CALLBACK_TASK_FLIGHTCONTROL
 #define MAX_UPDATE_PERIOD_MS 1000
+#define HEAP_GROW_STEP       16
+#define HEAP_INDEX_NONE      0xFFFF
 
 // Private types
 
@@ -65,12 +67,16 @@ struct PeriodicObjectListStruct {
     EventCallbackInfo evInfo; /** Event callback information */
     uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
     int32_t  timeToNextUpdateMs; /** Time delay to the next update */
+    uint16_t heapIndex; /** Position in the deadline heap or HEAP_INDEX_NONE if not scheduled */
     struct PeriodicObjectListStruct *next; /** Needed by linked list library (utlist.h) */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
 // Private variables
 static PeriodicObjectList *mObjList;
+static PeriodicObjectList **mHeap; /** Binary min-heap of scheduled entries, keyed on timeToNextUpdateMs */
+static uint16_t mHeapSize;
+static uint16_t mHeapCapacity;
 static xQueueHandle mQueue;
 static DelayedCallbackInfo *eventSchedulerCallback;
 static xSemaphoreHandle mMutex;
@@ -82,6 +88,10 @@ static void eventTask();
 static int32_t eventPeriodicCreate(UAVObjEvent *ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static int32_t eventPeriodicUpdate(UAVObjEvent *ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static uint16_t randomizePeriod(uint16_t periodMs);
+static void heapSchedule(PeriodicObjectList *objEntry);
+static void heapRemove(PeriodicObjectList *objEntry);
+static void heapSiftUp(uint16_t index);
+static void heapSiftDown(uint16_t index);
 
 
 /**
@@ -91,7 +101,10 @@ static uint16_t randomizePeriod(uint16_t periodMs);
 int32_t EventDispatcherInitialize()
 {
     // Initialize variables
-    mObjList = NULL;
+    mObjList      = NULL;
+    mHeap         = NULL;
+    mHeapSize     = 0;
+    mHeapCapacity = 0;
     memset(&mStats, 0, sizeof(EventStats));
 
     // Create mMutex
@@ -230,6 +243,7 @@ static int32_t eventPeriodicCreate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
     // Create handle
     objEntry = (PeriodicObjectList *)pios_malloc(sizeof(PeriodicObjectList));
     if (objEntry == NULL) {
+        xSemaphoreGiveRecursive(mMutex);
         return -1;
     }
     objEntry->evInfo.ev.obj      = ev->obj;
@@ -239,8 +253,10 @@ static int32_t eventPeriodicCreate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
     objEntry->evInfo.queue       = queue;
     objEntry->updatePeriodMs     = periodMs;
     objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
-    // Add to list
+    objEntry->heapIndex = HEAP_INDEX_NONE;
+    // Add to list and schedule
     LL_APPEND(mObjList, objEntry);
+    heapSchedule(objEntry);
     // Release lock
     xSemaphoreGiveRecursive(mMutex);
     return 0;
@@ -270,6 +286,7 @@ static int32_t eventPeriodicUpdate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
             // Object found, update period
             objEntry->updatePeriodMs     = periodMs;
             objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
+            heapSchedule(objEntry);
             // Release lock
             xSemaphoreGiveRecursive(mMutex);
             return 0;
@@ -312,6 +329,7 @@ static void eventTask()
 
 /**
  * Handle periodic updates for all objects.
+ * Only the entries that are due are touched, the heap root holds the next deadline.
  * \return The system time until the next update (in ms) or -1 if failed
  */
 static int32_t processPeriodicUpdates()
@@ -320,48 +338,158 @@ static int32_t processPeriodicUpdates()
     int32_t timeNow;
     int32_t timeToNextUpdate;
     int32_t offset;
+    uint16_t limit;
 
     // Get lock
     xSemaphoreTakeRecursive(mMutex, portMAX_DELAY);
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update.
-    timeToNextUpdate = xTaskGetTickCount() * portTICK_RATE_MS + MAX_UPDATE_PERIOD_MS;
-    LL_FOREACH(mObjList, objEntry) {
-        // If object is configured for periodic updates
-        if (objEntry->updatePeriodMs > 0) {
-            // Check if time for the next update
-            timeNow = xTaskGetTickCount() * portTICK_RATE_MS;
-            if (objEntry->timeToNextUpdateMs <= timeNow) {
-                // Reset timer
-                offset = (timeNow - objEntry->timeToNextUpdateMs) % objEntry->updatePeriodMs;
-                objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-                // Invoke callback, if one
-                if (objEntry->evInfo.cb != 0) {
-                    objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
-                }
-                // Push event to queue, if one
-                if (objEntry->evInfo.queue != 0) {
-                    if (xQueueSend(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != pdTRUE && !objEntry->evInfo.ev.lowPriority) { // do not block if queue is full
-                        if (objEntry->evInfo.ev.obj != NULL) {
-                            mStats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-                        }
-                        ++mStats.eventErrors;
-                    }
+    timeNow = xTaskGetTickCount() * portTICK_RATE_MS;
+
+    // Pop every due entry from the heap root, reschedule it and transmit the object.
+    // Each entry is processed at most once per call, even if a callback reschedules it.
+    limit = mHeapSize;
+    while (limit-- && mHeapSize > 0 && mHeap[0]->timeToNextUpdateMs <= timeNow) {
+        objEntry = mHeap[0];
+        // Reset timer
+        offset   = (timeNow - objEntry->timeToNextUpdateMs) % objEntry->updatePeriodMs;
+        objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
+        heapSiftDown(0);
+        // Invoke callback, if one
+        if (objEntry->evInfo.cb != 0) {
+            objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
+        }
+        // Push event to queue, if one
+        if (objEntry->evInfo.queue != 0) {
+            if (xQueueSend(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != pdTRUE && !objEntry->evInfo.ev.lowPriority) { // do not block if queue is full
+                if (objEntry->evInfo.ev.obj != NULL) {
+                    mStats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
                 }
-            }
-            // Update minimum delay
-            if (objEntry->timeToNextUpdateMs < timeToNextUpdate) {
-                timeToNextUpdate = objEntry->timeToNextUpdateMs;
+                ++mStats.eventErrors;
             }
         }
     }
 
+    // The smallest delay to the next update is at the heap root
+    timeToNextUpdate = timeNow + MAX_UPDATE_PERIOD_MS;
+    if (mHeapSize > 0 && mHeap[0]->timeToNextUpdateMs < timeToNextUpdate) {
+        timeToNextUpdate = mHeap[0]->timeToNextUpdateMs;
+    }
+
     // Done
     xSemaphoreGiveRecursive(mMutex);
     return timeToNextUpdate;
 }
 
+/**
+ * Insert, move or remove an entry in the deadline heap after its period or
+ * deadline changed. Entries with a zero period are not scheduled.
+ * Must be called with mMutex held.
+ * \param[in] objEntry The entry to (re)schedule
+ */
+static void heapSchedule(PeriodicObjectList *objEntry)
+{
+    if (objEntry->updatePeriodMs == 0) {
+        heapRemove(objEntry);
+        return;
+    }
+
+    if (objEntry->heapIndex != HEAP_INDEX_NONE) {
+        // Deadline changed in either direction
+        heapSiftUp(objEntry->heapIndex);
+        heapSiftDown(objEntry->heapIndex);
+        return;
+    }
+
+    if (mHeapSize == mHeapCapacity) {
+        PeriodicObjectList **newHeap = (PeriodicObjectList **)pios_malloc((mHeapCapacity + HEAP_GROW_STEP) * sizeof(PeriodicObjectList *));
+        if (newHeap == NULL) {
+            ++mStats.eventErrors;
+            return;
+        }
+        if (mHeap != NULL) {
+            memcpy(newHeap, mHeap, mHeapSize * sizeof(PeriodicObjectList *));
+            pios_free(mHeap);
+        }
+        mHeap = newHeap;
+        mHeapCapacity += HEAP_GROW_STEP;
+    }
+
+    objEntry->heapIndex = mHeapSize;
+    mHeap[mHeapSize++]  = objEntry;
+    heapSiftUp(objEntry->heapIndex);
+}
+
+/**
+ * Remove an entry from the deadline heap, if scheduled.
+ * Must be called with mMutex held.
+ * \param[in] objEntry The entry to remove
+ */
+static void heapRemove(PeriodicObjectList *objEntry)
+{
+    PeriodicObjectList *moved;
+    uint16_t index = objEntry->heapIndex;
+
+    if (index == HEAP_INDEX_NONE) {
+        return;
+    }
+
+    objEntry->heapIndex = HEAP_INDEX_NONE;
+    if (index != --mHeapSize) {
+        // Fill the hole with the last entry and restore the heap property around it
+        moved = mHeap[mHeapSize];
+        mHeap[index]     = moved;
+        moved->heapIndex = index;
+        heapSiftUp(index);
+        heapSiftDown(moved->heapIndex);
+    }
+}
+
+/**
+ * Move a heap entry towards the root while its deadline is earlier than its parent's.
+ */
+static void heapSiftUp(uint16_t index)
+{
+    PeriodicObjectList *objEntry = mHeap[index];
+
+    while (index > 0) {
+        uint16_t parent = (index - 1) / 2;
+        if (mHeap[parent]->timeToNextUpdateMs <= objEntry->timeToNextUpdateMs) {
+            break;
+        }
+        mHeap[index] = mHeap[parent];
+        mHeap[index]->heapIndex = index;
+        index = parent;
+    }
+    mHeap[index] = objEntry;
+    objEntry->heapIndex = index;
+}
+
+/**
+ * Move a heap entry towards the leaves while its deadline is later than one of its children's.
+ */
+static void heapSiftDown(uint16_t index)
+{
+    PeriodicObjectList *objEntry = mHeap[index];
+
+    for (;;) {
+        uint16_t child = 2 * index + 1;
+        if (child >= mHeapSize) {
+            break;
+        }
+        if (child + 1 < mHeapSize && mHeap[child + 1]->timeToNextUpdateMs < mHeap[child]->timeToNextUpdateMs) {
+            ++child;
+        }
+        if (objEntry->timeToNextUpdateMs <= mHeap[child]->timeToNextUpdateMs) {
+            break;
+        }
+        mHeap[index] = mHeap[child];
+        mHeap[index]->heapIndex = index;
+        index = child;
+    }
+    mHeap[index] = objEntry;
+    objEntry->heapIndex = index;
+}
+
 /**
  * Return a psedorandom integer from 0 to periodMs
  * Based on the Park-Miller-Carta Pseudo-Random Number Generator
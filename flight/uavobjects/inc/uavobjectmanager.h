@@ -34,6 +34,7 @@
 
 #define UAVOBJ_ALL_INSTANCES                   0xFFFF
 #define UAVOBJ_MAX_INSTANCES                   1000
+#define UAVOBJ_MAX_SAVE_LIST                   16
 
 /*
  * Shifts and masks used to read/write metadata flags.
@@ -62,14 +63,14 @@ typedef void *UAVObjHandle;
 // we have limited trust in our compiler
 // make sure this macro actually works on all platforms
 
-typedef struct __attribute__((__packed__)) {
+typedef struct {
     uint16_t element1;
     uint16_t element2;
     uint16_t element3;
 }
 __DummyUAVObjectFieldData;
 
-typedef struct __attribute__((__packed__)) {
+typedef struct {
     uint16_t array[3];
 }
 __DummyUAVObjectFieldDataArray;
@@ -172,6 +173,61 @@ typedef void (*UAVObjEventCallback)(UAVObjEvent *ev);
  */
 typedef void (*UAVObjInitializeCallback)(UAVObjHandle obj_handle, uint16_t instId);
 
+/**
+ * Field types, numbered as in the object definitions
+ */
+typedef enum {
+    UAVOBJ_FIELDTYPE_INT8 = 0,
+    UAVOBJ_FIELDTYPE_INT16,
+    UAVOBJ_FIELDTYPE_INT32,
+    UAVOBJ_FIELDTYPE_UINT8,
+    UAVOBJ_FIELDTYPE_UINT16,
+    UAVOBJ_FIELDTYPE_UINT32,
+    UAVOBJ_FIELDTYPE_FLOAT32,
+    UAVOBJ_FIELDTYPE_ENUM
+} UAVObjFieldType;
+
+/**
+ * Field descriptor, generated for each field of an object and kept in flash.
+ * Names are only kept as a hash, see UAVObjFieldNameHash().
+ */
+typedef struct {
+    uint32_t nameHash;
+    uint16_t offset; /** Byte offset of the field in the object data */
+    uint16_t type        : 4; /** UAVObjFieldType */
+    uint16_t numElements : 12; /** Number of elements, 1 for plain fields */
+} UAVObjFieldInfo;
+
+/**
+ * All field descriptors of an object, in data order
+ */
+typedef struct {
+    const UAVObjFieldInfo *fields;
+    uint8_t numFields;
+} UAVObjFieldTable;
+
+#define UAVOBJ_MAX_FIELDS 64
+
+/**
+ * Size in bytes of the field data, all elements
+ */
+static inline uint32_t UAVObjFieldNumBytes(const UAVObjFieldInfo *field)
+{
+    switch (field->type) {
+    case UAVOBJ_FIELDTYPE_INT16:
+    case UAVOBJ_FIELDTYPE_UINT16:
+        return 2 * field->numElements;
+
+    case UAVOBJ_FIELDTYPE_INT32:
+    case UAVOBJ_FIELDTYPE_UINT32:
+    case UAVOBJ_FIELDTYPE_FLOAT32:
+        return 4 * field->numElements;
+
+    default:
+        return field->numElements;
+    }
+}
+
 /**
  * Event manager statistics
  */
@@ -185,7 +241,7 @@ typedef struct {
 int32_t UAVObjInitialize();
 void UAVObjGetStats(UAVObjStats *statsOut);
 void UAVObjClearStats();
-UAVObjHandle UAVObjRegister(uint32_t id, bool isSingleInstance, bool isSettings, bool isPriority, uint32_t num_bytes, UAVObjInitializeCallback initCb);
+UAVObjHandle UAVObjRegister(uint32_t id, bool isSingleInstance, bool isSettings, bool isPriority, uint32_t num_bytes, UAVObjInitializeCallback initCb, const UAVObjFieldTable *fieldTable);
 UAVObjHandle UAVObjGetByID(uint32_t id);
 uint32_t UAVObjGetID(UAVObjHandle obj);
 uint32_t UAVObjGetNumBytes(UAVObjHandle obj);
@@ -202,6 +258,7 @@ uint8_t UAVObjUpdateCRC(UAVObjHandle obj_handle, uint16_t instId, uint8_t crc);
 int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId);
 int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId);
 int32_t UAVObjDelete(UAVObjHandle obj_handle, uint16_t instId);
+int32_t UAVObjSaveList(const UAVObjHandle *obj_handles, uint8_t count, uint16_t instId);
 int32_t UAVObjSaveSettings();
 int32_t UAVObjLoadSettings();
 int32_t UAVObjDeleteSettings();
@@ -216,6 +273,13 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId, const vo
 int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void *dataIn, uint32_t offset, uint32_t size);
 int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId, void *dataOut);
 int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, void *dataOut, uint32_t offset, uint32_t size);
+uint32_t UAVObjFieldNameHash(const char *name);
+uint8_t UAVObjGetNumFields(UAVObjHandle obj_handle);
+const UAVObjFieldInfo *UAVObjGetFieldInfo(UAVObjHandle obj_handle, uint8_t index);
+int16_t UAVObjFindField(UAVObjHandle obj_handle, uint32_t nameHash);
+int32_t UAVObjSetInstanceField(UAVObjHandle obj_handle, uint16_t instId, uint8_t index, const void *dataIn);
+int32_t UAVObjGetInstanceField(UAVObjHandle obj_handle, uint16_t instId, uint8_t index, void *dataOut);
+int32_t UAVObjGetChangedFields(UAVObjHandle obj_handle, uint16_t instId, const void *reference, uint64_t *changed);
 int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata *dataIn);
 int32_t UAVObjGetMetadata(UAVObjHandle obj_handle, UAVObjMetadata *dataOut);
 uint8_t UAVObjGetMetadataAccess(const UAVObjMetadata *dataOut);
@@ -119,6 +119,7 @@ struct UAVOData {
      */
     struct UAVOMeta metaObj;
     uint16_t instance_size;
+    const UAVObjFieldTable *field_table;
 } __attribute__((packed, aligned(4)));
 
 /* Augmented type for Single Instance Data UAVO */
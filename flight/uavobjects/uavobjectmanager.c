@@ -49,6 +49,11 @@ int32_t UAVObjPers_stub(__attribute__((unused)) UAVObjHandle obj_handle, __attri
 int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)  __attribute__((weak, alias("UAVObjPers_stub")));;
 int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId) __attribute__((weak, alias("UAVObjPers_stub")));
 int32_t UAVObjDelete(UAVObjHandle obj_handle, uint16_t instId) __attribute__((weak, alias("UAVObjPers_stub")));
+int32_t UAVObjPersList_stub(__attribute__((unused)) const UAVObjHandle *obj_handles, __attribute__((unused)) uint8_t count, __attribute__((unused)) uint16_t instId)
+{
+    return 0;
+}
+int32_t UAVObjSaveList(const UAVObjHandle *obj_handles, uint8_t count, uint16_t instId) __attribute__((weak, alias("UAVObjPersList_stub")));
 
 
 // Private variables
@@ -205,13 +210,15 @@ static struct UAVOData *UAVObjAllocMulti(uint32_t num_bytes)
  * \param[in] isSettings Is this a settings object
  * \param[in] numBytes Number of bytes of object data (for one instance)
  * \param[in] initCb Default field and metadata initialization function
+ * \param[in] fieldTable Field descriptors, may be NULL
  * \return Object handle, or NULL if failure.
  * \return
  */
 UAVObjHandle UAVObjRegister(uint32_t id,
                             bool isSingleInstance, bool isSettings, bool isPriority,
                             uint32_t num_bytes,
-                            UAVObjInitializeCallback initCb)
+                            UAVObjInitializeCallback initCb,
+                            const UAVObjFieldTable *fieldTable)
 {
     struct UAVOData *uavo_data = NULL;
 
@@ -236,6 +243,7 @@ UAVObjHandle UAVObjRegister(uint32_t id,
     /* Fill in the details about this UAVO */
     uavo_data->id = id;
     uavo_data->instance_size = num_bytes;
+    uavo_data->field_table   = fieldTable;
     if (isSettings) {
         uavo_data->base.flags.isSettings = true;
         // settings defaults to being sent with priority
@@ -1106,6 +1114,161 @@ unlock_exit:
     return rc;
 }
 
+/**
+ * Hash of a field name, as stored in UAVObjFieldInfo.nameHash.
+ * Same Shift-Add-XOR hash the generator uses for the object IDs.
+ * \param[in] name The field name as in the object definition
+ * \return The hash
+ */
+uint32_t UAVObjFieldNameHash(const char *name)
+{
+    uint32_t hash = 0;
+
+    while (*name) {
+        hash ^= (hash << 5) + (hash >> 2) + (uint8_t)*name++;
+    }
+    return hash;
+}
+
+/**
+ * Get the field descriptors of a data object
+ */
+static const UAVObjFieldTable *getFieldTable(UAVObjHandle obj_handle)
+{
+    PIOS_Assert(obj_handle);
+
+    if (UAVObjIsMetaobject(obj_handle)) {
+        return NULL;
+    }
+    return ((struct UAVOData *)obj_handle)->field_table;
+}
+
+/**
+ * Get the number of fields of an object
+ * \param[in] obj The object handle
+ * \return The number of fields, 0 for metaobjects
+ */
+uint8_t UAVObjGetNumFields(UAVObjHandle obj_handle)
+{
+    const UAVObjFieldTable *table = getFieldTable(obj_handle);
+
+    return table ? table->numFields : 0;
+}
+
+/**
+ * Get the descriptor of a field
+ * \param[in] obj The object handle
+ * \param[in] index The field index, in data order
+ * \return The field descriptor or NULL if there is no such field
+ */
+const UAVObjFieldInfo *UAVObjGetFieldInfo(UAVObjHandle obj_handle, uint8_t index)
+{
+    const UAVObjFieldTable *table = getFieldTable(obj_handle);
+
+    if (!table || index >= table->numFields) {
+        return NULL;
+    }
+    return &table->fields[index];
+}
+
+/**
+ * Find a field by name
+ * \param[in] obj The object handle
+ * \param[in] nameHash The field name hash, see UAVObjFieldNameHash()
+ * \return The field index or -1 if not found
+ */
+int16_t UAVObjFindField(UAVObjHandle obj_handle, uint32_t nameHash)
+{
+    const UAVObjFieldTable *table = getFieldTable(obj_handle);
+
+    if (table) {
+        for (uint8_t n = 0; n < table->numFields; n++) {
+            if (table->fields[n].nameHash == nameHash) {
+                return n;
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * Set the data of one field of a specific object instance
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] index The field index
+ * \param[in] dataIn The field data, all elements
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetInstanceField(UAVObjHandle obj_handle, uint16_t instId, uint8_t index, const void *dataIn)
+{
+    const UAVObjFieldInfo *field = UAVObjGetFieldInfo(obj_handle, index);
+
+    if (!field) {
+        return -1;
+    }
+    return UAVObjSetInstanceDataField(obj_handle, instId, dataIn, field->offset, UAVObjFieldNumBytes(field));
+}
+
+/**
+ * Get the data of one field of a specific object instance
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] index The field index
+ * \param[out] dataOut The field data, all elements
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjGetInstanceField(UAVObjHandle obj_handle, uint16_t instId, uint8_t index, void *dataOut)
+{
+    const UAVObjFieldInfo *field = UAVObjGetFieldInfo(obj_handle, index);
+
+    if (!field) {
+        return -1;
+    }
+    return UAVObjGetInstanceDataField(obj_handle, instId, dataOut, field->offset, UAVObjFieldNumBytes(field));
+}
+
+/**
+ * Compare an object instance with an earlier copy of its data, field by field
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] reference The earlier copy, a complete object data structure
+ * \param[out] changed Bit n is set if field n differs
+ * \return The number of fields that differ or -1 if failure
+ */
+int32_t UAVObjGetChangedFields(UAVObjHandle obj_handle, uint16_t instId, const void *reference, uint64_t *changed)
+{
+    const UAVObjFieldTable *table = getFieldTable(obj_handle);
+
+    if (!table) {
+        return -1;
+    }
+
+    // Lock
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+
+    int32_t rc = -1;
+
+    // Get instance information
+    InstanceHandle instEntry = getInstance((struct UAVOData *)obj_handle, instId);
+    if (instEntry == NULL) {
+        goto unlock_exit;
+    }
+
+    *changed = 0;
+    rc = 0;
+    for (uint8_t n = 0; n < table->numFields; n++) {
+        const UAVObjFieldInfo *field = &table->fields[n];
+        if (memcmp(InstanceData(instEntry) + field->offset, (const uint8_t *)reference + field->offset, UAVObjFieldNumBytes(field))) {
+            *changed |= (uint64_t)1 << n;
+            rc++;
+        }
+    }
+
+unlock_exit:
+    xSemaphoreGiveRecursive(mutex);
+    return rc;
+}
+
 /**
  * Set the object metadata
  * \param[in] obj The object handle
@@ -69,6 +69,50 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
     return 0;
 }
 
+/**
+ * Save a set of objects to the file system in one batch, previous versions are
+ * replaced in a single pass and garbage collection runs at most once.
+ * @param[in] obj_handles The object handles, each object must only be listed once
+ * @param[in] count Number of objects, at most UAVOBJ_MAX_SAVE_LIST
+ * @param[in] instId The instance ID saved of every object
+ * @return 0 if success or -1 if failure
+ */
+int32_t UAVObjSaveList(const UAVObjHandle *obj_handles, uint8_t count, uint16_t instId)
+{
+    struct PIOS_FLASHFS_ObjItem items[UAVOBJ_MAX_SAVE_LIST];
+
+    if (count > UAVOBJ_MAX_SAVE_LIST) {
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        UAVObjHandle obj_handle = obj_handles[i];
+        PIOS_Assert(obj_handle);
+
+        items[i].obj_id      = UAVObjGetID(obj_handle);
+        items[i].obj_inst_id = instId;
+        items[i].obj_size    = UAVObjGetNumBytes(obj_handle);
+
+        if (UAVObjIsMetaobject(obj_handle)) {
+            if (instId != 0) {
+                return -1;
+            }
+            items[i].obj_data = (uint8_t *)MetaDataPtr((struct UAVOMeta *)obj_handle);
+        } else {
+            InstanceHandle instEntry = getInstance((struct UAVOData *)obj_handle, instId);
+
+            if (instEntry == NULL || InstanceData(instEntry) == NULL) {
+                return -1;
+            }
+            items[i].obj_data = InstanceData(instEntry);
+        }
+    }
+
+    if (PIOS_FLASHFS_ObjSaveBatch(pios_uavo_settings_fs_id, items, count) != 0) {
+        return -1;
+    }
+    return 0;
+}
 
 /**
  * Load an object from the file system (SD card).
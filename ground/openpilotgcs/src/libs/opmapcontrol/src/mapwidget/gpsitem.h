@@ -39,7 +39,6 @@
 #include <QtSvg/QSvgRenderer>
 #include "opmapwidget.h"
 #include "trailitem.h"
-#include "traillineitem.h"
 namespace mapcontrol {
 class WayPointItem;
 class OPMapWidget;
@@ -191,6 +190,19 @@ public:
      * @brief Deletes all the trail points
      */
     void DeleteTrail() const;
+    /**
+     * @brief Sets how many trail points are kept, the oldest are dropped first
+     *
+     * @param value
+     */
+    void SetTrailMaxPoints(int const & value)
+    {
+        trail->SetMaxPoints(value);
+    }
+    int TrailMaxPoints() const
+    {
+        return trail->MaxPoints();
+    }
     /**
      * @brief Returns true if the UAV automaticaly sets WP reached value (changing its color)
      *
@@ -242,9 +254,7 @@ private:
     QPixmap pic;
     core::Point localposition;
     OPMapWidget *mapwidget;
-    QGraphicsItemGroup *trail;
-    QGraphicsItemGroup *trailLine;
-    internals::PointLatLng lasttrailline;
+    TrailItem *trail;
     QTime timer;
     bool showtrail;
     bool showtrailline;
@@ -261,8 +271,6 @@ public slots:
 signals:
     void UAVReachedWayPoint(int const & waypointnumber, WayPointItem *waypoint);
     void UAVLeftSafetyBouble(internals::PointLatLng const & position);
-    void setChildPosition();
-    void setChildLine();
 };
 }
 #endif // GPSITEM_H
@@ -3,7 +3,7 @@
  *
  * @file       trailitem.cpp
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @brief      A graphicsItem representing a trail point
+ * @brief      A graphicsItem representing the trail of a UAV
  * @see        The GNU Public License (GPL) Version 3
  * @defgroup   OPMapWidget
  * @{
@@ -25,14 +25,25 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 #include "trailitem.h"
-#include <QDateTime>
+#include <QtCore/qmath.h>
+
+// #define DEBUG_TRAILITEM
+#ifdef DEBUG_TRAILITEM
+#include <QElapsedTimer>
+#include <QDebug>
+#endif
+
 namespace mapcontrol {
-TrailItem::TrailItem(internals::PointLatLng const & coord, int const & altitude, QBrush color, MapGraphicItem *map) : QGraphicsItem(map), coord(coord), m_brush(color), m_map(map)
-{
-    QDateTime time    = QDateTime::currentDateTime();
-    QString coord_str = " " + QString::number(coord.Lat(), 'f', 6) + "   " + QString::number(coord.Lng(), 'f', 6);
+// points closer than this on screen are drawn as one
+static const qreal SimplifyPixels = 2.0;
+static const qreal PointRadius    = 2.0;
 
-    setToolTip(QString(tr("Position:") + "%1\n" + tr("Altitude:") + "%2\n" + tr("Time:") + "%3").arg(coord_str).arg(QString::number(altitude)).arg(time.toString()));
+TrailItem::TrailItem(QColor const & pointColor, QColor const & lineColor, MapGraphicItem *map) : QGraphicsItem(map), m_map(map),
+    m_pointColor(pointColor), m_lineColor(lineColor), points(DefaultMaxPoints), first(0), count(0), showpoints(true), showline(true),
+    zoom(-1), provisionaltail(false)
+{
+    connect(map, SIGNAL(childRefreshPosition()), this, SLOT(RefreshPos()));
+    connect(map, SIGNAL(zoomChanged(double, double, double)), this, SLOT(RefreshPos()));
 }
 
 void TrailItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
@@ -40,22 +51,174 @@ void TrailItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
     Q_UNUSED(option);
     Q_UNUSED(widget);
 
-    painter->setBrush(m_brush);
-    painter->drawEllipse(-2, -2, 4, 4);
+#ifdef DEBUG_TRAILITEM
+    QElapsedTimer timer;
+    timer.start();
+#endif
+
+    if (showline && path.size() > 1) {
+        QPen pen(m_lineColor);
+        pen.setWidth(1);
+        painter->setPen(pen);
+        painter->drawPolyline(path);
+    }
+    if (showpoints) {
+        painter->setPen(Qt::black);
+        painter->setBrush(m_pointColor);
+        foreach(QPointF point, path) {
+            painter->drawEllipse(point, PointRadius, PointRadius);
+        }
+    }
+
+#ifdef DEBUG_TRAILITEM
+    qDebug() << "TrailItem: painted" << path.size() << "of" << count << "points in" << timer.nsecsElapsed() / 1000 << "us";
+#endif
 }
+
 QRectF TrailItem::boundingRect() const
 {
-    return QRectF(-2, -2, 4, 4);
+    return bounds;
 }
 
-
 int TrailItem::type() const
 {
     return Type;
 }
 
-void TrailItem::setPosSLOT()
+void TrailItem::AddPoint(internals::PointLatLng const & coord, int const & altitude)
+{
+    if (count == points.size()) {
+        // drop a block of the oldest points at once, the path is then
+        // projected again, so a full trail does not do it on every point
+        int drop = qMax(1, points.size() / 16);
+        first  = (first + drop) % points.size();
+        count -= drop;
+        zoom   = -1;
+    }
+
+    TrailPoint &point = points[(first + count) % points.size()];
+    point.coord    = coord;
+    point.altitude = altitude;
+    count++;
+
+    if (count == 1 || zoom != m_map->ZoomTotal()) {
+        Project();
+    } else {
+        core::Point local = m_map->FromLatLngToLocal(coord);
+        core::Point base  = m_map->FromLatLngToLocal(origin);
+        prepareGeometryChange();
+        AppendLocal(QPointF(local.X() - base.X(), local.Y() - base.Y()));
+    }
+}
+
+void TrailItem::Clear()
+{
+    prepareGeometryChange();
+    first  = 0;
+    count  = 0;
+    path.clear();
+    bounds = QRectF();
+    provisionaltail = false;
+}
+
+void TrailItem::SetMaxPoints(int const & value)
+{
+    int size = qMax(1, value);
+
+    if (size == points.size()) {
+        return;
+    }
+
+    // keep the newest points that still fit
+    QVector<TrailPoint> kept(size);
+    int keep = qMin(count, size);
+    for (int i = 0; i < keep; i++) {
+        kept[i] = points[(first + count - keep + i) % points.size()];
+    }
+    points = kept;
+    first  = 0;
+    count  = keep;
+    Project();
+}
+
+void TrailItem::SetShowPoints(bool const & value)
+{
+    showpoints = value;
+    UpdateVisibility();
+    update();
+}
+
+void TrailItem::SetShowLine(bool const & value)
+{
+    showline = value;
+    UpdateVisibility();
+    update();
+}
+
+void TrailItem::UpdateVisibility()
+{
+    setVisible(showpoints || showline);
+}
+
+/**
+ * Projects all the points at the current zoom level and simplifies them
+ */
+void TrailItem::Project()
+{
+    prepareGeometryChange();
+    path.clear();
+    bounds = QRectF();
+    provisionaltail = false;
+    zoom   = m_map->ZoomTotal();
+
+    if (count == 0) {
+        return;
+    }
+
+    origin = points[first].coord;
+    core::Point base = m_map->FromLatLngToLocal(origin);
+    for (int i = 0; i < count; i++) {
+        core::Point local = m_map->FromLatLngToLocal(points[(first + i) % points.size()].coord);
+        AppendLocal(QPointF(local.X() - base.X(), local.Y() - base.Y()));
+    }
+    setPos(base.X(), base.Y());
+}
+
+/**
+ * Adds a point to the simplified path. A point too close to the last kept
+ * one is only shown as the provisional tail, until the trail moves further.
+ */
+void TrailItem::AppendLocal(QPointF const & point)
+{
+    if (path.isEmpty()) {
+        path.append(point);
+    } else {
+        QPointF anchor = provisionaltail && path.size() > 1 ? path.at(path.size() - 2) : path.last();
+        QPointF delta  = point - anchor;
+        bool far = delta.x() * delta.x() + delta.y() * delta.y() >= SimplifyPixels * SimplifyPixels;
+
+        if (provisionaltail) {
+            path.last() = point;
+        } else {
+            path.append(point);
+        }
+        provisionaltail = !far;
+    }
+
+    qreal margin = PointRadius + 1;
+    bounds = bounds.united(QRectF(point.x() - margin, point.y() - margin, 2 * margin, 2 * margin));
+}
+
+void TrailItem::RefreshPos()
 {
-    setPos(m_map->FromLatLngToLocal(this->coord).X(), m_map->FromLatLngToLocal(this->coord).Y());
+    if (count == 0) {
+        return;
+    }
+    if (zoom != m_map->ZoomTotal()) {
+        Project();
+        return;
+    }
+    core::Point base = m_map->FromLatLngToLocal(origin);
+    setPos(base.X(), base.Y());
 }
 }
@@ -3,7 +3,7 @@
  *
  * @file       trailitem.h
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @brief      A graphicsItem representing a WayPoint
+ * @brief      A graphicsItem representing the trail of a UAV
  * @see        The GNU Public License (GPL) Version 3
  * @defgroup   OPMapWidget
  * @{
@@ -29,28 +29,88 @@
 
 #include <QGraphicsItem>
 #include <QPainter>
-#include <QLabel>
+#include <QVector>
+#include <QPolygonF>
 #include "../internals/pointlatlng.h"
 #include <QObject>
 #include "mapgraphicitem.h"
 
 namespace mapcontrol {
+/**
+ * @brief The whole trail of a UAV, painted as one polyline
+ *
+ * The points are kept in a ring buffer, the oldest are dropped once
+ * MaxPoints() is reached. They are projected and simplified once per
+ * zoom level, panning the map only moves the item.
+ *
+ * @class TrailItem trailitem.h "mapwidget/trailitem.h"
+ */
 class TrailItem : public QObject, public QGraphicsItem {
     Q_OBJECT Q_INTERFACES(QGraphicsItem)
 public:
     enum { Type = UserType + 3 };
-    TrailItem(internals::PointLatLng const & coord, int const & altitude, QBrush color, MapGraphicItem *map);
+    TrailItem(QColor const & pointColor, QColor const & lineColor, MapGraphicItem *map);
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
                QWidget *widget);
     QRectF boundingRect() const;
     int type() const;
-    internals::PointLatLng coord;
+
+    void AddPoint(internals::PointLatLng const & coord, int const & altitude);
+    void Clear();
+    int Count() const
+    {
+        return count;
+    }
+    /**
+     * @brief Sets how many trail points are kept, the oldest are dropped first
+     */
+    void SetMaxPoints(int const & value);
+    int MaxPoints() const
+    {
+        return points.size();
+    }
+    void SetShowPoints(bool const & value);
+    bool ShowPoints() const
+    {
+        return showpoints;
+    }
+    void SetShowLine(bool const & value);
+    bool ShowLine() const
+    {
+        return showline;
+    }
+
+    static const int DefaultMaxPoints = 10000;
+
 private:
-    QBrush m_brush;
+    struct TrailPoint {
+        internals::PointLatLng coord;
+        int altitude;
+    };
+
+    void Project();
+    void AppendLocal(QPointF const & point);
+    void UpdateVisibility();
+
     MapGraphicItem *m_map;
+    QColor m_pointColor;
+    QColor m_lineColor;
+    QVector<TrailPoint> points;
+    int first;
+    int count;
+    bool showpoints;
+    bool showline;
+
+    // the item sits on the oldest point, the path is relative to it
+    internals::PointLatLng origin;
+    double zoom;
+    QPolygonF path;
+    // the last path point only stands for the newest position, not yet kept
+    bool provisionaltail;
+    QRectF bounds;
+
 public slots:
-    void setPosSLOT();
-signals:
+    void RefreshPos();
 };
 }
 #endif // TRAILITEM_H
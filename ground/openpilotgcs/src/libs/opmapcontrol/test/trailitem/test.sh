@@ -0,0 +1,5 @@
+# -- run the trail paint benchmark from this directory, after qmake && make.
+# The single TrailItem is measured next to one item per point, the way the
+# trail was drawn before. Pass QTest options, e.g. -tickcounter or -iterations 100.
+
+exec ./tst_trailitem "$@"
@@ -0,0 +1,20 @@
+include(../../../../../openpilotgcs.pri)
+
+# TrailItem is a QGraphicsItem and needs Qt to build, so it is tested with
+# QTest here. The Qt free GCS code is tested with gtest in flight/tests.
+
+TEMPLATE = app
+TARGET = tst_trailitem
+CONFIG -= app_bundle
+DESTDIR = $${PWD}
+
+# the map widget headers pull in these modules
+QT += testlib widgets opengl network sql svg xml
+
+include(../../opmapcontrol.pri)
+
+SOURCES += tst_trailitem.cpp
+
+unix:!macx {
+    QMAKE_RPATHDIR += $$GCS_LIBRARY_PATH
+}
@@ -0,0 +1,196 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tst_trailitem.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Paint benchmark of the map trail
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "opmapcontrol/opmapcontrol.h"
+
+#include <QtCore/QObject>
+#include <QtCore/qmath.h>
+#include <QtTest/QtTest>
+#include <QGraphicsScene>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsLineItem>
+#include <QStyleOptionGraphicsItem>
+#include <QImage>
+
+using namespace mapcontrol;
+
+static const int ViewWidth  = 1280;
+static const int ViewHeight = 800;
+
+/**
+ * Paints trails of N points with the single TrailItem and with one
+ * ellipse and one line item per point, the way the trail was drawn
+ * before. Run it with -tickcounter or -callgrind for stable numbers.
+ */
+class tst_TrailItem : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void paintTrail_data();
+    void paintTrail();
+    void paintPerPointItems_data();
+    void paintPerPointItems();
+
+private:
+    void addPoints();
+    QList<internals::PointLatLng> flight(int count);
+
+    OPMapWidget *m_widget;
+    MapGraphicItem *m_map;
+    internals::PointLatLng m_home;
+};
+
+void tst_TrailItem::initTestCase()
+{
+    Configuration *config = new Configuration();
+
+    // no tiles are needed, keep the benchmark off the network
+    config->SetAccessMode(core::AccessMode::CacheOnly);
+    m_widget = new OPMapWidget(0, config);
+    m_widget->resize(ViewWidth, ViewHeight);
+    m_home   = internals::PointLatLng(46.5, 6.6);
+
+    m_map    = 0;
+    foreach(QGraphicsItem * item, m_widget->scene()->items()) {
+        if ((m_map = dynamic_cast<MapGraphicItem *>(item))) {
+            break;
+        }
+    }
+    QVERIFY(m_map);
+}
+
+void tst_TrailItem::cleanupTestCase()
+{
+    delete m_widget;
+}
+
+/**
+ * A loitering flight around home, one point every 5 m
+ */
+QList<internals::PointLatLng> tst_TrailItem::flight(int count)
+{
+    QList<internals::PointLatLng> points;
+    const double metersPerDegree = 111320.0;
+    const double lngScale = qCos(qDegreesToRadians(m_home.Lat()));
+    double angle = 0;
+
+    for (int i = 0; i < count; i++) {
+        // circles of 50 to 350 m radius, 5 m apart along the circle
+        double radius = 50 + (i / 200) % 7 * 50;
+        angle += 5.0 / radius;
+        points << internals::PointLatLng(m_home.Lat() + radius * qSin(angle) / metersPerDegree,
+                                         m_home.Lng() + radius * qCos(angle) / (metersPerDegree * lngScale));
+    }
+    return points;
+}
+
+void tst_TrailItem::addPoints()
+{
+    QTest::addColumn<int>("points");
+    QTest::addColumn<int>("zoom");
+    // at zoom 17 the points are 6 px apart, at 13 most of them merge
+    foreach(int zoom, QList<int>() << 17 << 13) {
+        foreach(int points, QList<int>() << 1000 << 10000 << 100000) {
+            QTest::newRow(qPrintable(QString("%1 points, zoom %2").arg(points).arg(zoom))) << points << zoom;
+        }
+    }
+}
+
+void tst_TrailItem::paintTrail_data()
+{
+    addPoints();
+}
+
+void tst_TrailItem::paintTrail()
+{
+    QFETCH(int, points);
+    QFETCH(int, zoom);
+
+    m_widget->SetZoom(zoom);
+    m_widget->SetCurrentPosition(m_home);
+    TrailItem trail(Qt::red, Qt::green, m_map);
+    trail.SetMaxPoints(points);
+    foreach(internals::PointLatLng point, flight(points)) {
+        trail.AddPoint(point, 0);
+    }
+    QCOMPARE(trail.Count(), points);
+
+    QImage image(ViewWidth, ViewHeight, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    QStyleOptionGraphicsItem option;
+    QPointF view = m_map->mapFromScene(m_widget->mapToScene(0, 0));
+    painter.translate(trail.pos() - view);
+
+    QBENCHMARK {
+        trail.paint(&painter, &option, 0);
+    }
+}
+
+void tst_TrailItem::paintPerPointItems_data()
+{
+    addPoints();
+}
+
+void tst_TrailItem::paintPerPointItems()
+{
+    QFETCH(int, points);
+    QFETCH(int, zoom);
+
+    m_widget->SetZoom(zoom);
+    m_widget->SetCurrentPosition(m_home);
+    QGraphicsScene scene;
+    QBrush brush(Qt::red);
+    QPen pen(QBrush(Qt::green), 1);
+    QPointF previous;
+    bool first = true;
+    foreach(internals::PointLatLng point, flight(points)) {
+        core::Point local = m_map->FromLatLngToLocal(point);
+        QPointF position(local.X(), local.Y());
+        QGraphicsEllipseItem *dot = scene.addEllipse(-2, -2, 4, 4, QPen(Qt::black), brush);
+        dot->setPos(position);
+        if (!first) {
+            scene.addLine(QLineF(previous, position), pen);
+        }
+        previous = position;
+        first    = false;
+    }
+    QCOMPARE(scene.items().size(), 2 * points - 1);
+
+    QImage image(ViewWidth, ViewHeight, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    QPointF view = m_map->mapFromScene(m_widget->mapToScene(0, 0));
+    QRectF source(view, QSizeF(ViewWidth, ViewHeight));
+
+    QBENCHMARK {
+        scene.render(&painter, QRectF(0, 0, ViewWidth, ViewHeight), source);
+    }
+}
+
+QTEST_MAIN(tst_TrailItem)
+
+#include "tst_trailitem.moc"
@@ -123,6 +123,7 @@ HEADERS += mainwindow.h \
     eventfilteringmainwindow.h \
     connectionmanager.h \
     iconnection.h \
+    ispanreader.h \
     iuavgadgetconfiguration.h \
     uavgadgetinstancemanager.h \
     uavgadgetoptionspagedecorator.h \
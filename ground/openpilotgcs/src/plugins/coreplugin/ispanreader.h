@@ -0,0 +1,57 @@
+/**
+ ******************************************************************************
+ *
+ * @file       ispanreader.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup CorePlugin Core Plugin
+ * @{
+ * @brief The Core GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ISPANREADER_H
+#define ISPANREADER_H
+
+#include <QtGlobal>
+
+namespace Core {
+/**
+ *   Implemented by connection QIODevices that can hand out received data
+ *   in place, so a protocol parser can work on it without copying it out
+ *   with read() first. Only to be used by the single reader of the device.
+ */
+class ISpanReader {
+public:
+    virtual ~ISpanReader() {}
+
+    /**
+     * Points data to the oldest contiguous block of received bytes
+     * \return its size, 0 if nothing was received. The block stays
+     * valid until consumeSpan() is called.
+     */
+    virtual qint64 peekSpan(const char **data) = 0;
+
+    /**
+     * Releases size bytes from the front of the block returned by peekSpan()
+     */
+    virtual void consumeSpan(qint64 size) = 0;
+};
+} // namespace Core
+
+#endif // ISPANREADER_H
@@ -155,6 +155,13 @@ Rectangle {
                             Rectangle {
                                 Layout.fillWidth: true
                             }
+                            Button {
+                                id: traceButton
+                                enabled: !logManager.disableControls && logManager.boardConnected
+                                text: qsTr("Export trace...")
+                                activeFocusOnPress: true
+                                onClicked: logManager.exportTrace()
+                            }
                             Button {
                                 id: clearButton
                                 enabled: !logManager.disableControls && logManager.boardConnected
@@ -32,9 +32,16 @@
 #include <QFileDialog>
 #include <QXmlStreamReader>
 #include <QMessageBox>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
 #include <QDebug>
 
 #include "debuglogcontrol.h"
+#include "taskinfo.h"
+#include "callbackinfo.h"
+#include "perfcounter.h"
 #include "uavobjecthelper.h"
 #include "uavtalk/uavtalk.h"
 #include "utils/logfile.h"
@@ -75,6 +82,12 @@ FlightLogManager::FlightLogManager(QObject *parent) :
     m_objectPersistence = ObjectPersistence::GetInstance(m_objectManager);
     Q_ASSERT(m_objectPersistence);
 
+    m_traceControl = TraceControl::GetInstance(m_objectManager);
+    Q_ASSERT(m_traceControl);
+
+    m_traceData = TraceData::GetInstance(m_objectManager);
+    Q_ASSERT(m_traceData);
+
     updateFlightEntries(m_flightLogStatus->getFlight());
 
     setupLogSettings();
@@ -417,6 +430,222 @@ void FlightLogManager::cancelExportLogs()
     m_cancelDownload = true;
 }
 
+// Event record layout and types, must match flight/pios/inc/pios_tracebuffer.h
+namespace {
+const int TRACE_EVENT_SIZE = 8;
+const quint16 TRACE_ID_UNKNOWN = 0xFFFF;
+enum TraceEventType {
+    TRACE_TASK_SWITCH = 1,
+    TRACE_CALLBACK_START,
+    TRACE_CALLBACK_END,
+    TRACE_ISR_ENTER,
+    TRACE_ISR_EXIT,
+    TRACE_MARKER_START,
+    TRACE_MARKER_END,
+    TRACE_MARKER_INSTANT
+};
+enum TraceProcess { TRACE_PID_TASKS = 1, TRACE_PID_CALLBACKS, TRACE_PID_INTERRUPTS, TRACE_PID_MARKERS };
+
+QJsonObject traceEvent(QString phase, int pid, int tid, double timestamp, QString name)
+{
+    QJsonObject event;
+
+    event["ph"]   = phase;
+    event["pid"]  = pid;
+    event["tid"]  = tid;
+    event["ts"]   = timestamp;
+    event["name"] = name;
+    if (phase == "i") {
+        event["s"] = QString("t");
+    }
+    return event;
+}
+
+QJsonObject traceMetadata(QString kind, int pid, int tid, QString name)
+{
+    QJsonObject event;
+    QJsonObject args;
+
+    args["name"]  = name;
+    event["ph"]   = QString("M");
+    event["pid"]  = pid;
+    event["tid"]  = tid;
+    event["name"] = kind;
+    event["args"] = args;
+    return event;
+}
+}
+
+void FlightLogManager::exportTraceToJSON(QString fileName, const QByteArray & events, quint32 rawClock)
+{
+    QStringList taskNames     = TaskInfo::GetInstance(m_objectManager)->getField("Running")->getElementNames();
+    QStringList callbackNames = CallbackInfo::GetInstance(m_objectManager)->getField("RunningTime")->getElementNames();
+    QStringList markerNames;
+
+    for (int i = 0; i < m_objectManager->getNumInstances(PerfCounter::OBJID); i++) {
+        markerNames << QString("0x%1").arg(PerfCounter::GetInstance(m_objectManager, i)->getId(), 8, 16, QChar('0'));
+    }
+
+    QJsonArray traceEvents;
+    traceEvents.append(traceMetadata("process_name", TRACE_PID_TASKS, 0, tr("Tasks")));
+    traceEvents.append(traceMetadata("process_name", TRACE_PID_CALLBACKS, 0, tr("Callbacks")));
+    traceEvents.append(traceMetadata("process_name", TRACE_PID_INTERRUPTS, 0, tr("Interrupts")));
+    traceEvents.append(traceMetadata("process_name", TRACE_PID_MARKERS, 0, tr("Markers")));
+
+    QSet<quint32> namedThreads;
+    int runningTask   = -1;
+    quint32 lastStamp = 0;
+    qint64 ticks      = 0;
+    double timestamp  = 0;
+    // Chrome trace times are in us
+    double usPerTick  = 1e6 / (rawClock ? rawClock : 1000000);
+    for (int offset = 0; offset + TRACE_EVENT_SIZE <= events.size(); offset += TRACE_EVENT_SIZE) {
+        const uchar *record = reinterpret_cast<const uchar *>(events.constData() + offset);
+        quint32 stamp = record[0] | (record[1] << 8) | (record[2] << 16) | ((quint32)record[3] << 24);
+        quint16 id    = record[4] | (record[5] << 8);
+        quint8 type   = record[6];
+
+        // the flight side clock is the raw delay timer, a wrapping 32 bit tick
+        // counter, events are never more than half its period apart
+        if (offset == 0) {
+            ticks = stamp;
+        } else {
+            ticks += (qint32)(stamp - lastStamp);
+        }
+        lastStamp = stamp;
+        timestamp = ticks * usPerTick;
+
+        int pid;
+        QString name;
+        switch (type) {
+        case TRACE_TASK_SWITCH:
+            pid  = TRACE_PID_TASKS;
+            name = (id < taskNames.size()) ? taskNames[id] : tr("Other");
+            if (id == TRACE_ID_UNKNOWN) {
+                id = taskNames.size();
+            }
+            break;
+        case TRACE_CALLBACK_START:
+        case TRACE_CALLBACK_END:
+            pid  = TRACE_PID_CALLBACKS;
+            name = (id < callbackNames.size()) ? callbackNames[id] : tr("Callback %1").arg(id);
+            break;
+        case TRACE_ISR_ENTER:
+        case TRACE_ISR_EXIT:
+            pid  = TRACE_PID_INTERRUPTS;
+            name = tr("IRQ %1").arg(id);
+            break;
+        case TRACE_MARKER_START:
+        case TRACE_MARKER_END:
+        case TRACE_MARKER_INSTANT:
+            pid  = TRACE_PID_MARKERS;
+            name = (id < markerNames.size()) ? markerNames[id] : tr("Counter %1").arg(id);
+            break;
+        default:
+            continue;
+        }
+
+        if (!namedThreads.contains((pid << 16) | id)) {
+            namedThreads.insert((pid << 16) | id);
+            traceEvents.append(traceMetadata("thread_name", pid, id, name));
+        }
+
+        switch (type) {
+        case TRACE_TASK_SWITCH:
+            // a task runs until the next one is switched in
+            if (runningTask >= 0) {
+                traceEvents.append(traceEvent("E", TRACE_PID_TASKS, runningTask, timestamp, QString()));
+            }
+            traceEvents.append(traceEvent("B", pid, id, timestamp, name));
+            runningTask = id;
+            break;
+        case TRACE_CALLBACK_START:
+        case TRACE_ISR_ENTER:
+        case TRACE_MARKER_START:
+            traceEvents.append(traceEvent("B", pid, id, timestamp, name));
+            break;
+        case TRACE_CALLBACK_END:
+        case TRACE_ISR_EXIT:
+        case TRACE_MARKER_END:
+            traceEvents.append(traceEvent("E", pid, id, timestamp, name));
+            break;
+        case TRACE_MARKER_INSTANT:
+            traceEvents.append(traceEvent("i", pid, id, timestamp, name));
+            break;
+        }
+    }
+    if (runningTask >= 0) {
+        traceEvents.append(traceEvent("E", TRACE_PID_TASKS, runningTask, timestamp, QString()));
+    }
+
+    QJsonObject trace;
+    trace["traceEvents"] = traceEvents;
+
+    QFile jsonFile(fileName);
+    if (jsonFile.open(QFile::WriteOnly | QFile::Truncate)) {
+        jsonFile.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+        jsonFile.close();
+    }
+}
+
+void FlightLogManager::exportTrace()
+{
+    setDisableControls(true);
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    UAVObjectUpdaterHelper updateHelper;
+    UAVObjectRequestHelper requestHelper;
+    QByteArray events;
+    quint32 rawClock = 0;
+    bool success     = false;
+
+    // Freeze the ring so all blocks come from the same window
+    m_traceControl->setOperation(TraceControl::OPERATION_STOP);
+    if (updateHelper.doObjectAndWait(m_traceControl, UAVTALK_TIMEOUT) == UAVObjectUpdaterHelper::SUCCESS) {
+        m_traceControl->setOperation(TraceControl::OPERATION_RETRIEVE);
+        quint16 index = 0;
+        forever {
+            m_traceControl->setIndex(index);
+            if (updateHelper.doObjectAndWait(m_traceControl, UAVTALK_TIMEOUT) != UAVObjectUpdaterHelper::SUCCESS ||
+                requestHelper.doObjectAndWait(m_traceData, UAVTALK_TIMEOUT) != UAVObjectUpdaterHelper::SUCCESS) {
+                break;
+            }
+            TraceData::DataFields data = m_traceData->getData();
+            if (data.Index != index) {
+                break;
+            }
+            events.append(reinterpret_cast<const char *>(data.Events), data.Count * TRACE_EVENT_SIZE);
+            rawClock = data.RawClock;
+            index += data.Count;
+            if (data.Count == 0 || index >= data.Total) {
+                success = true;
+                break;
+            }
+        }
+    }
+
+    // Resume recording, this clears the ring on the flight side
+    m_traceControl->setOperation(TraceControl::OPERATION_START);
+    updateHelper.doObjectAndWait(m_traceControl, UAVTALK_TIMEOUT);
+
+    QApplication::restoreOverrideCursor();
+
+    if (!success) {
+        QMessageBox::warning(NULL, tr("Trace download failed"), tr("The event trace could not be retrieved from the board."));
+    } else {
+        QString jsonFilter = tr("Chrome trace file %1").arg("(*.json)");
+        QString fileName   = QFileDialog::getSaveFileName(NULL, tr("Save Event Trace"), QDir::homePath(), jsonFilter);
+        if (!fileName.isEmpty()) {
+            if (!fileName.endsWith(".json")) {
+                fileName.append(".json");
+            }
+            exportTraceToJSON(fileName, events, rawClock);
+        }
+    }
+
+    setDisableControls(false);
+}
+
 void FlightLogManager::loadSettings()
 {
     QString xmlFilter = tr("XML file %1").arg("(*.xml)");
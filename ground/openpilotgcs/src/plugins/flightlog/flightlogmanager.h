@@ -42,6 +42,8 @@
 #include "debuglogstatus.h"
 #include "debuglogsettings.h"
 #include "debuglogcontrol.h"
+#include "tracecontrol.h"
+#include "tracedata.h"
 #include "objectpersistence.h"
 #include "uavtalk/telemetrymanager.h"
 
@@ -266,6 +268,7 @@ public slots:
     void retrieveLogs(int flightToRetrieve = -1);
     void exportLogs();
     void cancelExportLogs();
+    void exportTrace();
     void loadSettings();
     void saveSettings();
     void resetSettings(bool clear);
@@ -329,6 +332,8 @@ private:
     DebugLogEntry *m_flightLogEntry;
     DebugLogSettings *m_flightLogSettings;
     ObjectPersistence *m_objectPersistence;
+    TraceControl *m_traceControl;
+    TraceData *m_traceData;
 
     QList<ExtendedDebugLogEntry *> m_logEntries;
     QStringList m_flightEntries;
@@ -341,6 +346,7 @@ private:
     void exportToOPL(QString fileName);
     void exportToCSV(QString fileName);
     void exportToXML(QString fileName);
+    void exportTraceToJSON(QString fileName, const QByteArray & events, quint32 rawClock);
 
     static const int UAVTALK_TIMEOUT = 4000;
     static const int LOG_SETTINGS_FILE_VERSION = 1;
@@ -36,6 +36,7 @@
 #include <QByteArray>
 #include "ophid_hidapi.h"
 #include "ophid_usbmon.h"
+#include "coreplugin/ispanreader.h"
 
 class RawHIDReadThread;
 class RawHIDWriteThread;
@@ -44,7 +45,7 @@ class RawHIDWriteThread;
  *   The actual IO device that will be used to communicate
  *   with the board.
  */
-class OPHID_EXPORT RawHID : public QIODevice {
+class OPHID_EXPORT RawHID : public QIODevice, public Core::ISpanReader {
     Q_OBJECT
 
     friend class RawHIDReadThread;
@@ -59,6 +60,10 @@ public:
     virtual void close();
     virtual bool isSequential() const;
 
+    // Core::ISpanReader
+    virtual qint64 peekSpan(const char **data);
+    virtual void consumeSpan(qint64 size);
+
 signals:
     void closed();
 
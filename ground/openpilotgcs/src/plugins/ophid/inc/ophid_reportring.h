@@ -0,0 +1,149 @@
+/**
+ ******************************************************************************
+ *
+ * @file       ophid_reportring.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup opHIDPlugin HID Plugin
+ * @{
+ * @brief Lock free ring of received HID reports
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef OPHID_REPORTRING_H
+#define OPHID_REPORTRING_H
+
+// Nothing but QAtomicInt from Qt, the unit test (flight/tests/ophid)
+// builds the ring against a stand in for it.
+#include <QAtomicInt>
+#include <string.h>
+
+/**
+ *   Single producer, single consumer ring of raw HID reports.
+ *   The read thread receives reports straight into the ring and the
+ *   reader of the device takes the payloads out, without any lock.
+ *   A report is the report ID, the number of valid bytes and the payload.
+ */
+class opHID_ReportRing {
+public:
+    enum {
+        REPORT_SIZE = 64,
+        PAYLOAD_MAX = REPORT_SIZE - 2,
+        REPORTS     = 256, // power of two
+        // head and tail run over twice the ring to tell full from empty
+        INDEX_MASK  = 2 * REPORTS - 1
+    };
+
+    opHID_ReportRing() : m_head(0), m_tail(0), m_bytes(0), m_offset(0) {}
+
+    // Producer side
+
+    /** Slot to receive the next report into, NULL while the ring is full */
+    char *writeSlot()
+    {
+        int head = m_head.load();
+
+        if (((head - m_tail.loadAcquire()) & INDEX_MASK) == REPORTS) {
+            return NULL;
+        }
+        return m_reports[head & (REPORTS - 1)];
+    }
+
+    /** Publishes the report received into writeSlot() */
+    void commit()
+    {
+        int head   = m_head.load();
+        char *slot = m_reports[head & (REPORTS - 1)];
+
+        // never trust the length byte beyond the report
+        if ((quint8)slot[1] > PAYLOAD_MAX) {
+            slot[1] = PAYLOAD_MAX;
+        }
+        m_bytes.fetchAndAddRelease((quint8)slot[1]);
+        m_head.storeRelease((head + 1) & INDEX_MASK);
+    }
+
+    // Consumer side
+
+    /** Payload bytes left in the oldest report, data points to them */
+    int peek(const char **data)
+    {
+        int tail = m_tail.load();
+
+        while (tail != m_head.loadAcquire()) {
+            const char *slot = m_reports[tail & (REPORTS - 1)];
+            int size = (quint8)slot[1] - m_offset;
+            if (size > 0) {
+                *data = &slot[2 + m_offset];
+                return size;
+            }
+            // empty report, skip it
+            m_offset = 0;
+            tail     = (tail + 1) & INDEX_MASK;
+            m_tail.storeRelease(tail);
+        }
+        return 0;
+    }
+
+    /** Releases size bytes returned by peek() */
+    void consume(int size)
+    {
+        int tail = m_tail.load();
+
+        m_offset += size;
+        m_bytes.fetchAndAddRelease(-size);
+        if (m_offset >= (quint8)m_reports[tail & (REPORTS - 1)][1]) {
+            m_offset = 0;
+            m_tail.storeRelease((tail + 1) & INDEX_MASK);
+        }
+    }
+
+    /** Copies up to maxSize payload bytes, across as many reports as needed */
+    qint64 read(char *data, qint64 maxSize)
+    {
+        qint64 total = 0;
+        const char *span;
+        int size;
+
+        while (total < maxSize && (size = peek(&span)) > 0) {
+            size = (int)qMin((qint64)size, maxSize - total);
+            memcpy(data + total, span, size);
+            consume(size);
+            total += size;
+        }
+        return total;
+    }
+
+    qint64 bytesAvailable() const
+    {
+        return m_bytes.loadAcquire();
+    }
+
+private:
+    char m_reports[REPORTS][REPORT_SIZE];
+
+    // reports committed by the producer and released by the consumer
+    QAtomicInt m_head;
+    QAtomicInt m_tail;
+    // payload bytes in the ring, for bytesAvailable()
+    QAtomicInt m_bytes;
+    // consumer position inside the oldest report
+    int m_offset;
+};
+
+#endif // OPHID_REPORTRING_H
@@ -16,6 +16,7 @@ HEADERS += \
     inc/ophid_const.h \
     inc/ophid_usbmon.h \
     inc/ophid_usbsignal.h \
+    inc/ophid_reportring.h \
     hidapi/hidapi.h
 
 SOURCES += \
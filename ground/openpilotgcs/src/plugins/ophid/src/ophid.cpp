@@ -27,6 +27,7 @@
 
 #include "ophid.h"
 #include "ophid_const.h"
+#include "ophid_reportring.h"
 #include "coreplugin/connectionmanager.h"
 #include <extensionsystem/pluginmanager.h>
 #include <QtGlobal>
@@ -55,7 +56,13 @@ public:
     virtual ~RawHIDReadThread();
 
     /** Return the data read so far without waiting */
-    int getReadData(char *data, int size);
+    qint64 getReadData(char *data, qint64 size);
+
+    /** Payload of the oldest report without copying it */
+    qint64 peekReadData(const char **data);
+
+    /** Release the bytes returned by peekReadData() */
+    void consumeReadData(qint64 size);
 
     /** return the bytes buffered */
     qint64 getBytesAvailable();
@@ -69,12 +76,9 @@ public slots:
 protected:
     void run();
 
-    /** QByteArray might not be the most efficient way to implement
-       a circular buffer but it's good enough and very simple */
-    QByteArray m_readBuffer;
-
-    /** A mutex to protect read buffer */
-    QMutex m_readBufMtx;
+    /** The reports are received straight into this ring, this thread
+       is the only producer and the RawHID reader the only consumer */
+    opHID_ReportRing m_ring;
 
     RawHID *m_hid;
 
@@ -157,22 +161,27 @@ void RawHIDReadThread::run()
     m_running = m_hid->openDevice();
 
     while (m_running) {
-        // here we use a temporary buffer so we don't need to lock
-        // the mutex while we are reading from the device
-
         // Want to read in regular chunks that match the packet size the device
         // is using.  In this case it is 64 bytes (the interrupt packet limit)
         // although it would be nice if the device had a different report to
         // configure this
-        char buffer[READ_SIZE] = { 0 };
+        char *buffer = m_ring.writeSlot();
+
+        if (!buffer) {
+            // the reader is behind, let it drain the ring
+            msleep(1);
+            continue;
+        }
 
         int ret = hiddev->receive(hidno, buffer, READ_SIZE, READ_TIMEOUT);
 
         if (ret > 0) { // read some data
-            QMutexLocker lock(&m_readBufMtx);
-            // Note: Preprocess the USB packets in this OS independent code
+            // Note: the ring strips the USB packets in this OS independent code
             // First byte is report ID, second byte is the number of valid bytes
-            m_readBuffer.append(&buffer[2], buffer[1]);
+            if (ret < 2) {
+                buffer[1] = 0;
+            }
+            m_ring.commit();
 
             emit m_hid->readyRead();
         } else if (ret == 0) { // nothing read
@@ -186,23 +195,24 @@ void RawHIDReadThread::run()
     OPHID_TRACE("OUT");
 }
 
-int RawHIDReadThread::getReadData(char *data, int size)
+qint64 RawHIDReadThread::getReadData(char *data, qint64 size)
 {
-    QMutexLocker lock(&m_readBufMtx);
-
-    size = qMin(size, m_readBuffer.size());
+    return m_ring.read(data, size);
+}
 
-    memcpy(data, m_readBuffer.constData(), size);
-    m_readBuffer.remove(0, size);
+qint64 RawHIDReadThread::peekReadData(const char **data)
+{
+    return m_ring.peek(data);
+}
 
-    return size;
+void RawHIDReadThread::consumeReadData(qint64 size)
+{
+    m_ring.consume(size);
 }
 
 qint64 RawHIDReadThread::getBytesAvailable()
 {
-    QMutexLocker lock(&m_readBufMtx);
-
-    return m_readBuffer.size();
+    return m_ring.bytesAvailable();
 }
 
 // *********************************************************************************
@@ -402,7 +412,8 @@ bool RawHID::open(OpenMode mode)
         return false;
     }
 
-    QIODevice::open(mode);
+    // the read thread already buffers whole reports, reads go straight to it
+    QIODevice::open(mode | QIODevice::Unbuffered);
 
     Q_ASSERT(m_readThread);
     Q_ASSERT(m_writeThread);
@@ -484,6 +495,26 @@ qint64 RawHID::readData(char *data, qint64 maxSize)
     return m_readThread->getReadData(data, maxSize);
 }
 
+qint64 RawHID::peekSpan(const char **data)
+{
+    QMutexLocker locker(m_mutex);
+
+    if (!m_readThread || !data) {
+        return -1;
+    }
+
+    return m_readThread->peekReadData(data);
+}
+
+void RawHID::consumeSpan(qint64 size)
+{
+    QMutexLocker locker(m_mutex);
+
+    if (m_readThread) {
+        m_readThread->consumeReadData(size);
+    }
+}
+
 qint64 RawHID::writeData(const char *data, qint64 maxSize)
 {
     QMutexLocker locker(m_mutex);
@@ -75,6 +75,7 @@ SUBDIRS += plugin_scope
 plugin_uavobjectbrowser.subdir = uavobjectbrowser
 plugin_uavobjectbrowser.depends = plugin_coreplugin
 plugin_uavobjectbrowser.depends += plugin_uavobjects
+plugin_uavobjectbrowser.depends += plugin_uavtalk
 SUBDIRS += plugin_uavobjectbrowser
 
 # ModelView UAVGadget
@@ -37,7 +37,8 @@ PlotData::PlotData(UAVObject *object, UAVObjectField *field, int element,
     m_meanSum(0.0f), m_mathFunction(mathFunction), m_correctionSum(0.0f),
     m_correctionCount(0), m_plotDataSize(plotDataSize),
     m_object(object), m_field(field), m_element(element),
-    m_plotCurve(NULL), m_isVisible(true), m_pen(pen), m_isEnumPlot(false)
+    m_plotCurve(NULL), m_isVisible(true), m_pen(pen), m_isEnumPlot(false),
+    m_dirty(false), m_redraw(true), m_drawnSize(0)
 {
     if (m_field->getNumElements() > 1) {
         m_elementName = m_field->getElementNames().at(m_element);
@@ -91,6 +92,22 @@ void PlotData::setVisible(bool visible)
 void PlotData::updatePlotData()
 {
     m_plotCurve->setSamples(m_xDataEntries, m_yDataEntries);
+    m_drawnSize = m_yDataEntries.size();
+    m_dirty     = false;
+    m_redraw    = false;
+}
+
+bool PlotData::canDrawIncrementally(const QwtInterval &yInterval) const
+{
+    if (m_redraw || m_drawnSize == 0 || m_yDataEntries.size() <= m_drawnSize) {
+        return false;
+    }
+    for (int i = m_drawnSize; i < m_yDataEntries.size(); i++) {
+        if (!yInterval.contains(m_yDataEntries.at(i))) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void PlotData::clear()
@@ -100,6 +117,8 @@ void PlotData::clear()
     m_correctionCount = 0;
     m_xDataEntries.clear();
     m_yDataEntries.clear();
+    m_dirty  = true;
+    m_redraw = true;
     while (!m_enumMarkerList.isEmpty()) {
         QwtPlotMarker *marker = m_enumMarkerList.takeFirst();
         marker->detach();
@@ -219,10 +238,12 @@ bool SequentialPlotData::append(UAVObject *obj)
             if (m_yDataEntries.size() > m_plotDataSize) {
                 // If new data overflows the window, remove old data...
                 m_yDataEntries.pop_front();
+                m_redraw = true;
             } else {
                 // ...otherwise, add a new y point at position xData
                 m_xDataEntries.insert(m_xDataEntries.size(), m_xDataEntries.size());
             }
+            m_dirty = true;
             return true;
         } else {
             // Enum markers
@@ -237,6 +258,8 @@ bool SequentialPlotData::append(UAVObject *obj)
                     marker->attach(m_plotCurve->plot());
                 }
                 m_enumMarkerList.append(marker);
+                m_dirty  = true;
+                m_redraw = true;
             }
         }
     }
@@ -266,6 +289,7 @@ bool ChronoPlotData::append(UAVObject *obj)
             }
 
             m_xDataEntries.append(xValue);
+            m_dirty = true;
         } else {
             // Enum markers
             QString value = m_field->getValue(m_element).toString();
@@ -279,6 +303,8 @@ bool ChronoPlotData::append(UAVObject *obj)
                     marker->attach(m_plotCurve->plot());
                 }
                 m_enumMarkerList.append(marker);
+                m_dirty  = true;
+                m_redraw = true;
             }
         }
         removeStaleData();
@@ -293,11 +319,13 @@ void ChronoPlotData::removeStaleData()
            (m_xDataEntries.last() - m_xDataEntries.first()) > m_plotDataSize) {
         m_yDataEntries.pop_front();
         m_xDataEntries.pop_front();
+        m_redraw = true;
     }
     while (!m_enumMarkerList.isEmpty() &&
            (m_enumMarkerList.last()->xValue() - m_enumMarkerList.first()->xValue()) > m_plotDataSize) {
         QwtPlotMarker *marker = m_enumMarkerList.takeFirst();
         marker->detach();
         delete marker;
+        m_redraw = true;
     }
 }
@@ -36,6 +36,7 @@
 #include "qwt/src/qwt_scale_draw.h"
 #include "qwt/src/qwt_scale_widget.h"
 #include <qwt/src/qwt_plot_marker.h>
+#include <qwt/src/qwt_interval.h>
 
 #include <QTimer>
 #include <QTime>
@@ -92,6 +93,23 @@ public:
     virtual PlotType plotType() const   = 0;
     virtual void removeStaleData() = 0;
 
+    // New data since the last updatePlotData()
+    bool isDirty() const
+    {
+        return m_dirty;
+    }
+    // Only points were appended and they fit the current y range,
+    // so they can be painted over the previous frame
+    bool canDrawIncrementally(const QwtInterval &yInterval) const;
+    int drawnSize() const
+    {
+        return m_drawnSize;
+    }
+    QwtPlotCurve *curve() const
+    {
+        return m_plotCurve;
+    }
+
     void updatePlotData();
     void clear();
 
@@ -127,6 +145,10 @@ protected:
     bool m_isVisible;
     QPen m_pen;
     bool m_isEnumPlot;
+    bool m_dirty;
+    // Existing points moved or markers changed, the curve must be redrawn as a whole
+    bool m_redraw;
+    int m_drawnSize;
     virtual void calcMathFunction(double currentValue);
     QwtPlotMarker *createMarker(QString value);
 };
@@ -14,7 +14,8 @@ HEADERS += \
     scopegadgetconfiguration.h \
     scopegadget.h \
     scopegadgetwidget.h \
-    scopegadgetfactory.h
+    scopegadgetfactory.h \
+    scopecsvwriter.h
 
 SOURCES += \
     scopeplugin.cpp \
@@ -23,7 +24,8 @@ SOURCES += \
     scopegadgetconfiguration.cpp \
     scopegadget.cpp \
     scopegadgetfactory.cpp \
-    scopegadgetwidget.cpp
+    scopegadgetwidget.cpp \
+    scopecsvwriter.cpp
 
 OTHER_FILES += ScopeGadget.pluginspec
 
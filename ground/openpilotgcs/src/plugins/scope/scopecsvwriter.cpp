@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scopecsvwriter.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Writes the scope CSV log from a background thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopecsvwriter.h"
+
+#include <QDebug>
+
+// Buffered data is pushed to the disk at least this often
+#define CSV_FLUSH_INTERVAL_MS 1000
+
+ScopeCsvWriter::ScopeCsvWriter() :
+    m_file(NULL), m_stream(NULL)
+{}
+
+ScopeCsvWriter::~ScopeCsvWriter()
+{
+    close();
+    // the file is a child, deleted along with the writer
+    delete m_stream;
+}
+
+void ScopeCsvWriter::start()
+{
+    m_file   = new QFile(this);
+    m_stream = new QTextStream();
+}
+
+void ScopeCsvWriter::open(QString fileName, QString header)
+{
+    if (!m_file) {
+        return;
+    }
+
+    close();
+
+    m_file->setFileName(fileName);
+    if (!m_file->open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "Unable to open " << m_file->fileName() << " for csv logging";
+        return;
+    }
+    m_stream->setDevice(m_file);
+    *m_stream << header;
+    m_stream->flush();
+    m_lastFlush.start();
+}
+
+void ScopeCsvWriter::write(QString lines)
+{
+    if (!m_file || !m_file->isOpen()) {
+        return;
+    }
+
+    *m_stream << lines;
+    if (m_lastFlush.elapsed() >= CSV_FLUSH_INTERVAL_MS) {
+        m_stream->flush();
+        m_lastFlush.restart();
+    }
+}
+
+void ScopeCsvWriter::close()
+{
+    if (!m_file || !m_file->isOpen()) {
+        return;
+    }
+
+    m_stream->flush();
+    m_stream->setDevice(NULL);
+    m_file->close();
+}
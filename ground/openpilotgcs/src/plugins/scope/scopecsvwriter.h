@@ -0,0 +1,61 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scopecsvwriter.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Writes the scope CSV log from a background thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SCOPECSVWRITER_H
+#define SCOPECSVWRITER_H
+
+#include <QObject>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+
+/*!
+   \brief Keeps the CSV log open and buffered, living in its own thread so
+   that file I/O never blocks the GUI. All slots are called through queued
+   connections from ScopeGadgetWidget, start() when the thread starts so the
+   file and stream are created in the writer thread.
+ */
+class ScopeCsvWriter : public QObject {
+    Q_OBJECT
+
+public:
+    ScopeCsvWriter();
+    ~ScopeCsvWriter();
+
+public slots:
+    void start();
+    void open(QString fileName, QString header);
+    void write(QString lines);
+    void close();
+
+private:
+    QFile *m_file;
+    QTextStream *m_stream;
+    QElapsedTimer m_lastFlush;
+};
+
+#endif // SCOPECSVWRITER_H
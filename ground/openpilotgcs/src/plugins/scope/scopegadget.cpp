@@ -50,6 +50,7 @@ void ScopeGadget::loadConfiguration(IUAVGadgetConfiguration *config)
     widget->setObjectName(config->name());
     widget->setPlotDataSize(sgConfig->dataSize());
     widget->setRefreshInterval(sgConfig->refreshInterval());
+    widget->setBenchmark(sgConfig->benchmark());
 
     if (sgConfig->plotType() == SequentialPlot) {
         widget->setupSequentialPlot();
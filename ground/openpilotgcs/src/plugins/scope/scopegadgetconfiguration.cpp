@@ -32,7 +32,8 @@ ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings *q
     m_plotType((int)ChronoPlot),
     m_dataSize(60),
     m_refreshInterval(1000),
-    m_mathFunctionType(0)
+    m_mathFunctionType(0),
+    m_benchmark(false)
 {
     uint currentStreamVersion = 0;
     int plotCurveCount = 0;
@@ -73,6 +74,7 @@ ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings *q
         m_loggingEnabled = qSettings->value("LoggingEnabled").toBool();
         m_loggingNewFileOnConnect = qSettings->value("LoggingNewFileOnConnect").toBool();
         m_loggingPath    = qSettings->value("LoggingPath").toString();
+        m_benchmark      = qSettings->value("benchmark", false).toBool();
     }
 }
 
@@ -125,6 +127,7 @@ IUAVGadgetConfiguration *ScopeGadgetConfiguration::clone()
     m->setLoggingEnabled(m_loggingEnabled);
     m->setLoggingNewFileOnConnect(m_loggingNewFileOnConnect);
     m->setLoggingPath(m_loggingPath);
+    m->setBenchmark(m_benchmark);
 
     return m;
 }
@@ -165,6 +168,7 @@ void ScopeGadgetConfiguration::saveConfig(QSettings *qSettings) const
     qSettings->setValue("LoggingEnabled", m_loggingEnabled);
     qSettings->setValue("LoggingNewFileOnConnect", m_loggingNewFileOnConnect);
     qSettings->setValue("LoggingPath", m_loggingPath);
+    qSettings->setValue("benchmark", m_benchmark);
 }
 
 void ScopeGadgetConfiguration::replacePlotCurveConfig(QList<PlotCurveConfiguration *> newPlotCurveConfigs)
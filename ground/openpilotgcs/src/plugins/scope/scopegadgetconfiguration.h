@@ -126,6 +126,14 @@ public:
     {
         m_loggingPath = value;
     }
+    bool benchmark()
+    {
+        return m_benchmark;
+    }
+    void setBenchmark(bool value)
+    {
+        m_benchmark = value;
+    }
 
 private:
 
@@ -145,6 +153,8 @@ private:
     bool m_loggingEnabled;
     bool m_loggingNewFileOnConnect;
     QString m_loggingPath;
+    // Report frame times and CPU use of the plot
+    bool m_benchmark;
 };
 
 #endif // SCOPEGADGETCONFIGURATION_H
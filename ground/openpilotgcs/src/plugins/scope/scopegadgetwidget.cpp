@@ -59,6 +59,11 @@
 #include <qwt/src/qwt_plot_canvas.h>
 #include <qwt/src/qwt_plot_layout.h>
 
+// Buffered CSV rows are handed to the writer thread in chunks of about this many characters
+#define CSV_LOGGING_CHUNK 4096
+// Interval of the benchmark report
+#define BENCHMARK_REPORT_MS 5000
+
 ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
     m_csvLoggingStarted(false), m_csvLoggingEnabled(false),
     m_csvLoggingHeaderSaved(false), m_csvLoggingDataSaved(false),
@@ -69,6 +74,16 @@ ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
     m_csvLoggingPath("./csvlogging/"),
     m_plotLegend(NULL), m_picker(NULL)
 {
+    m_plotting  = false;
+    m_replotAll = true;
+    m_benchmark = false;
+    m_benchmarkCpu     = 0;
+    m_benchmarkUpdates = 0;
+    m_benchmarkFrames  = 0;
+    m_benchmarkIncrementalFrames = 0;
+    m_benchmarkFrameNs    = 0;
+    m_benchmarkMaxFrameNs = 0;
+
     setMouseTracking(true);
 
     QwtPlotCanvas *plotCanvas = dynamic_cast<QwtPlotCanvas *>(canvas());
@@ -89,9 +104,24 @@ ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
     m_picker->setRubberBandPen(QColor(Qt::darkMagenta));
     m_picker->setTrackerPen(QColor(Qt::green));
 
-    // Setup the timer that replots data
+    // Setup the timer that replots data, started when data arrives
     replotTimer = new QTimer(this);
+    replotTimer->setSingleShot(true);
     connect(replotTimer, SIGNAL(timeout()), this, SLOT(replotNewData()));
+    m_lastReplot.start();
+
+    // Paints appended points without redrawing the whole plot
+    m_directPainter = new QwtPlotDirectPainter(this);
+
+    // CSV logging is written to disk from its own thread
+    m_csvLoggingWriter = new ScopeCsvWriter();
+    m_csvLoggingWriter->moveToThread(&m_csvLoggingThread);
+    connect(&m_csvLoggingThread, SIGNAL(started()), m_csvLoggingWriter, SLOT(start()));
+    connect(&m_csvLoggingThread, SIGNAL(finished()), m_csvLoggingWriter, SLOT(deleteLater()));
+    connect(this, SIGNAL(csvLoggingOpen(QString, QString)), m_csvLoggingWriter, SLOT(open(QString, QString)));
+    connect(this, SIGNAL(csvLoggingWrite(QString)), m_csvLoggingWriter, SLOT(write(QString)));
+    connect(this, SIGNAL(csvLoggingClose()), m_csvLoggingWriter, SLOT(close()));
+    m_csvLoggingThread.start();
 
     // Listen to telemetry connection/disconnection events, no point in
     // running the scopes if we are not connected and not replaying logs.
@@ -121,6 +151,12 @@ ScopeGadgetWidget::~ScopeGadgetWidget()
         replotTimer = NULL;
     }
 
+    // Write what is left, wait for the writer to close the file and stop its thread
+    csvLoggingStop();
+    QMetaObject::invokeMethod(m_csvLoggingWriter, "close", Qt::BlockingQueuedConnection);
+    m_csvLoggingThread.quit();
+    m_csvLoggingThread.wait();
+
     // Get the object to de-monitor
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
@@ -156,6 +192,7 @@ void ScopeGadgetWidget::mouseDoubleClickEvent(QMouseEvent *e)
 
     // On double-click, reset plot zoom
     setAxisAutoScale(QwtPlot::yLeft, true);
+    m_replotAll = true;
 
     update();
 
@@ -200,6 +237,7 @@ void ScopeGadgetWidget::wheelEvent(QWheelEvent *e)
 
 void ScopeGadgetWidget::showEvent(QShowEvent *e)
 {
+    m_replotAll = true;
     replotNewData();
     QwtPlot::showEvent(e);
 }
@@ -209,23 +247,39 @@ void ScopeGadgetWidget::showEvent(QShowEvent *e)
  */
 void ScopeGadgetWidget::startPlotting()
 {
-    if (replotTimer && !replotTimer->isActive()) {
+    if (replotTimer && !m_plotting) {
         foreach(PlotData * plot, m_curvesData.values()) {
             if (plot->wantsInitialData()) {
                 plot->append(NULL);
             }
         }
-        replotTimer->start(m_refreshInterval);
+        m_plotting  = true;
+        m_replotAll = true;
+        scheduleReplot();
     }
 }
 
 void ScopeGadgetWidget::stopPlotting()
 {
+    m_plotting = false;
     if (replotTimer) {
         replotTimer->stop();
     }
 }
 
+/**
+ * Replots once the refresh interval since the last frame is over,
+ * several updates arriving in between end up in the same frame
+ */
+void ScopeGadgetWidget::scheduleReplot()
+{
+    if (!m_plotting || !replotTimer || replotTimer->isActive()) {
+        return;
+    }
+    qint64 wait = m_refreshInterval - m_lastReplot.elapsed();
+    replotTimer->start(wait > 0 ? wait : 0);
+}
+
 void ScopeGadgetWidget::deleteLegend()
 {
     if (m_plotLegend) {
@@ -284,15 +338,11 @@ void ScopeGadgetWidget::preparePlot(PlotType plotType)
     grid->setPen(Qt::darkGray, 1, Qt::DotLine);
     grid->attach(this);
 
-    // Only start the timer if we are already connected
+    // Only plot if we are already connected
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
-    if (cm->isConnected() && replotTimer) {
-        if (!replotTimer->isActive()) {
-            replotTimer->start(m_refreshInterval);
-        } else {
-            replotTimer->setInterval(m_refreshInterval);
-        }
-    }
+    m_plotting  = cm->isConnected();
+    m_replotAll = true;
+    scheduleReplot();
 }
 
 void ScopeGadgetWidget::showCurve(QVariant itemInfo, bool visible, int index)
@@ -309,6 +359,7 @@ void ScopeGadgetWidget::showCurve(QVariant itemInfo, bool visible, int index)
     }
 
     m_mutex.lock();
+    m_replotAll = true;
     replot();
     m_mutex.unlock();
 }
@@ -421,30 +472,121 @@ void ScopeGadgetWidget::uavObjectReceived(UAVObject *obj)
         }
     }
     csvLoggingAddData();
+
+    if (m_benchmark) {
+        m_benchmarkUpdates++;
+    }
+    scheduleReplot();
 }
 
 void ScopeGadgetWidget::replotNewData()
 {
+    csvLoggingInsertData();
+
     if (!isVisible()) {
         return;
     }
 
     QMutexLocker locker(&m_mutex);
+    QElapsedTimer frameTime;
+    frameTime.start();
+
+    // Curves that only got new points within the y range are painted over the
+    // last frame. Scrolling, rescaling and markers need a full replot.
+    const QwtInterval yInterval = axisInterval(QwtPlot::yLeft);
+    bool fullReplot = m_replotAll || m_plotType == ChronoPlot;
+    bool dirty = m_replotAll;
+    QList<PlotData *> appended;
     foreach(PlotData * plotData, m_curvesData.values()) {
         plotData->removeStaleData();
-        plotData->updatePlotData();
+        if (!plotData->isDirty()) {
+            continue;
+        }
+        if (!plotData->isVisible()) {
+            plotData->updatePlotData();
+            continue;
+        }
+        dirty = true;
+        if (plotData->canDrawIncrementally(yInterval)) {
+            appended.append(plotData);
+        } else {
+            fullReplot = true;
+        }
+    }
+    if (!dirty) {
+        return;
     }
 
-    QDateTime NOW = QDateTime::currentDateTime();
-    double toTime = NOW.toTime_t();
-    toTime += NOW.time().msec() / 1000.0;
-    if (m_plotType == ChronoPlot) {
-        setAxisScale(QwtPlot::xBottom, toTime - m_plotDataSize, toTime);
+    if (fullReplot) {
+        foreach(PlotData * plotData, m_curvesData.values()) {
+            if (plotData->isDirty()) {
+                plotData->updatePlotData();
+            }
+        }
+
+        QDateTime NOW = QDateTime::currentDateTime();
+        double toTime = NOW.toTime_t();
+        toTime += NOW.time().msec() / 1000.0;
+        if (m_plotType == ChronoPlot) {
+            setAxisScale(QwtPlot::xBottom, toTime - m_plotDataSize, toTime);
+        }
+
+        replot();
+    } else {
+        foreach(PlotData * plotData, appended) {
+            // start at the last drawn point so the line stays connected
+            int from = plotData->drawnSize() - 1;
+            plotData->updatePlotData();
+            m_directPainter->drawSeries(plotData->curve(), from, plotData->drawnSize() - 1);
+        }
     }
 
-    csvLoggingInsertData();
+    m_replotAll = false;
+    m_lastReplot.restart();
 
-    replot();
+    if (m_benchmark) {
+        benchmarkFrame(frameTime.nsecsElapsed(), !fullReplot);
+    }
+}
+
+/**
+ * Collects frame times and reports them with the CPU use of the GCS
+ * every few seconds, for gadgets configured with benchmark enabled
+ */
+void ScopeGadgetWidget::benchmarkFrame(qint64 frameNs, bool incremental)
+{
+    if (!m_benchmarkTimer.isValid()) {
+        m_benchmarkTimer.start();
+        m_benchmarkCpu     = clock();
+        m_benchmarkUpdates = 0;
+        m_benchmarkFrames  = 0;
+        m_benchmarkIncrementalFrames = 0;
+        m_benchmarkFrameNs    = 0;
+        m_benchmarkMaxFrameNs = 0;
+        return;
+    }
+
+    m_benchmarkFrames++;
+    if (incremental) {
+        m_benchmarkIncrementalFrames++;
+    }
+    m_benchmarkFrameNs   += frameNs;
+    m_benchmarkMaxFrameNs = qMax(m_benchmarkMaxFrameNs, frameNs);
+
+    qint64 elapsed = m_benchmarkTimer.elapsed();
+    if (elapsed < BENCHMARK_REPORT_MS) {
+        return;
+    }
+
+    double seconds = elapsed / 1000.0;
+    double cpu     = (double)(clock() - m_benchmarkCpu) / CLOCKS_PER_SEC;
+    qDebug() << "Scope" << objectName() << ":" << m_curvesData.size() << "curves,"
+             << m_benchmarkUpdates / seconds << "updates/s,"
+             << m_benchmarkFrames / seconds << "frames/s," << m_benchmarkIncrementalFrames << "of" << m_benchmarkFrames << "incremental,"
+             << "frame time avg" << m_benchmarkFrameNs / 1e6 / m_benchmarkFrames << "ms max" << m_benchmarkMaxFrameNs / 1e6 << "ms,"
+             << "GCS CPU" << 100.0 * cpu / seconds << "%";
+
+    m_benchmarkTimer.invalidate();
 }
 
 void ScopeGadgetWidget::clearCurvePlots()
@@ -534,6 +676,10 @@ int ScopeGadgetWidget::csvLoggingStart()
 
 int ScopeGadgetWidget::csvLoggingStop()
 {
+    if (m_csvLoggingStarted) {
+        csvLoggingInsertData();
+        emit csvLoggingClose();
+    }
     m_csvLoggingStarted = 0;
 
     return 0;
@@ -552,23 +698,22 @@ int ScopeGadgetWidget::csvLoggingInsertHeader()
     }
 
     m_csvLoggingHeaderSaved = 1;
-    if (m_csvLoggingFile.open(QIODevice::WriteOnly | QIODevice::Append) == false) {
-        qDebug() << "Unable to open " << m_csvLoggingFile.fileName() << " for csv logging Header";
-    } else {
-        QTextStream ts(&m_csvLoggingFile);
-        ts << "date" << ", " << "Time" << ", " << "Sec since start" << ", " << "Connected" << ", " << "Data changed";
-
-        foreach(PlotData * plotData2, m_curvesData.values()) {
-            ts << ", ";
-            ts << plotData2->objectName();
-            ts << "." << plotData2->field()->getName();
-            if (!plotData2->elementName().isEmpty()) {
-                ts << "." << plotData2->elementName();
-            }
+    QString header;
+    QTextStream ts(&header);
+    ts << "date" << ", " << "Time" << ", " << "Sec since start" << ", " << "Connected" << ", " << "Data changed";
+
+    foreach(PlotData * plotData2, m_curvesData.values()) {
+        ts << ", ";
+        ts << plotData2->objectName();
+        ts << "." << plotData2->field()->getName();
+        if (!plotData2->elementName().isEmpty()) {
+            ts << "." << plotData2->elementName();
         }
-        ts << endl;
-        m_csvLoggingFile.close();
     }
+    ts << endl;
+
+    // the writer thread opens the file and keeps it open until csvLoggingStop()
+    emit csvLoggingOpen(m_csvLoggingFile.fileName(), header);
     return 0;
 }
 
@@ -601,8 +746,10 @@ int ScopeGadgetWidget::csvLoggingAddData()
     }
     ss << endl;
     if (m_csvLoggingDataValid) {
-        QTextStream ts(&m_csvLoggingBuffer);
-        ts << tempString;
+        m_csvLoggingBuffer += tempString;
+        if (m_csvLoggingBuffer.size() >= CSV_LOGGING_CHUNK) {
+            csvLoggingInsertData();
+        }
     }
 
     return 0;
@@ -613,15 +760,12 @@ int ScopeGadgetWidget::csvLoggingInsertData()
     if (!m_csvLoggingStarted) {
         return -1;
     }
+    if (m_csvLoggingBuffer.isEmpty()) {
+        return 0;
+    }
     m_csvLoggingDataSaved = 1;
 
-    if (m_csvLoggingFile.open(QIODevice::WriteOnly | QIODevice::Append) == false) {
-        qDebug() << "Unable to open " << m_csvLoggingFile.fileName() << " for csv logging Data";
-    } else {
-        QTextStream ts(&m_csvLoggingFile);
-        ts << m_csvLoggingBuffer;
-        m_csvLoggingFile.close();
-    }
+    emit csvLoggingWrite(m_csvLoggingBuffer);
     m_csvLoggingBuffer.clear();
 
     return 0;
@@ -671,8 +815,9 @@ void ScopeGadgetWidget::clearPlot()
     foreach(PlotData * plot, m_curvesData.values()) {
         plot->clear();
     }
+    m_replotAll = true;
     m_mutex.unlock();
-    replot();
+    replotNewData();
 }
 
 void ScopeGadgetWidget::copyToClipboardAsImage()
@@ -29,6 +29,7 @@
 #define SCOPEGADGETWIDGET_H_
 
 #include "plotdata.h"
+#include "scopecsvwriter.h"
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_legend.h"
@@ -37,11 +38,15 @@
 #include "qwt/src/qwt_scale_draw.h"
 #include "qwt/src/qwt_scale_widget.h"
 #include "qwt/src/qwt_plot_picker.h"
+#include "qwt/src/qwt_plot_directpainter.h"
 
 #include <QTimer>
 #include <QTime>
+#include <QElapsedTimer>
+#include <QThread>
 #include <QVector>
 #include <QMutex>
+#include <time.h>
 
 class QSettings;
 
@@ -86,6 +91,7 @@ public:
     {
         return m_plotDataSize;
     }
+    // The plot is redrawn when new data arrives, at most once per refresh interval
     void setRefreshInterval(double refreshInterval)
     {
         m_refreshInterval = refreshInterval;
@@ -119,8 +125,16 @@ public:
     {
         m_csvLoggingPath = value;
     }
+    void setBenchmark(bool value)
+    {
+        m_benchmark = value;
+        m_benchmarkTimer.invalidate();
+    }
 signals:
     void visibilityChanged(QwtPlotItem *item);
+    void csvLoggingOpen(QString fileName, QString header);
+    void csvLoggingWrite(QString lines);
+    void csvLoggingClose();
 
 protected:
     void mousePressEvent(QMouseEvent *e);
@@ -146,6 +160,8 @@ private slots:
 private:
     void preparePlot(PlotType plotType);
     void setupExamplePlot();
+    void scheduleReplot();
+    void benchmarkFrame(qint64 frameNs, bool incremental);
 
     PlotType m_plotType;
 
@@ -155,6 +171,19 @@ private:
     QMap<QString, PlotData *> m_curvesData;
 
     QTimer *replotTimer;
+    QElapsedTimer m_lastReplot;
+    QwtPlotDirectPainter *m_directPainter;
+    bool m_plotting;
+    bool m_replotAll;
+
+    bool m_benchmark;
+    QElapsedTimer m_benchmarkTimer;
+    clock_t m_benchmarkCpu;
+    int m_benchmarkUpdates;
+    int m_benchmarkFrames;
+    int m_benchmarkIncrementalFrames;
+    qint64 m_benchmarkFrameNs;
+    qint64 m_benchmarkMaxFrameNs;
 
     bool m_csvLoggingStarted;
     bool m_csvLoggingEnabled;
@@ -172,6 +201,8 @@ private:
     QString m_csvLoggingPath;
     QString m_csvLoggingBuffer;
     QFile m_csvLoggingFile;
+    QThread m_csvLoggingThread;
+    ScopeCsvWriter *m_csvLoggingWriter;
 
     QMutex m_mutex;
     QwtLegend *m_plotLegend;
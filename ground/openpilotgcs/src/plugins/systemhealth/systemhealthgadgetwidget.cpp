@@ -26,6 +26,9 @@
  */
 
 #include "systemalarms.h"
+#include "callbackinfo.h"
+#include "taskinfo.h"
+#include "taskstats.h"
 #include "systemhealthgadgetwidget.h"
 
 #include "utils/stylehelper.h"
@@ -286,9 +289,106 @@ void SystemHealthGadgetWidget::showAllAlarmDescriptions(const QPoint & location)
             }
         }
 
+        // Append the task and callback scheduler timing statistics
+        alarmsText.append(taskStatsText());
+        alarmsText.append(callbackTimingText());
+
         // Show alarms text if we have any
         if (alarmsText.length() > 0) {
             QWhatsThis::showText(location, alarmsText);
         }
     }
 }
+
+/**
+ * Build an HTML table with the per task cpu accounting the
+ * flight side task monitor reports in the TaskStats object.
+ */
+QString SystemHealthGadgetWidget::taskStatsText()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    TelemetryManager *telMngr    = pm->getObject<TelemetryManager>();
+    TaskInfo *taskInfo   = TaskInfo::GetInstance(objManager);
+    TaskStats *taskStats = TaskStats::GetInstance(objManager);
+
+    if (!taskInfo || !taskStats || !telMngr->isConnected()) {
+        return QString();
+    }
+
+    UAVObjectField *running     = taskInfo->getField("Running");
+    UAVObjectField *load        = taskStats->getField("Load");
+    UAVObjectField *loadAvg     = taskStats->getField("LoadAvg");
+    UAVObjectField *maxSlice    = taskStats->getField("MaxSlice");
+    UAVObjectField *maxLatency  = taskStats->getField("MaxLatency");
+    UAVObjectField *preemptions = taskStats->getField("Preemptions");
+
+    QString text = "<p><b>" + tr("Task load") + "</b></p>"
+                   "<table cellpadding=\"2\"><tr><th align=\"left\">" + tr("Task") + "</th>"
+                   "<th>" + tr("Load now/avg (%)") + "</th>"
+                   "<th>" + tr("Max slice (us)") + "</th>"
+                   "<th>" + tr("Max wake-up latency (us)") + "</th>"
+                   "<th>" + tr("Preemptions") + "</th></tr>";
+    bool haveRows = false;
+
+    for (uint i = 0; i < running->getNumElements() && i < load->getNumElements(); ++i) {
+        if (running->getValue(i).toString() != "True") {
+            continue;
+        }
+        haveRows = true;
+        text.append(QString("<tr><td>%1</td><td align=\"right\">%2/%3</td><td align=\"right\">%4</td><td align=\"right\">%5</td><td align=\"right\">%6</td></tr>")
+                    .arg(running->getElementNames()[i])
+                    .arg(load->getValue(i).toUInt() / 100.0, 0, 'f', 2).arg(loadAvg->getValue(i).toUInt() / 100.0, 0, 'f', 2)
+                    .arg(maxSlice->getValue(i).toUInt())
+                    .arg(maxLatency->getValue(i).toUInt())
+                    .arg(preemptions->getValue(i).toUInt()));
+    }
+    text.append("</table>");
+
+    return haveRows ? text : QString();
+}
+
+/**
+ * Build an HTML table with the latency and run time statistics the
+ * flight side callback scheduler reports in the CallbackInfo object.
+ */
+QString SystemHealthGadgetWidget::callbackTimingText()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    TelemetryManager *telMngr    = pm->getObject<TelemetryManager>();
+    CallbackInfo *callbackInfo   = CallbackInfo::GetInstance(objManager);
+
+    if (!callbackInfo || !telMngr->isConnected()) {
+        return QString();
+    }
+
+    UAVObjectField *running    = callbackInfo->getField("Running");
+    UAVObjectField *latencyMax = callbackInfo->getField("LatencyMax");
+    UAVObjectField *latency99  = callbackInfo->getField("Latency99");
+    UAVObjectField *runTimeMax = callbackInfo->getField("RunTimeMax");
+    UAVObjectField *runTime99  = callbackInfo->getField("RunTime99");
+    UAVObjectField *deadlineMisses = callbackInfo->getField("DeadlineMisses");
+
+    QString text = "<p><b>" + tr("Callback timing") + "</b></p>"
+                   "<table cellpadding=\"2\"><tr><th align=\"left\">" + tr("Callback") + "</th>"
+                   "<th>" + tr("Latency p99/max (us)") + "</th>"
+                   "<th>" + tr("Run time p99/max (us)") + "</th>"
+                   "<th>" + tr("Missed deadlines") + "</th></tr>";
+    bool haveRows = false;
+
+    for (uint i = 0; i < running->getNumElements(); ++i) {
+        if (running->getValue(i).toString() != "True") {
+            continue;
+        }
+        haveRows = true;
+        text.append(QString("<tr><td>%1</td><td align=\"right\">%2/%3</td><td align=\"right\">%4/%5</td><td align=\"right\">%6</td></tr>")
+                    .arg(running->getElementNames()[i])
+                    .arg(latency99->getValue(i).toUInt()).arg(latencyMax->getValue(i).toUInt())
+                    .arg(runTime99->getValue(i).toUInt()).arg(runTimeMax->getValue(i).toUInt())
+                    .arg(deadlineMisses->getValue(i).toUInt()));
+    }
+    text.append("</table>");
+
+    return haveRows ? text : QString();
+}
@@ -70,5 +70,7 @@ private:
 
     void showAlarmDescriptionForItemId(const QString itemId, const QPoint & location);
     void showAllAlarmDescriptions(const QPoint &location);
+    QString taskStatsText();
+    QString callbackTimingText();
 };
 #endif /* SYSTEMHEALTHGADGETWIDGET_H_ */
@@ -31,6 +31,7 @@
 #include "ui_uavobjectbrowser.h"
 #include "ui_viewoptions.h"
 #include "uavobjectmanager.h"
+#include "telemetrysessionmanager.h"
 #include <QStringList>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
@@ -48,7 +49,19 @@ UAVObjectBrowserWidget::UAVObjectBrowserWidget(QWidget *parent) : QWidget(parent
     m_viewoptionsDialog = new QDialog(this);
     m_viewoptions->setupUi(m_viewoptionsDialog);
     m_browser->setupUi(this);
-    m_model = new UAVObjectTreeModel();
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    m_sessions   = pm->getObject<TelemetrySessionManager>();
+    m_objManager = m_sessions ? m_sessions->objectManager(m_sessions->currentSession()) : pm->getObject<UAVObjectManager>();
+    if (m_sessions) {
+        connect(m_sessions, SIGNAL(sessionAdded(QString)), this, SLOT(updateSessions()));
+        connect(m_sessions, SIGNAL(sessionRemoved(QString)), this, SLOT(updateSessions()));
+        connect(m_sessions, SIGNAL(currentSessionChanged(QString)), this, SLOT(sessionChanged(QString)));
+    }
+    connect(m_browser->sessionBox, SIGNAL(activated(QString)), this, SLOT(sessionSelected(QString)));
+    updateSessions();
+
+    m_model = new UAVObjectTreeModel(0, false, false, m_objManager);
     m_browser->treeView->setModel(m_model);
     m_browser->treeView->setColumnWidth(0, 300);
 
@@ -111,10 +124,20 @@ void UAVObjectBrowserWidget::showDescription(bool show)
 }
 
 void UAVObjectBrowserWidget::categorize(bool categorize)
+{
+    replaceModel(categorize, m_viewoptions->cbScientific->isChecked());
+}
+
+void UAVObjectBrowserWidget::useScientificNotation(bool scientific)
+{
+    replaceModel(m_viewoptions->cbCategorized->isChecked(), scientific);
+}
+
+void UAVObjectBrowserWidget::replaceModel(bool categorize, bool scientific)
 {
     UAVObjectTreeModel *tmpModel = m_model;
 
-    m_model = new UAVObjectTreeModel(0, categorize, m_viewoptions->cbScientific->isChecked());
+    m_model = new UAVObjectTreeModel(0, categorize, scientific, m_objManager);
     m_model->setRecentlyUpdatedColor(m_recentlyUpdatedColor);
     m_model->setManuallyChangedColor(m_manuallyChangedColor);
     m_model->setRecentlyUpdatedTimeout(m_recentlyUpdatedTimeout);
@@ -127,20 +150,41 @@ void UAVObjectBrowserWidget::categorize(bool categorize)
     delete tmpModel;
 }
 
-void UAVObjectBrowserWidget::useScientificNotation(bool scientific)
+void UAVObjectBrowserWidget::updateSessions()
 {
-    UAVObjectTreeModel *tmpModel = m_model;
+    QStringList sessions;
 
-    m_model = new UAVObjectTreeModel(0, m_viewoptions->cbCategorized->isChecked(), scientific);
-    m_model->setRecentlyUpdatedColor(m_recentlyUpdatedColor);
-    m_model->setManuallyChangedColor(m_manuallyChangedColor);
-    m_model->setRecentlyUpdatedTimeout(m_recentlyUpdatedTimeout);
-    m_model->setUnknowObjectColor(m_unknownObjectColor);
-    m_browser->treeView->setModel(m_model);
-    showMetaData(m_viewoptions->cbMetaData->isChecked());
-    connect(m_browser->treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex, QModelIndex)), this, SLOT(currentChanged(QModelIndex, QModelIndex)), Qt::UniqueConnection);
+    if (m_sessions) {
+        sessions = m_sessions->sessions();
+    }
+    m_browser->sessionBox->clear();
+    m_browser->sessionBox->addItems(sessions);
+    if (m_sessions) {
+        m_browser->sessionBox->setCurrentIndex(sessions.indexOf(m_sessions->currentSession()));
+    }
+    // nothing to choose from with a single vehicle
+    m_browser->sessionBox->setVisible(sessions.size() > 1);
+}
 
-    delete tmpModel;
+void UAVObjectBrowserWidget::sessionChanged(const QString &name)
+{
+    UAVObjectManager *objManager = m_sessions->objectManager(name);
+
+    m_browser->sessionBox->setCurrentIndex(m_browser->sessionBox->findText(name));
+    if (!objManager || objManager == m_objManager) {
+        return;
+    }
+    m_objManager = objManager;
+    replaceModel(m_viewoptions->cbCategorized->isChecked(), m_viewoptions->cbScientific->isChecked());
+    enableSendRequest(false);
+    updateDescription();
+}
+
+void UAVObjectBrowserWidget::sessionSelected(const QString &name)
+{
+    if (m_sessions) {
+        m_sessions->setCurrentSession(name);
+    }
 }
 
 void UAVObjectBrowserWidget::sendUpdate()
@@ -229,9 +273,7 @@ void UAVObjectBrowserWidget::eraseObject()
 
 void UAVObjectBrowserWidget::updateObjectPersistance(ObjectPersistence::OperationOptions op, UAVObject *obj)
 {
-    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
-    ObjectPersistence *objper    = dynamic_cast<ObjectPersistence *>(objManager->getObject(ObjectPersistence::NAME));
+    ObjectPersistence *objper = dynamic_cast<ObjectPersistence *>(m_objManager->getObject(ObjectPersistence::NAME));
 
     if (obj != NULL) {
         ObjectPersistence::DataFields data;
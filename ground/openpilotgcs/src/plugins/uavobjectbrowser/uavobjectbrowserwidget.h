@@ -34,6 +34,7 @@
 #include "uavobjecttreemodel.h"
 
 class QPushButton;
+class TelemetrySessionManager;
 class ObjectTreeItem;
 class Ui_UAVObjectBrowser;
 class Ui_viewoptions;
@@ -79,6 +80,9 @@ public slots:
     void useScientificNotation(bool scientific);
 
 private slots:
+    void updateSessions();
+    void sessionChanged(const QString &name);
+    void sessionSelected(const QString &name);
     void sendUpdate();
     void requestUpdate();
     void saveObject();
@@ -99,6 +103,9 @@ private:
     Ui_viewoptions *m_viewoptions;
     QDialog *m_viewoptionsDialog;
     UAVObjectTreeModel *m_model;
+    // the vehicle shown, the user selection shared by the gadgets
+    TelemetrySessionManager *m_sessions;
+    UAVObjectManager *m_objManager;
 
     int m_recentlyUpdatedTimeout;
     QColor m_unknownObjectColor;
@@ -107,6 +114,7 @@ private:
     bool m_onlyHilightChangedValues;
     QString m_mustacheTemplate;
 
+    void replaceModel(bool categorize, bool scientific);
     void updateObjectPersistance(ObjectPersistence::OperationOptions op, UAVObject *obj);
     void enableSendRequest(bool enable);
     void updateDescription();
@@ -37,7 +37,7 @@
 #include <QtCore/QSignalMapper>
 #include <QtCore/QDebug>
 
-UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool useScientificNotation) :
+UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool useScientificNotation, UAVObjectManager *objManager) :
     QAbstractItemModel(parent),
     m_useScientificFloatNotation(useScientificNotation),
     m_categorize(categorize),
@@ -46,8 +46,10 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool us
     m_manuallyChangedColor(QColor(230, 230, 255)),
     m_unknownObjectColor(QColor(Qt::gray))
 {
-    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    if (!objManager) {
+        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+        objManager = pm->getObject<UAVObjectManager>();
+    }
 
     Q_ASSERT(objManager);
 
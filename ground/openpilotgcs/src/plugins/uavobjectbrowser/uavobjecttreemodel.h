@@ -48,7 +48,9 @@ class QTimer;
 class UAVObjectTreeModel : public QAbstractItemModel {
     Q_OBJECT
 public:
-    explicit UAVObjectTreeModel(QObject *parent = 0, bool categorize = false, bool useScientificNotation = false);
+    // objects of objManager, by default the global object manager
+    explicit UAVObjectTreeModel(QObject *parent = 0, bool categorize = false, bool useScientificNotation = false,
+                                UAVObjectManager *objManager = 0);
     ~UAVObjectTreeModel();
 
     QVariant data(const QModelIndex &index, int role) const;
@@ -0,0 +1,343 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjecthistory.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Memory bounded history of the subscribed object fields
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjecthistory.h"
+#include "uavobjecthistorycolumn.h"
+#include "uavdataobject.h"
+#include <QDateTime>
+#include <QDir>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <QDebug>
+#include <QFile>
+#include <string.h>
+
+UAVObjectHistory::UAVObjectHistory(UAVObjectManager *objMngr) : m_objMngr(objMngr),
+    m_store(new UAVObjectHistoryStore(DEFAULT_MEMORY_LIMIT))
+{
+    // instances of subscribed objects created later
+    connect(m_objMngr, SIGNAL(newInstance(UAVObject *)), this, SLOT(onNewInstance(UAVObject *)), Qt::DirectConnection);
+}
+
+UAVObjectHistory::~UAVObjectHistory()
+{
+    qDeleteAll(m_instances);
+    delete m_store;
+}
+
+quint64 UAVObjectHistory::key(quint32 objId, quint32 instId)
+{
+    return ((quint64)objId << 32) | instId;
+}
+
+bool UAVObjectHistory::subscribe(const QString & object)
+{
+    // only data, not the metadata
+    UAVObject *obj = m_objMngr->getObject(object);
+
+    if (!dynamic_cast<UAVDataObject *>(obj)) {
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_subscribed.contains(obj->getObjID())) {
+            return true;
+        }
+        m_subscribed.insert(obj->getObjID());
+    }
+
+    // outside of the lock as in range(), an instance registered meanwhile
+    // is already watched by onNewInstance() and skipped here
+    foreach(UAVObject * instance, m_objMngr->getObjectInstances(obj->getObjID())) {
+        watch(instance);
+    }
+    return true;
+}
+
+bool UAVObjectHistory::isSubscribed(const QString & object) const
+{
+    UAVObject *obj = m_objMngr->getObject(object);
+
+    if (!obj) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    return m_subscribed.contains(obj->getObjID());
+}
+
+void UAVObjectHistory::onNewInstance(UAVObject *obj)
+{
+    watch(obj);
+}
+
+void UAVObjectHistory::watch(UAVObject *obj)
+{
+    if (!dynamic_cast<UAVDataObject *>(obj)) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    quint64 k = key(obj->getObjID(), obj->getInstID());
+    if (!m_subscribed.contains(obj->getObjID()) || m_instances.contains(k)) {
+        return;
+    }
+
+    Instance *instance = new Instance;
+    foreach(UAVObjectField * field, obj->getFields()) {
+        if (field->getType() == UAVObjectField::STRING) {
+            continue;
+        }
+        FieldLayout layout;
+        layout.type        = field->getType();
+        layout.offset      = field->getDataOffset();
+        layout.elements    = field->getNumElements();
+        layout.firstColumn = instance->columns.size();
+        instance->fieldIndex.insert(field->getName(), instance->fields.size());
+        instance->fields.append(layout);
+        for (quint32 i = 0; i < layout.elements; i++) {
+            instance->columns.append(m_store->addColumn());
+        }
+    }
+    instance->buffer.resize(obj->getNumBytes());
+    m_instances.insert(k, instance);
+
+    // recorded in the thread updating the object, with the time of the update
+    connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(onObjectUpdated(UAVObject *)), Qt::DirectConnection);
+}
+
+void UAVObjectHistory::onObjectUpdated(UAVObject *obj)
+{
+    record(obj, QDateTime::currentMSecsSinceEpoch());
+}
+
+void UAVObjectHistory::record(UAVObject *obj, qint64 time)
+{
+    QMutexLocker locker(&m_mutex);
+    Instance *instance = m_instances.value(key(obj->getObjID(), obj->getInstID()));
+
+    if (!instance) {
+        return;
+    }
+
+    // the wire layout, decoded by type below
+    quint8 *data = (quint8 *)instance->buffer.data();
+    obj->pack(data);
+
+    foreach(const FieldLayout &layout, instance->fields) {
+        const quint8 *element = data + layout.offset;
+
+        if (layout.type == UAVObjectField::BITFIELD) {
+            // packed 8 bits a byte, the field spans getNumBytes()
+            for (quint32 i = 0; i < layout.elements; i++) {
+                m_store->append(instance->columns.at(layout.firstColumn + i), time, (element[i / 8] >> (i % 8)) & 1);
+            }
+            continue;
+        }
+        for (quint32 i = 0; i < layout.elements; i++) {
+            double value;
+            switch (layout.type) {
+            case UAVObjectField::INT8:
+                value = (qint8)*element;
+                element += 1;
+                break;
+            case UAVObjectField::INT16:
+                value = qFromLittleEndian<qint16>(element);
+                element += 2;
+                break;
+            case UAVObjectField::INT32:
+                value = qFromLittleEndian<qint32>(element);
+                element += 4;
+                break;
+            case UAVObjectField::UINT16:
+                value = qFromLittleEndian<quint16>(element);
+                element += 2;
+                break;
+            case UAVObjectField::UINT32:
+                value = qFromLittleEndian<quint32>(element);
+                element += 4;
+                break;
+            case UAVObjectField::FLOAT32:
+            {
+                quint32 bits = qFromLittleEndian<quint32>(element);
+                float f;
+                memcpy(&f, &bits, sizeof(f));
+                value    = f;
+                element += 4;
+                break;
+            }
+            default:
+                // UINT8 and ENUM
+                value = *element;
+                element += 1;
+                break;
+            }
+
+            m_store->append(instance->columns.at(layout.firstColumn + i), time, value);
+        }
+    }
+}
+
+void UAVObjectHistory::setMemoryLimit(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_store->setMemoryLimit(bytes);
+}
+
+qint64 UAVObjectHistory::memoryLimit() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_store->memoryLimit();
+}
+
+bool UAVObjectHistory::setSpillDirectory(const QString & path)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // the blocks already in the old file stay readable only with it, start over
+    if (m_store->spilledBytes() > 0) {
+        qWarning() << "UAVObjectHistory: the spill file can only be set before anything is spilled";
+        return false;
+    }
+    if (path.isEmpty()) {
+        return m_store->setSpillFile(std::string());
+    }
+
+    QString fileName = QDir(path).filePath(QString("uavobjecthistory-%1.spill").arg(QDateTime::currentMSecsSinceEpoch()));
+    if (!m_store->setSpillFile(QFile::encodeName(fileName).constData())) {
+        qWarning() << "UAVObjectHistory: cannot open spill file" << fileName;
+        return false;
+    }
+    return true;
+}
+
+qint64 UAVObjectHistory::memoryUsed() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_store->memoryUsed();
+}
+
+qint64 UAVObjectHistory::spilledBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_store->spilledBytes();
+}
+
+quint64 UAVObjectHistory::samples() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_store->samples();
+}
+
+UAVObjectHistoryColumn *UAVObjectHistory::column(quint32 objId, const QString & field, quint32 element, quint32 instId) const
+{
+    Instance *instance = m_instances.value(key(objId, instId));
+
+    if (!instance || !instance->fieldIndex.contains(field)) {
+        return NULL;
+    }
+    const FieldLayout &layout = instance->fields.at(instance->fieldIndex.value(field));
+    if (element >= layout.elements) {
+        return NULL;
+    }
+    return instance->columns.at(layout.firstColumn + element);
+}
+
+bool UAVObjectHistory::range(const QString & object, const QString & field, quint32 element, qint64 from, qint64 to,
+                             QVector<qint64> & times, QVector<double> & values, quint32 instId) const
+{
+    // looked up before locking, the object manager calls back into
+    // watch() with its own lock held when it registers an instance
+    UAVObject *obj = m_objMngr->getObject(object, instId);
+
+    if (!obj) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    UAVObjectHistoryColumn *col = column(obj->getObjID(), field, element, instId);
+    if (!col) {
+        return false;
+    }
+    std::vector<int64_t> columnTimes;
+    std::vector<double> columnValues;
+    m_store->range(col, from, to, columnTimes, columnValues);
+    locker.unlock();
+
+    times.reserve(times.size() + (int)columnTimes.size());
+    values.reserve(values.size() + (int)columnValues.size());
+    for (size_t i = 0; i < columnTimes.size(); i++) {
+        times.append(columnTimes[i]);
+        values.append(columnValues[i]);
+    }
+    return true;
+}
+
+bool UAVObjectHistory::downsample(const QString & object, const QString & field, quint32 element, qint64 from, qint64 to, int buckets,
+                                  QVector<qint64> & times, QVector<double> & min, QVector<double> & max, QVector<double> & mean,
+                                  quint32 instId) const
+{
+    QVector<qint64> sampleTimes;
+    QVector<double> sampleValues;
+
+    if (buckets <= 0 || to < from || !range(object, field, element, from, to, sampleTimes, sampleValues, instId)) {
+        return false;
+    }
+
+    double span = (double)to - (double)from + 1.0;
+    int current = -1;
+    int count   = 0;
+    for (int i = 0; i < sampleTimes.size(); i++) {
+        int bucket   = qMin((int)(((double)sampleTimes.at(i) - (double)from) / span * buckets), buckets - 1);
+        double value = sampleValues.at(i);
+        if (bucket != current) {
+            if (count) {
+                mean.last() /= count;
+            }
+            current = bucket;
+            count   = 0;
+            times.append(sampleTimes.at(i));
+            min.append(value);
+            max.append(value);
+            mean.append(0.0);
+        }
+        min.last()   = qMin(min.last(), value);
+        max.last()   = qMax(max.last(), value);
+        mean.last() += value;
+        count++;
+    }
+    if (count) {
+        mean.last() /= count;
+    }
+    return true;
+}
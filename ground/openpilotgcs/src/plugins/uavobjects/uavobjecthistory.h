@@ -0,0 +1,126 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjecthistory.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Memory bounded history of the subscribed object fields
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTHISTORY_H
+#define UAVOBJECTHISTORY_H
+
+#include "uavobjects_global.h"
+#include "uavobjectmanager.h"
+#include "uavobjectfield.h"
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+
+class UAVObjectHistoryColumn;
+class UAVObjectHistoryStore;
+
+/**
+ * History of the numeric field elements of the data objects gadgets
+ * subscribed to, fed by the object updates. Nothing is recorded for an
+ * object before its first subscription. Each element (each bit of a
+ * bitfield) is a compressed column with its time index, all gadgets share
+ * it and it outlives their configuration.
+ * The memory held by the columns is bounded, the oldest blocks go to the
+ * spill file when one is set, or are dropped.
+ * Times are milliseconds since the epoch. Thread safe.
+ */
+class UAVOBJECTS_EXPORT UAVObjectHistory : public QObject {
+    Q_OBJECT
+
+public:
+    UAVObjectHistory(UAVObjectManager *objMngr);
+    ~UAVObjectHistory();
+
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const;
+    // keeps the released blocks in a file of this directory, empty to drop them
+    bool setSpillDirectory(const QString & path);
+
+    /**
+     * Starts recording all instances of the object, existing and new ones
+     * \return false if there is no such data object
+     */
+    bool subscribe(const QString & object);
+    bool isSubscribed(const QString & object) const;
+
+    qint64 memoryUsed() const;
+    qint64 spilledBytes() const;
+    quint64 samples() const;
+
+    /**
+     * Samples of one field element with from <= time <= to
+     * \return false if there is no such field element or the object is not subscribed
+     */
+    bool range(const QString & object, const QString & field, quint32 element, qint64 from, qint64 to,
+               QVector<qint64> & times, QVector<double> & values, quint32 instId = 0) const;
+
+    /**
+     * The same range reduced to at most buckets points, one per equal time
+     * slice with samples: the time of its first sample, the min, max and mean
+     */
+    bool downsample(const QString & object, const QString & field, quint32 element, qint64 from, qint64 to, int buckets,
+                    QVector<qint64> & times, QVector<double> & min, QVector<double> & max, QVector<double> & mean,
+                    quint32 instId = 0) const;
+
+    // add a sample of every field element of obj, as if it was just updated,
+    // ignored if obj is not subscribed
+    void record(UAVObject *obj, qint64 time);
+
+    static const qint64 DEFAULT_MEMORY_LIMIT = 64 * 1024 * 1024;
+
+private slots:
+    void onNewInstance(UAVObject *obj);
+    void onObjectUpdated(UAVObject *obj);
+
+private:
+    struct FieldLayout {
+        UAVObjectField::FieldType type;
+        quint32 offset;
+        quint32 elements; // bits of a bitfield
+        int firstColumn;
+    };
+
+    struct Instance {
+        QVector<FieldLayout> fields;
+        QHash<QString, int> fieldIndex;
+        QVector<UAVObjectHistoryColumn *> columns; // owned by m_store
+        QByteArray buffer;
+    };
+
+    void watch(UAVObject *obj);
+    UAVObjectHistoryColumn *column(quint32 objId, const QString & field, quint32 element, quint32 instId) const;
+    static quint64 key(quint32 objId, quint32 instId);
+
+    UAVObjectManager *m_objMngr;
+    mutable QMutex m_mutex;
+    QSet<quint32> m_subscribed;
+    QHash<quint64, Instance *> m_instances;
+    UAVObjectHistoryStore *m_store;
+};
+
+#endif // UAVOBJECTHISTORY_H
@@ -0,0 +1,430 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjecthistorycolumn.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Compressed time series of the object history and their memory bound
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjecthistorycolumn.h"
+#include <algorithm>
+#include <string.h>
+
+UAVObjectHistorySpill::UAVObjectHistorySpill(const std::string & fileName) : m_fileName(fileName), m_size(0)
+{
+    m_file = fopen(fileName.c_str(), "w+b");
+}
+
+UAVObjectHistorySpill::~UAVObjectHistorySpill()
+{
+    if (m_file) {
+        fclose(m_file);
+        remove(m_fileName.c_str());
+    }
+}
+
+bool UAVObjectHistorySpill::isOpen() const
+{
+    return m_file != NULL;
+}
+
+int64_t UAVObjectHistorySpill::write(const std::vector<uint8_t> & data)
+{
+    int64_t offset = m_size;
+
+    if (!m_file || fseeko(m_file, offset, SEEK_SET) ||
+        fwrite(data.data(), 1, data.size(), m_file) != data.size()) {
+        return -1;
+    }
+    m_size += data.size();
+    return offset;
+}
+
+std::vector<uint8_t> UAVObjectHistorySpill::read(int64_t offset, int32_t size)
+{
+    std::vector<uint8_t> data(size);
+
+    // reads follow writes on the same stream, fflush() before switching
+    if (!m_file || fflush(m_file) || fseeko(m_file, offset, SEEK_SET)) {
+        return std::vector<uint8_t>();
+    }
+    data.resize(fread(data.data(), 1, size, m_file));
+    return data;
+}
+
+// Bit lengths of the time delta of delta, by prefix 0, 10, 110, 1110, 1111
+static const int TIME_BITS[] = { 0, 7, 9, 12, 64 };
+
+static inline int leadingZeros(uint64_t v)
+{
+    int n = 0;
+
+    if (!(v & 0xFFFFFFFF00000000ULL)) {
+        n += 32; v <<= 32;
+    }
+    if (!(v & 0xFFFF000000000000ULL)) {
+        n += 16; v <<= 16;
+    }
+    if (!(v & 0xFF00000000000000ULL)) {
+        n += 8; v <<= 8;
+    }
+    if (!(v & 0xF000000000000000ULL)) {
+        n += 4; v <<= 4;
+    }
+    if (!(v & 0xC000000000000000ULL)) {
+        n += 2; v <<= 2;
+    }
+    if (!(v & 0x8000000000000000ULL)) {
+        n += 1;
+    }
+    return n;
+}
+
+static inline int trailingZeros(uint64_t v)
+{
+    int n = 0;
+
+    if (!(v & 0xFFFFFFFFULL)) {
+        n += 32; v >>= 32;
+    }
+    if (!(v & 0xFFFFULL)) {
+        n += 16; v >>= 16;
+    }
+    if (!(v & 0xFFULL)) {
+        n += 8; v >>= 8;
+    }
+    if (!(v & 0xFULL)) {
+        n += 4; v >>= 4;
+    }
+    if (!(v & 0x3ULL)) {
+        n += 2; v >>= 2;
+    }
+    if (!(v & 0x1ULL)) {
+        n += 1;
+    }
+    return n;
+}
+
+static inline uint64_t doubleBits(double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline double bitsDouble(uint64_t bits)
+{
+    double value;
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+namespace {
+class BitReader {
+public:
+    BitReader(const std::vector<uint8_t> & data) : data(data.data()), size(data.size() * 8), pos(0) {}
+
+    uint64_t read(int bits)
+    {
+        uint64_t value = 0;
+
+        while (bits > 0 && pos < size) {
+            int used     = pos & 7;
+            int take     = std::min(8 - used, bits);
+            uint8_t byte = data[pos >> 3];
+            value = (value << take) | ((byte >> (8 - used - take)) & ((1 << take) - 1));
+            bits -= take;
+            pos  += take;
+        }
+        // past the end, only for a truncated block
+        return bits >= 64 ? 0 : value << bits;
+    }
+
+private:
+    const uint8_t *data;
+    uint64_t size;
+    uint64_t pos;
+};
+}
+
+const uint32_t UAVObjectHistoryColumn::BLOCK_SAMPLES;
+
+UAVObjectHistoryColumn::UAVObjectHistoryColumn() : m_firstInMemory(0), m_memory(0), m_count(0)
+{
+    m_open.count = 0;
+    m_open.spillOffset = -1;
+    m_open.spillSize   = 0;
+    m_encoder.bits     = 0;
+}
+
+void UAVObjectHistoryColumn::writeBits(uint64_t value, int bits)
+{
+    while (bits > 0) {
+        int used = m_encoder.bits & 7;
+        if (used == 0) {
+            m_open.data.push_back(0);
+            m_memory++;
+        }
+        int take      = std::min(8 - used, bits);
+        uint8_t chunk = (value >> (bits - take)) & ((1 << take) - 1);
+        m_open.data[m_encoder.bits >> 3] |= chunk << (8 - used - take);
+        bits -= take;
+        m_encoder.bits += take;
+    }
+}
+
+bool UAVObjectHistoryColumn::append(int64_t time, double value)
+{
+    uint64_t valueBits = doubleBits(value);
+
+    if (m_open.count == 0) {
+        m_open.firstTime = time;
+        writeBits(time, 64);
+        writeBits(valueBits, 64);
+        m_encoder.prevDelta    = 0;
+        m_encoder.prevLeading  = -1;
+        m_encoder.prevTrailing = 0;
+    } else {
+        // time, delta of delta zigzag encoded
+        int64_t delta = time - m_encoder.prevTime;
+        int64_t dod   = delta - m_encoder.prevDelta;
+        uint64_t zz   = ((uint64_t)dod << 1) ^ (uint64_t)(dod >> 63);
+        if (zz == 0) {
+            writeBits(0, 1);
+        } else {
+            int prefix = 1;
+            while (prefix < 4 && zz >= (1ULL << TIME_BITS[prefix])) {
+                prefix++;
+            }
+            // prefix 1..3 -> 10, 110, 1110, 4 -> 1111
+            writeBits(prefix < 4 ? ((1ULL << (prefix + 1)) - 2) : 0xF, prefix < 4 ? prefix + 1 : 4);
+            writeBits(zz, TIME_BITS[prefix]);
+        }
+        m_encoder.prevDelta = delta;
+
+        // value, XOR with the previous one
+        uint64_t x = valueBits ^ m_encoder.prevValue;
+        if (x == 0) {
+            writeBits(0, 1);
+        } else {
+            int leading  = std::min(leadingZeros(x), 31);
+            int trailing = trailingZeros(x);
+            if (m_encoder.prevLeading >= 0 && leading >= m_encoder.prevLeading && trailing >= m_encoder.prevTrailing) {
+                // fits in the window of the previous value
+                writeBits(2, 2);
+                writeBits(x >> m_encoder.prevTrailing, 64 - m_encoder.prevLeading - m_encoder.prevTrailing);
+            } else {
+                int length = 64 - leading - trailing;
+                writeBits(3, 2);
+                writeBits(leading, 5);
+                writeBits(length - 1, 6);
+                writeBits(x >> trailing, length);
+                m_encoder.prevLeading  = leading;
+                m_encoder.prevTrailing = trailing;
+            }
+        }
+    }
+    m_encoder.prevTime  = time;
+    m_encoder.prevValue = valueBits;
+    m_open.lastTime     = time;
+    m_open.count++;
+    m_count++;
+
+    if (m_open.count >= BLOCK_SAMPLES) {
+        seal();
+        return true;
+    }
+    return false;
+}
+
+void UAVObjectHistoryColumn::seal()
+{
+    // the sealed copy holds no spare capacity
+    m_blocks.push_back(m_open);
+
+    m_open.data.clear();
+    m_open.count   = 0;
+    m_encoder.bits = 0;
+}
+
+int64_t UAVObjectHistoryColumn::releaseOldest(UAVObjectHistorySpill *spill)
+{
+    if (m_firstInMemory >= m_blocks.size()) {
+        return 0;
+    }
+
+    Block &block   = m_blocks[m_firstInMemory];
+    int64_t memory = block.data.size();
+
+    if (spill && spill->isOpen()) {
+        block.spillOffset = spill->write(block.data);
+        block.spillSize   = block.data.size();
+    }
+    if (block.spillOffset >= 0) {
+        std::vector<uint8_t>().swap(block.data);
+        m_firstInMemory++;
+    } else {
+        // nowhere to keep it
+        m_count -= block.count;
+        m_blocks.erase(m_blocks.begin() + m_firstInMemory);
+    }
+    m_memory -= memory;
+    return memory;
+}
+
+void UAVObjectHistoryColumn::range(int64_t from, int64_t to, UAVObjectHistorySpill *spill,
+                                   std::vector<int64_t> & times, std::vector<double> & values) const
+{
+    for (std::deque<Block>::const_iterator block = m_blocks.begin(); block != m_blocks.end(); ++block) {
+        if (block->lastTime < from || block->firstTime > to) {
+            continue;
+        }
+        if (!block->data.empty()) {
+            decode(block->data, block->count, from, to, times, values);
+        } else if (spill && block->spillOffset >= 0) {
+            decode(spill->read(block->spillOffset, block->spillSize), block->count, from, to, times, values);
+        }
+    }
+    if (m_open.count > 0 && m_open.lastTime >= from && m_open.firstTime <= to) {
+        decode(m_open.data, m_open.count, from, to, times, values);
+    }
+}
+
+void UAVObjectHistoryColumn::decode(const std::vector<uint8_t> & data, uint32_t count, int64_t from, int64_t to,
+                                    std::vector<int64_t> & times, std::vector<double> & values)
+{
+    BitReader reader(data);
+    int64_t time   = (int64_t)reader.read(64);
+    uint64_t value = reader.read(64);
+    int64_t delta  = 0;
+    int leading    = 0;
+    int trailing   = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (i > 0) {
+            int prefix = 0;
+            while (prefix < 4 && reader.read(1)) {
+                prefix++;
+            }
+            if (prefix > 0) {
+                uint64_t zz = reader.read(TIME_BITS[prefix]);
+                delta += (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1);
+            }
+            time += delta;
+
+            if (reader.read(1)) {
+                if (reader.read(1)) {
+                    leading  = reader.read(5);
+                    trailing = 64 - leading - ((int)reader.read(6) + 1);
+                }
+                value ^= reader.read(64 - leading - trailing) << trailing;
+            }
+        }
+        if (time > to) {
+            return;
+        }
+        if (time >= from) {
+            times.push_back(time);
+            values.push_back(bitsDouble(value));
+        }
+    }
+}
+
+UAVObjectHistoryStore::UAVObjectHistoryStore(int64_t memoryLimit) : m_spill(NULL), m_memory(0), m_memoryLimit(memoryLimit)
+{}
+
+UAVObjectHistoryStore::~UAVObjectHistoryStore()
+{
+    for (size_t i = 0; i < m_columns.size(); i++) {
+        delete m_columns[i];
+    }
+    delete m_spill;
+}
+
+UAVObjectHistoryColumn *UAVObjectHistoryStore::addColumn()
+{
+    m_columns.push_back(new UAVObjectHistoryColumn());
+    return m_columns.back();
+}
+
+void UAVObjectHistoryStore::append(UAVObjectHistoryColumn *column, int64_t time, double value)
+{
+    int64_t before = column->memory();
+
+    if (column->append(time, value)) {
+        m_sealed.push_back(column);
+    }
+    m_memory += column->memory() - before;
+    enforceLimit();
+}
+
+void UAVObjectHistoryStore::range(const UAVObjectHistoryColumn *column, int64_t from, int64_t to,
+                                  std::vector<int64_t> & times, std::vector<double> & values) const
+{
+    column->range(from, to, m_spill, times, values);
+}
+
+void UAVObjectHistoryStore::enforceLimit()
+{
+    while (m_memory > m_memoryLimit && !m_sealed.empty()) {
+        m_memory -= m_sealed.front()->releaseOldest(m_spill);
+        m_sealed.pop_front();
+    }
+}
+
+void UAVObjectHistoryStore::setMemoryLimit(int64_t bytes)
+{
+    m_memoryLimit = bytes;
+    enforceLimit();
+}
+
+bool UAVObjectHistoryStore::setSpillFile(const std::string & fileName)
+{
+    // the blocks already in the old file stay readable only with it
+    if (m_spill && m_spill->size() > 0) {
+        return false;
+    }
+    delete m_spill;
+    m_spill = NULL;
+    if (fileName.empty()) {
+        return true;
+    }
+    m_spill = new UAVObjectHistorySpill(fileName);
+    if (!m_spill->isOpen()) {
+        delete m_spill;
+        m_spill = NULL;
+        return false;
+    }
+    return true;
+}
+
+uint64_t UAVObjectHistoryStore::samples() const
+{
+    uint64_t count = 0;
+
+    for (size_t i = 0; i < m_columns.size(); i++) {
+        count += m_columns[i]->count();
+    }
+    return count;
+}
@@ -0,0 +1,175 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjecthistorycolumn.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Compressed time series of the object history and their memory bound
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTHISTORYCOLUMN_H
+#define UAVOBJECTHISTORYCOLUMN_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+// No Qt in here, the unit test (flight/tests/uavobjecthistory) runs the
+// codec, the spill file and the memory limit on their own.
+
+/**
+ * Where the history puts the blocks that do not fit in memory any more
+ */
+class UAVObjectHistorySpill {
+public:
+    UAVObjectHistorySpill(const std::string & fileName);
+    ~UAVObjectHistorySpill();
+
+    bool isOpen() const;
+    // offset of the data in the file, -1 on error
+    int64_t write(const std::vector<uint8_t> & data);
+    std::vector<uint8_t> read(int64_t offset, int32_t size);
+    int64_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    std::string m_fileName;
+    FILE *m_file;
+    int64_t m_size;
+};
+
+/**
+ * Samples of one field element, in blocks of up to BLOCK_SAMPLES.
+ * Times are stored as delta of delta and values as the XOR with the
+ * previous value, both with variable bit lengths, so a slowly changing
+ * series takes a few bits per sample. Only the newest block grows,
+ * the older ones are sealed and can be released to the spill file.
+ */
+class UAVObjectHistoryColumn {
+public:
+    static const uint32_t BLOCK_SAMPLES = 1024;
+
+    UAVObjectHistoryColumn();
+
+    // returns true when the append sealed the open block
+    bool append(int64_t time, double value);
+
+    // samples with from <= time <= to, in time order
+    void range(int64_t from, int64_t to, UAVObjectHistorySpill *spill,
+               std::vector<int64_t> & times, std::vector<double> & values) const;
+
+    // moves the oldest sealed block still in memory to the spill file,
+    // or drops it without one, returns the memory released
+    int64_t releaseOldest(UAVObjectHistorySpill *spill);
+
+    // bytes of encoded samples held in memory
+    int64_t memory() const
+    {
+        return m_memory;
+    }
+    uint64_t count() const
+    {
+        return m_count;
+    }
+
+private:
+    struct Block {
+        int64_t firstTime;
+        int64_t lastTime;
+        uint32_t count;
+        std::vector<uint8_t> data; // empty once spilled
+        int64_t spillOffset;
+        int32_t spillSize;
+    };
+
+    struct Encoder {
+        uint64_t bits;
+        int64_t prevTime;
+        int64_t prevDelta;
+        uint64_t prevValue;
+        int prevLeading;
+        int prevTrailing;
+    };
+
+    void writeBits(uint64_t value, int bits);
+    void seal();
+    static void decode(const std::vector<uint8_t> & data, uint32_t count, int64_t from, int64_t to,
+                       std::vector<int64_t> & times, std::vector<double> & values);
+
+    std::deque<Block> m_blocks; // sealed, oldest first
+    size_t m_firstInMemory;
+    Block m_open;
+    Encoder m_encoder;
+    int64_t m_memory;
+    uint64_t m_count;
+};
+
+/**
+ * The columns of the history and the bound on their memory. Blocks are
+ * released in the order they were sealed, so the oldest samples of all
+ * columns go first. Not thread safe, UAVObjectHistory locks around it.
+ */
+class UAVObjectHistoryStore {
+public:
+    UAVObjectHistoryStore(int64_t memoryLimit);
+    ~UAVObjectHistoryStore();
+
+    // owned by the store
+    UAVObjectHistoryColumn *addColumn();
+
+    void append(UAVObjectHistoryColumn *column, int64_t time, double value);
+    void range(const UAVObjectHistoryColumn *column, int64_t from, int64_t to,
+               std::vector<int64_t> & times, std::vector<double> & values) const;
+
+    void setMemoryLimit(int64_t bytes);
+    int64_t memoryLimit() const
+    {
+        return m_memoryLimit;
+    }
+    // fileName empty to drop the released blocks, fails once something is spilled
+    bool setSpillFile(const std::string & fileName);
+
+    int64_t memoryUsed() const
+    {
+        return m_memory;
+    }
+    int64_t spilledBytes() const
+    {
+        return m_spill ? m_spill->size() : 0;
+    }
+    uint64_t samples() const;
+
+private:
+    void enforceLimit();
+
+    std::vector<UAVObjectHistoryColumn *> m_columns;
+    // one entry per sealed block still in memory
+    std::deque<UAVObjectHistoryColumn *> m_sealed;
+    UAVObjectHistorySpill *m_spill;
+    int64_t m_memory;
+    int64_t m_memoryLimit;
+};
+
+#endif // UAVOBJECTHISTORYCOLUMN_H
@@ -14,14 +14,18 @@ HEADERS += \
     uavdataobject.h \
     uavobjectfield.h \
     uavobjectsinit.h \
-    uavobjectsplugin.h
+    uavobjectsplugin.h \
+    uavobjecthistory.h \
+    uavobjecthistorycolumn.h
 SOURCES += \
     uavobject.cpp \
     uavmetaobject.cpp \
     uavobjectmanager.cpp \
     uavdataobject.cpp \
     uavobjectfield.cpp \
-    uavobjectsplugin.cpp
+    uavobjectsplugin.cpp \
+    uavobjecthistory.cpp \
+    uavobjecthistorycolumn.cpp
 
 OTHER_FILES += UAVObjects.pluginspec
 
@@ -58,6 +62,7 @@ UAVOBJS = \
     $${UAVOBJ_XML_DIR}/callbackinfo.xml \
     $${UAVOBJ_XML_DIR}/cameradesired.xml \
     $${UAVOBJ_XML_DIR}/camerastabsettings.xml \
+    $${UAVOBJ_XML_DIR}/controllatency.xml \
     $${UAVOBJ_XML_DIR}/debuglogcontrol.xml \
     $${UAVOBJ_XML_DIR}/debuglogentry.xml \
     $${UAVOBJ_XML_DIR}/debuglogsettings.xml \
@@ -138,6 +143,9 @@ UAVOBJS = \
     $${UAVOBJ_XML_DIR}/systemstats.xml \
     $${UAVOBJ_XML_DIR}/takeofflocation.xml \
     $${UAVOBJ_XML_DIR}/taskinfo.xml \
+    $${UAVOBJ_XML_DIR}/taskstats.xml \
+    $${UAVOBJ_XML_DIR}/tracecontrol.xml \
+    $${UAVOBJ_XML_DIR}/tracedata.xml \
     $${UAVOBJ_XML_DIR}/txpidsettings.xml \
     $${UAVOBJ_XML_DIR}/txpidstatus.xml \
     $${UAVOBJ_XML_DIR}/velocitydesired.xml \
@@ -47,6 +47,9 @@ UAVObjectUtilManager::UAVObjectUtilManager()
 {
     mutex     = new QMutex(QMutex::Recursive);
     saveState = IDLE;
+    saveBatchSize = 0;
+    saveDone  = 0;
+    saveTotal = 0;
     failureTimer.stop();
     failureTimer.setSingleShot(true);
     failureTimer.setInterval(1000);
@@ -94,7 +97,12 @@ UAVObjectManager *UAVObjectUtilManager::getObjectManager()
 void UAVObjectUtilManager::saveObjectToSD(UAVObject *obj)
 {
     // Add to queue
+    if (queue.isEmpty()) {
+        saveDone  = 0;
+        saveTotal = 0;
+    }
     queue.enqueue(obj);
+    saveTotal++;
     qDebug() << "Enqueue object: " << obj->getName();
 
 
@@ -124,9 +132,22 @@ void UAVObjectUtilManager::saveNextObject()
     if (obj != NULL) {
         ObjectPersistence::DataFields data;
         data.Operation  = ObjectPersistence::OPERATION_SAVE;
-        data.Selection  = ObjectPersistence::SELECTION_SINGLEOBJECT;
         data.ObjectID   = obj->getObjID();
         data.InstanceID = obj->getInstID();
+
+        // Following objects of the same instance are saved along in one list request,
+        // the flight side writes them to flash as one batch
+        saveBatchSize = 0;
+        while (saveBatchSize < queue.length() && saveBatchSize < (int)ObjectPersistence::OBJECTLIST_NUMELEM &&
+               queue.at(saveBatchSize)->getInstID() == obj->getInstID() &&
+               !queue.mid(0, saveBatchSize).contains(queue.at(saveBatchSize))) {
+            data.ObjectList[saveBatchSize] = queue.at(saveBatchSize)->getObjID();
+            saveBatchSize++;
+        }
+        for (int i = saveBatchSize; i < (int)ObjectPersistence::OBJECTLIST_NUMELEM; i++) {
+            data.ObjectList[i] = 0;
+        }
+        data.Selection = (saveBatchSize > 1) ? ObjectPersistence::SELECTION_OBJECTLIST : ObjectPersistence::SELECTION_SINGLEOBJECT;
         objper->setData(data);
         objper->updated();
     }
@@ -137,6 +158,25 @@ void UAVObjectUtilManager::saveNextObject()
     // operation we asked for (saved, other).
 }
 
+/**
+ * @brief Remove the objects of the current request from the queue, report them
+ * and continue with the next request.
+ * @param[in] success Whether the board saved the objects
+ */
+void UAVObjectUtilManager::finishSave(bool success)
+{
+    for (int i = 0; i < saveBatchSize && !queue.isEmpty(); i++) {
+        UAVObject *obj = queue.dequeue();
+        saveDone++;
+        emit saveCompleted(obj->getObjID(), success);
+    }
+    saveBatchSize = 0;
+    saveState     = IDLE;
+    emit saveProgress(saveDone, saveTotal);
+
+    saveNextObject();
+}
+
 /**
  * @brief Process the transactionCompleted message from Telemetry indicating request sent successfully
  * @param[in] The object just transsacted.  Must be ObjectPersistance
@@ -164,10 +204,7 @@ void UAVObjectUtilManager::objectPersistenceTransactionCompleted(UAVObject *obj,
         qDebug() << "objectPersistenceTranscationCompleted (error)";
         UAVObject *obj = getObjectManager()->getObject(ObjectPersistence::NAME);
         obj->disconnect(this);
-        queue.dequeue(); // We can now remove the object, it failed anyway.
-        saveState = IDLE;
-        emit saveCompleted(obj->getField("ObjectID")->getValue().toInt(), false);
-        saveNextObject();
+        finishSave(false); // We can now remove the objects, they failed anyway.
     }
 }
 
@@ -185,15 +222,9 @@ void UAVObjectUtilManager::objectPersistenceOperationFailed()
         ObjectPersistence *objectPersistence = ObjectPersistence::GetInstance(getObjectManager());
         Q_ASSERT(objectPersistence);
 
-        UAVObject *obj = queue.dequeue(); // We can now remove the object, it failed anyway.
-        Q_ASSERT(obj);
-
         objectPersistence->disconnect(this);
 
-        saveState = IDLE;
-        emit saveCompleted(obj->getObjID(), false);
-
-        saveNextObject();
+        finishSave(false); // We can now remove the objects, they failed anyway.
     }
 }
 
@@ -223,11 +254,7 @@ void UAVObjectUtilManager::objectPersistenceUpdated(UAVObject *obj)
         }
 
         obj->disconnect(this);
-        queue.dequeue(); // We can now remove the object, it's done.
-        saveState = IDLE;
-
-        emit saveCompleted(objectPersistence.ObjectID, true);
-        saveNextObject();
+        finishSave(true); // We can now remove the objects, they are done.
     }
 }
 
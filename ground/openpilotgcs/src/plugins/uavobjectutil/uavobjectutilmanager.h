@@ -72,12 +72,17 @@ protected:
 
 signals:
     void saveCompleted(int objectID, bool status);
+    void saveProgress(int saved, int total);
 
 private:
     QMutex *mutex;
     QQueue<UAVObject *> queue;
     enum { IDLE, AWAITING_ACK, AWAITING_COMPLETED } saveState;
+    int saveBatchSize;
+    int saveDone;
+    int saveTotal;
     void saveNextObject();
+    void finishSave(bool success);
     QTimer failureTimer;
 
     ExtensionSystem::PluginManager *pm;
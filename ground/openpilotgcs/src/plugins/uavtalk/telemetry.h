@@ -54,7 +54,7 @@ private slots:
     void timeout();
 };
 
-class Telemetry : public QObject {
+class UAVTALK_EXPORT Telemetry : public QObject {
     Q_OBJECT
 
 public:
@@ -79,9 +79,11 @@ public:
     void resetStats();
     void transactionTimeout(ObjectTransactionInfo *info);
 
+    // Time to wait for an answer before a request is retried or failed
+    static const int REQ_TIMEOUT_MS = 250;
+
 private:
     // Constants
-    static const int REQ_TIMEOUT_MS = 250;
     static const int MAX_RETRIES    = 2;
     static const int MAX_UPDATE_PERIOD_MS = 1000;
     static const int MIN_UPDATE_PERIOD_MS = 1;
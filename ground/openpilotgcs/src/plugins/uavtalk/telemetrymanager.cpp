@@ -32,12 +32,18 @@
 #include <coreplugin/icore.h>
 #include <coreplugin/threadmanager.h>
 
-TelemetryManager::TelemetryManager() : m_connectionState(TELEMETRY_DISCONNECTED)
+TelemetryManager::TelemetryManager(UAVObjectManager *objMngr, QThread *thread) :
+    m_uavobjectManager(objMngr), m_connectionState(TELEMETRY_DISCONNECTED)
 {
-    moveToThread(Core::ICore::instance()->threadManager()->getRealTimeThread());
-    // Get UAVObjectManager instance
-    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    m_uavobjectManager = pm->getObject<UAVObjectManager>();
+    if (!thread) {
+        thread = Core::ICore::instance()->threadManager()->getRealTimeThread();
+    }
+    moveToThread(thread);
+    if (!m_uavobjectManager) {
+        // Get UAVObjectManager instance
+        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+        m_uavobjectManager = pm->getObject<UAVObjectManager>();
+    }
 
     // connect to start stop signals
     connect(this, SIGNAL(myStart()), this, SLOT(onStart()), Qt::QueuedConnection);
@@ -57,6 +63,11 @@ TelemetryManager::ConnectionState TelemetryManager::connectionState() const
     return m_connectionState;
 }
 
+UAVObjectManager *TelemetryManager::objectManager() const
+{
+    return m_uavobjectManager;
+}
+
 void TelemetryManager::start(QIODevice *dev)
 {
     m_connectionState = TELEMETRY_CONNECTING;
@@ -123,6 +134,7 @@ void TelemetryManager::onStop()
     delete m_telemetry;
     delete m_uavTalk;
     onDisconnect();
+    emit stopped();
 }
 
 void TelemetryManager::onConnect()
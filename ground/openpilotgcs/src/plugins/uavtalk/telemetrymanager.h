@@ -48,19 +48,23 @@ public:
         TELEMETRY_CONNECTING
     };
 
-    TelemetryManager();
+    // by default the telemetry of the global object manager, in the real time thread
+    TelemetryManager(UAVObjectManager *objMngr = NULL, QThread *thread = NULL);
     ~TelemetryManager();
 
     void start(QIODevice *dev);
     void stop();
     bool isConnected() const;
     ConnectionState connectionState() const;
+    UAVObjectManager *objectManager() const;
 
 signals:
     void connecting();
     void connected();
     void disconnecting();
     void disconnected();
+    // emitted from the telemetry thread once stop() has torn the link down
+    void stopped();
     void telemetryUpdated(double txRate, double rxRate);
     void myStart();
     void myStop();
@@ -39,9 +39,13 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel) :
     flightStatsObj(FlightTelemetryStats::GetInstance(objMngr)),
     firmwareIAPObj(FirmwareIAPObj::GetInstance(objMngr)),
     statsTimer(new QTimer(this)),
-    objPending(NULL),
+    refillTimer(new QTimer(this)),
     mutex(new QMutex(QMutex::Recursive)),
-    connectionTimer(new QTime())
+    connectionTimer(new QTime()),
+    window(INITIAL_WINDOW),
+    minRtt(-1),
+    smoothedRtt(-1),
+    objRetrieved(0)
 {
     // Listen for flight stats updates
     connect(flightStatsObj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(flightStatsUpdated(UAVObject *)));
@@ -49,6 +53,10 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel) :
     // Start update timer
     connect(statsTimer, SIGNAL(timeout()), this, SLOT(processStatsUpdates()));
     statsTimer->start(STATS_CONNECT_PERIOD_MS);
+
+    // Requests are refilled from the event loop, see transactionCompleted()
+    refillTimer->setSingleShot(true);
+    connect(refillTimer, SIGNAL(timeout()), this, SLOT(retrieveNextObjects()));
 }
 
 TelemetryMonitor::~TelemetryMonitor()
@@ -66,8 +74,11 @@ TelemetryMonitor::~TelemetryMonitor()
  */
 void TelemetryMonitor::startRetrievingObjects()
 {
-    // Clear object queue
+    // Clear object queue, requests of a previous connection must not complete into this one
     queue.clear();
+    refillTimer->stop();
+    cancelPendingRequests();
+    objRetried.clear();
     // Get all objects, add metaobjects, settings and data objects with OnChange update mode to the queue
     QList< QList<UAVObject *> > objs = objMngr->getObjects();
     for (int n = 0; n < objs.length(); ++n) {
@@ -87,10 +98,12 @@ void TelemetryMonitor::startRetrievingObjects()
             }
         }
     }
-    // Start retrieving
+    // Start retrieving, keep the window learned on a previous connection
     qDebug() << tr("Starting to retrieve meta and settings objects from the autopilot (%1 objects)")
         .arg(queue.length());
-    retrieveNextObject();
+    objRetrieved = 0;
+    retrievalTimer.start();
+    retrieveNextObjects();
 }
 
 /**
@@ -100,16 +113,34 @@ void TelemetryMonitor::stopRetrievingObjects()
 {
     qDebug("Object retrieval has been cancelled");
     queue.clear();
+    refillTimer->stop();
+    cancelPendingRequests();
+}
+
+/**
+ * Stop listening to the outstanding requests
+ */
+void TelemetryMonitor::cancelPendingRequests()
+{
+    foreach(UAVObject * obj, objPending.keys()) {
+        disconnect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
+    }
+    objPending.clear();
 }
 
 /**
- * Retrieve the next object in the queue
+ * Request objects from the queue until the window of outstanding requests is full.
+ * Requests are pipelined so that the link round trip time is paid once per window
+ * instead of once per object.
  */
-void TelemetryMonitor::retrieveNextObject()
+void TelemetryMonitor::retrieveNextObjects()
 {
-    // If queue is empty return
-    if (queue.isEmpty()) {
-        qDebug("Object retrieval completed");
+    QMutexLocker locker(mutex);
+
+    // If queue is empty and all requests are answered return
+    if (queue.isEmpty() && objPending.isEmpty()) {
+        qDebug() << tr("Object retrieval completed, %1 objects in %2 ms (window %3, round trip %4 ms)")
+            .arg(objRetrieved).arg(retrievalTimer.elapsed()).arg((int)window).arg(smoothedRtt);
         if (firmwareIAPObj->getBoardType()) {
             emit connected();
         } else {
@@ -118,16 +149,47 @@ void TelemetryMonitor::retrieveNextObject()
         return;
     }
 
-    // Get next object from the queue
-    UAVObject *obj = queue.dequeue();
-    // qDebug( tr("Retrieving object: %1").arg(obj->getName()) );
+    while (!queue.isEmpty() && objPending.size() < (int)window) {
+        // Get next object from the queue
+        UAVObject *obj = queue.dequeue();
+        // qDebug( tr("Retrieving object: %1").arg(obj->getName()) );
 
-    // Connect to object
-    connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
+        // Connect to object
+        connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
 
-    // Request update
-    obj->requestUpdate();
-    objPending = obj;
+        // Request update
+        objPending.insert(obj, retrievalTimer.elapsed());
+        obj->requestUpdate();
+    }
+}
+
+/**
+ * Adapt the number of outstanding requests. The window grows by one object per
+ * window of answered requests while the round trip time stays close to the
+ * smallest one seen, it shrinks again as soon as requests queue up on the link
+ * and is halved when a request is lost. Objects the autopilot does not have are
+ * nacked, that says nothing about the link.
+ */
+void TelemetryMonitor::updateWindow(int rtt, bool success)
+{
+    if (!success) {
+        // failures answered faster than the request timeout are nacks, not losses
+        if (rtt >= Telemetry::REQ_TIMEOUT_MS) {
+            window = qMax((double)MIN_WINDOW, window / 2);
+        }
+        return;
+    }
+
+    if (minRtt < 0 || rtt < minRtt) {
+        minRtt = rtt;
+    }
+    smoothedRtt = (smoothedRtt < 0) ? rtt : (7 * smoothedRtt + rtt) / 8;
+
+    if (rtt <= 2 * minRtt + RTT_SLACK_MS) {
+        window = qMin((double)MAX_WINDOW, window + 1.0 / window);
+    } else {
+        window = qMax((double)MIN_WINDOW, window - 1.0 / window);
+    }
 }
 
 /**
@@ -135,18 +197,26 @@ void TelemetryMonitor::retrieveNextObject()
  */
 void TelemetryMonitor::transactionCompleted(UAVObject *obj, bool success)
 {
-    Q_UNUSED(success);
     QMutexLocker locker(mutex);
 
-    if (obj == objPending) {
+    if (objPending.contains(obj)) {
         // Disconnect from sending object
-        obj->disconnect(this);
-        objPending = NULL;
+        disconnect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
+        updateWindow(retrievalTimer.elapsed() - objPending.take(obj), success);
+        if (success) {
+            ++objRetrieved;
+        } else if (!objRetried.contains(obj)) {
+            // The request may have been dropped by a full queue, give it one more try
+            objRetried.insert(obj);
+            queue.enqueue(obj);
+        }
         // Process next object if telemetry is still available
         GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
 
         if (gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED) {
-            retrieveNextObject();
+            // A request the telemetry queue has no room for completes right away from within
+            // retrieveNextObjects(), refill from the event loop instead of recursing into it
+            refillTimer->start(0);
         } else {
             stopRetrievingObjects();
         }
@@ -30,6 +30,8 @@
 
 #include <QObject>
 #include <QQueue>
+#include <QHash>
+#include <QSet>
 #include <QTimer>
 #include <QTime>
 #include <QMutex>
@@ -41,7 +43,7 @@
 #include "systemstats.h"
 #include "telemetry.h"
 
-class TelemetryMonitor : public QObject {
+class UAVTALK_EXPORT TelemetryMonitor : public QObject {
     Q_OBJECT
 
 public:
@@ -59,10 +61,18 @@ public slots:
     void flightStatsUpdated(UAVObject *obj);
     void firmwareIAPUpdated(UAVObject *obj);
 
+private slots:
+    void retrieveNextObjects();
+
 private:
     static const int STATS_UPDATE_PERIOD_MS  = 4000;
     static const int STATS_CONNECT_PERIOD_MS = 2000;
     static const int CONNECTION_TIMEOUT_MS   = 8000;
+    // Outstanding object requests during retrieval, must stay below the telemetry event queue size
+    static const int MIN_WINDOW     = 1;
+    static const int INITIAL_WINDOW = 4;
+    static const int MAX_WINDOW     = 16;
+    static const int RTT_SLACK_MS   = 10;
 
     UAVObjectManager *objMngr;
     Telemetry *tel;
@@ -71,13 +81,21 @@ private:
     FlightTelemetryStats *flightStatsObj;
     FirmwareIAPObj *firmwareIAPObj;
     QTimer *statsTimer;
-    UAVObject *objPending;
+    QTimer *refillTimer;
+    QHash<UAVObject *, int> objPending;
+    QSet<UAVObject *> objRetried;
     QMutex *mutex;
     QTime *connectionTimer;
+    QTime retrievalTimer;
+    double window;
+    int minRtt;
+    int smoothedRtt;
+    int objRetrieved;
 
     void startRetrievingObjects();
-    void retrieveNextObject();
     void stopRetrievingObjects();
+    void cancelPendingRequests();
+    void updateWindow(int rtt, bool success);
 };
 
 #endif // TELEMETRYMONITOR_H
@@ -0,0 +1,154 @@
+/**
+ ******************************************************************************
+ *
+ * @file       telemetrysessionmanager.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Concurrent telemetry sessions, one per vehicle
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "telemetrysessionmanager.h"
+#include "uavobjectsinit.h"
+#include <QThread>
+#include <QDebug>
+#include <QtNetwork/QUdpSocket>
+
+const QString TelemetrySessionManager::PrimarySession = "primary";
+
+TelemetrySessionManager::TelemetrySessionManager(TelemetryManager *primary) :
+    m_currentSession(PrimarySession)
+{
+    Session session;
+
+    session.objMngr = primary->objectManager();
+    session.telMngr = primary;
+    session.thread  = NULL;
+    session.dev     = NULL;
+    m_sessions.insert(PrimarySession, session);
+}
+
+TelemetrySessionManager::~TelemetrySessionManager()
+{
+    foreach(QString name, m_sessions.keys()) {
+        removeSession(name);
+    }
+    m_sessions.clear();
+}
+
+QStringList TelemetrySessionManager::sessions() const
+{
+    return m_sessions.keys();
+}
+
+TelemetryManager *TelemetrySessionManager::telemetryManager(const QString &name) const
+{
+    return m_sessions.contains(name) ? m_sessions.value(name).telMngr : NULL;
+}
+
+UAVObjectManager *TelemetrySessionManager::objectManager(const QString &name) const
+{
+    return m_sessions.contains(name) ? m_sessions.value(name).objMngr : NULL;
+}
+
+QString TelemetrySessionManager::currentSession() const
+{
+    return m_currentSession;
+}
+
+void TelemetrySessionManager::setCurrentSession(const QString &name)
+{
+    if (name == m_currentSession || !m_sessions.contains(name)) {
+        return;
+    }
+    m_currentSession = name;
+    emit currentSessionChanged(name);
+}
+
+bool TelemetrySessionManager::addSession(const QString &name, QIODevice *dev)
+{
+    if (m_sessions.contains(name) || !dev || !dev->isOpen()) {
+        return false;
+    }
+
+    Session session;
+
+    // a registry of its own, so vehicles do not overwrite each other's objects
+    session.objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(session.objMngr);
+
+    // parsing and the telemetry timers of this vehicle run in their own thread
+    session.thread  = new QThread();
+    session.thread->setObjectName("Telemetry " + name);
+    session.thread->start();
+
+    session.dev     = dev;
+    session.telMngr = new TelemetryManager(session.objMngr, session.thread);
+    // once stopped nothing is left to run in the thread
+    connect(session.telMngr, SIGNAL(stopped()), session.thread, SLOT(quit()), Qt::DirectConnection);
+    session.telMngr->start(dev);
+
+    m_sessions.insert(name, session);
+    emit sessionAdded(name);
+    return true;
+}
+
+bool TelemetrySessionManager::addUdpSession(const QString &name, const QString &host, int port)
+{
+    // no parent, the device is moved to the session thread
+    QUdpSocket *socket = new QUdpSocket();
+
+    socket->connectToHost(host, port);
+    if (!socket->waitForConnected(5000) || !addSession(name, socket)) {
+        qWarning() << "TelemetrySessionManager: cannot open session" << name << "to" << host << port;
+        delete socket;
+        return false;
+    }
+    return true;
+}
+
+void TelemetrySessionManager::removeSession(const QString &name)
+{
+    // the primary session belongs to the connection manager
+    if (name == PrimarySession || !m_sessions.contains(name)) {
+        return;
+    }
+    // gadgets showing the vehicle move away before its objects go
+    if (name == m_currentSession) {
+        m_currentSession = PrimarySession;
+        emit currentSessionChanged(m_currentSession);
+    }
+
+    Session session = m_sessions.take(name);
+
+    session.telMngr->stop();
+    session.thread->wait();
+
+    delete session.telMngr;
+    delete session.dev;
+    delete session.thread;
+    // the object manager does not own its objects
+    foreach(QList<UAVObject *> instances, session.objMngr->getObjects()) {
+        qDeleteAll(instances);
+    }
+    delete session.objMngr;
+
+    emit sessionRemoved(name);
+}
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ *
+ * @file       telemetrysessionmanager.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Concurrent telemetry sessions, one per vehicle
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TELEMETRYSESSIONMANAGER_H
+#define TELEMETRYSESSIONMANAGER_H
+
+#include "uavtalk_global.h"
+#include "telemetrymanager.h"
+#include <QMap>
+#include <QStringList>
+
+/**
+ *   Keeps one telemetry session per connected vehicle. Every session has
+ *   its own object manager, connection and thread running the protocol.
+ *   The primary session is the global object manager driven by the
+ *   connection manager, gadgets that do not care keep using that one.
+ */
+class UAVTALK_EXPORT TelemetrySessionManager : public QObject {
+    Q_OBJECT
+
+public:
+    static const QString PrimarySession;
+
+    TelemetrySessionManager(TelemetryManager *primary);
+    ~TelemetrySessionManager();
+
+    QStringList sessions() const;
+    TelemetryManager *telemetryManager(const QString &name) const;
+    UAVObjectManager *objectManager(const QString &name) const;
+
+    // the session gadgets following the user selection should show
+    QString currentSession() const;
+    void setCurrentSession(const QString &name);
+
+    // takes ownership of the opened device
+    bool addSession(const QString &name, QIODevice *dev);
+    bool addUdpSession(const QString &name, const QString &host, int port);
+    void removeSession(const QString &name);
+
+signals:
+    void sessionAdded(const QString &name);
+    void sessionRemoved(const QString &name);
+    void currentSessionChanged(const QString &name);
+
+private:
+    struct Session {
+        UAVObjectManager *objMngr;
+        TelemetryManager *telMngr;
+        QThread *thread;
+        QIODevice *dev;
+    };
+
+    QMap<QString, Session> m_sessions;
+    QString m_currentSession;
+};
+
+#endif // TELEMETRYSESSIONMANAGER_H
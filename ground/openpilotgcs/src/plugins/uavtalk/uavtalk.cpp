@@ -27,6 +27,7 @@
 #include "uavtalk.h"
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/generalsettings.h>
+#include <coreplugin/ispanreader.h>
 #include <utils/crc.h>
 
 #include <QtEndian>
@@ -44,6 +45,9 @@
 
 #define SYNC_VAL 0x3C
 
+// bytes taken from the device at once when it cannot hand them out in place
+#define RX_CHUNK_SIZE 256
+
 using namespace Utils;
 
 /**
@@ -56,9 +60,10 @@ UAVTalk::UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr) : io(iodev), objMn
 
     memset(&stats, 0, sizeof(ComStats));
 
+    // there are no GCS settings when running headless
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    Core::Internal::GeneralSettings *settings = pm->getObject<Core::Internal::GeneralSettings>();
-    useUDPMirror = settings->useUDPMirror();
+    Core::Internal::GeneralSettings *settings = pm ? pm->getObject<Core::Internal::GeneralSettings>() : NULL;
+    useUDPMirror = settings && settings->useUDPMirror();
     qDebug() << "USE UDP:::::::::::." << useUDPMirror;
     if (useUDPMirror) {
         udpSocketTx = new QUdpSocket(this);
@@ -208,31 +213,56 @@ bool UAVTalk::objectTransaction(quint8 type, quint32 objId, quint16 instId, UAVO
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
+    if (!io || !io->isReadable()) {
+        return;
+    }
+
+    Core::ISpanReader *spanReader = dynamic_cast<Core::ISpanReader *>(io.data());
+    if (spanReader) {
+        // parse the received data in place
+        const char *span;
+        qint64 size;
+        while ((size = spanReader->peekSpan(&span)) > 0) {
+            processInputBytes((const quint8 *)span, size);
+            spanReader->consumeSpan(size);
+        }
+        return;
+    }
 
-    if (io && io->isReadable()) {
-        while (io->bytesAvailable() > 0) {
-            int ret = io->read((char *)&tmp, 1);
-            if (ret != -1) {
-                processInputByte(tmp);
+    quint8 buffer[RX_CHUNK_SIZE];
+    while (io->bytesAvailable() > 0) {
+        qint64 ret = io->read((char *)buffer, sizeof(buffer));
+        if (ret <= 0) {
+            break;
+        }
+        processInputBytes(buffer, ret);
+    }
+}
+
+/**
+ * Process a block of bytes from the telemetry stream and
+ * dispatch every object completed by them.
+ * \param[in] data Received bytes
+ * \param[in] size Number of bytes
+ */
+void UAVTalk::processInputBytes(const quint8 *data, qint64 size)
+{
+    for (qint64 i = 0; i < size; i++) {
+        processInputByte(data[i]);
+        if (rxState == STATE_COMPLETE) {
+            mutex.lock();
+            if (receiveObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength)) {
+                stats.rxObjectBytes += rxLength;
+                stats.rxObjects++;
             } else {
-                // TODOD
+                // TODO...
             }
-            if (rxState == STATE_COMPLETE) {
-                mutex.lock();
-                if (receiveObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength)) {
-                    stats.rxObjectBytes += rxLength;
-                    stats.rxObjects++;
-                } else {
-                    // TODO...
-                }
-                mutex.unlock();
+            mutex.unlock();
 
-                if (useUDPMirror) {
-                    // it is safe to do this outside of the above critical section as the rxDataArray is
-                    // accessed from this thread only
-                    udpSocketTx->writeDatagram(rxDataArray, QHostAddress::LocalHost, udpSocketRx->localPort());
-                }
+            if (useUDPMirror) {
+                // it is safe to do this outside of the above critical section as the rxDataArray is
+                // accessed from this thread only
+                udpSocketTx->writeDatagram(rxDataArray, QHostAddress::LocalHost, udpSocketRx->localPort());
             }
         }
     }
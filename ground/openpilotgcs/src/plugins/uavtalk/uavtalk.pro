@@ -16,6 +16,7 @@ HEADERS += \
     uavtalkplugin.h \
     telemetrymonitor.h \
     telemetrymanager.h \
+    telemetrysessionmanager.h \
     uavtalk_global.h \
     telemetry.h
 
@@ -24,6 +25,7 @@ SOURCES += \
     uavtalkplugin.cpp \
     telemetrymonitor.cpp \
     telemetrymanager.cpp \
+    telemetrysessionmanager.cpp \
     telemetry.cpp
 
 OTHER_FILES += UAVTalk.pluginspec
@@ -28,6 +28,7 @@
 
 #include <coreplugin/icore.h>
 #include <coreplugin/connectionmanager.h>
+#include <QDebug>
 
 UAVTalkPlugin::UAVTalkPlugin()
 {}
@@ -38,7 +39,19 @@ UAVTalkPlugin::~UAVTalkPlugin()
  * Called once all the plugins which depend on us have been loaded
  */
 void UAVTalkPlugin::extensionsInitialized()
-{}
+{
+    foreach(QString vehicle, vehicles) {
+        QString name = vehicle.section('@', 0, 0);
+        QString host = vehicle.section('@', 1).section(':', 0, 0);
+        int port     = vehicle.section(':', -1).toInt();
+
+        if (name.isEmpty() || host.isEmpty() || port <= 0) {
+            qWarning() << "UAVTalkPlugin: ignoring vehicle" << vehicle << "expected name@host:port";
+            continue;
+        }
+        sessionMngr->addUdpSession(name, host, port);
+    }
+}
 
 /**
  * Called at startup, before any plugin which depends on us is initialized
@@ -46,13 +59,22 @@ void UAVTalkPlugin::extensionsInitialized()
 bool UAVTalkPlugin::initialize(const QStringList & arguments, QString *errorString)
 {
     // Done
-    Q_UNUSED(arguments);
     Q_UNUSED(errorString);
 
+    for (int i = 0; i < arguments.size() - 1; i++) {
+        if (arguments.at(i) == "-vehicle") {
+            vehicles << arguments.at(++i);
+        }
+    }
+
     // Create TelemetryManager
     telMngr = new TelemetryManager();
     addAutoReleasedObject(telMngr);
 
+    // Other vehicles get sessions of their own next to it
+    sessionMngr = new TelemetrySessionManager(telMngr);
+    addAutoReleasedObject(sessionMngr);
+
     // Connect to connection manager so we get notified when the user connect to his device
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
     QObject::connect(cm, SIGNAL(deviceConnected(QIODevice *)),
@@ -32,6 +32,7 @@
 #include <QtPlugin>
 #include "uavtalk.h"
 #include "telemetrymanager.h"
+#include "telemetrysessionmanager.h"
 
 class UAVTALK_EXPORT UAVTalkPlugin : public ExtensionSystem::IPlugin {
     Q_OBJECT
@@ -51,6 +52,9 @@ protected slots:
 
 private:
     TelemetryManager *telMngr;
+    TelemetrySessionManager *sessionMngr;
+    // extra vehicles from the command line, name@host:port
+    QStringList vehicles;
 };
 
 #endif // UAVTALKPLUGIN_H
@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ *
+ * @file       dfusectors.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup Uploader Uploader Plugin
+ * @{
+ * @brief Sector CRCs of the differential firmware upload
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "dfusectors.h"
+
+#define PACKET_BYTES        (4 * 14)
+#define SECTOR_ENTRY_SIZE   13
+#define SECTORS_PER_REQUEST 128
+
+using namespace OP_DFU;
+
+/**
+   Works out which sectors differ from the new firmware and which upload
+   packets fall into them
+ */
+SectorDiff::SectorDiff(const char *firmware, uint32_t length, uint32_t sizeOfCode, const std::vector<sector> & sectors)
+    : dirty(sectors.size(), false), total(0), erased(0), image(firmware, firmware + length)
+{
+    // the bootloader CRCs cover the whole code area
+    if (image.size() < sizeOfCode) {
+        image.resize(sizeOfCode, (char)0xFF);
+    }
+
+    uint32_t numberOfPackets = (length + PACKET_BYTES - 1) / PACKET_BYTES;
+    packets.assign(numberOfPackets, false);
+    for (uint32_t x = 0; x < sectors.size(); ++x) {
+        const sector &s = sectors[x];
+        total += s.Size;
+        if (!s.Description && s.Offset + s.Size <= image.size() &&
+            CRC32(0xFFFFFFFF, image.data() + s.Offset, s.Size) == s.CRC) {
+            continue;
+        }
+        dirty[x] = true;
+        erased  += s.Size;
+        // the description sector is erased as a whole, resend everything in it
+        uint32_t end = s.Description ? sizeOfCode : s.Offset + s.Size;
+        for (uint32_t packet = s.Offset / PACKET_BYTES; packet < numberOfPackets && packet * PACKET_BYTES < end; ++packet) {
+            packets[packet] = true;
+        }
+    }
+}
+
+int SectorDiff::parseReply(const char *buf, std::vector<sector> & sectors)
+{
+    int total   = (uint8_t)buf[7] << 8 | (uint8_t)buf[8];
+    int entries = (uint8_t)buf[6];
+
+    if (total == 0 || entries == 0) {
+        return 0;
+    }
+    for (int x = 0; x < entries; ++x) {
+        const uint8_t *entry = (const uint8_t *)&buf[9 + x * SECTOR_ENTRY_SIZE];
+        sector s;
+        s.Offset      = (uint32_t)entry[0] << 24 | entry[1] << 16 | entry[2] << 8 | entry[3];
+        s.Size        = (uint32_t)entry[4] << 24 | entry[5] << 16 | entry[6] << 8 | entry[7];
+        s.CRC         = (uint32_t)entry[8] << 24 | entry[9] << 16 | entry[10] << 8 | entry[11];
+        s.Description = entry[12] & 0x01;
+        sectors.push_back(s);
+    }
+    return total;
+}
+
+int SectorDiff::selectRequest(char *buf, const std::vector<bool> & dirty, int first)
+{
+    int count = (int)dirty.size() - first;
+
+    if (count > SECTORS_PER_REQUEST) {
+        count = SECTORS_PER_REQUEST;
+    }
+    buf[6] = count;
+    for (int x = 0; x < count; ++x) {
+        if (dirty[first + x]) {
+            buf[7 + x / 8] |= 1 << (x % 8);
+        }
+    }
+    return count;
+}
+
+uint32_t SectorDiff::CRC32(uint32_t crc, const char *data, uint32_t size)
+{
+    while (size--) {
+        crc ^= (uint32_t)(uint8_t)*data++ << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool SectorDiff::verify(const std::vector<sector> & sectors) const
+{
+    if (sectors.size() != dirty.size()) {
+        return false;
+    }
+    for (uint32_t x = 0; x < sectors.size(); ++x) {
+        const sector &s = sectors[x];
+        if (s.Offset + s.Size > image.size() || CRC32(0xFFFFFFFF, image.data() + s.Offset, s.Size) != s.CRC) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ *
+ * @file       dfusectors.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup Uploader Uploader Plugin
+ * @{
+ * @brief Sector CRCs of the differential firmware upload
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef DFUSECTORS_H
+#define DFUSECTORS_H
+
+#include <stdint.h>
+#include <vector>
+
+// No Qt in here, the bootloader unit test (flight/tests/opdfu) runs this
+// code against the real op_dfu.c.
+namespace OP_DFU {
+// one erase sector of the firmware area, as reported by the bootloader
+struct sector {
+    uint32_t Offset; // from the start of the firmware
+    uint32_t Size; // clipped to the code area
+    uint32_t CRC;
+    bool     Description; // also holds the description, always rewritten
+};
+
+class SectorDiff {
+public:
+    SectorDiff(const char *firmware, uint32_t length, uint32_t sizeOfCode, const std::vector<sector> & sectors);
+
+    // Appends the sectors of a Rep_SectorCRC reply, returns the number of sectors
+    // of the firmware area or 0 if the bootloader can't tell
+    static int parseReply(const char *buf, std::vector<sector> & sectors);
+    // Fills the bitmap of a Select_Sectors request, returns the number of sectors in it
+    static int selectRequest(char *buf, const std::vector<bool> & dirty, int first);
+    // Byte wise CRC32 as PIOS_CRC32_updateCRC
+    static uint32_t CRC32(uint32_t crc, const char *data, uint32_t size);
+
+    // the sector CRCs read back after the upload match the new firmware
+    bool verify(const std::vector<sector> & sectors) const;
+
+    std::vector<bool> dirty; // sectors to erase and program
+    std::vector<bool> packets; // upload packets to send
+    uint32_t total; // bytes in the firmware area
+    uint32_t erased; // bytes in the dirty sectors
+
+private:
+    std::vector<char> image; // the firmware padded to the code size, erased flash reads 0xFF
+};
+}
+
+#endif // DFUSECTORS_H
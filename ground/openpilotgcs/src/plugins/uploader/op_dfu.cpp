@@ -27,6 +27,7 @@
 
 #include "op_dfu.h"
 #include <cmath>
+#include <algorithm>
 #include <qwaitcondition.h>
 #include <QMetaType>
 #include <QtWidgets/QApplication>
@@ -180,7 +181,7 @@ bool DFUObject::enterDFU(int const &devNumber)
    erase the memory to make room for the data. You will have to query
    its status to wait until erase is done before doing the actual upload.
  */
-bool DFUObject::StartUpload(qint32 const & numberOfBytes, TransferTypes const & type, quint32 crc)
+bool DFUObject::StartUpload(qint32 const & numberOfBytes, TransferTypes const & type, quint32 crc, int eraseWait)
 {
     int lastPacketCount;
     qint32 numberOfPackets = numberOfBytes / 4 / 14;
@@ -210,7 +211,7 @@ bool DFUObject::StartUpload(qint32 const & numberOfBytes, TransferTypes const &
     }
 
     int result = sendData(buf, BUF_LEN);
-    delay::msleep(1000);
+    delay::msleep(eraseWait);
 
     if (debug) {
         qDebug() << result << " bytes sent";
@@ -226,7 +227,7 @@ bool DFUObject::StartUpload(qint32 const & numberOfBytes, TransferTypes const &
    Does the actual data upload to the board. Needs to be called once the
    board is ready to accept data following a StartUpload command, and it is erased.
  */
-bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray & data)
+bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray & data, const std::vector<bool> & packets)
 {
     int lastPacketCount;
     qint32 numberOfPackets = numberOfBytes / 4 / 14;
@@ -253,6 +254,10 @@ bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray & data)
             printProgBar((int)percentage, "UPLOADING");
         }
         laspercentage = (int)percentage;
+        if (!packets.empty() && !packets[packetcount]) {
+            // packet of an unchanged sector, differential upload
+            continue;
+        }
         if (packetcount == numberOfPackets) {
             packetsize = lastPacketCount;
         } else {
@@ -658,6 +663,7 @@ bool DFUObject::findDevices()
             aux = aux << 8 | (quint8)buf[4];
             aux = aux << 8 | (quint8)buf[5];
             devices[x].SizeOfCode = aux;
+            devices[x].SectorCRC  = buf[16] & 0x01;
         }
         if (debug) {
             qDebug() << "Found " << numberOfDevices << " devices";
@@ -670,6 +676,7 @@ bool DFUObject::findDevices()
                 qDebug() << "Device SizeOfDesc=" << devices[x].SizeOfDesc;
                 qDebug() << "BL Version=" << devices[x].BL_Version;
                 qDebug() << "FW CRC=" << devices[x].FW_CRC;
+                qDebug() << "Sector CRC=" << devices[x].SectorCRC;
             }
         }
     }
@@ -761,6 +768,14 @@ OP_DFU::Status DFUObject::UploadFirmwareT(const QString &sfile, const bool &veri
         qDebug() << "NEW FIRMWARE CRC=" << crc;
     }
 
+    if (devices[device].SectorCRC) {
+        std::vector<sector> sectors;
+        if (RequestSectorCRCs(sectors)) {
+            return UploadFirmwareDiff(arr, crc, sectors, verify, device);
+        }
+        cout << "Sector CRCs not available, uploading the whole firmware\n";
+    }
+
     if (!StartUpload(arr.length(), OP_DFU::FW, crc)) {
         ret = StatusRequest();
         if (debug) {
@@ -834,6 +849,142 @@ OP_DFU::Status DFUObject::UploadFirmwareT(const QString &sfile, const bool &veri
 }
 
 
+/**
+   Gets the offset, size and CRC of every erase sector of the firmware
+   \return false if the bootloader can't tell, then upload everything
+ */
+bool DFUObject::RequestSectorCRCs(std::vector<sector> & sectors)
+{
+    char buf[BUF_LEN];
+    int total = 1;
+
+    sectors.clear();
+    while ((int)sectors.size() < total) {
+        memset(buf, 0, BUF_LEN);
+        buf[0] = 0x02; // reportID
+        buf[1] = OP_DFU::Req_SectorCRC; // DFU Command
+        buf[2] = sectors.size() >> 24; // first sector
+        buf[3] = sectors.size() >> 16;
+        buf[4] = sectors.size() >> 8;
+        buf[5] = sectors.size();
+        buf[6] = OP_DFU::FW;
+
+        if (sendData(buf, BUF_LEN) < 1 || receiveData(buf, BUF_LEN) < 1) {
+            return false;
+        }
+        if (buf[1] != OP_DFU::Rep_SectorCRC) {
+            return false;
+        }
+        total = SectorDiff::parseReply(buf, sectors);
+        if (total == 0) {
+            return false;
+        }
+    }
+    if (debug) {
+        qDebug() << "Got CRCs of" << sectors.size() << "sectors";
+    }
+    return true;
+}
+
+/**
+   Tells the bootloader which sectors to erase and program on the next upload
+ */
+bool DFUObject::SelectSectors(const std::vector<bool> & dirty)
+{
+    char buf[BUF_LEN];
+
+    for (int first = 0; first < (int)dirty.size();) {
+        memset(buf, 0, BUF_LEN);
+        buf[0] = 0x02; // reportID
+        buf[1] = OP_DFU::Select_Sectors; // DFU Command
+        buf[2] = first >> 24; // first sector
+        buf[3] = first >> 16;
+        buf[4] = first >> 8;
+        buf[5] = first;
+        first += SectorDiff::selectRequest(buf, dirty, first);
+        if (sendData(buf, BUF_LEN) < 1) {
+            return false;
+        }
+    }
+    return StatusRequest() == OP_DFU::DFUidle;
+}
+
+/**
+   Uploads only the sectors whose CRC differs from the new firmware
+   and verifies the result with the sector CRCs instead of reading it back
+ */
+OP_DFU::Status DFUObject::UploadFirmwareDiff(QByteArray & arr, quint32 crc, const std::vector<sector> & sectors, const bool &verify, int device)
+{
+    OP_DFU::Status ret;
+    SectorDiff diff(arr.constData(), arr.length(), devices[device].SizeOfCode, sectors);
+
+    cout << "Differential upload: " << std::count(diff.dirty.begin(), diff.dirty.end(), true) << " of " << sectors.size() << " sectors changed, "
+         << std::count(diff.packets.begin(), diff.packets.end(), true) << " of " << diff.packets.size() << " packets to send\n";
+
+    if (!SelectSectors(diff.dirty)) {
+        ret = StatusRequest();
+        if (debug) {
+            qDebug() << "SelectSectors returned:" << StatusToString(ret);
+        }
+        return ret;
+    }
+
+    // erase time scales with the share of the firmware area being erased
+    int eraseWait = diff.total ? qMax(100, (int)(1000ULL * diff.erased / diff.total)) : 1000;
+    if (!StartUpload(arr.length(), OP_DFU::FW, crc, eraseWait)) {
+        ret = StatusRequest();
+        if (debug) {
+            qDebug() << "StartUpload returned:" << StatusToString(ret);
+        }
+        return ret;
+    }
+
+    emit operationProgress(QString("Erasing changed sectors, please wait..."));
+    ret = StatusRequest();
+    if (ret != OP_DFU::uploading) {
+        if (debug) {
+            qDebug() << "Erase returned: " << StatusToString(ret);
+        }
+        return ret;
+    }
+
+    emit operationProgress(QString("Uploading changed sectors"));
+    if (!UploadData(arr.length(), arr, diff.packets)) {
+        ret = StatusRequest();
+        if (debug) {
+            qDebug() << "UploadData returned:" << StatusToString(ret);
+        }
+        return ret;
+    }
+    if (!EndOperation()) {
+        ret = StatusRequest();
+        if (debug) {
+            qDebug() << "EndOperation returned:" << StatusToString(ret);
+        }
+        return ret;
+    }
+    ret = StatusRequest();
+    if (ret != OP_DFU::Last_operation_Success) {
+        return ret;
+    }
+
+    if (verify) {
+        emit operationProgress(QString("Verifying firmware"));
+        cout << "Starting code verification\n";
+        std::vector<sector> check;
+        if (!RequestSectorCRCs(check) || !diff.verify(check)) {
+            cout << "Verify:FAILED\n";
+            return OP_DFU::abort;
+        }
+    }
+
+    if (debug) {
+        qDebug() << "Status=" << ret;
+    }
+    cout << "Firmware Uploading succeeded\n";
+    return ret;
+}
+
 OP_DFU::Status DFUObject::CompareFirmware(const QString &sfile, const CompareType &type, int device)
 {
     cout << "Starting Firmware Compare...\n";
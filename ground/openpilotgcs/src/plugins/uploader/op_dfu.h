@@ -16,6 +16,7 @@
 #include <QVariant>
 #include <iostream>
 #include "delay.h"
+#include "dfusectors.h"
 #include <QtSerialPort/QSerialPort>
 #include <QtSerialPort/QSerialPortInfo>
 #include <QTime>
@@ -85,6 +86,9 @@ enum Commands {
     Download, // 10
     Status_Request, // 11
     Status_Rep, // 12
+    Req_SectorCRC, // 13
+    Rep_SectorCRC, // 14
+    Select_Sectors, // 15
 };
 
 enum eBoardType {
@@ -103,6 +107,7 @@ struct device {
     quint32 SizeOfCode;
     bool    Readable;
     bool    Writable;
+    bool    SectorCRC; // bootloader can report sector CRCs for differential uploads
 };
 
 
@@ -189,8 +194,13 @@ private:
 
     void CopyWords(char *source, char *destination, int count);
     void printProgBar(int const & percent, QString const & label);
-    bool StartUpload(qint32 const &numberOfBytes, TransferTypes const & type, quint32 crc);
-    bool UploadData(qint32 const & numberOfPackets, QByteArray & data);
+    bool StartUpload(qint32 const &numberOfBytes, TransferTypes const & type, quint32 crc, int eraseWait = 1000);
+    bool UploadData(qint32 const & numberOfPackets, QByteArray & data, const std::vector<bool> & packets = std::vector<bool>());
+
+    // Differential upload:
+    bool RequestSectorCRCs(std::vector<sector> & sectors);
+    bool SelectSectors(const std::vector<bool> & dirty);
+    OP_DFU::Status UploadFirmwareDiff(QByteArray & arr, quint32 crc, const std::vector<sector> & sectors, const bool &verify, int device);
 
     // Thread management:
     // Same as startDownload except that we store in an external array:
@@ -22,6 +22,7 @@ HEADERS += uploadergadget.h \
     uploadergadgetwidget.h \
     uploaderplugin.h \
     op_dfu.h \
+    dfusectors.h \
     delay.h \
     devicewidget.h \
     SSP/port.h \
@@ -41,6 +42,7 @@ SOURCES += uploadergadget.cpp \
     uploadergadgetwidget.cpp \
     uploaderplugin.cpp \
     op_dfu.cpp \
+    dfusectors.cpp \
     delay.cpp \
     devicewidget.cpp \
     SSP/port.cpp \
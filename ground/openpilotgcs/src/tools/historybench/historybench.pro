@@ -0,0 +1,27 @@
+include(../../../openpilotgcs.pri)
+
+TEMPLATE = app
+TARGET = historybench
+DESTDIR = $$GCS_APP_PATH
+
+CONFIG += console
+CONFIG -= app_bundle
+
+# the UAVObjects plugin library provides the objects and the history
+LIBS += -L$$GCS_PLUGIN_PATH/OpenPilot
+include(../../plugins/uavobjects/uavobjects.pri)
+
+SOURCES += \
+    main.cpp
+
+win32 {
+    target.path = /bin
+    INSTALLS += target
+} else:!macx {
+    target.path  = /bin
+    INSTALLS    += target
+    QMAKE_RPATHDIR  = $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_LIBRARY_PATH, $$GCS_APP_PATH))
+    QMAKE_RPATHDIR += $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_PLUGIN_PATH/OpenPilot, $$GCS_APP_PATH))
+    QMAKE_RPATHDIR += $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_QT_LIBRARY_PATH, $$GCS_APP_PATH))
+    include(../../rpath.pri)
+}
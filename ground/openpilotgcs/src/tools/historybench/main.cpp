@@ -0,0 +1,240 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Measures the ingestion rate and memory of the object history
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include "uavobjecthistory.h"
+
+#define RETURN_ERR_USAGE 1
+#define RETURN_OK        0
+
+using namespace std;
+
+// objects a flying board streams at a high rate
+static const char *const STREAMED[] = {
+    "GyroState", "AccelState", "MagState", "AttitudeState", "BaroSensor",
+    "PositionState", "VelocityState", "ActuatorCommand", "ManualControlCommand"
+};
+
+/**
+ * print usage info
+ */
+void usage()
+{
+    cout << "Usage: historybench [-samples millions] [-rate hz] [-limit MB] [-spill]" << endl;
+    cout << "\t-samples millions  field samples to record, default 10" << endl;
+    cout << "\t-rate hz           update rate of every object, default 500" << endl;
+    cout << "\t-limit MB          memory limit of the history, default its own" << endl;
+    cout << "\t-spill             spill to a temporary directory instead of dropping" << endl;
+    cout << "\t-h                 this help" << endl;
+}
+
+/**
+ * inform user of invalid usage
+ */
+int usage_err()
+{
+    cout << "Invalid usage!" << endl;
+    usage();
+    return RETURN_ERR_USAGE;
+}
+
+/**
+ * take "option value" out of the arguments
+ * @returns false if the option is there without a value
+ */
+bool takeOption(QStringList & arguments, const QString & option, QString & value)
+{
+    int index = arguments.indexOf(option);
+
+    if (index < 0) {
+        return true;
+    }
+    if (index + 1 >= arguments.size()) {
+        return false;
+    }
+    value = arguments.at(index + 1);
+    arguments.removeAt(index + 1);
+    arguments.removeAt(index);
+    return true;
+}
+
+/**
+ * Sensor like data: floats walk slowly with some noise, integers count
+ */
+void synthesize(UAVObject *obj, QByteArray & buffer, quint32 step)
+{
+    quint8 *data = (quint8 *)buffer.data();
+
+    foreach(UAVObjectField * field, obj->getFields()) {
+        quint8 *element = data + field->getDataOffset();
+        for (quint32 i = 0; i < field->getNumElements(); i++) {
+            switch (field->getType()) {
+            case UAVObjectField::FLOAT32:
+            {
+                float value = 10.0f * sinf(step * 0.001f + i) + (rand() % 1000) * 0.0001f;
+                quint32 bits;
+                memcpy(&bits, &value, sizeof(bits));
+                qToLittleEndian<quint32>(bits, element);
+                element += 4;
+                break;
+            }
+            case UAVObjectField::INT16:
+            case UAVObjectField::UINT16:
+                qToLittleEndian<quint16>(1000 + (step / 50 + i) % 1000, element);
+                element += 2;
+                break;
+            case UAVObjectField::INT32:
+            case UAVObjectField::UINT32:
+                qToLittleEndian<quint32>(step, element);
+                element += 4;
+                break;
+            default:
+                element += field->getNumBytes() / field->getNumElements();
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * entrance
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QStringList arguments_stringlist;
+
+    // process arguments
+    for (int argi = 1; argi < argc; argi++) {
+        arguments_stringlist << argv[argi];
+    }
+
+    if (arguments_stringlist.removeAll("-h") > 0) {
+        usage();
+        return RETURN_OK;
+    }
+
+    bool spill = arguments_stringlist.removeAll("-spill") > 0;
+    QString millions("10"), rate("500"), limit;
+    if (!takeOption(arguments_stringlist, "-samples", millions) ||
+        !takeOption(arguments_stringlist, "-rate", rate) ||
+        !takeOption(arguments_stringlist, "-limit", limit) ||
+        !arguments_stringlist.isEmpty() || millions.toDouble() <= 0 || rate.toInt() <= 0) {
+        return usage_err();
+    }
+
+    UAVObjectManager *objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+
+    UAVObjectHistory history(objMngr);
+    if (!limit.isEmpty()) {
+        history.setMemoryLimit(limit.toLongLong() * 1024 * 1024);
+    }
+    QTemporaryDir spillDir;
+    if (spill && !history.setSpillDirectory(spillDir.path())) {
+        return usage_err();
+    }
+
+    QList<UAVObject *> objects;
+    QList<QByteArray> buffers;
+    quint32 samplesPerStep = 0;
+    for (unsigned int i = 0; i < sizeof(STREAMED) / sizeof(STREAMED[0]); i++) {
+        UAVObject *obj = objMngr->getObject(STREAMED[i]);
+        if (!obj || !history.subscribe(STREAMED[i])) {
+            continue;
+        }
+        QByteArray buffer(obj->getNumBytes(), 0);
+        obj->pack((quint8 *)buffer.data());
+        // the history is fed below with the simulated time, not on the signal
+        obj->blockSignals(true);
+        objects << obj;
+        buffers << buffer;
+        foreach(UAVObjectField * field, obj->getFields()) {
+            if (field->getType() != UAVObjectField::STRING) {
+                samplesPerStep += field->getNumElements();
+            }
+        }
+    }
+    if (objects.isEmpty()) {
+        cout << "None of the streamed objects is defined" << endl;
+        return RETURN_ERR_USAGE;
+    }
+
+    quint64 target = (quint64)(millions.toDouble() * 1000000);
+    quint64 steps  = target / samplesPerStep + 1;
+    qint64 start   = 1420070400000LL;
+    double period  = 1000.0 / rate.toInt();
+
+    QElapsedTimer timer;
+    qint64 unpackNs = 0, recordNs = 0;
+    for (quint64 step = 0; step < steps; step++) {
+        qint64 time = start + (qint64)(step * period);
+        for (int i = 0; i < objects.size(); i++) {
+            timer.start();
+            synthesize(objects.at(i), buffers[i], step);
+            objects.at(i)->unpack((const quint8 *)buffers.at(i).constData());
+            unpackNs += timer.nsecsElapsed();
+
+            timer.start();
+            history.record(objects.at(i), time);
+            recordNs += timer.nsecsElapsed();
+        }
+    }
+
+    quint64 samples = steps * samplesPerStep;
+    double stored   = history.memoryUsed() + history.spilledBytes();
+    cout << objects.size() << " objects, " << samplesPerStep << " field elements, " << steps << " updates each at " << rate.toInt() << " Hz" << endl;
+    cout << "  ingested:  " << samples << " samples, " << (quint64)(samples / (recordNs / 1e9)) << " samples/s"
+         << " (+" << unpackNs / 1000000 << " ms synthesizing)" << endl;
+    cout << "  held:      " << history.samples() << " samples" << endl;
+    cout << "  memory:    " << history.memoryUsed() / 1024 << " KB, spilled " << history.spilledBytes() / 1024 << " KB" << endl;
+    cout << "  per 1M:    " << stored / history.samples() * 1000000 / 1024 << " KB per million samples held" << endl;
+
+    // gadget like queries on the first object
+    UAVObjectField *field = objects.first()->getFields().first();
+    QVector<qint64> times;
+    QVector<double> values, min, max, mean;
+    timer.start();
+    history.range(objects.first()->getName(), field->getName(), 0, start, start + (qint64)(steps * period), times, values);
+    qint64 rangeNs = timer.nsecsElapsed();
+    times.clear();
+    timer.start();
+    history.downsample(objects.first()->getName(), field->getName(), 0, start, start + (qint64)(steps * period), 1000, times, min, max, mean);
+    qint64 downsampleNs = timer.nsecsElapsed();
+    cout << "  range:     " << values.size() << " samples of " << qPrintable(objects.first()->getName()) << "." << qPrintable(field->getName())
+         << " in " << rangeNs / 1000 << " us, downsampled to " << times.size() << " in " << downsampleNs / 1000 << " us" << endl;
+
+    return RETURN_OK;
+}
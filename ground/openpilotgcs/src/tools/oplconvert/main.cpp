@@ -0,0 +1,301 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Converts .opl telemetry logs to CSV and column files without the GCS
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFuture>
+#include <QQueue>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <iostream>
+#include <locale.h>
+
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include "oplschema.h"
+#include "opldecoder.h"
+#include "oplcolumnfile.h"
+
+#define RETURN_ERR_USAGE 1
+#define RETURN_ERR_FILE  2
+#define RETURN_OK        0
+
+using namespace std;
+
+/**
+ * print usage info
+ */
+void usage()
+{
+    cout << "Usage: oplconvert [-csv] [-col] [-j threads] [-chunk MB] [-o output_dir] logfile [UAVObj1] ... [UAVObjN]" << endl;
+    cout << "Formats: " << endl;
+    cout << "\t-csv           one <UAVObject>.csv per object" << endl;
+    cout << "\t-col           one <UAVObject>.col column file per object" << endl;
+    cout << "\tIf no format is specified both are written." << endl;
+    cout << "Misc: " << endl;
+    cout << "\t-h             this help" << endl;
+    cout << "\t-j threads     decoder threads, default one per core" << endl;
+    cout << "\t-chunk MB      bytes of log decoded per task, default picked from the log size" << endl;
+    cout << "\t-o output_dir  where to write, default the log name without extension" << endl;
+    cout << "\tlogfile        .opl telemetry log recorded by the GCS." << endl;
+    cout << "\tUAVObjXY       name of a specific UAVObject to be converted." << endl;
+    cout << "\tIf no UAVObject is specified -> all are converted." << endl;
+}
+
+/**
+ * inform user of invalid usage
+ */
+int usage_err()
+{
+    cout << "Invalid usage!" << endl;
+    usage();
+    return RETURN_ERR_USAGE;
+}
+
+/**
+ * take "option value" out of the arguments
+ * @returns false if the option is there without a value
+ */
+bool takeOption(QStringList & arguments, const QString & option, QString & value)
+{
+    int index = arguments.indexOf(option);
+
+    if (index < 0) {
+        return true;
+    }
+    if (index + 1 >= arguments.size()) {
+        return false;
+    }
+    value = arguments.at(index + 1);
+    arguments.removeAt(index + 1);
+    arguments.removeAt(index);
+    return true;
+}
+
+/**
+ * Output files of one object, opened when its first row shows up
+ * so objects missing from the log leave no empty files behind.
+ */
+struct ObjectOutput {
+    ObjectOutput() : csv(NULL), col(NULL), rows(0) {}
+    QFile *csv;
+    OplColumnFile *col;
+    quint64 rows;
+};
+
+/**
+ * entrance
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // Qt sets the locale from the environment, the CSV needs a dot as decimal point
+    setlocale(LC_NUMERIC, "C");
+
+    QStringList arguments_stringlist;
+
+    // process arguments
+    for (int argi = 1; argi < argc; argi++) {
+        arguments_stringlist << argv[argi];
+    }
+
+    if (arguments_stringlist.removeAll("-h") > 0) {
+        usage();
+        return RETURN_OK;
+    }
+
+    int formats = 0;
+    if (arguments_stringlist.removeAll("-csv") > 0) {
+        formats |= OPL_FORMAT_CSV;
+    }
+    if (arguments_stringlist.removeAll("-col") > 0) {
+        formats |= OPL_FORMAT_COLUMNS;
+    }
+    if (!formats) {
+        formats = OPL_FORMAT_CSV | OPL_FORMAT_COLUMNS;
+    }
+
+    QString threads_string;
+    QString chunk_string;
+    QString outputpath;
+    if (!takeOption(arguments_stringlist, "-j", threads_string) ||
+        !takeOption(arguments_stringlist, "-chunk", chunk_string) ||
+        !takeOption(arguments_stringlist, "-o", outputpath)) {
+        return usage_err();
+    }
+
+    int threads = QThread::idealThreadCount();
+    if (!threads_string.isEmpty()) {
+        bool ok;
+        threads = threads_string.toInt(&ok);
+        if (!ok || threads < 1) {
+            return usage_err();
+        }
+    }
+    threads = qMax(threads, 1);
+
+    qint64 chunkSize = 0;
+    if (!chunk_string.isEmpty()) {
+        bool ok;
+        chunkSize = chunk_string.toInt(&ok) * 1024LL * 1024LL;
+        if (!ok || chunkSize < 1) {
+            return usage_err();
+        }
+    }
+
+    if (arguments_stringlist.isEmpty()) {
+        return usage_err();
+    }
+
+    QString logpath = arguments_stringlist.takeFirst();
+    QStringList objects_stringlist = arguments_stringlist;
+
+    if (outputpath.isEmpty()) {
+        QFileInfo info(logpath);
+        outputpath = info.path() + "/" + info.completeBaseName();
+    }
+    QDir outputdir;
+    if (!outputdir.mkpath(outputpath)) {
+        cerr << "Could not create " << qPrintable(outputpath) << endl;
+        return RETURN_ERR_FILE;
+    }
+    outputdir.setPath(outputpath);
+
+    // the decoders only need the packed layout of each object, which the manager knows
+    UAVObjectManager objMngr;
+    UAVObjectsInitialize(&objMngr);
+
+    OplSchema schema;
+    schema.build(&objMngr, objects_stringlist);
+    if (schema.objects().isEmpty()) {
+        cerr << "No matching UAVObjects" << endl;
+        return RETURN_ERR_USAGE;
+    }
+
+    OplLogFile log;
+    if (!log.open(logpath)) {
+        cerr << "Could not open " << qPrintable(logpath) << endl;
+        return RETURN_ERR_FILE;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (chunkSize == 0) {
+        // a few chunks per thread to balance the load, but bounded to keep the results small
+        chunkSize = qBound(64LL * 1024LL, log.size() / (threads * 4), 8LL * 1024LL * 1024LL);
+    }
+    const QList<OplChunk> chunks = log.split(chunkSize);
+    if (log.validSize() < log.size()) {
+        cerr << "Warning: " << (log.size() - log.validSize()) << " bytes at the end of the log are truncated or corrupt" << endl;
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    QVector<ObjectOutput> outputs(schema.objects().size());
+    OplChunkResult totals;
+    bool write_ok = true;
+
+    // keep a bounded number of chunks in flight and write the results in log order
+    QQueue<QFuture<OplChunkResult> > pending;
+    int next = 0;
+    while (next < chunks.size() || !pending.isEmpty()) {
+        while (next < chunks.size() && pending.size() < threads * 2) {
+            pending.enqueue(QtConcurrent::run(decodeChunk, &log, &schema, chunks.at(next++), formats));
+        }
+
+        const OplChunkResult result = pending.dequeue().result();
+        totals.packets        += result.packets;
+        totals.crcErrors      += result.crcErrors;
+        totals.unknownPackets += result.unknownPackets;
+        totals.skippedBytes   += result.skippedBytes;
+
+        for (int i = 0; i < result.objects.size(); ++i) {
+            const OplObjectRows &rows = result.objects.at(i);
+            const OplObject &object   = schema.objects().at(i);
+            ObjectOutput &output = outputs[i];
+            if (rows.rows == 0) {
+                continue;
+            }
+            output.rows += rows.rows;
+
+            if (formats & OPL_FORMAT_CSV) {
+                if (!output.csv) {
+                    output.csv = new QFile(outputdir.filePath(object.name + ".csv"));
+                    write_ok  &= output.csv->open(QIODevice::WriteOnly | QIODevice::Truncate);
+                    QByteArray header("Timestamp,Instance");
+                    foreach(const OplColumn &column, object.columns) {
+                        header += "," + column.name.toUtf8();
+                    }
+                    header    += "\n";
+                    write_ok  &= output.csv->write(header) == header.size();
+                }
+                write_ok &= output.csv->write(rows.csv) == rows.csv.size();
+            }
+            if (formats & OPL_FORMAT_COLUMNS) {
+                if (!output.col) {
+                    output.col = new OplColumnFile();
+                    write_ok  &= output.col->open(outputdir.filePath(object.name + ".col"), object);
+                }
+                write_ok &= output.col->writeGroup(rows);
+            }
+        }
+    }
+
+    int converted = 0;
+    for (int i = 0; i < outputs.size(); ++i) {
+        if (outputs[i].csv) {
+            outputs[i].csv->close();
+            delete outputs[i].csv;
+        }
+        if (outputs[i].col) {
+            write_ok &= outputs[i].col->close();
+            delete outputs[i].col;
+        }
+        if (outputs[i].rows) {
+            converted++;
+        }
+    }
+
+    const double seconds = qMax(timer.elapsed(), (qint64)1) / 1000.0;
+    const double megabytes = log.validSize() / (1024.0 * 1024.0);
+    log.close();
+
+    cout << "Converted " << converted << " objects to " << qPrintable(outputpath) << endl;
+    cout << megabytes << " MB in " << seconds << " s, " << megabytes / seconds << " MB/s on "
+         << threads << " threads, " << chunks.size() << " chunks" << endl;
+    cout << totals.packets << " packets, " << totals.crcErrors << " CRC errors, "
+         << totals.unknownPackets << " unknown, " << totals.skippedBytes << " bytes skipped" << endl;
+
+    if (!write_ok) {
+        cerr << "Error writing the output files" << endl;
+        return RETURN_ERR_FILE;
+    }
+    return RETURN_OK;
+}
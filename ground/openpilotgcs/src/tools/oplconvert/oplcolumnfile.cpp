@@ -0,0 +1,105 @@
+/**
+ ******************************************************************************
+ *
+ * @file       oplcolumnfile.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Writer for the columnar .col output of oplconvert
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "oplcolumnfile.h"
+#include "opldecoder.h"
+#include "oplschema.h"
+
+#include <QDataStream>
+
+namespace {
+const quint16 COLUMN_FILE_VERSION = 1;
+const qint64 ROW_COUNT_OFFSET     = 8; // after the magic, version and column count
+
+void writeString(QDataStream & out, const QString & text)
+{
+    const QByteArray utf8 = text.toUtf8();
+
+    out << (quint16)utf8.size();
+    out.writeRawData(utf8.constData(), utf8.size());
+}
+
+void writeColumn(QDataStream & out, const QString & name, UAVObjectField::FieldType type,
+                 quint32 width, const QStringList & options)
+{
+    writeString(out, name);
+    out << (quint8)type << (quint16)width << (quint16)options.size();
+    foreach(const QString &option, options) {
+        writeString(out, option);
+    }
+}
+}
+
+bool OplColumnFile::open(const QString & fileName, const OplObject & object)
+{
+    m_rows = 0;
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QDataStream out(&m_file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData("OPLC", 4);
+    out << COLUMN_FILE_VERSION << (quint16)(object.columns.size() + 2) << m_rows << object.objId;
+    writeString(out, object.name);
+
+    writeColumn(out, "Timestamp", UAVObjectField::UINT32, 4, QStringList());
+    writeColumn(out, "Instance", UAVObjectField::UINT16, 2, QStringList());
+    foreach(const OplColumn &column, object.columns) {
+        writeColumn(out, column.name, column.type, column.width, column.options);
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+bool OplColumnFile::writeGroup(const OplObjectRows & rows)
+{
+    if (rows.rows == 0) {
+        return true;
+    }
+
+    QDataStream out(&m_file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << rows.rows;
+    foreach(const QByteArray &column, rows.columns) {
+        out.writeRawData(column.constData(), column.size());
+    }
+    m_rows += rows.rows;
+    return out.status() == QDataStream::Ok;
+}
+
+bool OplColumnFile::close()
+{
+    bool ok = m_file.seek(ROW_COUNT_OFFSET);
+
+    if (ok) {
+        QDataStream out(&m_file);
+        out.setByteOrder(QDataStream::LittleEndian);
+        out << m_rows;
+        ok = out.status() == QDataStream::Ok;
+    }
+    m_file.close();
+    return ok;
+}
@@ -0,0 +1,62 @@
+/**
+ ******************************************************************************
+ *
+ * @file       oplcolumnfile.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Writer for the columnar .col output of oplconvert
+ *
+ *             All values are little endian, strings are a quint16 length
+ *             followed by UTF-8.
+ *
+ *             header:  "OPLC", quint16 version, quint16 column count,
+ *                      quint64 row count, quint32 object id, object name
+ *             columns: name, quint8 UAVObjectField::FieldType, quint16 width,
+ *                      quint16 option count, option names
+ *             groups:  quint32 rows, then for each column rows * width bytes
+ *
+ *             The first two columns are Timestamp (UINT32, ms) and Instance
+ *             (UINT16). BITFIELD columns hold one byte per bit. Each decoded
+ *             chunk becomes one group, so the file is written front to back
+ *             and only the row count is patched on close.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef OPLCOLUMNFILE_H
+#define OPLCOLUMNFILE_H
+
+#include <QFile>
+#include <QString>
+
+struct OplObject;
+struct OplObjectRows;
+
+class OplColumnFile {
+public:
+    OplColumnFile() : m_rows(0) {}
+
+    bool open(const QString & fileName, const OplObject & object);
+    bool writeGroup(const OplObjectRows & rows);
+    bool close();
+
+private:
+    QFile m_file;
+    quint64 m_rows;
+};
+
+#endif // OPLCOLUMNFILE_H
@@ -0,0 +1,36 @@
+include(../../../openpilotgcs.pri)
+
+TEMPLATE = app
+TARGET = oplconvert
+DESTDIR = $$GCS_APP_PATH
+
+QT += concurrent
+CONFIG += console
+CONFIG -= app_bundle
+
+# the UAVObjects plugin library provides the object definitions
+LIBS += -L$$GCS_PLUGIN_PATH/OpenPilot
+include(../../plugins/uavobjects/uavobjects.pri)
+
+HEADERS += \
+    oplschema.h \
+    opldecoder.h \
+    oplcolumnfile.h
+
+SOURCES += \
+    main.cpp \
+    oplschema.cpp \
+    opldecoder.cpp \
+    oplcolumnfile.cpp
+
+win32 {
+    target.path = /bin
+    INSTALLS += target
+} else:!macx {
+    target.path  = /bin
+    INSTALLS    += target
+    QMAKE_RPATHDIR  = $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_LIBRARY_PATH, $$GCS_APP_PATH))
+    QMAKE_RPATHDIR += $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_PLUGIN_PATH/OpenPilot, $$GCS_APP_PATH))
+    QMAKE_RPATHDIR += $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_QT_LIBRARY_PATH, $$GCS_APP_PATH))
+    include(../../rpath.pri)
+}
@@ -0,0 +1,334 @@
+/**
+ ******************************************************************************
+ *
+ * @file       opldecoder.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Splits a memory mapped .opl log into chunks and decodes them to columns
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "opldecoder.h"
+#include "oplschema.h"
+
+#include <QtEndian>
+#include <string.h>
+#include <utils/crc.h>
+
+using namespace Utils;
+
+namespace {
+// log records, see LogFile
+const int RECORD_HEADER_LENGTH = 12;
+const qint64 MAX_RECORD_LENGTH = 1024 * 1024;
+
+// UAVTalk framing, see UAVTalk
+const quint8 SYNC_VAL           = 0x3C;
+const int TYPE_MASK = 0xF8;
+const int TYPE_VER  = 0x20;
+const int TYPE_OBJ  = (TYPE_VER | 0x00);
+const int TYPE_OBJ_ACK          = (TYPE_VER | 0x02);
+const int HEADER_LENGTH         = 10;
+const int MAX_PAYLOAD_LENGTH    = 256;
+const int CHECKSUM_LENGTH       = 1;
+const int MIN_PACKET_LENGTH     = HEADER_LENGTH + CHECKSUM_LENGTH;
+
+void appendUInt(QByteArray & out, quint32 value)
+{
+    char digits[10];
+    int n = 0;
+
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (n) {
+        out.append(digits[--n]);
+    }
+}
+
+void appendInt(QByteArray & out, qint32 value)
+{
+    if (value < 0) {
+        out.append('-');
+        appendUInt(out, 0u - (quint32)value);
+    } else {
+        appendUInt(out, value);
+    }
+}
+
+// main() sets LC_NUMERIC to "C", so the decimal point is always a dot
+void appendFloat(QByteArray & out, const uchar *data)
+{
+    quint32 raw = qFromLittleEndian<quint32>(data);
+    float value;
+    char text[32];
+
+    memcpy(&value, &raw, sizeof(value));
+    out.append(text, qsnprintf(text, sizeof(text), "%.9g", value));
+}
+
+void appendString(QByteArray & out, const uchar *data, quint32 width)
+{
+    out.append('"');
+    for (quint32 n = 0; n < width && data[n]; ++n) {
+        if (data[n] == '"') {
+            out.append('"');
+        }
+        out.append((char)data[n]);
+    }
+    out.append('"');
+}
+
+class ChunkDecoder {
+public:
+    ChunkDecoder(const OplSchema *schema, int formats, OplChunkResult *result)
+        : m_schema(schema), m_formats(formats), m_result(result)
+    {
+        m_result->objects.resize(schema->objects().size());
+    }
+
+    void decode(const uchar *base, const OplChunk & chunk);
+
+private:
+    int parse(const uchar *data, int length, quint32 timestamp);
+    void addRow(int index, quint32 timestamp, quint16 instId, const uchar *data);
+
+    const OplSchema *m_schema;
+    int m_formats;
+    OplChunkResult *m_result;
+    QByteArray m_carry; // start of a packet continued in the next record
+    quint32 m_carryTime;
+};
+
+void ChunkDecoder::decode(const uchar *base, const OplChunk & chunk)
+{
+    qint64 pos = chunk.begin;
+
+    while (pos < chunk.end) {
+        const quint32 timestamp = qFromLittleEndian<quint32>(base + pos);
+        const int length = (int)qFromLittleEndian<qint64>(base + pos + 4);
+        const uchar *payload    = base + pos + RECORD_HEADER_LENGTH;
+        pos += RECORD_HEADER_LENGTH + length;
+
+        // UAVTalk writes whole packets, so records normally hold complete packets and are parsed in place
+        if (m_carry.isEmpty()) {
+            int used = parse(payload, length, timestamp);
+            if (used < length) {
+                m_carry     = QByteArray((const char *)payload + used, length - used);
+                m_carryTime = timestamp;
+            }
+        } else {
+            m_carry.append((const char *)payload, length);
+            m_carry.remove(0, parse((const uchar *)m_carry.constData(), m_carry.size(), m_carryTime));
+            m_carryTime = timestamp;
+        }
+    }
+
+    // a packet cut by the chunk boundary is lost
+    m_result->skippedBytes += m_carry.size();
+}
+
+/**
+ * Decode the complete packets in data.
+ * @returns the number of bytes used, the rest may be the start of a packet
+ */
+int ChunkDecoder::parse(const uchar *data, int length, quint32 timestamp)
+{
+    int pos = 0;
+
+    while (length - pos >= MIN_PACKET_LENGTH) {
+        const uchar *packet = data + pos;
+        const int type = packet[1];
+
+        if (packet[0] != SYNC_VAL || (type & TYPE_MASK) != TYPE_VER) {
+            m_result->skippedBytes++;
+            pos++;
+            continue;
+        }
+
+        const int packetSize = qFromLittleEndian<quint16>(packet + 2);
+        if (packetSize < HEADER_LENGTH || packetSize > HEADER_LENGTH + MAX_PAYLOAD_LENGTH) {
+            m_result->skippedBytes++;
+            pos++;
+            continue;
+        }
+        if (length - pos < packetSize + CHECKSUM_LENGTH) {
+            break;
+        }
+        if (Crc::updateCRC(0, packet, packetSize) != packet[packetSize]) {
+            m_result->crcErrors++;
+            m_result->skippedBytes++;
+            pos++;
+            continue;
+        }
+        pos += packetSize + CHECKSUM_LENGTH;
+        m_result->packets++;
+
+        // requests and acks carry no data
+        if (type != TYPE_OBJ && type != TYPE_OBJ_ACK) {
+            continue;
+        }
+
+        const int index = m_schema->indexOf(qFromLittleEndian<quint32>(packet + 4));
+        if (index < 0 || (quint32)packetSize != HEADER_LENGTH + m_schema->objects().at(index).numBytes) {
+            m_result->unknownPackets++;
+            continue;
+        }
+        addRow(index, timestamp, qFromLittleEndian<quint16>(packet + 8), packet + HEADER_LENGTH);
+    }
+    return pos;
+}
+
+void ChunkDecoder::addRow(int index, quint32 timestamp, quint16 instId, const uchar *data)
+{
+    const OplObject &object = m_schema->objects().at(index);
+    OplObjectRows &rows     = m_result->objects[index];
+
+    rows.rows++;
+
+    if (m_formats & OPL_FORMAT_COLUMNS) {
+        if (rows.columns.isEmpty()) {
+            rows.columns.resize(object.columns.size() + 2);
+        }
+        uchar header[6];
+        qToLittleEndian<quint32>(timestamp, header);
+        qToLittleEndian<quint16>(instId, header + 4);
+        rows.columns[0].append((const char *)header, 4);
+        rows.columns[1].append((const char *)header + 4, 2);
+        for (int c = 0; c < object.columns.size(); ++c) {
+            const OplColumn &column = object.columns.at(c);
+            if (column.type == UAVObjectField::BITFIELD) {
+                rows.columns[c + 2].append((char)((data[column.offset] >> column.bit) & 1));
+            } else {
+                // UAVTalk is little endian like the column file, the bytes are copied as they are
+                rows.columns[c + 2].append((const char *)data + column.offset, column.width);
+            }
+        }
+    }
+
+    if (m_formats & OPL_FORMAT_CSV) {
+        QByteArray &csv = rows.csv;
+        appendUInt(csv, timestamp);
+        csv.append(',');
+        appendUInt(csv, instId);
+        foreach(const OplColumn &column, object.columns) {
+            const uchar *value = data + column.offset;
+            csv.append(',');
+            switch (column.type) {
+            case UAVObjectField::INT8:
+                appendInt(csv, (qint8)value[0]);
+                break;
+            case UAVObjectField::INT16:
+                appendInt(csv, qFromLittleEndian<qint16>(value));
+                break;
+            case UAVObjectField::INT32:
+                appendInt(csv, qFromLittleEndian<qint32>(value));
+                break;
+            case UAVObjectField::UINT8:
+                appendUInt(csv, value[0]);
+                break;
+            case UAVObjectField::UINT16:
+                appendUInt(csv, qFromLittleEndian<quint16>(value));
+                break;
+            case UAVObjectField::UINT32:
+                appendUInt(csv, qFromLittleEndian<quint32>(value));
+                break;
+            case UAVObjectField::FLOAT32:
+                appendFloat(csv, value);
+                break;
+            case UAVObjectField::ENUM:
+                if (value[0] < column.optionsUtf8.size()) {
+                    csv.append(column.optionsUtf8.at(value[0]));
+                } else {
+                    appendUInt(csv, value[0]);
+                }
+                break;
+            case UAVObjectField::BITFIELD:
+                csv.append((value[0] >> column.bit) & 1 ? '1' : '0');
+                break;
+            case UAVObjectField::STRING:
+                appendString(csv, value, column.width);
+                break;
+            }
+        }
+        csv.append('\n');
+    }
+}
+} // namespace
+
+bool OplLogFile::open(const QString & fileName)
+{
+    m_data = NULL;
+    m_size = m_validSize = 0;
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size > 0) {
+        m_data = m_file.map(0, m_size);
+    }
+    return m_data != NULL;
+}
+
+void OplLogFile::close()
+{
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = NULL;
+    }
+    m_file.close();
+}
+
+QList<OplChunk> OplLogFile::split(qint64 chunkSize)
+{
+    QList<OplChunk> chunks;
+    OplChunk chunk;
+    qint64 pos = 0;
+
+    chunk.begin = 0;
+    while (m_size - pos >= RECORD_HEADER_LENGTH) {
+        const qint64 length = qFromLittleEndian<qint64>(m_data + pos + 4);
+        // same sanity limits as LogFile replay
+        if (length < 1 || length > MAX_RECORD_LENGTH || length > m_size - pos - RECORD_HEADER_LENGTH) {
+            break;
+        }
+        pos += RECORD_HEADER_LENGTH + length;
+        if (pos - chunk.begin >= chunkSize) {
+            chunk.end = pos;
+            chunks.append(chunk);
+            chunk.begin = pos;
+        }
+    }
+    if (pos > chunk.begin) {
+        chunk.end = pos;
+        chunks.append(chunk);
+    }
+    m_validSize = pos;
+    return chunks;
+}
+
+OplChunkResult decodeChunk(const OplLogFile *log, const OplSchema *schema, const OplChunk & chunk, int formats)
+{
+    OplChunkResult result;
+    ChunkDecoder decoder(schema, formats, &result);
+
+    decoder.decode(log->data(), chunk);
+    return result;
+}
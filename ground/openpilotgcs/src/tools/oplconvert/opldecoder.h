@@ -0,0 +1,110 @@
+/**
+ ******************************************************************************
+ *
+ * @file       opldecoder.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Splits a memory mapped .opl log into chunks and decodes them to columns
+ *
+ *             An .opl file is a sequence of records as written by LogFile:
+ *             quint32 timestamp in ms, qint64 size and size bytes of UAVTalk
+ *             stream. Records carry no sync marker, so the chunk boundaries
+ *             are found by one pass over the record headers; the chunks are
+ *             then decoded independently.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef OPLDECODER_H
+#define OPLDECODER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+class OplSchema;
+
+struct OplChunk {
+    qint64 begin; // offset of the first record header
+    qint64 end; // offset past the last record
+};
+
+/**
+ * Decoded rows of one object in one chunk.
+ */
+struct OplObjectRows {
+    OplObjectRows() : rows(0) {}
+    quint32    rows;
+    QByteArray csv; // lines without the header
+    QVector<QByteArray> columns; // Timestamp, Instance, then the schema columns, little endian
+};
+
+struct OplChunkResult {
+    OplChunkResult() : packets(0), crcErrors(0), unknownPackets(0), skippedBytes(0) {}
+    QVector<OplObjectRows> objects; // indexed like OplSchema::objects()
+    quint64 packets;
+    quint64 crcErrors;
+    quint64 unknownPackets; // valid packets of objects not in the schema or of another size
+    quint64 skippedBytes; // bytes outside valid packets
+};
+
+enum OplFormat {
+    OPL_FORMAT_CSV     = 0x01,
+    OPL_FORMAT_COLUMNS = 0x02
+};
+
+class OplLogFile {
+public:
+    bool open(const QString & fileName);
+    void close();
+
+    /**
+     * Walk the record headers and cut the log into chunks of about chunkSize bytes.
+     * Stops at the first record with an unlikely size, see validSize().
+     */
+    QList<OplChunk> split(qint64 chunkSize);
+
+    const uchar *data() const
+    {
+        return m_data;
+    }
+    qint64 size() const
+    {
+        return m_size;
+    }
+    // bytes up to the end of the last good record
+    qint64 validSize() const
+    {
+        return m_validSize;
+    }
+
+private:
+    QFile m_file;
+    uchar *m_data;
+    qint64 m_size;
+    qint64 m_validSize;
+};
+
+/**
+ * Decode one chunk, safe to run on several chunks in parallel.
+ * @param formats OPL_FORMAT_CSV and/or OPL_FORMAT_COLUMNS
+ */
+OplChunkResult decodeChunk(const OplLogFile *log, const OplSchema *schema, const OplChunk & chunk, int formats);
+
+#endif // OPLDECODER_H
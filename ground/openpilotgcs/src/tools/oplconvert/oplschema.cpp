@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ *
+ * @file       oplschema.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Flat column layout of the UAVObjects, taken from the UAVObjects library
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "oplschema.h"
+
+#include "uavobjectmanager.h"
+#include "uavdataobject.h"
+
+void OplSchema::build(UAVObjectManager *objMngr, const QStringList & names)
+{
+    m_objects.clear();
+    m_index.clear();
+
+    foreach(QList<UAVDataObject *> instances, objMngr->getDataObjects()) {
+        UAVDataObject *obj = instances.first();
+
+        if (!names.isEmpty() && !names.contains(obj->getName(), Qt::CaseInsensitive)) {
+            continue;
+        }
+
+        OplObject object;
+        object.name     = obj->getName();
+        object.objId    = obj->getObjID();
+        object.numBytes = obj->getNumBytes();
+
+        foreach(UAVObjectField * field, obj->getFields()) {
+            OplColumn column;
+
+            column.type    = field->getType();
+            column.options = field->getOptions();
+            column.bit     = 0;
+            foreach(const QString &option, column.options) {
+                column.optionsUtf8.append(option.toUtf8());
+            }
+
+            if (column.type == UAVObjectField::STRING) {
+                column.name   = field->getName();
+                column.offset = field->getDataOffset();
+                column.width  = field->getNumElements();
+                object.columns.append(column);
+                continue;
+            }
+
+            const QStringList elements = field->getElementNames();
+            const quint32 size = field->getNumBytes() / field->getNumElements();
+            for (quint32 n = 0; n < field->getNumElements(); ++n) {
+                column.name = field->getName();
+                if (elements.size() > 1) {
+                    column.name += QString(".") + elements.at(n);
+                }
+                if (column.type == UAVObjectField::BITFIELD) {
+                    // bits are packed eight to a byte, the column holds them as 0 or 1
+                    column.offset = field->getDataOffset() + n / 8;
+                    column.bit    = n % 8;
+                    column.width  = 1;
+                } else {
+                    column.offset = field->getDataOffset() + n * size;
+                    column.width  = size;
+                }
+                object.columns.append(column);
+            }
+        }
+
+        m_index.insert(object.objId, m_objects.size());
+        m_objects.append(object);
+    }
+}
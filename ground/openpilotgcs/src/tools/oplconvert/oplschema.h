@@ -0,0 +1,88 @@
+/**
+ ******************************************************************************
+ *
+ * @file       oplschema.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Flat column layout of the UAVObjects, taken from the UAVObjects library
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef OPLSCHEMA_H
+#define OPLSCHEMA_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+#include "uavobjectfield.h"
+
+class UAVObjectManager;
+
+/**
+ * One output column, a single element of a UAVObject field.
+ * Strings are kept whole in one column.
+ */
+struct OplColumn {
+    QString     name; // Field or Field.Element
+    UAVObjectField::FieldType type;
+    quint32     offset; // byte offset in the packed object data
+    quint8      bit; // bit within that byte for BITFIELD elements
+    quint32     width; // bytes per value in the column file
+    QStringList options; // ENUM option names
+    QVector<QByteArray> optionsUtf8; // the same, ready for the CSV text
+};
+
+struct OplObject {
+    QString name;
+    quint32 objId;
+    quint32 numBytes;
+    QVector<OplColumn> columns;
+};
+
+/**
+ * Read only once built, so the decoder threads can share it without locking.
+ * Unlike the UAVObject instances it holds no Qt objects.
+ */
+class OplSchema {
+public:
+    /**
+     * Collect the data objects known to the manager.
+     * @param names object names to keep, all if empty (case insensitive)
+     */
+    void build(UAVObjectManager *objMngr, const QStringList & names);
+
+    const QVector<OplObject> & objects() const
+    {
+        return m_objects;
+    }
+
+    // index into objects(), -1 for objects not in the schema
+    int indexOf(quint32 objId) const
+    {
+        return m_index.value(objId, -1);
+    }
+
+private:
+    QVector<OplObject> m_objects;
+    QHash<quint32, int> m_index;
+};
+
+#endif // OPLSCHEMA_H
@@ -0,0 +1,265 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      CPU and memory load of the telemetry sessions, per vehicle
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QThread>
+#include <QTimer>
+#include <iostream>
+#include <iomanip>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include "telemetrymanager.h"
+#include "telemetrysessionmanager.h"
+
+#define RETURN_ERR_USAGE 1
+#define RETURN_ERR_LINK  2
+#define RETURN_OK        0
+
+using namespace std;
+
+/**
+ * print usage info
+ */
+void usage()
+{
+    cout << "Usage: sessionload [-vehicles n] [-host host] [-port port] [-port-step step] [-seconds s]" << endl;
+    cout << "Opens one telemetry session per vehicle, one vehicle at a time, and reports" << endl;
+    cout << "the CPU and memory used by the process after each one." << endl;
+    cout << "\t-vehicles n    number of vehicles, default 4" << endl;
+    cout << "\t-host host     address of the vehicles, default 127.0.0.1" << endl;
+    cout << "\t-port port     UDP telemetry port of the first vehicle, default 9000" << endl;
+    cout << "\t-port-step n   port distance between the vehicles, default 10, see simposix --port-offset" << endl;
+    cout << "\t-seconds s     measurement length per step, default 10" << endl;
+    cout << "\t-h             this help" << endl;
+}
+
+/**
+ * inform user of invalid usage
+ */
+int usage_err()
+{
+    cout << "Invalid usage!" << endl;
+    usage();
+    return RETURN_ERR_USAGE;
+}
+
+/**
+ * take "option value" out of the arguments
+ * @returns false if the option is there without a value
+ */
+bool takeOption(QStringList & arguments, const QString & option, QString & value)
+{
+    int index = arguments.indexOf(option);
+
+    if (index < 0) {
+        return true;
+    }
+    if (index + 1 >= arguments.size()) {
+        return false;
+    }
+    value = arguments.at(index + 1);
+    arguments.removeAt(index + 1);
+    arguments.removeAt(index);
+    return true;
+}
+
+/**
+ * user and system time of all threads of the process, in seconds
+ */
+double cpuSeconds()
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/**
+ * resident memory in MB, the peak where the current size is not known
+ */
+double residentMB()
+{
+    QFile statm("/proc/self/statm");
+
+    if (statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> pages = statm.readAll().split(' ');
+        if (pages.size() > 1) {
+            return pages.at(1).toLongLong() * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+/**
+ * Link rates the telemetry monitor of a session reports
+ */
+class SessionProbe : public QObject {
+    Q_OBJECT
+
+public:
+    SessionProbe(TelemetryManager *telMngr) : rxRate(0), connected(false)
+    {
+        connect(telMngr, SIGNAL(connected()), this, SLOT(onConnected()));
+        connect(telMngr, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+        connect(telMngr, SIGNAL(telemetryUpdated(double, double)), this, SLOT(onTelemetryUpdated(double, double)));
+    }
+
+    double rxRate;
+    bool connected;
+
+private slots:
+    void onConnected()
+    {
+        connected = true;
+    }
+    void onDisconnected()
+    {
+        connected = false;
+        rxRate    = 0;
+    }
+    void onTelemetryUpdated(double, double rx)
+    {
+        rxRate = rx;
+    }
+};
+
+/**
+ * runs the event loop for some time
+ */
+void runFor(int ms)
+{
+    QEventLoop loop;
+
+    QTimer::singleShot(ms, &loop, SLOT(quit()));
+    loop.exec();
+}
+
+/**
+ * entrance
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QStringList arguments_stringlist;
+
+    // process arguments
+    for (int argi = 1; argi < argc; argi++) {
+        arguments_stringlist << argv[argi];
+    }
+
+    if (arguments_stringlist.removeAll("-h") > 0) {
+        usage();
+        return RETURN_OK;
+    }
+
+    QString vehicles("4"), host("127.0.0.1"), port("9000"), portStep("10"), seconds("10");
+    if (!takeOption(arguments_stringlist, "-vehicles", vehicles) ||
+        !takeOption(arguments_stringlist, "-host", host) ||
+        !takeOption(arguments_stringlist, "-port", port) ||
+        !takeOption(arguments_stringlist, "-port-step", portStep) ||
+        !takeOption(arguments_stringlist, "-seconds", seconds) ||
+        !arguments_stringlist.isEmpty()) {
+        return usage_err();
+    }
+    int count    = vehicles.toInt();
+    int duration = seconds.toInt();
+    if (count <= 0 || duration <= 0 || port.toInt() <= 0) {
+        return usage_err();
+    }
+
+    // the primary session of the GCS is never started here, the baseline
+    // is the process with one object manager and no link
+    UAVObjectManager *objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+    QThread idle;
+    TelemetryManager primary(objMngr, &idle);
+    TelemetrySessionManager sessions(&primary);
+    QList<SessionProbe *> probes;
+
+    cout << setw(8) << "vehicles" << setw(10) << "connected" << setw(10) << "cpu [%]"
+         << setw(10) << "rss [MB]" << setw(12) << "rx [B/s]" << endl;
+
+    double baseCpu = 0, baseMemory = 0, cpu = 0, memory = 0;
+    for (int vehicle = 0; vehicle <= count; vehicle++) {
+        if (vehicle > 0) {
+            QString name = QString("vehicle%1").arg(vehicle);
+            if (!sessions.addUdpSession(name, host, port.toInt() + (vehicle - 1) * portStep.toInt())) {
+                cout << "Cannot open " << qPrintable(name) << endl;
+                return RETURN_ERR_LINK;
+            }
+            probes << new SessionProbe(sessions.telemetryManager(name));
+            // connecting retrieves all objects, leave it out of the measurement
+            QElapsedTimer connecting;
+            connecting.start();
+            while (!probes.last()->connected && connecting.elapsed() < 30000) {
+                runFor(100);
+            }
+            runFor(2000);
+        }
+
+        double startCpu = cpuSeconds();
+        QElapsedTimer elapsed;
+        elapsed.start();
+        runFor(duration * 1000);
+        cpu    = 100.0 * (cpuSeconds() - startCpu) / (elapsed.elapsed() / 1000.0);
+        memory = residentMB();
+
+        int connected = 0;
+        double rx     = 0;
+        foreach(SessionProbe * probe, probes) {
+            connected += probe->connected;
+            rx += probe->rxRate;
+        }
+        if (vehicle == 0) {
+            baseCpu    = cpu;
+            baseMemory = memory;
+        }
+        cout << fixed << setprecision(1) << setw(8) << vehicle << setw(10) << connected << setw(10) << cpu
+             << setw(10) << memory << setw(12) << setprecision(0) << rx << endl;
+    }
+
+    cout << fixed << setprecision(2) << "per vehicle: " << (cpu - baseCpu) / count << " % cpu, "
+         << (memory - baseMemory) / count << " MB" << endl;
+
+    // the session manager closes the sessions on the way out
+    qDeleteAll(probes);
+    return RETURN_OK;
+}
+
+#include "main.moc"
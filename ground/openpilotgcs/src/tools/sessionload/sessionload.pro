@@ -0,0 +1,29 @@
+include(../../../openpilotgcs.pri)
+
+TEMPLATE = app
+TARGET = sessionload
+DESTDIR = $$GCS_APP_PATH
+
+QT += network
+CONFIG += console
+CONFIG -= app_bundle
+
+# the UAVObjects and UAVTalk plugin libraries provide the objects and the sessions
+LIBS += -L$$GCS_PLUGIN_PATH/OpenPilot
+include(../../plugins/uavobjects/uavobjects.pri)
+include(../../plugins/uavtalk/uavtalk.pri)
+
+SOURCES += \
+    main.cpp
+
+win32 {
+    target.path = /bin
+    INSTALLS += target
+} else:!macx {
+    target.path  = /bin
+    INSTALLS    += target
+    QMAKE_RPATHDIR  = $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_LIBRARY_PATH, $$GCS_APP_PATH))
+    QMAKE_RPATHDIR += $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_PLUGIN_PATH/OpenPilot, $$GCS_APP_PATH))
+    QMAKE_RPATHDIR += $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_QT_LIBRARY_PATH, $$GCS_APP_PATH))
+    include(../../rpath.pri)
+}
@@ -0,0 +1,248 @@
+/**
+ ******************************************************************************
+ *
+ * @file       fanoutserver.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Serves decoded telemetry to local subscribers
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "fanoutserver.h"
+#include <utils/crc.h>
+#include <QtEndian>
+#include <QStringList>
+#include <QDebug>
+
+// UAVTalk framing: sync(1), type (1), size(2), object ID(4), instance ID(2), data, crc(1)
+#define SYNC_VAL        0x3C
+#define TYPE_OBJ        0x20
+#define HEADER_LENGTH   10
+#define CHECKSUM_LENGTH 1
+
+FanoutSubscriber::FanoutSubscriber(QLocalSocket *socket, FanoutServer *server) :
+    QObject(server), m_socket(socket), m_server(server), m_allInterval(-1), m_sent(0), m_dropped(0)
+{
+    m_socket->setParent(this);
+    connect(m_socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+    connect(m_socket, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+}
+
+qint64 FanoutSubscriber::interval(quint32 objId) const
+{
+    return m_intervals.value(objId, m_allInterval);
+}
+
+bool FanoutSubscriber::wants(quint32 objId) const
+{
+    return interval(objId) >= 0;
+}
+
+void FanoutSubscriber::publish(quint32 objId, quint16 instId, const QByteArray &packet, qint64 now)
+{
+    qint64 ms = interval(objId);
+
+    if (ms < 0) {
+        return;
+    }
+    if (ms == 0) {
+        send(packet);
+        return;
+    }
+
+    InstanceState &state = m_instances[((quint64)objId << 16) | instId];
+    if (state.lastSent < 0 || now - state.lastSent >= ms) {
+        send(packet);
+        state.lastSent = now;
+        state.pending.clear();
+    } else {
+        // keep the latest, flush() sends it when the interval is over
+        state.pending = packet;
+    }
+}
+
+void FanoutSubscriber::flush(qint64 now)
+{
+    QHash<quint64, InstanceState>::iterator it;
+
+    for (it = m_instances.begin(); it != m_instances.end(); ++it) {
+        InstanceState &state = it.value();
+        if (!state.pending.isEmpty() && now - state.lastSent >= interval(it.key() >> 16)) {
+            send(state.pending);
+            state.lastSent = now;
+            state.pending.clear();
+        }
+    }
+}
+
+void FanoutSubscriber::send(const QByteArray &packet)
+{
+    if (m_socket->bytesToWrite() > FanoutServer::MAX_BACKLOG) {
+        m_dropped++;
+        return;
+    }
+    m_socket->write(packet);
+    m_sent++;
+}
+
+void FanoutSubscriber::onReadyRead()
+{
+    while (m_socket->canReadLine()) {
+        command(QString::fromLatin1(m_socket->readLine()).trimmed());
+    }
+}
+
+void FanoutSubscriber::command(const QString &line)
+{
+    QStringList words = line.split(' ', QString::SkipEmptyParts);
+
+    if (words.size() < 2) {
+        return;
+    }
+
+    QString verb = words.at(0);
+    qint64 ms    = -1;
+    if (verb == "sub") {
+        double rate = words.size() > 2 ? words.at(2).toDouble() : 0.0;
+        ms = rate > 0.0 ? (qint64)(1000.0 / rate) : 0;
+    } else if (verb != "unsub") {
+        qWarning() << "telemetryd: unknown subscriber command" << line;
+        return;
+    }
+
+    if (words.at(1) == "*") {
+        // a wildcard resets the per object choices
+        m_allInterval = ms;
+        m_intervals.clear();
+        m_instances.clear();
+        return;
+    }
+
+    UAVObject *obj = m_server->objectManager()->getObject(words.at(1));
+    if (!obj) {
+        qWarning() << "telemetryd: no object named" << words.at(1);
+        return;
+    }
+    m_intervals.insert(obj->getObjID(), ms);
+}
+
+void FanoutSubscriber::onDisconnected()
+{
+    emit closed(this);
+}
+
+FanoutServer::FanoutServer(UAVObjectManager *objMngr, QObject *parent) :
+    QObject(parent), m_objMngr(objMngr)
+{
+    m_clock.start();
+
+    foreach(QList<UAVObject *> instances, m_objMngr->getObjects()) {
+        foreach(UAVObject * obj, instances) {
+            watch(obj);
+        }
+    }
+    connect(m_objMngr, SIGNAL(newInstance(UAVObject *)), this, SLOT(onNewInstance(UAVObject *)));
+    connect(&m_server, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+
+    // rate limited updates waiting for their interval
+    connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+    m_flushTimer.start(FLUSH_PERIOD);
+}
+
+bool FanoutServer::listen(const QString &name)
+{
+    // a crashed daemon leaves its socket file behind
+    QLocalServer::removeServer(name);
+    return m_server.listen(name);
+}
+
+QString FanoutServer::errorString() const
+{
+    return m_server.errorString();
+}
+
+void FanoutServer::watch(UAVObject *obj)
+{
+    connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(onObjectUpdated(UAVObject *)));
+}
+
+void FanoutServer::onNewInstance(UAVObject *obj)
+{
+    watch(obj);
+}
+
+void FanoutServer::onNewConnection()
+{
+    while (m_server.hasPendingConnections()) {
+        FanoutSubscriber *subscriber = new FanoutSubscriber(m_server.nextPendingConnection(), this);
+        connect(subscriber, SIGNAL(closed(FanoutSubscriber *)), this, SLOT(onSubscriberClosed(FanoutSubscriber *)));
+        m_subscribers.append(subscriber);
+    }
+}
+
+void FanoutServer::onSubscriberClosed(FanoutSubscriber *subscriber)
+{
+    m_subscribers.removeAll(subscriber);
+    subscriber->deleteLater();
+}
+
+void FanoutServer::onObjectUpdated(UAVObject *obj)
+{
+    quint32 objId = obj->getObjID();
+    QByteArray packet;
+    qint64 now    = m_clock.elapsed();
+
+    foreach(FanoutSubscriber * subscriber, m_subscribers) {
+        if (!subscriber->wants(objId)) {
+            continue;
+        }
+        // encoded once, the subscribers share the bytes
+        if (packet.isEmpty()) {
+            packet = encode(obj);
+        }
+        subscriber->publish(objId, obj->getInstID(), packet, now);
+    }
+}
+
+void FanoutServer::flush()
+{
+    qint64 now = m_clock.elapsed();
+
+    foreach(FanoutSubscriber * subscriber, m_subscribers) {
+        subscriber->flush(now);
+    }
+}
+
+/**
+ * A UAVTalk object packet, the same the flight side would send
+ */
+QByteArray FanoutServer::encode(UAVObject *obj)
+{
+    quint32 length = obj->getNumBytes();
+    QByteArray packet(HEADER_LENGTH + length + CHECKSUM_LENGTH, 0);
+    quint8 *buf    = (quint8 *)packet.data();
+
+    buf[0] = SYNC_VAL;
+    buf[1] = TYPE_OBJ;
+    qToLittleEndian<quint16>(HEADER_LENGTH + length, &buf[2]);
+    qToLittleEndian<quint32>(obj->getObjID(), &buf[4]);
+    qToLittleEndian<quint16>(obj->getInstID(), &buf[8]);
+    obj->pack(&buf[HEADER_LENGTH]);
+    buf[HEADER_LENGTH + length] = Utils::Crc::updateCRC(0, buf, HEADER_LENGTH + length);
+    return packet;
+}
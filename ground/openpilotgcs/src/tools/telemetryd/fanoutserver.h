@@ -0,0 +1,146 @@
+/**
+ ******************************************************************************
+ *
+ * @file       fanoutserver.h
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Serves decoded telemetry to local subscribers
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef FANOUTSERVER_H
+#define FANOUTSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#include "uavobjectmanager.h"
+
+class FanoutServer;
+
+/**
+ * One local client of the daemon.
+ * It sends text lines to choose what it gets:
+ *   sub <object|*> [max_rate_hz]    every update, or at most max_rate_hz per instance
+ *   unsub <object|*>
+ * and receives UAVTalk object packets, so existing parsers can read them.
+ * Updates coming faster than the rate are merged, the latest one is sent
+ * once the interval is over.
+ */
+class FanoutSubscriber : public QObject {
+    Q_OBJECT
+
+public:
+    FanoutSubscriber(QLocalSocket *socket, FanoutServer *server);
+
+    bool wants(quint32 objId) const;
+    // route one encoded update through the filter and rate limit
+    void publish(quint32 objId, quint16 instId, const QByteArray &packet, qint64 now);
+    // send the merged updates whose interval is over
+    void flush(qint64 now);
+
+    quint64 sent() const
+    {
+        return m_sent;
+    }
+    quint64 dropped() const
+    {
+        return m_dropped;
+    }
+
+signals:
+    void closed(FanoutSubscriber *subscriber);
+
+private slots:
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    struct InstanceState {
+        InstanceState() : lastSent(-1) {}
+        qint64 lastSent;
+        QByteArray pending;
+    };
+
+    // minimum ms between two updates of an instance, -1 when not subscribed
+    qint64 interval(quint32 objId) const;
+    void command(const QString &line);
+    void send(const QByteArray &packet);
+
+    QLocalSocket *m_socket;
+    FanoutServer *m_server;
+    qint64 m_allInterval;
+    QHash<quint32, qint64> m_intervals;
+    QHash<quint64, InstanceState> m_instances;
+    quint64 m_sent;
+    quint64 m_dropped;
+};
+
+/**
+ * Encodes every object update once and hands it to the subscribers.
+ */
+class FanoutServer : public QObject {
+    Q_OBJECT
+
+public:
+    // a subscriber that lets this much pile up loses updates rather than stalling the others
+    static const qint64 MAX_BACKLOG = 256 * 1024;
+    static const int FLUSH_PERIOD   = 10;
+
+    FanoutServer(UAVObjectManager *objMngr, QObject *parent = 0);
+
+    bool listen(const QString &name);
+    QString errorString() const;
+
+    UAVObjectManager *objectManager() const
+    {
+        return m_objMngr;
+    }
+    qint64 elapsed() const
+    {
+        return m_clock.elapsed();
+    }
+    const QList<FanoutSubscriber *> &subscribers() const
+    {
+        return m_subscribers;
+    }
+
+private slots:
+    void onNewConnection();
+    void onNewInstance(UAVObject *obj);
+    void onObjectUpdated(UAVObject *obj);
+    void onSubscriberClosed(FanoutSubscriber *subscriber);
+    void flush();
+
+private:
+    void watch(UAVObject *obj);
+    static QByteArray encode(UAVObject *obj);
+
+    UAVObjectManager *m_objMngr;
+    QLocalServer m_server;
+    QList<FanoutSubscriber *> m_subscribers;
+    QTimer m_flushTimer;
+    QElapsedTimer m_clock;
+};
+
+#endif // FANOUTSERVER_H
@@ -0,0 +1,283 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     The LibrePilot Project, http://www.librepilot.org Copyright (C) 2015.
+ * @brief      Headless telemetry daemon, owns the link and fans the objects out
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QtNetwork/QTcpSocket>
+#include <QtNetwork/QUdpSocket>
+#include <QtSerialPort/QSerialPort>
+#include <iostream>
+
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include "uavtalk.h"
+#include "telemetry.h"
+#include "telemetrymonitor.h"
+#include "fanoutserver.h"
+
+#define RETURN_ERR_USAGE 1
+#define RETURN_ERR_LINK  2
+#define RETURN_OK        0
+
+using namespace std;
+
+/**
+ * print usage info
+ */
+void usage()
+{
+    cout << "Usage: telemetryd [-serial port [-baud rate] | -udp host:port | -tcp host:port] [-socket name]" << endl;
+    cout << "       telemetryd -bench subscribers [-seconds s] [-socket name]" << endl;
+    cout << "Link: " << endl;
+    cout << "\t-serial port   serial port of the telemetry radio or board, -baud default 57600" << endl;
+    cout << "\t-udp host:port UDP telemetry, e.g. a simposix instance" << endl;
+    cout << "\t-tcp host:port TCP telemetry" << endl;
+    cout << "Subscribers: " << endl;
+    cout << "\t-socket name   local socket the subscribers connect to, default telemetryd" << endl;
+    cout << "\t               a subscriber writes lines \"sub <object|*> [max_rate_hz]\" or \"unsub <object|*>\"" << endl;
+    cout << "\t               and reads UAVTalk object packets" << endl;
+    cout << "Misc: " << endl;
+    cout << "\t-h             this help" << endl;
+    cout << "\t-bench n       no link, n local subscribers take every update of all objects" << endl;
+    cout << "\t-seconds s     benchmark length, default 10" << endl;
+}
+
+/**
+ * inform user of invalid usage
+ */
+int usage_err()
+{
+    cout << "Invalid usage!" << endl;
+    usage();
+    return RETURN_ERR_USAGE;
+}
+
+/**
+ * take "option value" out of the arguments
+ * @returns false if the option is there without a value
+ */
+bool takeOption(QStringList & arguments, const QString & option, QString & value)
+{
+    int index = arguments.indexOf(option);
+
+    if (index < 0) {
+        return true;
+    }
+    if (index + 1 >= arguments.size()) {
+        return false;
+    }
+    value = arguments.at(index + 1);
+    arguments.removeAt(index + 1);
+    arguments.removeAt(index);
+    return true;
+}
+
+/**
+ * In process subscriber of the benchmark, takes everything and counts the bytes
+ */
+class BenchClient : public QObject {
+    Q_OBJECT
+
+public:
+    BenchClient(const QString &name) : received(0)
+    {
+        connect(&socket, SIGNAL(connected()), this, SLOT(onConnected()));
+        connect(&socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+        socket.connectToServer(name);
+    }
+
+    QLocalSocket socket;
+    quint64 received;
+
+private slots:
+    void onConnected()
+    {
+        socket.write("sub *\n");
+    }
+    void onReadyRead()
+    {
+        received += socket.readAll().size();
+    }
+};
+
+/**
+ * Updates every object as fast as the event loop allows
+ */
+class BenchProducer : public QObject {
+    Q_OBJECT
+
+public:
+    BenchProducer(UAVObjectManager *objMngr) : updates(0)
+    {
+        foreach(QList<UAVObject *> instances, objMngr->getObjects()) {
+            objects << instances.first();
+        }
+        connect(&timer, SIGNAL(timeout()), this, SLOT(burst()));
+    }
+
+    QList<UAVObject *> objects;
+    QTimer timer;
+    quint64 updates;
+
+private slots:
+    void burst()
+    {
+        foreach(UAVObject * obj, objects) {
+            obj->updated();
+        }
+        updates += objects.size();
+    }
+};
+
+/**
+ * entrance
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QStringList arguments_stringlist;
+
+    // process arguments
+    for (int argi = 1; argi < argc; argi++) {
+        arguments_stringlist << argv[argi];
+    }
+
+    if (arguments_stringlist.removeAll("-h") > 0) {
+        usage();
+        return RETURN_OK;
+    }
+
+    QString serialPort, baud("57600"), udp, tcp, socketName("telemetryd"), bench, seconds("10");
+    if (!takeOption(arguments_stringlist, "-serial", serialPort) ||
+        !takeOption(arguments_stringlist, "-baud", baud) ||
+        !takeOption(arguments_stringlist, "-udp", udp) ||
+        !takeOption(arguments_stringlist, "-tcp", tcp) ||
+        !takeOption(arguments_stringlist, "-socket", socketName) ||
+        !takeOption(arguments_stringlist, "-bench", bench) ||
+        !takeOption(arguments_stringlist, "-seconds", seconds) ||
+        !arguments_stringlist.isEmpty()) {
+        return usage_err();
+    }
+    int links = !serialPort.isEmpty() + !udp.isEmpty() + !tcp.isEmpty();
+    if (bench.isEmpty() ? links != 1 : links != 0) {
+        return usage_err();
+    }
+
+    UAVObjectManager *objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+
+    FanoutServer server(objMngr);
+    if (!server.listen(socketName)) {
+        cout << "Cannot listen on " << qPrintable(socketName) << ": " << qPrintable(server.errorString()) << endl;
+        return RETURN_ERR_LINK;
+    }
+
+    if (!bench.isEmpty()) {
+        int subscribers = bench.toInt();
+        int duration    = seconds.toInt();
+        if (subscribers <= 0 || duration <= 0) {
+            return usage_err();
+        }
+
+        QList<BenchClient *> clients;
+        for (int i = 0; i < subscribers; i++) {
+            clients << new BenchClient(socketName);
+        }
+        // let the subscribers connect and subscribe before producing
+        while (server.subscribers().size() < subscribers) {
+            a.processEvents();
+        }
+        for (int i = 0; i < 100; i++) {
+            a.processEvents();
+        }
+
+        BenchProducer producer(objMngr);
+        QElapsedTimer elapsed;
+        elapsed.start();
+        producer.timer.start(0);
+        QTimer::singleShot(duration * 1000, &a, SLOT(quit()));
+        a.exec();
+        producer.timer.stop();
+
+        double secs    = elapsed.elapsed() / 1000.0;
+        quint64 sent   = 0, dropped = 0, received = 0;
+        foreach(FanoutSubscriber * subscriber, server.subscribers()) {
+            sent    += subscriber->sent();
+            dropped += subscriber->dropped();
+        }
+        foreach(BenchClient * client, clients) {
+            received += client->received;
+        }
+
+        cout << subscribers << " subscribers, " << producer.objects.size() << " objects, " << secs << " s" << endl;
+        cout << "  updates:   " << (quint64)(producer.updates / secs) << " objects/s" << endl;
+        cout << "  delivered: " << (quint64)(sent / secs) << " packets/s, "
+             << (quint64)(sent / secs / subscribers) << " packets/s per subscriber" << endl;
+        cout << "  received:  " << received / secs / (1024 * 1024) << " MB/s" << endl;
+        cout << "  dropped:   " << dropped << " packets on full subscribers" << endl;
+
+        qDeleteAll(clients);
+        return RETURN_OK;
+    }
+
+    QIODevice *link;
+    if (!serialPort.isEmpty()) {
+        QSerialPort *port = new QSerialPort(serialPort);
+        port->setBaudRate(baud.toInt());
+        link = port;
+        if (!port->open(QIODevice::ReadWrite)) {
+            cout << "Cannot open " << qPrintable(serialPort) << ": " << qPrintable(port->errorString()) << endl;
+            return RETURN_ERR_LINK;
+        }
+    } else {
+        QString address = udp.isEmpty() ? tcp : udp;
+        QAbstractSocket *socket;
+        if (udp.isEmpty()) {
+            socket = new QTcpSocket();
+        } else {
+            socket = new QUdpSocket();
+        }
+        link = socket;
+        socket->connectToHost(address.section(':', 0, 0), address.section(':', 1).toInt());
+        if (!socket->waitForConnected(5000)) {
+            cout << "Cannot connect to " << qPrintable(address) << ": " << qPrintable(socket->errorString()) << endl;
+            return RETURN_ERR_LINK;
+        }
+    }
+
+    // the same protocol stack the GCS runs, minus the GUI
+    UAVTalk *uavTalk = new UAVTalk(link, objMngr);
+    QObject::connect(link, SIGNAL(readyRead()), uavTalk, SLOT(processInputStream()));
+    Telemetry *telemetry = new Telemetry(uavTalk, objMngr);
+    TelemetryMonitor *monitor = new TelemetryMonitor(objMngr, telemetry);
+    Q_UNUSED(monitor);
+
+    cout << "Serving telemetry on " << qPrintable(socketName) << endl;
+    return a.exec();
+}
+
+#include "main.moc"
@@ -0,0 +1,33 @@
+include(../../../openpilotgcs.pri)
+
+TEMPLATE = app
+TARGET = telemetryd
+DESTDIR = $$GCS_APP_PATH
+
+QT += network serialport
+CONFIG += console
+CONFIG -= app_bundle
+
+# the UAVObjects and UAVTalk plugin libraries provide the objects and the protocol
+LIBS += -L$$GCS_PLUGIN_PATH/OpenPilot
+include(../../plugins/uavobjects/uavobjects.pri)
+include(../../plugins/uavtalk/uavtalk.pri)
+
+HEADERS += \
+    fanoutserver.h
+
+SOURCES += \
+    main.cpp \
+    fanoutserver.cpp
+
+win32 {
+    target.path = /bin
+    INSTALLS += target
+} else:!macx {
+    target.path  = /bin
+    INSTALLS    += target
+    QMAKE_RPATHDIR  = $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_LIBRARY_PATH, $$GCS_APP_PATH))
+    QMAKE_RPATHDIR += $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_PLUGIN_PATH/OpenPilot, $$GCS_APP_PATH))
+    QMAKE_RPATHDIR += $$shell_quote(\$$ORIGIN/$$relative_path($$GCS_QT_LIBRARY_PATH, $$GCS_APP_PATH))
+    include(../../rpath.pri)
+}
@@ -0,0 +1,7 @@
+TEMPLATE  = subdirs
+
+SUBDIRS = \
+    oplconvert \
+    telemetryd \
+    sessionload \
+    historybench
@@ -32,6 +32,9 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser *parser, QString templat
 {
     fieldTypeStrC << "int8_t" << "int16_t" << "int32_t" << "uint8_t"
                   << "uint16_t" << "uint32_t" << "float" << "uint8_t";
+    fieldTypeEnumC << "UAVOBJ_FIELDTYPE_INT8" << "UAVOBJ_FIELDTYPE_INT16" << "UAVOBJ_FIELDTYPE_INT32"
+                   << "UAVOBJ_FIELDTYPE_UINT8" << "UAVOBJ_FIELDTYPE_UINT16" << "UAVOBJ_FIELDTYPE_UINT32"
+                   << "UAVOBJ_FIELDTYPE_FLOAT32" << "UAVOBJ_FIELDTYPE_ENUM";
 
     QString flightObjInit, objInc, objFileNames, objNames;
     qint32 sizeCalc;
@@ -53,7 +56,9 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser *parser, QString templat
     sizeCalc = 0;
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo *info = parser->getObjectByIndex(objidx);
-        process_object(info);
+        if (!process_object(info)) {
+            return false;
+        }
         flightObjInit.append("#ifdef UAVOBJ_INIT_" + info->namelc + "\n");
         flightObjInit.append("    " + info->name + "Initialize();\n");
         flightObjInit.append("#endif\n");
@@ -139,12 +144,12 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
         if (info->fields[n]->numElements > 1) {
             if (info->fields[n]->elementNames[0].compare(QString("0")) != 0) {
                 QString structTypeName = QString("%1%2Data").arg(info->name).arg(info->fields[n]->name);
-                QString structType     = QString("typedef struct __attribute__ ((__packed__)) {\n");
+                QString structType     = QString("typedef struct {\n");
                 for (int f = 0; f < info->fields[n]->elementNames.count(); f++) {
                     structType.append(QString("    %1 %2;\n").arg(type).arg(info->fields[n]->elementNames[f]));
                 }
                 structType.append(QString("}  %1 ;\n").arg(structTypeName));
-                structType.append(QString("typedef struct __attribute__ ((__packed__)) {\n"));
+                structType.append(QString("typedef struct {\n"));
                 structType.append(QString("    %1 array[%2];\n").arg(type).arg(info->fields[n]->elementNames.count()));
                 structType.append(QString("}  %1Array ;\n").arg(structTypeName));
                 structType.append(QString("#define %1%2ToArray( var ) UAVObjectFieldToArray( %3, var )\n\n").arg(info->name).arg(info->fields[n]->name).arg(structTypeName));
@@ -163,6 +168,8 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
     }
     outInclude.replace(QString("$(DATAFIELDS)"), fields);
     outInclude.replace(QString("$(DATASTRUCTURES)"), dataStructures);
+    // Replace the $(LASTFIELD) tag, used to check the aligned layout against the packed one
+    outCode.replace(QString("$(LASTFIELD)"), info->fields.last()->name);
     // Replace the $(DATAFIELDINFO) tag
     QString enums;
     for (int n = 0; n < info->fields.length(); ++n) {
@@ -216,6 +223,27 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
     }
     outInclude.replace(QString("$(DATAFIELDINFO)"), enums);
 
+    // Replace the $(FIELDINFO) tag, the descriptor layout is UAVObjFieldInfo
+    if (info->fields.length() > 64) {
+        cerr << "Error: " << info->name.toStdString() << " has more fields than UAVOBJ_MAX_FIELDS" << endl;
+        return false;
+    }
+    QString fieldinfo;
+    for (int n = 0; n < info->fields.length(); ++n) {
+        if (info->fields[n]->numElements > 4095) {
+            cerr << "Error: field " << info->fields[n]->name.toStdString() << " of " << info->name.toStdString()
+                 << " has too many elements" << endl;
+            return false;
+        }
+        fieldinfo.append(QString("    { 0x%1, offsetof(%2DataPacked, %3), %4, %5 },\n")
+                         .arg(fieldNameHash(info->fields[n]->name), 8, 16, QChar('0'))
+                         .arg(info->name)
+                         .arg(info->fields[n]->name)
+                         .arg(fieldTypeEnumC[info->fields[n]->type])
+                         .arg(info->fields[n]->numElements));
+    }
+    outCode.replace(QString("$(FIELDINFO)"), fieldinfo);
+
     // Replace the $(INITFIELDS) tag
     QString initfields;
     for (int n = 0; n < info->fields.length(); ++n) {
@@ -420,3 +448,18 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
 
     return true;
 }
+
+/**
+ * Hash of a field name, must match UAVObjFieldNameHash() of the flight code.
+ * Same Shift-Add-XOR hash as the object IDs.
+ **/
+quint32 UAVObjectGeneratorFlight::fieldNameHash(const QString & name)
+{
+    QByteArray bytes = name.toLatin1();
+    quint32 hash     = 0;
+
+    for (int n = 0; n < bytes.length(); ++n) {
+        hash ^= (hash << 5) + (hash >> 2) + (quint8)bytes[n];
+    }
+    return hash;
+}
@@ -35,12 +35,14 @@ class UAVObjectGeneratorFlight {
 public:
     bool generate(UAVObjectParser *gen, QString templatepath, QString outputpath);
     QStringList fieldTypeStrC;
+    QStringList fieldTypeEnumC;
     QString flightCodeTemplate, flightIncludeTemplate, flightInitTemplate, flightInitIncludeTemplate, flightMakeTemplate;
     QDir flightCodePath;
     QDir flightOutputPath;
 
 private:
     bool process_object(ObjectInfo *info);
+    quint32 fieldNameHash(const QString & name);
 };
 
 #endif
@@ -120,12 +120,15 @@ SRC += $(PIOSCOMMON)/pios_task_monitor.c
 SRC += $(PIOSCOMMON)/pios_callbackscheduler.c
 SRC += $(PIOSCOMMON)/pios_notify.c
 SRC += $(PIOSCOMMON)/pios_instrumentation.c
+SRC += $(PIOSCOMMON)/pios_tracebuffer.c
 SRC += $(PIOSCOMMON)/pios_mem.c
 ## Misc library functions
 SRC += $(FLIGHTLIB)/fifo_buffer.c
 
 SRC += $(MATHLIB)/mathmisc.c
 SRC += $(MATHLIB)/butterworth.c
+SRC += $(MATHLIB)/decimator.c
+SRC += $(MATHLIB)/dynnotch.c
 SRC += $(FLIGHTLIB)/printf-stdarg.c
 SRC += $(FLIGHTLIB)/optypes.c
 
@@ -53,6 +53,9 @@ SRC += $(OPSYSTEM)/pios_board.c
 
 ## PIOS Hardware (Common)
 SRC += $(PIOSCOMMON)/pios_board_info.c
+ifneq ($(PIOS_OMITS_DFU_SECTOR_CRC),YES)
+SRC += $(PIOSCOMMON)/pios_crc.c
+endif
 SRC += $(PIOSCOMMON)/pios_com_msg.c
 SRC += $(PIOSCOMMON)/pios_iap.c
 ifneq ($(PIOS_OMITS_USB),YES)
@@ -117,6 +120,10 @@ EXTRA_LIBS +=
 CDEFS += 
 # enable bootloader specific stuffs
 CDEFS += -DBOOTLOADER
+# per-sector CRCs for differential firmware uploads, costs about 2k of flash
+ifneq ($(PIOS_OMITS_DFU_SECTOR_CRC),YES)
+CDEFS += -DDFU_INCLUDE_SECTOR_CRC
+endif
 
 # Set linker-script name depending on selected submodel name
 ifeq ($(MCU),cortex-m3)
@@ -39,6 +39,7 @@ DIAG_RATEDESIRED     ?= NO
 DIAG_I2C_WDG_STATS   ?= NO
 DIAG_TASKS           ?= NO
 DIAG_INSTRUMENTATION ?= NO
+DIAG_TRACEBUFFER     ?= NO
 
 # Or just turn on all the above diagnostics. WARNING: this consumes massive amounts of memory.
 DIAG_ALL             ?= NO
@@ -98,6 +99,10 @@ endif
 ifneq (,$(filter YES,$(DIAG_INSTRUMENTATION) $(DIAG_ALL)))
     CFLAGS += -DPIOS_INCLUDE_INSTRUMENTATION
 endif
+
+ifneq (,$(filter YES,$(DIAG_TRACEBUFFER) $(DIAG_ALL)))
+    CFLAGS += -DPIOS_INCLUDE_TRACEBUFFER
+endif
 # Place project-specific -D and/or -U options for Assembler with preprocessor here.
 #ADEFS = -DUSE_IRQ_ASM_WRAPPER
 ADEFS = -D__ASSEMBLY__